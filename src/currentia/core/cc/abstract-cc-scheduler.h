@@ -20,6 +20,7 @@ namespace currentia {
     // Concurrenty Control Scheduler
     class AbstractCCScheduler : public AbstractScheduler {
     protected:
+        Operator::CCMode cc_mode_;
         Operator* commit_operator_;
         std::deque<Operator*> redo_operators_;
         std::deque<Stream::ptr_t> redo_streams_;
@@ -32,6 +33,7 @@ namespace currentia {
                             const SchedulingPolicyFactory::ptr_t& scheduling_policy_factory,
                             Operator::CCMode cc_mode):
             AbstractScheduler(root_operator, scheduling_policy_factory),
+            cc_mode_(cc_mode),
             reset_tuples_count_(0),
             redo_counts_(0) {
             // Tell concurrency-control stragety to the operators rooted by `root_operator`
@@ -72,6 +74,12 @@ namespace currentia {
             return commit_operator_;
         }
 
+        // Commits and redos reset the streams and operators of the
+        // redo area
+        bool is_synchronization_point(Operator* op) const {
+            return cc_mode_ != Operator::NONE && op == commit_operator_;
+        }
+
 #ifdef CURRENTIA_CHECK_STATISTICS
         long get_redo_counts() {
             return redo_counts_;
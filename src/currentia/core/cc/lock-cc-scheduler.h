@@ -5,6 +5,8 @@
 
 #include "currentia/core/cc/abstract-pessimistic-cc-scheduler.h"
 
+#include <algorithm>
+
 namespace currentia {
     // Concurrenty Control Scheduler with 2-Phase Locking Protocol
     class LockCCScheduler : public AbstractPessimisticCCScheduler {
@@ -22,6 +24,14 @@ namespace currentia {
             release_all_locks_();
         }
 
+        // Locks taken by the reference operators are released by the
+        // commit operator
+        bool is_thread_bound(Operator* op) const {
+            return op == commit_operator_ ||
+                std::find(reference_operators_.begin(), reference_operators_.end(),
+                          dynamic_cast<TraitResourceReferenceOperator*>(op)) != reference_operators_.end();
+        }
+
     protected:
         void commit_() {
             // Nothing
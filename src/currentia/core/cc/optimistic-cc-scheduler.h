@@ -16,7 +16,10 @@ namespace currentia {
         }
 
         bool wake_up() {
-            Operator* next_operator = get_next_operator_();
+            return process_operator(get_next_operator_());
+        }
+
+        bool process_operator(Operator* next_operator) {
             if (!next_operator)
                 return false;
             if (next_operator != commit_operator_) {
@@ -16,7 +16,7 @@ namespace currentia {
         }
 
         bool wake_up() {
-            return process_operator_batch_(get_next_operator_());
+            return process_operator(get_next_operator_());
         }
     };
 }
@@ -6,6 +6,8 @@
 #include <sstream>
 #include <string>
 #include <iostream>
+#include <functional>           // std::hash
+#include <algorithm>            // std::swap
 
 #include "currentia/core/pointer.h"
 #include "currentia/core/operator/comparator.h"
@@ -48,22 +50,7 @@ namespace currentia {
     private:
         template <typename T>
         bool generic_compare_(const T& x, const T& y, Comparator::Type comparator) const {
-            switch (comparator) {
-            case Comparator::EQUAL:              // ==
-                return x == y;
-            case Comparator::NOT_EQUAL:          // !=
-                return x != y;
-            case Comparator::LESS_THAN:          // <
-                return x < y;
-            case Comparator::LESS_THAN_EQUAL:    // <=
-                return x <= y;
-            case Comparator::GREATER_THAN:       // >
-                return x > y;
-            case Comparator::GREATER_THAN_EQUAL: // >=
-                return x >= y;
-            default:
-                return false;
-            }
+            return Comparator::compare(x, y, comparator);
         }
 
         void set_int_number_(int int_number) {
@@ -120,7 +107,8 @@ namespace currentia {
 
         // Copy constructor
         Object(const Object& object):
-            type_(object.get_type()) {
+            type_(object.get_type()),
+            holder_() {         // an UNKNOWN object holds nothing
             switch (this->get_type()) {
             case INT:
                 holder_.int_number = object.get_int_number();
@@ -139,6 +127,15 @@ namespace currentia {
             }
         }
 
+        Object& operator=(const Object& object) {
+            if (this != &object) {
+                Object copied(object);
+                std::swap(type_, copied.type_);
+                std::swap(holder_, copied.holder_);
+            }
+            return *this;
+        }
+
         Object(int int_number): type_(INT) {
             set_int_number_(int_number);
         }
@@ -170,6 +167,10 @@ namespace currentia {
             set_string_ptr_(string_ptr_t(new std::string(raw_string)));
         }
 
+        Object(const char* raw_string, size_t length): type_(STRING) {
+            set_string_ptr_(string_ptr_t(new std::string(raw_string, length)));
+        }
+
         // If you do not want to your object to be replicated,
         // consider using BLOB. BLOB retains the original pointer, and
         // frees up the memory it points when the BLOB Object is
@@ -248,7 +249,7 @@ namespace currentia {
                 case STRING:
                     // compare deeply
                     comparison_result = generic_compare_(*(get_string_ptr()),
-                                                         *(get_string_ptr()),
+                                                         *(target.get_string_ptr()),
                                                          comparator);
                     break;
                 case BLOB:
@@ -273,6 +274,23 @@ namespace currentia {
             return comparison_result;
         }
 
+        // Objects equal under compare() have the same hash value (INT
+        // is hashed as FLOAT since they are compared after the cast)
+        size_t hash() const {
+            switch (get_type()) {
+            case INT:
+                return std::hash<double>()(static_cast<double>(get_int_number()));
+            case FLOAT:
+                return std::hash<double>()(get_float_number());
+            case STRING:
+                return std::hash<std::string>()(*get_string_ptr());
+            case BLOB:
+                return std::hash<blob_ptr_t>()(get_blob_ptr());
+            default:
+                return 0;
+            }
+        }
+
         bool operator ==(const Object& target) const {
             return this->compare(target, Comparator::EQUAL);
         }
@@ -329,4 +347,13 @@ namespace currentia {
     };
 }
 
+namespace std {
+    template <>
+    struct hash<currentia::Object> {
+        size_t operator()(const currentia::Object& object) const {
+            return object.hash();
+        }
+    };
+}
+
 #endif  /* ! CURRENTIA_OBJECT_H_ */
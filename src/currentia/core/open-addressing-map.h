@@ -0,0 +1,199 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_OPEN_ADDRESSING_MAP_H_
+#define CURRENTIA_OPEN_ADDRESSING_MAP_H_
+
+#include "currentia/trait/non-copyable.h"
+
+#include <cstddef>              // size_t
+#include <functional>           // std::hash, std::equal_to
+#include <utility>              // std::move
+#include <vector>
+
+namespace currentia {
+    // Hash map with open addressing (linear probing) in a single array
+    // of entries, so that a lookup mostly reads one or two adjacent
+    // cache lines instead of chasing the nodes of std::unordered_map.
+    // Erasure shifts the following entries of the probe sequence back
+    // rather than leaving tombstones, so probe sequences stay short
+    // while keys come and go.
+    //
+    // Unused entries hold a copy of empty_key (any value; keys without
+    // a default constructor have to give one). Pointers to values are
+    // invalidated by insertion and erasure.
+    template <typename Key,
+              typename Value,
+              typename Hash = std::hash<Key>,
+              typename Equal = std::equal_to<Key> >
+    class OpenAddressingMap : private NonCopyable<OpenAddressingMap<Key, Value, Hash, Equal> > {
+        struct Entry {
+            bool used;
+            size_t hash;
+            Key key;
+            Value value;
+
+            Entry(const Key& key):
+                used(false),
+                hash(0),
+                key(key),
+                value() {
+            }
+        };
+
+        Entry empty_entry_;
+        std::vector<Entry> entries_; // the size is a power of two
+        size_t mask_;
+        size_t size_;
+
+        Hash hash_;
+        Equal equal_;
+
+    public:
+        static const size_t INITIAL_CAPACITY = 16;
+        // grows when more than MAX_LOAD_PERCENT % of entries are used
+        static const size_t MAX_LOAD_PERCENT = 70;
+
+        OpenAddressingMap(const Key& empty_key = Key(),
+                          const Hash& hash = Hash(),
+                          const Equal& equal = Equal()):
+            empty_entry_(empty_key),
+            entries_(INITIAL_CAPACITY, empty_entry_),
+            mask_(INITIAL_CAPACITY - 1),
+            size_(0),
+            hash_(hash),
+            equal_(equal) {
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        size_t capacity() const {
+            return entries_.size();
+        }
+
+        void clear() {
+            std::vector<Entry>(INITIAL_CAPACITY, empty_entry_).swap(entries_);
+            mask_ = INITIAL_CAPACITY - 1;
+            size_ = 0;
+        }
+
+        // Returns NULL when the key is absent
+        Value* find(const Key& key) {
+            size_t index;
+            return find_index_(key, hash_(key), index) ? &entries_[index].value : NULL;
+        }
+
+        const Value* find(const Key& key) const {
+            size_t index;
+            return find_index_(key, hash_(key), index) ? &entries_[index].value : NULL;
+        }
+
+        // Inserts a default-constructed value when the key is absent
+        Value& operator[](const Key& key) {
+            size_t hash = hash_(key);
+            size_t index;
+            if (find_index_(key, hash, index))
+                return entries_[index].value;
+
+            if ((size_ + 1) * 100 > entries_.size() * MAX_LOAD_PERCENT) {
+                grow_();
+                find_index_(key, hash, index);
+            }
+
+            Entry& entry = entries_[index];
+            entry.used = true;
+            entry.hash = hash;
+            entry.key = key;
+            size_++;
+            return entry.value;
+        }
+
+        bool erase(const Key& key) {
+            size_t index;
+            if (!find_index_(key, hash_(key), index))
+                return false;
+            erase_index_(index);
+            return true;
+        }
+
+        // Calls function(key, value) for each entry
+        template <typename Function>
+        void for_each(Function function) {
+            for (size_t index = 0; index < entries_.size(); ++index) {
+                if (entries_[index].used)
+                    function(entries_[index].key, entries_[index].value);
+            }
+        }
+
+        // Erases the entries for which predicate(key, value) holds, and
+        // returns their number
+        template <typename Predicate>
+        size_t erase_if(Predicate predicate) {
+            size_t erased_count = 0;
+            // An erasure moves entries not visited yet back to the
+            // current index (or to visited indices after wrapping
+            // around), so the index is examined again.
+            for (size_t index = 0; index < entries_.size();) {
+                Entry& entry = entries_[index];
+                if (entry.used && predicate(entry.key, entry.value)) {
+                    erase_index_(index);
+                    erased_count++;
+                } else {
+                    index++;
+                }
+            }
+            return erased_count;
+        }
+
+    private:
+        // Sets index to the entry of the key, or to the unused entry
+        // where the key would be inserted
+        bool find_index_(const Key& key, size_t hash, size_t& index) const {
+            for (index = hash & mask_; entries_[index].used; index = (index + 1) & mask_) {
+                if (entries_[index].hash == hash && equal_(entries_[index].key, key))
+                    return true;
+            }
+            return false;
+        }
+
+        void erase_index_(size_t hole) {
+            // Backward shift deletion: an entry after the hole moves
+            // into it unless its home index lies cyclically in
+            // (hole, index].
+            for (size_t index = (hole + 1) & mask_; entries_[index].used; index = (index + 1) & mask_) {
+                size_t home = entries_[index].hash & mask_;
+                bool stays = hole <= index
+                    ? (hole < home && home <= index)
+                    : (hole < home || home <= index);
+                if (stays)
+                    continue;
+                entries_[hole] = std::move(entries_[index]);
+                hole = index;
+            }
+            entries_[hole] = empty_entry_;
+            size_--;
+        }
+
+        void grow_() {
+            std::vector<Entry> old_entries(entries_.size() * 2, empty_entry_);
+            old_entries.swap(entries_);
+            mask_ = entries_.size() - 1;
+
+            for (size_t i = 0; i < old_entries.size(); ++i) {
+                if (!old_entries[i].used)
+                    continue;
+                size_t index = old_entries[i].hash & mask_;
+                while (entries_[index].used)
+                    index = (index + 1) & mask_;
+                entries_[index] = std::move(old_entries[i]);
+            }
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_OPEN_ADDRESSING_MAP_H_ */
@@ -4,6 +4,7 @@
 #define CURRENTIA_OPERATIONS_H_
 
 #include "currentia/core/object.h"
+#include "currentia/core/operation/typed-operations.h"
 #include <sstream>
 
 namespace currentia {
@@ -16,127 +17,67 @@ namespace currentia {
 
         static Object add(const Object& left,
                           const Object& right) {
-            std::stringstream ss;
-
-            switch (left.get_type()) {
-            case Object::INT:
-                switch (right.get_type()) {
-                case Object::INT:
-                    return Object(left.get_int_number() + right.get_int_number());
-                case Object::FLOAT:
-                    return Object(static_cast<double>(left.get_int_number()) + right.get_float_number());
-                case Object::STRING:
-                    ss << left.get_int_number();
-                    return Object(*Object::string_ptr_t(new std::string(ss.str())) + *right.get_string_ptr());
-                default:
-                    throw TYPE_MISMATCH;
-                }
-            case Object::FLOAT:
-                switch (right.get_type()) {
-                case Object::INT:
-                    return Object(left.get_float_number() + static_cast<double>(right.get_int_number()));
-                case Object::FLOAT:
-                    return Object(left.get_float_number() + right.get_float_number());
-                case Object::STRING:
-                    ss << left.get_float_number();
-                    return Object(*Object::string_ptr_t(new std::string(ss.str())) + *right.get_string_ptr());
-                default:
-                    throw TYPE_MISMATCH;
-                }
-            case Object::STRING:
-                switch (right.get_type()) {
-                case Object::INT:
-                    ss << right.get_int_number();
-                    return Object(*left.get_string_ptr() + *Object::string_ptr_t(new std::string(ss.str())));
-                case Object::FLOAT:
-                    ss << right.get_float_number();
-                    return Object(*left.get_string_ptr() + *Object::string_ptr_t(new std::string(ss.str())));
-                case Object::STRING:
-                    return Object(*left.get_string_ptr() + *right.get_string_ptr());
-                default:
-                    throw TYPE_MISMATCH;
-                }
-            default:
-                throw UNSUPPORTED_OPERATION;
+            if (left.get_type() == Object::STRING || right.get_type() == Object::STRING) {
+                if (!is_operand_(left) || !is_operand_(right))
+                    throw is_operand_(left) ? TYPE_MISMATCH : UNSUPPORTED_OPERATION;
+                return Object(to_string_(left) + to_string_(right));
             }
+            return apply_<TypedOperation::Add>(left, right);
         }
 
         static Object subtract(const Object& left,
                                const Object& right) {
-            switch (left.get_type()) {
-            case Object::INT:
-                switch (right.get_type()) {
-                case Object::INT:
-                    return Object(left.get_int_number() - right.get_int_number());
-                case Object::FLOAT:
-                    return Object(static_cast<double>(left.get_int_number()) - right.get_float_number());
-                default:
-                    throw TYPE_MISMATCH;
-                }
-            case Object::FLOAT:
-                switch (right.get_type()) {
-                case Object::INT:
-                    return Object(left.get_float_number() - static_cast<double>(right.get_int_number()));
-                case Object::FLOAT:
-                    return Object(left.get_float_number() - right.get_float_number());
-                default:
-                    throw TYPE_MISMATCH;
-                }
-            default:
-                throw UNSUPPORTED_OPERATION;
-            }
+            return apply_<TypedOperation::Subtract>(left, right);
         }
 
         static Object multiply(const Object& left,
                                const Object& right) {
-            switch (left.get_type()) {
-            case Object::INT:
-                switch (right.get_type()) {
-                case Object::INT:
-                    return Object(left.get_int_number() * right.get_int_number());
-                case Object::FLOAT:
-                    return Object(static_cast<double>(left.get_int_number()) * right.get_float_number());
-                default:
-                    throw TYPE_MISMATCH;
-                }
-            case Object::FLOAT:
-                switch (right.get_type()) {
-                case Object::INT:
-                    return Object(left.get_float_number() * static_cast<double>(right.get_int_number()));
-                case Object::FLOAT:
-                    return Object(left.get_float_number() * right.get_float_number());
-                default:
-                    throw TYPE_MISMATCH;
-                }
-            default:
-                throw UNSUPPORTED_OPERATION;
-            }
+            return apply_<TypedOperation::Multiply>(left, right);
         }
 
         static Object divide(const Object& left,
                              const Object& right) {
-            switch (left.get_type()) {
-            case Object::INT:
-                switch (right.get_type()) {
-                case Object::INT:
-                    return Object(left.get_int_number() / right.get_int_number());
-                case Object::FLOAT:
-                    return Object(static_cast<double>(left.get_int_number()) / right.get_float_number());
-                default:
-                    throw TYPE_MISMATCH;
-                }
-            case Object::FLOAT:
-                switch (right.get_type()) {
-                case Object::INT:
-                    return Object(left.get_float_number() / static_cast<double>(right.get_int_number()));
-                case Object::FLOAT:
-                    return Object(left.get_float_number() / right.get_float_number());
-                default:
-                    throw TYPE_MISMATCH;
-                }
-            default:
+            return apply_<TypedOperation::Divide>(left, right);
+        }
+
+    private:
+        static bool is_number_(const Object& object) {
+            return object.get_type() == Object::INT || object.get_type() == Object::FLOAT;
+        }
+
+        static bool is_operand_(const Object& object) {
+            return is_number_(object) || object.get_type() == Object::STRING;
+        }
+
+        static double get_float_(const Object& object) {
+            if (object.get_type() == Object::INT)
+                return object.get_int_number();
+            return object.get_float_number();
+        }
+
+        // numbers only
+        template <typename Kernel>
+        static Object apply_(const Object& left, const Object& right) {
+            if (!is_number_(left))
                 throw UNSUPPORTED_OPERATION;
-            }
+            if (!is_number_(right))
+                throw TYPE_MISMATCH;
+
+            if (left.get_type() == Object::INT && right.get_type() == Object::INT)
+                return Object(Kernel::apply(left.get_int_number(), right.get_int_number()));
+            return Object(Kernel::apply(get_float_(left), get_float_(right)));
+        }
+
+        static std::string to_string_(const Object& object) {
+            if (object.get_type() == Object::STRING)
+                return *object.get_string_ptr();
+
+            std::stringstream ss;
+            if (object.get_type() == Object::INT)
+                ss << object.get_int_number();
+            else
+                ss << object.get_float_number();
+            return ss.str();
         }
     };
 }
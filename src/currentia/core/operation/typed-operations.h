@@ -0,0 +1,118 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_TYPED_OPERATIONS_H_
+#define CURRENTIA_TYPED_OPERATIONS_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/schema.h"
+#include "currentia/core/tuple.h"
+
+#include <string>
+#include <type_traits>          // std::common_type
+
+namespace currentia {
+    // Arithmetic on values whose types are known statically (int,
+    // double). Operation applies them to Objects, and operators apply
+    // them to attributes whose types are taken from schemas.
+    namespace TypedOperation {
+        struct Add {
+            template <typename L, typename R>
+            static typename std::common_type<L, R>::type apply(L left, R right) {
+                return left + right;
+            }
+        };
+
+        struct Subtract {
+            template <typename L, typename R>
+            static typename std::common_type<L, R>::type apply(L left, R right) {
+                return left - right;
+            }
+        };
+
+        struct Multiply {
+            template <typename L, typename R>
+            static typename std::common_type<L, R>::type apply(L left, R right) {
+                return left * right;
+            }
+        };
+
+        struct Divide {
+            template <typename L, typename R>
+            static typename std::common_type<L, R>::type apply(L left, R right) {
+                return left / right;
+            }
+        };
+
+        template <typename T>
+        inline
+        T get_value(const Tuple& tuple, int attribute_index);
+
+        template <>
+        inline
+        int get_value<int>(const Tuple& tuple, int attribute_index) {
+            return tuple.get_int_by_index(attribute_index);
+        }
+
+        template <>
+        inline
+        double get_value<double>(const Tuple& tuple, int attribute_index) {
+            return tuple.get_float_by_index(attribute_index);
+        }
+
+        // Sum of an attribute of type T over tuples [begin, end) (an
+        // iterator of Tuple::ptr_t), accumulated as Accumulator
+        template <typename T, typename Accumulator, typename Iterator>
+        inline
+        Accumulator sum(Iterator begin, Iterator end, int attribute_index) {
+            Accumulator accumulator = 0;
+            for (; begin != end; ++begin)
+                accumulator += get_value<T>(**begin, attribute_index);
+            return accumulator;
+        }
+    }
+
+    // A numeric (INT or FLOAT) attribute, resolved once from a schema.
+    // Values are read with the accessor of the attribute type, without
+    // Objects.
+    class NumericAttribute {
+        int attribute_index_;
+        Object::Type attribute_type_;
+
+    public:
+        NumericAttribute(const Schema::ptr_t& schema_ptr, const std::string& attribute_name):
+            attribute_index_(schema_ptr->get_attribute_index_by_name(attribute_name)),
+            attribute_type_(Object::UNKNOWN) {
+            if (attribute_index_ < 0)
+                throw attribute_name + " is not in " + schema_ptr->toString();
+            attribute_type_ = schema_ptr->get_attribute_type_by_index(attribute_index_);
+            if (attribute_type_ != Object::INT && attribute_type_ != Object::FLOAT)
+                throw attribute_name + " is not a number in " + schema_ptr->toString();
+        }
+
+        int get_index() const {
+            return attribute_index_;
+        }
+
+        Object::Type get_type() const {
+            return attribute_type_;
+        }
+
+        double get_float(const Tuple& tuple) const {
+            if (attribute_type_ == Object::INT)
+                return tuple.get_int_by_index(attribute_index_);
+            return tuple.get_float_by_index(attribute_index_);
+        }
+
+        // Sum over tuples [begin, end). INT values are summed exactly
+        // (in 64 bits) and converted at the end.
+        template <typename Iterator>
+        double sum(Iterator begin, Iterator end) const {
+            if (attribute_type_ == Object::INT)
+                return static_cast<double>(
+                    TypedOperation::sum<int, long long>(begin, end, attribute_index_));
+            return TypedOperation::sum<double, double>(begin, end, attribute_index_);
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_TYPED_OPERATIONS_H_ */
@@ -0,0 +1,231 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_AGGREGATE_FUNCTION_H_
+#define CURRENTIA_AGGREGATE_FUNCTION_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/operation/typed-operations.h"
+#include "currentia/core/operator/window-aggregation.h"
+#include "currentia/core/schema.h"
+#include "currentia/core/tuple.h"
+#include "currentia/trait/non-copyable.h"
+#include "currentia/trait/pointable.h"
+
+#include <functional>           // std::less, std::greater
+#include <limits>
+#include <string>
+
+namespace currentia {
+    // An aggregate function of an attribute over the tuples in a
+    // window, updated as they enter (insert()) and leave (evict()) it.
+    // Tuples leave in the order they entered.
+    class AggregateFunction: private NonCopyable<AggregateFunction>,
+                             public Pointable<AggregateFunction> {
+    public:
+        typedef Pointable<AggregateFunction>::ptr_t ptr_t;
+
+        enum Type {
+            SUM,
+            COUNT,
+            MIN,
+            MAX,
+            MEAN
+        };
+
+        static std::string type_to_string(Type type) {
+            switch (type) {
+            case SUM:
+                return "SUM";
+            case COUNT:
+                return "COUNT";
+            case MIN:
+                return "MIN";
+            case MAX:
+                return "MAX";
+            case MEAN:
+                return "MEAN";
+            default:
+                return "UNKNOWN AGGREGATE";
+            }
+        }
+
+        // Throws a std::string when the attribute is missing from the
+        // schema (or is not a number, except for COUNT)
+        static ptr_t create(Type type,
+                            const Schema::ptr_t& schema_ptr,
+                            const std::string& attribute_name);
+
+        // Result of a SUM of INT values (summed exactly in 64 bits);
+        // throws a std::string when it does not fit in an INT
+        static Object int_sum_to_object(long long sum) {
+            if (sum < std::numeric_limits<int>::min() || sum > std::numeric_limits<int>::max())
+                throw std::string("SUM is out of the range of INT");
+            return Object(static_cast<int>(sum));
+        }
+
+        virtual ~AggregateFunction() = 0;
+
+        virtual void clear() = 0;
+        virtual void insert(const Tuple& tuple) = 0;
+        virtual void evict(const Tuple& tuple) = 0;
+
+        // true when the state has drifted from the window, which should
+        // be recompute()d before get_result()
+        virtual bool needs_recomputation() const {
+            return false;
+        }
+
+        virtual Object::Type get_result_type() const = 0;
+        // Result over a non-empty window
+        virtual Object get_result() const = 0;
+
+        // Rebuilds the state from the tuples in the window (an iterator
+        // of Tuple::ptr_t from the oldest; NULL slots are skipped)
+        template <typename Iterator>
+        void recompute(Iterator begin, Iterator end) {
+            clear();
+            for (; begin != end; ++begin) {
+                if (*begin)
+                    insert(**begin);
+            }
+        }
+    };
+    AggregateFunction::~AggregateFunction() {}
+
+    // SUM (of the attribute type) and MEAN (FLOAT)
+    class AggregateSum: public AggregateFunction {
+        SlidingSum sum_;
+        bool mean_;
+
+    public:
+        AggregateSum(const Schema::ptr_t& schema_ptr,
+                     const std::string& attribute_name,
+                     bool mean):
+            sum_(schema_ptr, attribute_name),
+            mean_(mean) {
+        }
+
+        void clear() {
+            sum_.clear();
+        }
+
+        void insert(const Tuple& tuple) {
+            sum_.add(tuple);
+        }
+
+        void evict(const Tuple& tuple) {
+            sum_.remove(tuple);
+        }
+
+        bool needs_recomputation() const {
+            return sum_.needs_recomputation();
+        }
+
+        Object::Type get_result_type() const {
+            return mean_ ? Object::FLOAT : sum_.get_attribute().get_type();
+        }
+
+        Object get_result() const {
+            if (mean_)
+                return Object(sum_.get_sum() / sum_.get_count());
+            if (sum_.get_attribute().get_type() == Object::INT)
+                return int_sum_to_object(sum_.get_int_sum());
+            return Object(sum_.get_sum());
+        }
+    };
+
+    // Number of tuples in the window
+    class AggregateCount: public AggregateFunction {
+        long count_;
+
+    public:
+        AggregateCount(const Schema::ptr_t& schema_ptr,
+                       const std::string& attribute_name):
+            count_(0) {
+            if (schema_ptr->get_attribute_index_by_name(attribute_name) < 0)
+                throw attribute_name + " is not in " + schema_ptr->toString();
+        }
+
+        void clear() {
+            count_ = 0;
+        }
+
+        void insert(const Tuple& tuple) {
+            count_++;
+        }
+
+        void evict(const Tuple& tuple) {
+            count_--;
+        }
+
+        Object::Type get_result_type() const {
+            return Object::INT;
+        }
+
+        Object get_result() const {
+            return Object(count_);
+        }
+    };
+
+    // MIN (Compare = std::less<T>) and MAX (std::greater<T>) of an
+    // attribute of type T
+    template <typename T, typename Compare>
+    class AggregateExtremum: public AggregateFunction {
+        NumericAttribute attribute_;
+        MonotonicDeque<T, Compare> values_;
+
+    public:
+        AggregateExtremum(const Schema::ptr_t& schema_ptr,
+                          const std::string& attribute_name):
+            attribute_(schema_ptr, attribute_name) {
+        }
+
+        void clear() {
+            values_.clear();
+        }
+
+        void insert(const Tuple& tuple) {
+            values_.push(TypedOperation::get_value<T>(tuple, attribute_.get_index()));
+        }
+
+        void evict(const Tuple& tuple) {
+            values_.pop();
+        }
+
+        Object::Type get_result_type() const {
+            return attribute_.get_type();
+        }
+
+        Object get_result() const {
+            return Object(values_.get());
+        }
+    };
+
+    AggregateFunction::ptr_t AggregateFunction::create(Type type,
+                                                       const Schema::ptr_t& schema_ptr,
+                                                       const std::string& attribute_name) {
+        switch (type) {
+        case SUM:
+        case MEAN:
+            return ptr_t(new AggregateSum(schema_ptr, attribute_name, type == MEAN));
+        case COUNT:
+            return ptr_t(new AggregateCount(schema_ptr, attribute_name));
+        case MIN:
+        case MAX: {
+            NumericAttribute attribute(schema_ptr, attribute_name);
+            if (attribute.get_type() == Object::INT) {
+                if (type == MIN)
+                    return ptr_t(new AggregateExtremum<int, std::less<int> >(schema_ptr, attribute_name));
+                return ptr_t(new AggregateExtremum<int, std::greater<int> >(schema_ptr, attribute_name));
+            }
+            if (type == MIN)
+                return ptr_t(new AggregateExtremum<double, std::less<double> >(schema_ptr, attribute_name));
+            return ptr_t(new AggregateExtremum<double, std::greater<double> >(schema_ptr, attribute_name));
+        }
+        default:
+            throw std::string("unknown aggregate function");
+        }
+    }
+}
+
+#endif  /* ! CURRENTIA_AGGREGATE_FUNCTION_H_ */
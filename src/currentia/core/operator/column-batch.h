@@ -0,0 +1,83 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_COLUMN_BATCH_H_
+#define CURRENTIA_COLUMN_BATCH_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/stream.h"
+#include "currentia/core/tuple.h"
+#include "currentia/trait/non-copyable.h"
+
+#include <map>
+#include <vector>
+
+namespace currentia {
+    // Columnar view of a batch of tuples. Numeric attributes are
+    // gathered into contiguous arrays on first request (an INT
+    // attribute may also be requested as doubles), so that predicates
+    // can be evaluated column-at-a-time. Buffers are reused across
+    // batches.
+    class ColumnBatch: private NonCopyable<ColumnBatch> {
+        const Stream::batch_t* tuples_;
+
+        // attribute index -> column (empty until gathered for the
+        // current batch)
+        std::map<int, std::vector<int> > int_columns_;
+        std::map<int, std::vector<double> > float_columns_;
+
+    public:
+        ColumnBatch():
+            tuples_(NULL) {
+        }
+
+        void reset(const Stream::batch_t& tuples) {
+            tuples_ = &tuples;
+            auto int_iter = int_columns_.begin();
+            auto int_iter_end = int_columns_.end();
+            for (; int_iter != int_iter_end; ++int_iter)
+                int_iter->second.clear();
+            auto float_iter = float_columns_.begin();
+            auto float_iter_end = float_columns_.end();
+            for (; float_iter != float_iter_end; ++float_iter)
+                float_iter->second.clear();
+        }
+
+        size_t size() const {
+            return tuples_ ? tuples_->size() : 0;
+        }
+
+        const Tuple::ptr_t& get_tuple(size_t index) const {
+            return (*tuples_)[index];
+        }
+
+        // INT attribute
+        const int* get_int_column(int attribute_index) {
+            std::vector<int>& column = int_columns_[attribute_index];
+            if (column.empty() && size() > 0) {
+                column.resize(size());
+                for (size_t i = 0; i < column.size(); ++i)
+                    column[i] = (*tuples_)[i]->get_int_by_index(attribute_index);
+            }
+            return column.data();
+        }
+
+        // INT or FLOAT attribute
+        const double* get_float_column(int attribute_index, Object::Type attribute_type) {
+            std::vector<double>& column = float_columns_[attribute_index];
+            if (column.empty() && size() > 0) {
+                column.resize(size());
+                if (attribute_type == Object::INT) {
+                    const int* int_column = get_int_column(attribute_index);
+                    for (size_t i = 0; i < column.size(); ++i)
+                        column[i] = int_column[i];
+                } else {
+                    for (size_t i = 0; i < column.size(); ++i)
+                        column[i] = (*tuples_)[i]->get_float_by_index(attribute_index);
+                }
+            }
+            return column.data();
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_COLUMN_BATCH_H_ */
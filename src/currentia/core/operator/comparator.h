@@ -4,6 +4,8 @@
 #define CURRENTIA_COMPARATOR_H_
 
 #include <string>
+#include <algorithm>            // std::min
+#include <cstring>              // memcmp
 
 namespace currentia {
     namespace Comparator {
@@ -34,6 +36,56 @@ namespace currentia {
                 return "UNKNOWN COMPARATOR";
             }
         }
+
+        // "x <type> y" for values of the same type
+        template <typename T>
+        inline
+        bool compare(const T& x, const T& y, Type type) {
+            switch (type) {
+            case EQUAL:
+                return x == y;
+            case NOT_EQUAL:
+                return x != y;
+            case LESS_THAN:
+                return x < y;
+            case LESS_THAN_EQUAL:
+                return x <= y;
+            case GREATER_THAN:
+                return x > y;
+            case GREATER_THAN_EQUAL:
+                return x >= y;
+            default:
+                return false;
+            }
+        }
+
+        // Same as std::string comparison, for strings not held by
+        // std::string
+        inline
+        bool compare_strings(const char* x, size_t x_length,
+                             const char* y, size_t y_length,
+                             Type type) {
+            int result = std::memcmp(x, y, std::min(x_length, y_length));
+            if (result == 0)
+                result = x_length < y_length ? -1 : (x_length > y_length ? 1 : 0);
+            return compare(result, 0, type);
+        }
+
+        // Returns the comparator for swapped operands ("a < b" <=> "b > a")
+        Type mirror(Type type) {
+            switch (type) {
+            case LESS_THAN:
+                return GREATER_THAN;
+            case LESS_THAN_EQUAL:
+                return GREATER_THAN_EQUAL;
+            case GREATER_THAN:
+                return LESS_THAN;
+            case GREATER_THAN_EQUAL:
+                return LESS_THAN_EQUAL;
+            default:
+                return type;
+            }
+        }
     }
 }
 
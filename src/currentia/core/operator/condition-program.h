@@ -0,0 +1,369 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_CONDITION_PROGRAM_H_
+#define CURRENTIA_CONDITION_PROGRAM_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/tuple.h"
+#include "currentia/core/operator/comparator.h"
+#include "currentia/core/operator/condition.h"
+#include "currentia/trait/non-copyable.h"
+#include "currentia/trait/pointable.h"
+
+#include <string>
+#include <type_traits>          // std::common_type
+#include <utility>              // std::swap
+#include <vector>
+
+namespace currentia {
+    // A condition lowered into a flat program. Each comparison becomes
+    // an instruction calling a comparator instantiated for its operand
+    // types and comparison operator, and AND / OR / negation become
+    // jumps between instructions (short-circuit evaluation). Compile
+    // after obey_schema() (and to_cnf(), if used); comparisons whose
+    // types were not resolved fall back to Condition::check().
+    //
+    // An adaptive program samples one in SAMPLING_INTERVAL checks
+    // (Condition::sample()), and every REORDERING_INTERVAL samples
+    // reorders the terms of the condition by their selectivities and
+    // costs (Condition::reorder()) and recompiles itself.
+    class ConditionProgram: private NonCopyable<ConditionProgram>,
+                            public Pointable<ConditionProgram> {
+        struct Instruction;
+        typedef bool (*evaluate_t)(const Instruction& instruction,
+                                   const Tuple::ptr_t& left_tuple_ptr,
+                                   const Tuple::ptr_t& right_tuple_ptr);
+
+        struct Instruction {
+            evaluate_t evaluate;
+            // next instruction when the comparison holds / fails
+            // (or ACCEPT / REJECT)
+            int on_true;
+            int on_false;
+
+            // operands
+            bool reads_right_tuple; // for comparisons with a constant
+            int left_attribute_index;
+            int right_attribute_index;
+            int int_constant;
+            double float_constant;
+            std::string string_constant;
+
+            // for comparisons not compiled
+            Condition::ptr_t condition;
+        };
+
+        static const int ACCEPT = -1;
+        static const int REJECT = -2;
+
+        Condition::ptr_t condition_;
+        std::vector<Instruction> instructions_;
+        bool has_attribute_comparison_;
+
+        bool adaptive_;
+        long checks_count_;
+        long samples_count_;
+
+        ConditionProgram(const Condition::ptr_t& condition, bool adaptive):
+            condition_(condition),
+            has_attribute_comparison_(false),
+            adaptive_(adaptive),
+            checks_count_(0),
+            samples_count_(0) {
+            compile_(condition_, ACCEPT, REJECT);
+            // nothing to reorder without conjunctives
+            if (instructions_.size() < 2)
+                adaptive_ = false;
+        }
+
+    public:
+        static const long SAMPLING_INTERVAL = 64;
+        static const long REORDERING_INTERVAL = 256;
+
+        static ConditionProgram::ptr_t compile(const Condition::ptr_t& condition, bool adaptive = true) {
+            return ConditionProgram::ptr_t(new ConditionProgram(condition, adaptive));
+        }
+
+        // for selection
+        bool check(const Tuple::ptr_t& tuple_ptr) {
+            if (has_attribute_comparison_)
+                throw std::string("ConditionAttributeComparator doesn't support comparison of tuple and constant");
+            if (adaptive_)
+                adapt_(tuple_ptr, tuple_ptr);
+            return run_(tuple_ptr, tuple_ptr);
+        }
+
+        // for join
+        bool check(const Tuple::ptr_t& left_tuple_ptr, const Tuple::ptr_t& right_tuple_ptr) {
+            if (adaptive_)
+                adapt_(left_tuple_ptr, right_tuple_ptr);
+            return run_(left_tuple_ptr, right_tuple_ptr);
+        }
+
+        // Reorders the condition and recompiles (done periodically by
+        // adaptive programs)
+        void reorder() {
+            condition_->reorder();
+            instructions_.clear();
+            has_attribute_comparison_ = false;
+            compile_(condition_, ACCEPT, REJECT);
+        }
+
+        size_t size() const {
+            return instructions_.size();
+        }
+
+    private:
+        void adapt_(const Tuple::ptr_t& left_tuple_ptr, const Tuple::ptr_t& right_tuple_ptr) {
+            if (++checks_count_ % SAMPLING_INTERVAL != 0)
+                return;
+            condition_->sample(left_tuple_ptr, right_tuple_ptr);
+            if (++samples_count_ % REORDERING_INTERVAL == 0)
+                reorder();
+        }
+
+        bool run_(const Tuple::ptr_t& left_tuple_ptr, const Tuple::ptr_t& right_tuple_ptr) const {
+            int next = 0;
+            do {
+                const Instruction& instruction = instructions_[next];
+                next = instruction.evaluate(instruction, left_tuple_ptr, right_tuple_ptr)
+                    ? instruction.on_true
+                    : instruction.on_false;
+            } while (next >= 0);
+            return next == ACCEPT;
+        }
+
+        // Compilation
+
+        static int count_comparisons_(const Condition::ptr_t& condition) {
+            ConditionConjunctive::ptr_t conjunctive =
+                std::dynamic_pointer_cast<ConditionConjunctive>(condition);
+            if (!conjunctive)
+                return 1;
+            return count_comparisons_(conjunctive->get_left_condition()) +
+                count_comparisons_(conjunctive->get_right_condition());
+        }
+
+        void compile_(const Condition::ptr_t& condition, int on_true, int on_false) {
+            if (condition->is_negated())
+                std::swap(on_true, on_false);
+
+            ConditionConjunctive::ptr_t conjunctive =
+                std::dynamic_pointer_cast<ConditionConjunctive>(condition);
+            if (!conjunctive) {
+                instructions_.push_back(lower_comparison_(condition));
+                instructions_.back().on_true = on_true;
+                instructions_.back().on_false = on_false;
+                return;
+            }
+
+            // comparisons of the right condition follow those of the left one
+            int right_start = instructions_.size() +
+                count_comparisons_(conjunctive->get_left_condition());
+            if (conjunctive->get_type() == ConditionConjunctive::AND)
+                compile_(conjunctive->get_left_condition(), right_start, on_false);
+            else
+                compile_(conjunctive->get_left_condition(), on_true, right_start);
+            compile_(conjunctive->get_right_condition(), on_true, on_false);
+        }
+
+        Instruction lower_comparison_(const Condition::ptr_t& condition) {
+            Instruction instruction;
+            instruction.evaluate = NULL;
+            instruction.reads_right_tuple = false;
+            instruction.left_attribute_index = -1;
+            instruction.right_attribute_index = -1;
+            instruction.int_constant = 0;
+            instruction.float_constant = 0;
+
+            ConditionConstantComparator::ptr_t constant_comparator =
+                std::dynamic_pointer_cast<ConditionConstantComparator>(condition);
+            ConditionAttributeComparator::ptr_t attribute_comparator =
+                std::dynamic_pointer_cast<ConditionAttributeComparator>(condition);
+
+            if (constant_comparator) {
+                Object value = constant_comparator->get_condition_value();
+                instruction.reads_right_tuple = !constant_comparator->target_tuple_is_left();
+                instruction.left_attribute_index = constant_comparator->get_target_attribute_index();
+                switch (constant_comparator->get_value_comparison()) {
+                case COMPARE_INTS:
+                    instruction.int_constant = value.get_int_number();
+                    break;
+                case COMPARE_FLOATS:
+                    instruction.float_constant = value.cast_to(Object::FLOAT).get_float_number();
+                    break;
+                case COMPARE_STRINGS:
+                    instruction.string_constant = *value.get_string_ptr();
+                    break;
+                default:
+                    break;
+                }
+                instruction.evaluate = select_kernel_(constant_comparator->get_target_comparator_type(),
+                                                      constant_comparator->get_value_comparison(),
+                                                      constant_comparator->get_target_attribute_type(),
+                                                      value.get_type(),
+                                                      true);
+            } else if (attribute_comparator) {
+                has_attribute_comparison_ = true;
+                instruction.left_attribute_index = attribute_comparator->get_left_attribute_index();
+                instruction.right_attribute_index = attribute_comparator->get_right_attribute_index();
+                instruction.evaluate = select_kernel_(attribute_comparator->get_comparator_type(),
+                                                      attribute_comparator->get_value_comparison(),
+                                                      attribute_comparator->get_left_attribute_type(),
+                                                      attribute_comparator->get_right_attribute_type(),
+                                                      false);
+            }
+
+            if (!instruction.evaluate) {
+                instruction.condition = condition;
+                instruction.evaluate = &compare_by_condition_;
+            }
+
+            return instruction;
+        }
+
+        static evaluate_t select_kernel_(Comparator::Type comparator,
+                                         ValueComparison value_comparison,
+                                         Object::Type left_type,
+                                         Object::Type right_type,
+                                         bool with_constant) {
+            switch (comparator) {
+            case Comparator::EQUAL:
+                return select_kernel_for_<Comparator::EQUAL>(value_comparison, left_type, right_type, with_constant);
+            case Comparator::NOT_EQUAL:
+                return select_kernel_for_<Comparator::NOT_EQUAL>(value_comparison, left_type, right_type, with_constant);
+            case Comparator::LESS_THAN:
+                return select_kernel_for_<Comparator::LESS_THAN>(value_comparison, left_type, right_type, with_constant);
+            case Comparator::LESS_THAN_EQUAL:
+                return select_kernel_for_<Comparator::LESS_THAN_EQUAL>(value_comparison, left_type, right_type, with_constant);
+            case Comparator::GREATER_THAN:
+                return select_kernel_for_<Comparator::GREATER_THAN>(value_comparison, left_type, right_type, with_constant);
+            case Comparator::GREATER_THAN_EQUAL:
+                return select_kernel_for_<Comparator::GREATER_THAN_EQUAL>(value_comparison, left_type, right_type, with_constant);
+            default:
+                return NULL;
+            }
+        }
+
+        template <Comparator::Type Op>
+        static evaluate_t select_kernel_for_(ValueComparison value_comparison,
+                                             Object::Type left_type,
+                                             Object::Type right_type,
+                                             bool with_constant) {
+            switch (value_comparison) {
+            case COMPARE_INTS:
+                return with_constant
+                    ? &compare_constant_<Op, int, int>
+                    : &compare_attributes_<Op, int, int>;
+            case COMPARE_FLOATS:
+                if (with_constant) {
+                    if (left_type == Object::INT)
+                        return &compare_constant_<Op, int, double>;
+                    return &compare_constant_<Op, double, double>;
+                }
+                if (left_type == Object::INT)
+                    return right_type == Object::INT
+                        ? &compare_attributes_<Op, int, int>
+                        : &compare_attributes_<Op, int, double>;
+                return right_type == Object::INT
+                    ? &compare_attributes_<Op, double, int>
+                    : &compare_attributes_<Op, double, double>;
+            case COMPARE_STRINGS:
+                return with_constant
+                    ? &compare_string_constant_<Op>
+                    : &compare_string_attributes_<Op>;
+            default:
+                return NULL;
+            }
+        }
+
+        // Kernels
+
+        template <typename T>
+        static T read_(const Tuple& tuple, int attribute_index);
+
+        template <typename T>
+        static T constant_(const Instruction& instruction);
+
+        template <Comparator::Type Op, typename Column, typename Constant>
+        static bool compare_constant_(const Instruction& instruction,
+                                      const Tuple::ptr_t& left_tuple_ptr,
+                                      const Tuple::ptr_t& right_tuple_ptr) {
+            const Tuple& tuple = instruction.reads_right_tuple ? *right_tuple_ptr : *left_tuple_ptr;
+            return Comparator::compare<Constant>(read_<Column>(tuple, instruction.left_attribute_index),
+                                                 constant_<Constant>(instruction),
+                                                 Op);
+        }
+
+        template <Comparator::Type Op, typename Left, typename Right>
+        static bool compare_attributes_(const Instruction& instruction,
+                                        const Tuple::ptr_t& left_tuple_ptr,
+                                        const Tuple::ptr_t& right_tuple_ptr) {
+            typedef typename std::common_type<Left, Right>::type value_t;
+            return Comparator::compare<value_t>(read_<Left>(*left_tuple_ptr, instruction.left_attribute_index),
+                                                read_<Right>(*right_tuple_ptr, instruction.right_attribute_index),
+                                                Op);
+        }
+
+        template <Comparator::Type Op>
+        static bool compare_string_constant_(const Instruction& instruction,
+                                             const Tuple::ptr_t& left_tuple_ptr,
+                                             const Tuple::ptr_t& right_tuple_ptr) {
+            const Tuple& tuple = instruction.reads_right_tuple ? *right_tuple_ptr : *left_tuple_ptr;
+            size_t length;
+            const char* data = tuple.get_string_data_by_index(instruction.left_attribute_index, length);
+            return Comparator::compare_strings(data, length,
+                                               instruction.string_constant.data(),
+                                               instruction.string_constant.size(),
+                                               Op);
+        }
+
+        template <Comparator::Type Op>
+        static bool compare_string_attributes_(const Instruction& instruction,
+                                               const Tuple::ptr_t& left_tuple_ptr,
+                                               const Tuple::ptr_t& right_tuple_ptr) {
+            size_t left_length, right_length;
+            const char* left_data =
+                left_tuple_ptr->get_string_data_by_index(instruction.left_attribute_index, left_length);
+            const char* right_data =
+                right_tuple_ptr->get_string_data_by_index(instruction.right_attribute_index, right_length);
+            return Comparator::compare_strings(left_data, left_length, right_data, right_length, Op);
+        }
+
+        // Negation is compiled into jumps, so undo the one applied by
+        // check(). Both comparators accept (left, right) for selection,
+        // where left and right are the same tuple.
+        static bool compare_by_condition_(const Instruction& instruction,
+                                          const Tuple::ptr_t& left_tuple_ptr,
+                                          const Tuple::ptr_t& right_tuple_ptr) {
+            return instruction.condition->is_negated() !=
+                instruction.condition->check(left_tuple_ptr, right_tuple_ptr);
+        }
+    };
+
+    template <>
+    inline
+    int ConditionProgram::read_<int>(const Tuple& tuple, int attribute_index) {
+        return tuple.get_int_by_index(attribute_index);
+    }
+
+    template <>
+    inline
+    double ConditionProgram::read_<double>(const Tuple& tuple, int attribute_index) {
+        return tuple.get_float_by_index(attribute_index);
+    }
+
+    template <>
+    inline
+    int ConditionProgram::constant_<int>(const Instruction& instruction) {
+        return instruction.int_constant;
+    }
+
+    template <>
+    inline
+    double ConditionProgram::constant_<double>(const Instruction& instruction) {
+        return instruction.float_constant;
+    }
+}
+
+#endif  /* ! CURRENTIA_CONDITION_PROGRAM_H_ */
@@ -11,7 +11,9 @@
 #include "currentia/trait/pointable.h"
 #include "currentia/trait/show.h"
 
+#include <algorithm>            // std::stable_sort
 #include <list>
+#include <vector>
 
 namespace currentia {
     class Condition: private NonCopyable<Condition>,
@@ -20,20 +22,45 @@ namespace currentia {
     protected:
         bool negated_;
 
+        // evaluations recorded by sample()
+        mutable long sampled_count_;
+        mutable long satisfied_count_;
+
+        bool record_sample_(bool satisfied) const {
+            sampled_count_++;
+            if (satisfied)
+                satisfied_count_++;
+            return satisfied;
+        }
+
+        // older samples weigh less, as selectivities drift
+        void decay_statistics_() {
+            sampled_count_ /= 2;
+            satisfied_count_ /= 2;
+        }
+
     public:
-        Condition(): negated_(false) {}
+        Condition():
+            negated_(false),
+            sampled_count_(0),
+            satisfied_count_(0) {
+        }
         virtual ~Condition() = 0;
 
         // for selection
-        virtual bool check(Tuple::ptr_t tuple_ptr) const = 0;
+        virtual bool check(const Tuple::ptr_t& tuple_ptr) const = 0;
         // for join
-        virtual bool check(Tuple::ptr_t left_tuple_ptr, Tuple::ptr_t right_tuple_ptr) const = 0;
+        virtual bool check(const Tuple::ptr_t& left_tuple_ptr, const Tuple::ptr_t& right_tuple_ptr) const = 0;
 
         Condition* negate() {
             negated_ = !negated_;
             return this;
         }
 
+        bool is_negated() const {
+            return negated_;
+        }
+
         virtual void obey_schema(const Schema::ptr_t& left_schema,
                                  const Schema::ptr_t& right_schema) = 0;
         virtual void de_morgen() {}
@@ -43,6 +70,34 @@ namespace currentia {
         virtual std::string to_string_expression() const = 0;
         virtual bool equal_to(const Condition::ptr_t& target_condition) const = 0;
 
+        // Same expression, without schema and statistics (programs
+        // reorder their conditions, so each operator evaluating a
+        // condition on its own thread needs its own copy)
+        virtual Condition::ptr_t clone() const = 0;
+
+        // Same as check(), but evaluates every term (no short-circuit)
+        // and records how often each of them holds. For selection, pass
+        // the tuple as both tuples.
+        virtual bool sample(const Tuple::ptr_t& left_tuple_ptr, const Tuple::ptr_t& right_tuple_ptr) const {
+            return record_sample_(check(left_tuple_ptr, right_tuple_ptr));
+        }
+
+        // Reorders terms of conjunctives by the statistics recorded so
+        // far (see ConditionConjunctive::reorder())
+        virtual void reorder() {
+            decay_statistics_();
+        }
+
+        // Estimated cost of an evaluation (a comparison of integers
+        // costs 1)
+        virtual double get_cost() const = 0;
+
+        // Fraction of sampled evaluations which held (smoothed, so
+        // that it is 0.5 before any sample)
+        double get_selectivity() const {
+            return (satisfied_count_ + 1.0) / (sampled_count_ + 2.0);
+        }
+
         std::string toString() const {
             std::string str_expression = to_string_expression();
 
@@ -90,26 +145,26 @@ namespace currentia {
             right_condition_(right_condition) {
         }
 
-        bool check(Tuple::ptr_t tuple_ptr) const {
+        bool check(const Tuple::ptr_t& tuple_ptr) const {
             switch (type_) {
             case ConditionConjunctive::AND:
-                return left_condition_->check(tuple_ptr)
-                    && right_condition_->check(tuple_ptr);
+                return negated_ != (left_condition_->check(tuple_ptr)
+                                    && right_condition_->check(tuple_ptr));
             case ConditionConjunctive::OR:
-                return left_condition_->check(tuple_ptr)
-                    || right_condition_->check(tuple_ptr);
+                return negated_ != (left_condition_->check(tuple_ptr)
+                                    || right_condition_->check(tuple_ptr));
             }
             throw "Expected AND / OR";
         }
 
-        bool check(Tuple::ptr_t left_tuple_ptr, Tuple::ptr_t right_tuple_ptr) const {
+        bool check(const Tuple::ptr_t& left_tuple_ptr, const Tuple::ptr_t& right_tuple_ptr) const {
             switch (type_) {
             case ConditionConjunctive::AND:
-                return left_condition_->check(left_tuple_ptr, right_tuple_ptr)
-                    && right_condition_->check(left_tuple_ptr, right_tuple_ptr);
+                return negated_ != (left_condition_->check(left_tuple_ptr, right_tuple_ptr)
+                                    && right_condition_->check(left_tuple_ptr, right_tuple_ptr));
             case ConditionConjunctive::OR:
-                return left_condition_->check(left_tuple_ptr, right_tuple_ptr)
-                    || right_condition_->check(left_tuple_ptr, right_tuple_ptr);
+                return negated_ != (left_condition_->check(left_tuple_ptr, right_tuple_ptr)
+                                    || right_condition_->check(left_tuple_ptr, right_tuple_ptr));
             }
             throw "Expected AND / OR";
         }
@@ -120,6 +175,50 @@ namespace currentia {
             right_condition_->obey_schema(left_schema, right_schema);
         }
 
+        bool sample(const Tuple::ptr_t& left_tuple_ptr, const Tuple::ptr_t& right_tuple_ptr) const {
+            bool left_satisfied = left_condition_->sample(left_tuple_ptr, right_tuple_ptr);
+            bool right_satisfied = right_condition_->sample(left_tuple_ptr, right_tuple_ptr);
+            return record_sample_(negated_ != (type_ == AND
+                                               ? left_satisfied && right_satisfied
+                                               : left_satisfied || right_satisfied));
+        }
+
+        // Rebuilds the chain of terms joined by this conjunctive (terms
+        // of nested conjunctives of the same type included) so that
+        // terms which decide the result cheaply come first: for AND,
+        // cheap terms likely to fail, and for OR, cheap terms likely to
+        // hold.
+        void reorder() {
+            std::vector<Condition::ptr_t> terms;
+            collect_terms_(left_condition_, terms);
+            collect_terms_(right_condition_, terms);
+
+            auto iter = terms.begin();
+            auto iter_end = terms.end();
+            for (; iter != iter_end; ++iter)
+                (*iter)->reorder();
+
+            bool is_and = type_ == AND;
+            std::stable_sort(terms.begin(), terms.end(),
+                             [is_and](const Condition::ptr_t& x, const Condition::ptr_t& y) {
+                                 return get_rank_(x, is_and) < get_rank_(y, is_and);
+                             });
+
+            Condition::ptr_t rest = terms.back();
+            for (size_t i = terms.size() - 2; i > 0; --i)
+                rest = Condition::ptr_t(new ConditionConjunctive(terms[i], rest, type_));
+            left_condition_ = terms.front();
+            right_condition_ = rest;
+
+            decay_statistics_();
+        }
+
+        double get_cost() const {
+            double left_selectivity = left_condition_->get_selectivity();
+            return left_condition_->get_cost() +
+                (type_ == AND ? left_selectivity : 1 - left_selectivity) * right_condition_->get_cost();
+        }
+
         void de_morgen() {
             negate();
             type_ = type_ == AND ? OR : AND;
@@ -206,6 +305,15 @@ namespace currentia {
             return result;
         }
 
+        Condition::ptr_t clone() const {
+            Condition* condition = new ConditionConjunctive(left_condition_->clone(),
+                                                            right_condition_->clone(),
+                                                            type_);
+            if (negated_)
+                condition->negate();
+            return Condition::ptr_t(condition);
+        }
+
         std::string to_string_expression() const {
             return left_condition_->toString() +
                 conjunctive_type_to_string(type_) +
@@ -221,12 +329,74 @@ namespace currentia {
         }
 
         Condition::ptr_t get_right_condition() const {
-            return left_condition_;
+            return right_condition_;
+        }
+
+    private:
+        void collect_terms_(const Condition::ptr_t& condition, std::vector<Condition::ptr_t>& terms) const {
+            ConditionConjunctive::ptr_t conjunctive =
+                std::dynamic_pointer_cast<ConditionConjunctive>(condition);
+            if (conjunctive && !conjunctive->is_negated() && conjunctive->get_type() == type_) {
+                collect_terms_(conjunctive->get_left_condition(), terms);
+                collect_terms_(conjunctive->get_right_condition(), terms);
+            } else {
+                terms.push_back(condition);
+            }
+        }
+
+        // expected cost per decided evaluation (smaller first)
+        static double get_rank_(const Condition::ptr_t& term, bool is_and) {
+            double deciding_rate = is_and ? 1 - term->get_selectivity() : term->get_selectivity();
+            return term->get_cost() / deciding_rate;
         }
     };
 
     // Comparator
 
+    // How a comparator compares its operands, decided from their types
+    // when the condition obeys schemas
+    enum ValueComparison {
+        COMPARE_INTS,
+        COMPARE_FLOATS,         // INT and FLOAT (compared as FLOAT)
+        COMPARE_STRINGS,
+        COMPARE_OBJECTS         // others, or before obeying schemas
+    };
+
+    inline
+    ValueComparison decide_value_comparison(Object::Type left_type, Object::Type right_type) {
+        bool left_is_number = left_type == Object::INT || left_type == Object::FLOAT;
+        bool right_is_number = right_type == Object::INT || right_type == Object::FLOAT;
+
+        if (left_type == Object::INT && right_type == Object::INT)
+            return COMPARE_INTS;
+        if (left_is_number && right_is_number)
+            return COMPARE_FLOATS;
+        if (left_type == Object::STRING && right_type == Object::STRING)
+            return COMPARE_STRINGS;
+        return COMPARE_OBJECTS;
+    }
+
+    // relative to a comparison of integers
+    inline
+    double get_comparison_cost(ValueComparison value_comparison) {
+        switch (value_comparison) {
+        case COMPARE_INTS:
+        case COMPARE_FLOATS:
+            return 1;
+        case COMPARE_STRINGS:
+            return 4;
+        default:
+            return 16;
+        }
+    }
+
+    inline
+    double get_value_as_float(const Tuple& tuple, int attribute_index, Object::Type type) {
+        if (type == Object::INT)
+            return tuple.get_int_by_index(attribute_index);
+        return tuple.get_float_by_index(attribute_index);
+    }
+
     class ConditionConstantComparator: public Condition,
                                        public Pointable<ConditionConstantComparator> {
     public:
@@ -239,6 +409,12 @@ namespace currentia {
         Object condition_value_;
         bool target_tuple_is_left_;
 
+        // resolved by obey_schema()
+        int target_attribute_index_;
+        Object::Type target_attribute_type_;
+        ValueComparison value_comparison_;
+        double condition_float_value_;
+
     public:
         ConditionConstantComparator(std::string target_attribute_name,
                                     Comparator::Type comparator_type,
@@ -246,34 +422,83 @@ namespace currentia {
             target_attribute_name_(target_attribute_name),
             comparator_type_(comparator_type),
             condition_value_(condition_value),
-            target_tuple_is_left_(true) {
-        }
+            target_tuple_is_left_(true),
+            target_attribute_index_(-1),
+            target_attribute_type_(Object::UNKNOWN),
+            value_comparison_(COMPARE_OBJECTS),
+            condition_float_value_(0) {
+        }
+
+        bool check(const Tuple::ptr_t& tuple_ptr) const {
+            return negated_ != compare(tuple_ptr);
+        }
+
+        // check() ignoring negation
+        bool compare(const Tuple::ptr_t& tuple_ptr) const {
+            switch (value_comparison_) {
+            case COMPARE_INTS:
+                return Comparator::compare(tuple_ptr->get_int_by_index(target_attribute_index_),
+                                           condition_value_.get_int_number(),
+                                           comparator_type_);
+            case COMPARE_FLOATS:
+                return Comparator::compare(get_value_as_float(*tuple_ptr,
+                                                              target_attribute_index_,
+                                                              target_attribute_type_),
+                                           condition_float_value_,
+                                           comparator_type_);
+            case COMPARE_STRINGS: {
+                size_t length;
+                const char* data = tuple_ptr->get_string_data_by_index(target_attribute_index_, length);
+                const std::string& condition_string = *condition_value_.get_string_ptr();
+                return Comparator::compare_strings(data, length,
+                                                   condition_string.data(), condition_string.size(),
+                                                   comparator_type_);
+            }
+            default:
+                break;
+            }
 
-        bool check(Tuple::ptr_t tuple_ptr) const {
-            Object target_value = tuple_ptr->
-                                  get_value_by_attribute_name(target_attribute_name_);
+            Object target_value = target_attribute_index_ >= 0
+                ? tuple_ptr->get_value_by_index(target_attribute_index_)
+                : tuple_ptr->get_value_by_attribute_name(target_attribute_name_);
             return target_value.compare(condition_value_, comparator_type_);
         }
 
-        bool check(Tuple::ptr_t left_tuple_ptr, Tuple::ptr_t right_tuple_ptr) const {
+        bool check(const Tuple::ptr_t& left_tuple_ptr, const Tuple::ptr_t& right_tuple_ptr) const {
             if (target_tuple_is_left_)
                 return check(left_tuple_ptr);
             else
                 return check(right_tuple_ptr);
         }
 
+        bool compare(const Tuple::ptr_t& left_tuple_ptr, const Tuple::ptr_t& right_tuple_ptr) const {
+            return compare(target_tuple_is_left_ ? left_tuple_ptr : right_tuple_ptr);
+        }
+
         void obey_schema(const Schema::ptr_t& left_schema,
                          const Schema::ptr_t& right_schema) {
             if (left_schema->has_attribute(target_attribute_name_)) {
                 target_tuple_is_left_ = true;
-            } else if (left_schema->has_attribute(target_attribute_name_)) {
+            } else if (right_schema->has_attribute(target_attribute_name_)) {
                 target_tuple_is_left_ = false;
             } else {
                 std::stringstream ss;
                 ss << "Attribute in (" << this->toString()
                    << ") is missing in schemas " << left_schema->toString()
                    << " and " << right_schema->toString();
+                throw ss.str();
             }
+
+            const Schema::ptr_t& target_schema = target_tuple_is_left_ ? left_schema : right_schema;
+            target_attribute_index_ = target_schema->get_attribute_index_by_name(target_attribute_name_);
+            target_attribute_type_ = target_schema->get_attribute_type_by_index(target_attribute_index_);
+            value_comparison_ = decide_value_comparison(target_attribute_type_, condition_value_.get_type());
+            if (value_comparison_ == COMPARE_FLOATS)
+                condition_float_value_ = condition_value_.cast_to(Object::FLOAT).get_float_number();
+        }
+
+        double get_cost() const {
+            return get_comparison_cost(value_comparison_);
         }
 
         std::string to_string_expression() const {
@@ -294,6 +519,23 @@ namespace currentia {
             return condition_value_;
         }
 
+        bool target_tuple_is_left() const {
+            return target_tuple_is_left_;
+        }
+
+        // -1 before obey_schema()
+        int get_target_attribute_index() const {
+            return target_attribute_index_;
+        }
+
+        Object::Type get_target_attribute_type() const {
+            return target_attribute_type_;
+        }
+
+        ValueComparison get_value_comparison() const {
+            return value_comparison_;
+        }
+
         bool equal_to(const Condition::ptr_t& target_condition) const {
             ConditionConstantComparator::ptr_t target_constant_comparator =
                 std::dynamic_pointer_cast<ConditionConstantComparator>(target_condition);
@@ -305,6 +547,15 @@ namespace currentia {
 
             return result;
         }
+
+        Condition::ptr_t clone() const {
+            Condition* condition = new ConditionConstantComparator(target_attribute_name_,
+                                                                   comparator_type_,
+                                                                   condition_value_);
+            if (negated_)
+                condition->negate();
+            return Condition::ptr_t(condition);
+        }
     };
 
     class ConditionAttributeComparator: public Condition,
@@ -313,6 +564,13 @@ namespace currentia {
         std::string right_attribute_name_;
         Comparator::Type comparator_type_;
 
+        // resolved by obey_schema()
+        int left_attribute_index_;
+        int right_attribute_index_;
+        Object::Type left_attribute_type_;
+        Object::Type right_attribute_type_;
+        ValueComparison value_comparison_;
+
     public:
         typedef Pointable<ConditionAttributeComparator>::ptr_t ptr_t;
 
@@ -321,20 +579,59 @@ namespace currentia {
                                      std::string right_attribute_name):
             left_attribute_name_(left_attribute_name),
             right_attribute_name_(right_attribute_name),
-            comparator_type_(comparator_type) {
+            comparator_type_(comparator_type),
+            left_attribute_index_(-1),
+            right_attribute_index_(-1),
+            left_attribute_type_(Object::UNKNOWN),
+            right_attribute_type_(Object::UNKNOWN),
+            value_comparison_(COMPARE_OBJECTS) {
         }
 
-        bool check(Tuple::ptr_t tuple_ptr) const {
+        bool check(const Tuple::ptr_t& tuple_ptr) const {
             std::stringstream ss;
             ss << "ConditionAttributeComparator doesn't support comparison of tuple and constant";
             throw ss.str();
         }
 
-        bool check(Tuple::ptr_t left_tuple_ptr, Tuple::ptr_t right_tuple_ptr) const {
-            Object left_tuple_value = left_tuple_ptr->
-                                      get_value_by_attribute_name(left_attribute_name_);
-            Object right_tuple_value = right_tuple_ptr->
-                                       get_value_by_attribute_name(right_attribute_name_);
+        bool check(const Tuple::ptr_t& left_tuple_ptr, const Tuple::ptr_t& right_tuple_ptr) const {
+            return negated_ != compare(left_tuple_ptr, right_tuple_ptr);
+        }
+
+        // check() ignoring negation
+        bool compare(const Tuple::ptr_t& left_tuple_ptr, const Tuple::ptr_t& right_tuple_ptr) const {
+            switch (value_comparison_) {
+            case COMPARE_INTS:
+                return Comparator::compare(left_tuple_ptr->get_int_by_index(left_attribute_index_),
+                                           right_tuple_ptr->get_int_by_index(right_attribute_index_),
+                                           comparator_type_);
+            case COMPARE_FLOATS:
+                return Comparator::compare(get_value_as_float(*left_tuple_ptr,
+                                                              left_attribute_index_,
+                                                              left_attribute_type_),
+                                           get_value_as_float(*right_tuple_ptr,
+                                                              right_attribute_index_,
+                                                              right_attribute_type_),
+                                           comparator_type_);
+            case COMPARE_STRINGS: {
+                size_t left_length, right_length;
+                const char* left_data =
+                    left_tuple_ptr->get_string_data_by_index(left_attribute_index_, left_length);
+                const char* right_data =
+                    right_tuple_ptr->get_string_data_by_index(right_attribute_index_, right_length);
+                return Comparator::compare_strings(left_data, left_length,
+                                                   right_data, right_length,
+                                                   comparator_type_);
+            }
+            default:
+                break;
+            }
+
+            Object left_tuple_value = left_attribute_index_ >= 0
+                ? left_tuple_ptr->get_value_by_index(left_attribute_index_)
+                : left_tuple_ptr->get_value_by_attribute_name(left_attribute_name_);
+            Object right_tuple_value = right_attribute_index_ >= 0
+                ? right_tuple_ptr->get_value_by_index(right_attribute_index_)
+                : right_tuple_ptr->get_value_by_attribute_name(right_attribute_name_);
             return left_tuple_value.compare(right_tuple_value, comparator_type_);
         }
 
@@ -344,6 +641,7 @@ namespace currentia {
             if (left_schema->has_attribute(left_attribute_name_) &&
                 right_schema->has_attribute(right_attribute_name_)) {
                 // as is
+                resolve_attributes_(left_schema, right_schema);
                 return;
             }
 
@@ -353,6 +651,8 @@ namespace currentia {
                 std::string saved_left_attribute = left_attribute_name_;
                 left_attribute_name_ = right_attribute_name_;
                 right_attribute_name_ = saved_left_attribute;
+                comparator_type_ = Comparator::mirror(comparator_type_);
+                resolve_attributes_(left_schema, right_schema);
                 return;
             }
 
@@ -364,6 +664,10 @@ namespace currentia {
             throw ss.str();
         }
 
+        double get_cost() const {
+            return get_comparison_cost(value_comparison_);
+        }
+
         std::string to_string_expression() const {
             return left_attribute_name_ + " " +
                 comparator_to_string(comparator_type_) + " " +
@@ -382,6 +686,27 @@ namespace currentia {
             return comparator_type_;
         }
 
+        // -1 before obey_schema()
+        int get_left_attribute_index() const {
+            return left_attribute_index_;
+        }
+
+        int get_right_attribute_index() const {
+            return right_attribute_index_;
+        }
+
+        Object::Type get_left_attribute_type() const {
+            return left_attribute_type_;
+        }
+
+        Object::Type get_right_attribute_type() const {
+            return right_attribute_type_;
+        }
+
+        ValueComparison get_value_comparison() const {
+            return value_comparison_;
+        }
+
         bool equal_to(const Condition::ptr_t& target_condition) const {
             ConditionAttributeComparator::ptr_t target_attribute_comparator =
                 std::dynamic_pointer_cast<ConditionAttributeComparator>(target_condition);
@@ -394,7 +719,56 @@ namespace currentia {
 
             return result;
         }
+
+        Condition::ptr_t clone() const {
+            Condition* condition = new ConditionAttributeComparator(left_attribute_name_,
+                                                                    comparator_type_,
+                                                                    right_attribute_name_);
+            if (negated_)
+                condition->negate();
+            return Condition::ptr_t(condition);
+        }
+
+    private:
+        void resolve_attributes_(const Schema::ptr_t& left_schema,
+                                 const Schema::ptr_t& right_schema) {
+            left_attribute_index_ = left_schema->get_attribute_index_by_name(left_attribute_name_);
+            right_attribute_index_ = right_schema->get_attribute_index_by_name(right_attribute_name_);
+            left_attribute_type_ = left_schema->get_attribute_type_by_index(left_attribute_index_);
+            right_attribute_type_ = right_schema->get_attribute_type_by_index(right_attribute_index_);
+            value_comparison_ = decide_value_comparison(left_attribute_type_, right_attribute_type_);
+        }
     };
+
+    // Flattens (non-negated) AND nodes of a condition tree into conjuncts
+    void collect_conjuncts(const Condition::ptr_t& condition,
+                           std::list<Condition::ptr_t>& conjuncts) {
+        ConditionConjunctive::ptr_t conjunctive =
+            std::dynamic_pointer_cast<ConditionConjunctive>(condition);
+        if (conjunctive &&
+            !conjunctive->is_negated() &&
+            conjunctive->get_type() == ConditionConjunctive::AND) {
+            collect_conjuncts(conjunctive->get_left_condition(), conjuncts);
+            collect_conjuncts(conjunctive->get_right_condition(), conjuncts);
+        } else {
+            conjuncts.push_back(condition);
+        }
+    }
+
+    // Builds an AND chain of conditions (NULL for no conditions)
+    Condition::ptr_t conjoin_conditions(const std::list<Condition::ptr_t>& conditions) {
+        Condition::ptr_t conjoined;
+        auto iter = conditions.begin();
+        auto iter_end = conditions.end();
+        for (; iter != iter_end; ++iter) {
+            if (conjoined)
+                conjoined = Condition::ptr_t(
+                    new ConditionConjunctive(conjoined, *iter, ConditionConjunctive::AND));
+            else
+                conjoined = *iter;
+        }
+        return conjoined;
+    }
 }
 
 #endif  /* ! CURRENTIA_CONDITION_H_ */
@@ -66,10 +66,80 @@ namespace currentia {
             }
         }
 
+        void next_batch_implementation(int batch_count) {
+            if (left_needs_tuple_)
+                process_input_batch_(left_input_stream_, batch_count, true);
+            if (right_needs_tuple_)
+                process_input_batch_(right_input_stream_, batch_count, false);
+        }
+
         virtual void process_left_input(const Tuple::ptr_t& input) = 0;
         virtual void process_right_input(const Tuple::ptr_t& input) = 0;
 
+        // Process tuples from the left (right) input stream until the
+        // operator stops requesting them, and return the number of
+        // consumed tuples. Unconsumed tuples go back to the head of the
+        // input stream.
+        virtual size_t process_left_batch(const Stream::batch_t& inputs) {
+            size_t consumed_count = 0;
+            for (; consumed_count < inputs.size() && left_needs_tuple_; ++consumed_count) {
+                if (is_concrete_input(inputs[consumed_count])) {
+#ifdef CURRENTIA_CHECK_STATISTICS
+                    evaluation_count_++;
+#endif
+                    process_left_input(inputs[consumed_count]);
+                }
+            }
+            return consumed_count;
+        }
+
+        virtual size_t process_right_batch(const Stream::batch_t& inputs) {
+            size_t consumed_count = 0;
+            for (; consumed_count < inputs.size() && right_needs_tuple_; ++consumed_count) {
+                if (is_concrete_input(inputs[consumed_count])) {
+#ifdef CURRENTIA_CHECK_STATISTICS
+                    evaluation_count_++;
+#endif
+                    process_right_input(inputs[consumed_count]);
+                }
+            }
+            return consumed_count;
+        }
+
+    private:
+        Stream::batch_t input_batch_;
+
+        void process_input_batch_(const Stream::ptr_t& input_stream, int batch_count, bool is_left) {
+            input_batch_.clear();
+            if (input_stream->dequeue_batch(input_batch_, batch_count) == 0)
+                return;
+
+            size_t consumed_count = is_left ?
+                process_left_batch(input_batch_) : process_right_batch(input_batch_);
+
+            // unshift() puts a tuple at the head, so give back the rest
+            // from the newest one
+            for (size_t i = input_batch_.size(); i > consumed_count; --i)
+                input_stream->unshift(input_batch_[i - 1]);
+        }
+
     public:
+        bool has_input() const {
+            return (left_needs_tuple_ && left_input_stream_->has_tuple()) ||
+                (right_needs_tuple_ && right_input_stream_->has_tuple());
+        }
+
+        size_t get_input_tuples_count() const {
+            return (left_needs_tuple_ ? left_input_stream_->get_tuples_count() : 0) +
+                (right_needs_tuple_ ? right_input_stream_->get_tuples_count() : 0);
+        }
+
+        time_t get_oldest_input_time() const {
+            time_t left_time = left_needs_tuple_ ? get_input_time_(left_input_stream_->peek()) : NO_INPUT_TIME;
+            time_t right_time = right_needs_tuple_ ? get_input_time_(right_input_stream_->peek()) : NO_INPUT_TIME;
+            return left_time < right_time ? left_time : right_time;
+        }
+
         const Operator::ptr_t get_parent_left_operator() const {
             return parent_left_operator_ptr_;
         }
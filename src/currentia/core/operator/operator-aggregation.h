@@ -0,0 +1,160 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_OPERATOR_AGGREGATION_H_
+#define CURRENTIA_OPERATOR_AGGREGATION_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/operator/aggregate-function.h"
+#include "currentia/core/operator/single-input-operator.h"
+#include "currentia/core/operator/trait-aggregation-operator.h"
+#include "currentia/core/schema.h"
+#include "currentia/core/stream.h"
+#include "currentia/core/tuple.h"
+
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace currentia {
+    // Aggregation operator computing several aggregate functions over
+    // one window. All of them are updated as tuples enter and leave the
+    // shared synopsis, and each window is emitted as a single tuple
+    // holding their results in the order of the specifications.
+    class OperatorAggregation: public SingleInputOperator,
+                               public TraitAggregationOperator {
+    public:
+        struct Specification {
+            AggregateFunction::Type type;
+            std::string attribute_name;
+
+            Specification(AggregateFunction::Type type,
+                          const std::string& attribute_name):
+                type(type),
+                attribute_name(attribute_name) {
+            }
+
+            std::string toString() const {
+                return AggregateFunction::type_to_string(type) + "(" + attribute_name + ")";
+            }
+        };
+        typedef std::vector<Specification> specifications_t;
+
+    private:
+        specifications_t specifications_;
+        std::vector<AggregateFunction::ptr_t> aggregates_;
+        // After reset(), the synopsis evicts its tuples out of order
+        // until the window is refilled. Aggregates ignore the synopsis
+        // meanwhile, and are recomputed on the next acceptance.
+        bool recomputation_pending_;
+
+    public:
+        OperatorAggregation(Operator::ptr_t parent_operator_ptr,
+                            Window window,
+                            const specifications_t& specifications):
+            SingleInputOperator(parent_operator_ptr),
+            TraitAggregationOperator(window,
+                                     std::bind(&OperatorAggregation::emit_aggregates_, this)),
+            specifications_(specifications),
+            recomputation_pending_(false) {
+            if (specifications_.empty())
+                throw std::string("OperatorAggregation: no aggregate is specified");
+
+            Schema::ptr_t input_schema = parent_operator_ptr->get_output_schema_ptr();
+            Schema::ptr_t output_stream_schema(new Schema());
+            for (auto iter = specifications_.begin(); iter != specifications_.end(); ++iter) {
+                AggregateFunction::ptr_t aggregate;
+                try {
+                    aggregate = AggregateFunction::create(iter->type, input_schema, iter->attribute_name);
+                } catch (const std::string& error) {
+                    throw "OperatorAggregation: " + error;
+                }
+                aggregates_.push_back(aggregate);
+                add_result_attribute(output_stream_schema, *iter, aggregate->get_result_type());
+            }
+            set_output_stream(Stream::from_schema(output_stream_schema));
+
+            synopsis_->set_on_insert([this](const Tuple::ptr_t& tuple) {
+                if (recomputation_pending_)
+                    return;
+                for (auto iter = aggregates_.begin(); iter != aggregates_.end(); ++iter)
+                    (*iter)->insert(*tuple);
+            });
+            synopsis_->set_on_evict([this](const Tuple::ptr_t& tuple) {
+                if (recomputation_pending_)
+                    return;
+                for (auto iter = aggregates_.begin(); iter != aggregates_.end(); ++iter)
+                    (*iter)->evict(*tuple);
+            });
+        }
+
+        void process_single_input(Tuple::ptr_t input_tuple) {
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            check_window_committed_(in_pessimistic_cc(), input_tuple);
+#endif
+            synopsis_->enqueue(input_tuple);
+        }
+
+        void reset() {
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            reset_window_output_();
+#endif
+            synopsis_->reset();
+            recomputation_pending_ = true;
+        }
+
+        const specifications_t& get_specifications() const {
+            return specifications_;
+        }
+
+        // Result attributes are named after the aggregated attributes,
+        // or "<TYPE>_<attribute>" when the name is already taken
+        static void add_result_attribute(const Schema::ptr_t& schema_ptr,
+                                         const Specification& specification,
+                                         Object::Type result_type) {
+            std::string name = specification.attribute_name;
+            if (schema_ptr->get_attribute_index_by_name(name) >= 0)
+                name = AggregateFunction::type_to_string(specification.type) + "_" + name;
+            schema_ptr->add_attribute(name, result_type);
+        }
+
+    private:
+        void emit_aggregates_() {
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            time_t lwm = begin_window_output_(cc_mode_, is_commit_operator());
+#endif
+            Tuple::data_t results;
+            for (auto iter = aggregates_.begin(); iter != aggregates_.end(); ++iter) {
+                if (recomputation_pending_ || (*iter)->needs_recomputation())
+                    (*iter)->recompute(synopsis_->begin(), synopsis_->end());
+                results.push_back((*iter)->get_result());
+            }
+            recomputation_pending_ = false;
+
+            Tuple::ptr_t aggregated_tuple = Tuple::create(get_output_schema_ptr(), results);
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            aggregated_tuple->set_lwm(lwm);
+#endif
+            output_tuple(aggregated_tuple);
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            end_window_output_(cc_mode_);
+#endif
+        }
+
+    public:
+        std::string toString() const {
+            std::stringstream ss;
+            ss << parent_operator_ptr_->toString() << "\n -> " << get_name() << "(";
+            for (auto iter = specifications_.begin(); iter != specifications_.end(); ++iter)
+                ss << iter->toString() << ", ";
+            ss << window_.toString() << ")";
+            return ss.str();
+        }
+
+        std::string get_name() const {
+            return std::string("Aggregation");
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_OPERATOR_AGGREGATION_H_ */
@@ -0,0 +1,433 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_OPERATOR_EXCHANGE_H_
+#define CURRENTIA_OPERATOR_EXCHANGE_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+#include "currentia/core/operator/operator-visitor-serializer.h"
+#include "currentia/core/operator/single-input-operator.h"
+#include "currentia/core/scheduler/idle-waiter.h"
+#include "currentia/core/stream.h"
+#include "currentia/core/thread.h"
+#include "currentia/core/tuple.h"
+#include "currentia/trait/pointable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace currentia {
+    // Exchange operator, evaluating a sub-plan on several threads at
+    // once. Input tuples are hash-partitioned by the value of a key
+    // attribute into partitions_count streams. Each stream is read by
+    // a replica of the sub-plan (built by replica_builder on top of an
+    // adapter of the stream), evaluated by its own thread, and the
+    // outputs of the replicas are merged back in the order of
+    // arrived_time. In a tree, the exchange stands for the sub-plan.
+    //
+    // The merge takes an output tuple of a replica once every other
+    // replica has an older tuple waiting, or has processed all its
+    // input up to the arrived_time of the tuple. This assumes that
+    // the input stream comes in the order of arrived_time, and that
+    // an output tuple keeps the arrived_time of the input tuple it
+    // comes from (as selection, projection and stream-relation join
+    // do). Sub-plans whose result depends on how the stream is
+    // partitioned (windows over the whole stream) must not be
+    // replicated. System messages are output once the replicas have
+    // processed every tuple before them.
+    //
+    // The replica threads start at the first evaluation of the
+    // exchange, and park while no tuple is dispatched to them (see
+    // IdleWaiter). Replicas cannot be redone, so exchanges do not support
+    // concurrency control.
+    class OperatorExchange: public SingleInputOperator,
+                            public Pointable<OperatorExchange> {
+    public:
+        typedef Pointable<OperatorExchange>::ptr_t ptr_t;
+        // Builds a replica of the sub-plan on top of source, and
+        // returns its root
+        typedef std::function<Operator::ptr_t (const Operator::ptr_t& source)> replica_builder_t;
+
+        static const int REPLICA_BATCH_COUNT = 64;
+
+    private:
+        class Partition : public thread::Runnable {
+        public:
+            Stream::ptr_t input_stream;
+            Operator::ptr_t replica;
+            // in the order of OperatorVisitorSerializer
+            std::vector<Operator*> operators;
+            // arrived_time of the last tuple put into input_stream
+            std::atomic<time_t> dispatched_time;
+            // the replica has output everything for the tuples up to
+            // this arrived_time
+            std::atomic<time_t> completed_time;
+
+            // output tuples of the replica taken by the exchange, not
+            // merged yet (exchange thread only)
+            std::deque<Tuple::ptr_t> pending_tuples;
+            // parks the thread between dispatches (watches input_stream)
+            std::unique_ptr<IdleWaiter> idle_waiter;
+
+            Partition(const Schema::ptr_t& schema,
+                      const replica_builder_t& replica_builder):
+                input_stream(Stream::from_schema(schema, Stream::SPSC)),
+                dispatched_time(0),
+                completed_time(0) {
+                replica = replica_builder(Operator::ptr_t(new OperatorStreamAdapter(input_stream)));
+                replica->get_output_stream()->set_queue_mode(Stream::SPSC);
+                operators = OperatorVisitorSerializer::serialize_tree(replica);
+                idle_waiter.reset(new IdleWaiter(operators));
+            }
+
+            void run() {
+                try {
+                    while (!stopped()) {
+                        // tuples dispatched by now are in input_stream
+                        time_t dispatched = dispatched_time.load(std::memory_order_acquire);
+                        bool evaluated = false;
+                        for (auto iter = operators.begin(), iter_end = operators.end();
+                             iter != iter_end;
+                             ++iter) {
+                            if ((*iter)->has_input()) {
+                                (*iter)->process_next(REPLICA_BATCH_COUNT);
+                                evaluated = true;
+                            }
+                        }
+                        if (!evaluated)
+                            completed_time.store(dispatched, std::memory_order_release);
+                        // dispatch_partitioned_tuples_() notifies after
+                        // advancing dispatched_time
+                        idle_waiter->after_wake_up(evaluated, [this]() {
+                            return dispatched_time.load() != completed_time.load();
+                        });
+                    }
+                } catch (std::string error) {
+                    std::cerr << "OperatorExchange: " << error << std::endl;
+                }
+            }
+
+            // Takes the output tuples of the replica
+            void collect() {
+                Stream::batch_t output_tuples;
+                replica->get_output_stream()->dequeue_batch(output_tuples, SIZE_MAX);
+                pending_tuples.insert(pending_tuples.end(), output_tuples.begin(), output_tuples.end());
+            }
+
+            // Whether the replica has output everything for the tuples
+            // up to time (collected into pending_tuples)
+            bool is_completed_until(time_t time) {
+                if (completed_time.load(std::memory_order_acquire) < time)
+                    return false;
+                collect();
+                return true;
+            }
+        };
+
+        // A system message, waiting for the tuples dispatched before it
+        struct Barrier {
+            Tuple::ptr_t message;
+            std::vector<time_t> dispatched_times;
+        };
+
+        std::string key_attribute_name_;
+        int key_index_;
+        std::vector<std::shared_ptr<Partition> > partitions_;
+        bool partitions_started_;
+
+        std::deque<Barrier> barriers_;
+        Stream::batch_t input_tuples_;
+        std::vector<Stream::batch_t> partitioned_tuples_;
+        Stream::batch_t merged_tuples_;
+
+    public:
+        OperatorExchange(Operator::ptr_t parent_operator_ptr,
+                         const std::string& key_attribute_name,
+                         int partitions_count,
+                         const replica_builder_t& replica_builder):
+            SingleInputOperator(parent_operator_ptr),
+            key_attribute_name_(key_attribute_name),
+            partitions_started_(false),
+            partitioned_tuples_(std::max(partitions_count, 0)) {
+            Schema::ptr_t input_schema = parent_operator_ptr->get_output_schema_ptr();
+            key_index_ = input_schema->get_attribute_index_by_name(key_attribute_name);
+            if (key_index_ < 0)
+                throw "OperatorExchange: " + key_attribute_name + " is not in " + input_schema->toString();
+            if (partitions_count < 1)
+                throw std::string("OperatorExchange: at least one partition is needed");
+
+            for (int i = 0; i < partitions_count; ++i)
+                partitions_.push_back(std::shared_ptr<Partition>(new Partition(input_schema, replica_builder)));
+            set_output_stream(Stream::from_schema(partitions_.front()->replica->get_output_schema_ptr()));
+        }
+
+        ~OperatorExchange() {
+            stop_partitions();
+        }
+
+        void stop_partitions() {
+            for (auto iter = partitions_.begin(), iter_end = partitions_.end();
+                 iter != iter_end;
+                 ++iter) {
+                (*iter)->stop_and_wait();
+            }
+            partitions_started_ = false;
+        }
+
+        bool has_input() const {
+            if (input_stream_->has_tuple() || !barriers_.empty())
+                return true;
+            for (auto iter = partitions_.begin(), iter_end = partitions_.end();
+                 iter != iter_end;
+                 ++iter) {
+                if (!(*iter)->pending_tuples.empty() ||
+                    (*iter)->replica->get_output_stream()->has_tuple())
+                    return true;
+            }
+            return false;
+        }
+
+        // Input tuples and output tuples of the replicas waiting for
+        // the merge
+        size_t get_input_tuples_count() const {
+            size_t count = input_stream_->get_tuples_count() + barriers_.size();
+            for (auto iter = partitions_.begin(), iter_end = partitions_.end();
+                 iter != iter_end;
+                 ++iter) {
+                count += (*iter)->pending_tuples.size() +
+                    (*iter)->replica->get_output_stream()->get_tuples_count();
+            }
+            return count;
+        }
+
+        time_t get_oldest_input_time() const {
+            if (!barriers_.empty())
+                return 0;
+            time_t oldest_time = get_input_time_(input_stream_->peek());
+            for (auto iter = partitions_.begin(), iter_end = partitions_.end();
+                 iter != iter_end;
+                 ++iter) {
+                time_t time = (*iter)->pending_tuples.empty()
+                    ? get_input_time_((*iter)->replica->get_output_stream()->peek())
+                    : (*iter)->pending_tuples.front()->get_arrived_time();
+                if (time < oldest_time)
+                    oldest_time = time;
+            }
+            return oldest_time;
+        }
+
+        // The replicas output on the threads of the partitions
+        void collect_external_input_streams(std::vector<Stream::ptr_t>& streams) const {
+            for (auto iter = partitions_.begin(), iter_end = partitions_.end();
+                 iter != iter_end;
+                 ++iter) {
+                streams.push_back((*iter)->replica->get_output_stream());
+            }
+        }
+
+        int get_partitions_count() const {
+            return partitions_.size();
+        }
+
+        const Operator::ptr_t& get_replica(int partition) const {
+            return partitions_.at(partition)->replica;
+        }
+
+        const std::string& get_key_attribute_name() const {
+            return key_attribute_name_;
+        }
+
+    protected:
+        void next_implementation() {
+            next_batch_implementation(1);
+        }
+
+        void next_batch_implementation(int batch_count) {
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            if (cc_mode_ != NONE)
+                throw std::string("OperatorExchange: concurrency control is not supported");
+#endif
+            if (!partitions_started_)
+                start_partitions_();
+
+            input_tuples_.clear();
+            size_t dequeued_count = input_stream_->dequeue_batch(input_tuples_, batch_count);
+#ifdef CURRENTIA_CHECK_STATISTICS
+            evaluation_count_ += dequeued_count;
+#endif
+            if (dequeued_count > 0) {
+                // System messages split the batch, as they wait for
+                // the tuples dispatched before them
+                auto iter = input_tuples_.begin();
+                auto iter_end = input_tuples_.end();
+                for (; iter != iter_end; ++iter) {
+                    if ((*iter)->is_system_message()) {
+                        dispatch_partitioned_tuples_();
+                        add_barrier_(*iter);
+                    } else {
+                        partitioned_tuples_[get_partition_(*iter)].push_back(*iter);
+                    }
+                }
+                dispatch_partitioned_tuples_();
+            }
+
+            merge_();
+        }
+
+        void process_single_input(Tuple::ptr_t input_tuple) {
+            partitioned_tuples_[get_partition_(input_tuple)].push_back(input_tuple);
+            dispatch_partitioned_tuples_();
+        }
+
+    private:
+        void start_partitions_() {
+            for (auto iter = partitions_.begin(), iter_end = partitions_.end();
+                 iter != iter_end;
+                 ++iter) {
+                (*iter)->start();
+            }
+            partitions_started_ = true;
+        }
+
+        int get_partition_(const Tuple::ptr_t& tuple) const {
+            return tuple->get_value_by_index(key_index_).hash() % partitions_.size();
+        }
+
+        void dispatch_partitioned_tuples_() {
+            for (size_t i = 0; i < partitions_.size(); ++i) {
+                Stream::batch_t& tuples = partitioned_tuples_[i];
+                if (tuples.empty())
+                    continue;
+                Partition& partition = *partitions_[i];
+                time_t dispatched_time = partition.dispatched_time.load(std::memory_order_relaxed);
+                for (auto iter = tuples.begin(), iter_end = tuples.end(); iter != iter_end; ++iter)
+                    dispatched_time = std::max(dispatched_time, (*iter)->get_arrived_time());
+                partition.input_stream->enqueue_batch(tuples);
+                partition.dispatched_time.store(dispatched_time, std::memory_order_release);
+                partition.idle_waiter->get_arrival_signal()->notify();
+                tuples.clear();
+            }
+        }
+
+        void add_barrier_(const Tuple::ptr_t& message) {
+            Barrier barrier;
+            barrier.message = message;
+            for (auto iter = partitions_.begin(), iter_end = partitions_.end();
+                 iter != iter_end;
+                 ++iter) {
+                barrier.dispatched_times.push_back((*iter)->dispatched_time.load(std::memory_order_relaxed));
+            }
+            barriers_.push_back(barrier);
+        }
+
+        // Whether every partition has output (and the merge has
+        // taken) all the tuples dispatched before the barrier
+        bool is_barrier_ready_(const Barrier& barrier) {
+            for (size_t i = 0; i < partitions_.size(); ++i) {
+                Partition& partition = *partitions_[i];
+                if (!partition.is_completed_until(barrier.dispatched_times[i]))
+                    return false;
+                if (!partition.pending_tuples.empty() &&
+                    partition.pending_tuples.front()->get_arrived_time() <= barrier.dispatched_times[i])
+                    return false;
+            }
+            return true;
+        }
+
+        // Whether no partition but the candidate can output a tuple
+        // older than time. Sets collected when it took new tuples
+        // from a replica (the candidate may not be the oldest then).
+        bool is_mergeable_(int candidate, time_t time, bool& collected) {
+            for (size_t i = 0; i < partitions_.size(); ++i) {
+                Partition& partition = *partitions_[i];
+                if (static_cast<int>(i) == candidate || !partition.pending_tuples.empty())
+                    continue;
+                // tuples dispatched later are newer than the candidate
+                time_t dispatched_time = partition.dispatched_time.load(std::memory_order_relaxed);
+                if (!partition.is_completed_until(std::min(time, dispatched_time)))
+                    return false;
+                if (!partition.pending_tuples.empty()) {
+                    collected = true;
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void merge_() {
+            for (auto iter = partitions_.begin(), iter_end = partitions_.end();
+                 iter != iter_end;
+                 ++iter) {
+                (*iter)->collect();
+            }
+
+            merged_tuples_.clear();
+            for (;;) {
+                if (!barriers_.empty() && is_barrier_ready_(barriers_.front())) {
+                    if (!merged_tuples_.empty()) {
+                        output_tuples(merged_tuples_);
+                        merged_tuples_.clear();
+                    }
+                    output_tuple(barriers_.front().message);
+                    barriers_.pop_front();
+                    continue;
+                }
+
+                // the oldest tuple (before the next barrier)
+                int candidate = -1;
+                time_t candidate_time = 0;
+                for (size_t i = 0; i < partitions_.size(); ++i) {
+                    const std::deque<Tuple::ptr_t>& pending_tuples = partitions_[i]->pending_tuples;
+                    if (pending_tuples.empty())
+                        continue;
+                    time_t time = pending_tuples.front()->get_arrived_time();
+                    if (!barriers_.empty() && time > barriers_.front().dispatched_times[i])
+                        continue;
+                    if (candidate < 0 || time < candidate_time) {
+                        candidate = i;
+                        candidate_time = time;
+                    }
+                }
+                if (candidate < 0)
+                    break;
+
+                bool collected = false;
+                if (!is_mergeable_(candidate, candidate_time, collected)) {
+                    if (collected)
+                        continue;
+                    break;
+                }
+
+                std::deque<Tuple::ptr_t>& pending_tuples = partitions_[candidate]->pending_tuples;
+                merged_tuples_.push_back(pending_tuples.front());
+                pending_tuples.pop_front();
+            }
+
+            if (!merged_tuples_.empty())
+                output_tuples(merged_tuples_);
+        }
+
+    public:
+        std::string toString() const {
+            std::stringstream ss;
+            ss << parent_operator_ptr_->toString() << "\n -> " << get_name()
+               << "(BY " << key_attribute_name_ << ", " << partitions_.size() << " partitions)"
+               << " [" << partitions_.front()->replica->toString() << "]";
+            return ss.str();
+        }
+
+        std::string get_name() const {
+            return std::string("Exchange");
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_OPERATOR_EXCHANGE_H_ */
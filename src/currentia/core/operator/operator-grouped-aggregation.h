@@ -0,0 +1,241 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_OPERATOR_GROUPED_AGGREGATION_H_
+#define CURRENTIA_OPERATOR_GROUPED_AGGREGATION_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/open-addressing-map.h"
+#include "currentia/core/operator/aggregate-function.h"
+#include "currentia/core/operator/operator-aggregation.h"
+#include "currentia/core/operator/single-input-operator.h"
+#include "currentia/core/operator/trait-aggregation-operator.h"
+#include "currentia/core/schema.h"
+#include "currentia/core/stream.h"
+#include "currentia/core/tuple.h"
+
+#include <functional>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace currentia {
+    // Aggregation operator grouping the tuples of a window by the
+    // value of an attribute (GROUP BY). Each key present in the window
+    // keeps its own aggregate functions, updated as its tuples enter
+    // and leave the shared synopsis, in an open-addressing map. Each
+    // window is emitted as one tuple per key (the key followed by the
+    // results, keys in no particular order). Keys without tuples in the
+    // window are dropped at window boundaries, so the state is bounded
+    // by the number of keys in the window.
+    class OperatorGroupedAggregation: public SingleInputOperator,
+                                      public TraitAggregationOperator {
+    public:
+        typedef OperatorAggregation::Specification Specification;
+        typedef OperatorAggregation::specifications_t specifications_t;
+
+    private:
+        struct Group {
+            std::vector<AggregateFunction::ptr_t> aggregates;
+            long tuples_count;  // in the window
+
+            Group():
+                tuples_count(0) {
+            }
+        };
+        typedef OpenAddressingMap<Object, Group> groups_t;
+
+        std::string key_attribute_name_;
+        int key_index_;
+        specifications_t specifications_;
+        Schema::ptr_t input_schema_;
+        groups_t groups_;
+        // See OperatorAggregation
+        bool recomputation_pending_;
+
+    public:
+        OperatorGroupedAggregation(Operator::ptr_t parent_operator_ptr,
+                                   Window window,
+                                   const std::string& key_attribute_name,
+                                   const specifications_t& specifications):
+            SingleInputOperator(parent_operator_ptr),
+            TraitAggregationOperator(window,
+                                     std::bind(&OperatorGroupedAggregation::emit_groups_, this)),
+            key_attribute_name_(key_attribute_name),
+            specifications_(specifications),
+            input_schema_(parent_operator_ptr->get_output_schema_ptr()),
+            groups_(Object(0)),
+            recomputation_pending_(false) {
+            if (specifications_.empty())
+                throw std::string("OperatorGroupedAggregation: no aggregate is specified");
+
+            key_index_ = input_schema_->get_attribute_index_by_name(key_attribute_name);
+            if (key_index_ < 0)
+                throw "OperatorGroupedAggregation: " + key_attribute_name + " is not in " + input_schema_->toString();
+
+            Schema::ptr_t output_stream_schema(new Schema());
+            output_stream_schema->add_attribute(key_attribute_name,
+                                                input_schema_->get_attribute_type_by_index(key_index_));
+            Group prototype;
+            create_aggregates_(prototype);
+            for (size_t i = 0; i < specifications_.size(); ++i)
+                OperatorAggregation::add_result_attribute(output_stream_schema,
+                                                          specifications_[i],
+                                                          prototype.aggregates[i]->get_result_type());
+            set_output_stream(Stream::from_schema(output_stream_schema));
+
+            synopsis_->set_on_insert([this](const Tuple::ptr_t& tuple) {
+                if (!recomputation_pending_)
+                    insert_(*tuple);
+            });
+            synopsis_->set_on_evict([this](const Tuple::ptr_t& tuple) {
+                if (!recomputation_pending_)
+                    evict_(*tuple);
+            });
+        }
+
+        void process_single_input(Tuple::ptr_t input_tuple) {
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            check_window_committed_(in_pessimistic_cc(), input_tuple);
+#endif
+            synopsis_->enqueue(input_tuple);
+        }
+
+        void reset() {
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            reset_window_output_();
+#endif
+            synopsis_->reset();
+            recomputation_pending_ = true;
+        }
+
+        // Number of keys holding state (those in the window, and those
+        // of tuples arrived since the last window)
+        size_t get_groups_count() const {
+            return groups_.size();
+        }
+
+    private:
+        void create_aggregates_(Group& group) {
+            group.aggregates.reserve(specifications_.size());
+            for (auto iter = specifications_.begin(); iter != specifications_.end(); ++iter) {
+                try {
+                    group.aggregates.push_back(AggregateFunction::create(iter->type,
+                                                                         input_schema_,
+                                                                         iter->attribute_name));
+                } catch (const std::string& error) {
+                    throw "OperatorGroupedAggregation: " + error;
+                }
+            }
+        }
+
+        void insert_(const Tuple& tuple) {
+            Group& group = groups_[tuple.get_value_by_index(key_index_)];
+            if (group.aggregates.empty())
+                create_aggregates_(group);
+            for (auto iter = group.aggregates.begin(); iter != group.aggregates.end(); ++iter)
+                (*iter)->insert(tuple);
+            group.tuples_count++;
+        }
+
+        void evict_(const Tuple& tuple) {
+            Group* group = groups_.find(tuple.get_value_by_index(key_index_));
+            if (!group)
+                return;
+            for (auto iter = group->aggregates.begin(); iter != group->aggregates.end(); ++iter)
+                (*iter)->evict(tuple);
+            group->tuples_count--;
+        }
+
+        static bool is_idle_(const Object& key, const Group& group) {
+            return group.tuples_count == 0;
+        }
+
+        // Rebuilds all the groups from the window (whose tuples are in
+        // the order of arrival right after a reset())
+        void rebuild_groups_() {
+            groups_.clear();
+            for (auto iter = synopsis_->begin(); iter != synopsis_->end(); ++iter) {
+                if (*iter)
+                    insert_(**iter);
+            }
+        }
+
+        // Recomputes the aggregates which drifted (FLOAT sums, which do
+        // not depend on the order of tuples) from the window
+        void recompute_drifted_aggregates_() {
+            std::unordered_set<AggregateFunction*> drifted_aggregates;
+            groups_.for_each([&](const Object& key, Group& group) {
+                for (auto iter = group.aggregates.begin(); iter != group.aggregates.end(); ++iter) {
+                    if ((*iter)->needs_recomputation()) {
+                        (*iter)->clear();
+                        drifted_aggregates.insert(iter->get());
+                    }
+                }
+            });
+            if (drifted_aggregates.empty())
+                return;
+
+            for (auto iter = synopsis_->begin(); iter != synopsis_->end(); ++iter) {
+                if (!*iter)
+                    continue;
+                Group* group = groups_.find((*iter)->get_value_by_index(key_index_));
+                for (auto aggregate_iter = group->aggregates.begin();
+                     aggregate_iter != group->aggregates.end();
+                     ++aggregate_iter) {
+                    if (drifted_aggregates.count(aggregate_iter->get()))
+                        (*aggregate_iter)->insert(**iter);
+                }
+            }
+        }
+
+        void emit_groups_() {
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            time_t lwm = begin_window_output_(cc_mode_, is_commit_operator());
+#endif
+            if (recomputation_pending_) {
+                rebuild_groups_();
+                recomputation_pending_ = false;
+            } else {
+                groups_.erase_if(is_idle_);
+                recompute_drifted_aggregates_();
+            }
+
+            Stream::batch_t group_tuples;
+            group_tuples.reserve(groups_.size());
+            groups_.for_each([&](const Object& key, Group& group) {
+                Tuple::data_t results;
+                results.reserve(group.aggregates.size() + 1);
+                results.push_back(key);
+                for (auto iter = group.aggregates.begin(); iter != group.aggregates.end(); ++iter)
+                    results.push_back((*iter)->get_result());
+                Tuple::ptr_t group_tuple = Tuple::create(get_output_schema_ptr(), results);
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+                group_tuple->set_lwm(lwm);
+#endif
+                group_tuples.push_back(group_tuple);
+            });
+            if (!group_tuples.empty())
+                output_tuples(group_tuples);
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            end_window_output_(cc_mode_);
+#endif
+        }
+
+    public:
+        std::string toString() const {
+            std::stringstream ss;
+            ss << parent_operator_ptr_->toString() << "\n -> " << get_name() << "(";
+            for (auto iter = specifications_.begin(); iter != specifications_.end(); ++iter)
+                ss << iter->toString() << ", ";
+            ss << "BY " << key_attribute_name_ << ", " << window_.toString() << ")";
+            return ss.str();
+        }
+
+        std::string get_name() const {
+            return std::string("GroupedAggregation");
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_OPERATOR_GROUPED_AGGREGATION_H_ */
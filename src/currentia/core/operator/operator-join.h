@@ -4,35 +4,59 @@
 #define CURRENTIA_OPERATOR_JOIN_H_
 
 #include "currentia/core/tuple.h"
+#include "currentia/core/tuple-allocator.h"
 #include "currentia/core/stream.h"
 #include "currentia/core/object.h"
 #include "currentia/core/window.h"
 
 #include "currentia/core/operator/double-input-operator.h"
 #include "currentia/core/operator/condition.h"
+#include "currentia/core/operator/condition-program.h"
 #include "currentia/core/operator/synopsis.h"
 
+#include <algorithm>
+#include <deque>
 #include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
 
 namespace currentia {
     class OperatorJoin: public DoubleInputOperator {
     public:
+        // RECOMPUTE joins the whole windows on every evaluation.
+        // INCREMENTAL maintains a hash index over each window as
+        // tuples enter and leave it, and outputs only the pairs which
+        // involve tuples accepted since the last evaluation (requires
+        // an equality condition on attributes).
+        enum Mode {
+            RECOMPUTE,
+            INCREMENTAL
+        };
+
         OperatorJoin(const Operator::ptr_t& parent_left_operator_ptr,
                      Window left_window,
                      const Operator::ptr_t& parent_right_operator_ptr,
                      Window right_window,
-                     Condition::ptr_t join_condition):
+                     Condition::ptr_t join_condition,
+                     Mode mode = RECOMPUTE):
             DoubleInputOperator(parent_left_operator_ptr,
                                 parent_right_operator_ptr),
+            mode_(mode),
             left_window_(left_window),
             right_window_(right_window),
             // init synopsises
             left_synopsis_(create_synopsis_from_window(left_window_)),
             right_synopsis_(create_synopsis_from_window(right_window_)),
             // set join condition
-            join_condition_(join_condition) {
+            join_condition_(join_condition),
+            use_hash_join_(false),
+            left_key_index_(-1),
+            right_key_index_(-1) {
             // build new schema and index
             joined_schema_ptr_ = build_joined_schema_();
+            output_arena_.reset(new ArenaTupleAllocator());
+            joined_schema_ptr_->set_tuple_allocator(output_arena_);
             set_output_stream(Stream::from_schema(joined_schema_ptr_));
             // set callbacks
             left_synopsis_->set_on_accept(std::bind(&OperatorJoin::left_on_accept_, this));
@@ -42,6 +66,22 @@ namespace currentia {
                 parent_left_operator_ptr->get_output_stream()->get_schema(),
                 parent_right_operator_ptr->get_output_stream()->get_schema()
             );
+            join_program_ = ConditionProgram::compile(join_condition_);
+            // use hash join when the condition has an equality on attributes
+            detect_equi_join_();
+            if (mode_ == INCREMENTAL) {
+                if (!use_hash_join_)
+                    throw std::string("Incremental join requires an equality on attributes: ") +
+                        join_condition_->toString();
+                left_synopsis_->set_on_insert(std::bind(&OperatorJoin::left_on_insert_, this,
+                                                        std::placeholders::_1));
+                left_synopsis_->set_on_evict(std::bind(&OperatorJoin::left_on_evict_, this,
+                                                       std::placeholders::_1));
+                right_synopsis_->set_on_insert(std::bind(&OperatorJoin::right_on_insert_, this,
+                                                         std::placeholders::_1));
+                right_synopsis_->set_on_evict(std::bind(&OperatorJoin::right_on_evict_, this,
+                                                        std::placeholders::_1));
+            }
         }
 
         void process_left_input(const Tuple::ptr_t& input) {
@@ -55,9 +95,19 @@ namespace currentia {
         void reset() {
             left_synopsis_->reset();
             right_synopsis_->reset();
+            left_index_.clear();
+            right_index_.clear();
+            left_newcomers_.clear();
+            right_newcomers_.clear();
+        }
+
+        Mode get_mode() const {
+            return mode_;
         }
 
     private:
+        Mode mode_;
+
         Window left_window_;
         Window right_window_;
 
@@ -65,8 +115,101 @@ namespace currentia {
         Synopsis::ptr_t right_synopsis_;
 
         Condition::ptr_t join_condition_;
+        ConditionProgram::ptr_t join_program_;
 
         Schema::ptr_t joined_schema_ptr_;
+        // joined tuples of one evaluation are allocated (and freed)
+        // together
+        std::shared_ptr<ArenaTupleAllocator> output_arena_;
+
+        // Hash join (enabled when the join condition has a conjunct
+        // "left.attr = right.attr")
+        typedef std::unordered_map<Object, std::vector<Tuple::ptr_t> > hash_table_t;
+
+        bool use_hash_join_;
+        int left_key_index_;
+        int right_key_index_;
+        // rest of the conjuncts (NULL if nothing remains)
+        Condition::ptr_t residual_condition_;
+        ConditionProgram::ptr_t residual_program_;
+        hash_table_t hash_table_;
+
+        // Incremental mode: indices over tuples already joined, and
+        // tuples accepted since the last evaluation
+        typedef std::unordered_map<Object, std::deque<Tuple::ptr_t> > window_index_t;
+
+        window_index_t left_index_;
+        window_index_t right_index_;
+        std::deque<Tuple::ptr_t> left_newcomers_;
+        std::deque<Tuple::ptr_t> right_newcomers_;
+
+        void left_on_insert_(const Tuple::ptr_t& tuple) {
+            left_newcomers_.push_back(tuple);
+        }
+
+        void right_on_insert_(const Tuple::ptr_t& tuple) {
+            right_newcomers_.push_back(tuple);
+        }
+
+        void left_on_evict_(const Tuple::ptr_t& tuple) {
+            evict_from_window_(tuple, left_key_index_, left_index_, left_newcomers_);
+        }
+
+        void right_on_evict_(const Tuple::ptr_t& tuple) {
+            evict_from_window_(tuple, right_key_index_, right_index_, right_newcomers_);
+        }
+
+        void evict_from_window_(const Tuple::ptr_t& tuple, int key_index,
+                                window_index_t& index,
+                                std::deque<Tuple::ptr_t>& newcomers) {
+            // a newcomer can expire before it is joined (time-based windows)
+            auto newcomer_iter = std::find(newcomers.begin(), newcomers.end(), tuple);
+            if (newcomer_iter != newcomers.end()) {
+                newcomers.erase(newcomer_iter);
+                return;
+            }
+
+            auto found = index.find(tuple->get_value_by_index(key_index));
+            if (found == index.end())
+                return;
+
+            // windows are FIFO, so the evicted tuple is usually the first one
+            std::deque<Tuple::ptr_t>& tuples = found->second;
+            auto tuple_iter = std::find(tuples.begin(), tuples.end(), tuple);
+            if (tuple_iter != tuples.end())
+                tuples.erase(tuple_iter);
+            if (tuples.empty())
+                index.erase(found);
+        }
+
+        void detect_equi_join_() {
+            std::list<Condition::ptr_t> conjuncts;
+            collect_conjuncts(join_condition_, conjuncts);
+
+            auto iter = conjuncts.begin();
+            auto iter_end = conjuncts.end();
+            for (; iter != iter_end; ++iter) {
+                ConditionAttributeComparator::ptr_t comparator =
+                    std::dynamic_pointer_cast<ConditionAttributeComparator>(*iter);
+                if (comparator &&
+                    !comparator->is_negated() &&
+                    comparator->get_comparator_type() == Comparator::EQUAL) {
+                    left_key_index_ = parent_left_operator_ptr_->get_output_schema_ptr()
+                        ->get_attribute_index_by_name(comparator->get_left_attribute_name());
+                    right_key_index_ = parent_right_operator_ptr_->get_output_schema_ptr()
+                        ->get_attribute_index_by_name(comparator->get_right_attribute_name());
+                    use_hash_join_ = true;
+                    conjuncts.erase(iter);
+                    break;
+                }
+            }
+
+            if (use_hash_join_) {
+                residual_condition_ = conjoin_conditions(conjuncts);
+                if (residual_condition_)
+                    residual_program_ = ConditionProgram::compile(residual_condition_);
+            }
+        }
 
         void left_on_accept_() {
             left_needs_tuple_ = false;
@@ -94,12 +237,6 @@ namespace currentia {
 
         inline void
         join_synopsis_() {
-            Synopsis::const_iterator left_iter = left_synopsis_->begin();
-            Synopsis::const_iterator right_iter = right_synopsis_->begin();
-
-            Synopsis::const_iterator left_iter_end = left_synopsis_->end();
-            Synopsis::const_iterator right_iter_end = right_synopsis_->end();
-
 #if 0
             std::cout << "Left Synopsis\n" << left_synopsis_->toString() << std::endl;
             std::cout << "Right Synopsis\n" << right_synopsis_->toString() << std::endl;
@@ -110,26 +247,126 @@ namespace currentia {
             // decide lwm
             time_t lwm = std::min(left_synopsis_->get_lwm(),
                                   right_synopsis_->get_lwm());
+#else
+            time_t lwm = 0;
 #endif
 
-            // For now, just conduct a nested-loop join
+            if (mode_ == INCREMENTAL) {
+                incremental_join_(lwm);
+                return;
+            }
+
+            output_arena_->begin_region();
+            if (use_hash_join_)
+                hash_join_synopsis_(lwm);
+            else
+                nested_loop_join_synopsis_(lwm);
+        }
+
+        void nested_loop_join_synopsis_(time_t lwm) {
+            Synopsis::const_iterator left_iter = left_synopsis_->begin();
+            Synopsis::const_iterator left_iter_end = left_synopsis_->end();
+            Synopsis::const_iterator right_iter_end = right_synopsis_->end();
+
             for (; left_iter != left_iter_end; ++left_iter) {
+                Synopsis::const_iterator right_iter = right_synopsis_->begin();
                 for (; right_iter != right_iter_end; ++right_iter) {
-                    if (join_condition_->check(*left_iter, *right_iter)) {
-                        auto combined_tuple = Tuple::create(
-                            joined_schema_ptr_,
-                            (*left_iter)->get_concatenated_data(*right_iter),
-                            std::min((*left_iter)->get_arrived_time(), (*right_iter)->get_arrived_time())
-                        );
-#ifdef CURRENTIA_ENABLE_TRANSACTION
-                        combined_tuple->set_lwm(lwm);
-#endif
-                        output_tuple(combined_tuple);
-                    }
+                    if (join_program_->check(*left_iter, *right_iter))
+                        output_joined_tuple_(*left_iter, *right_iter, lwm);
                 }
             }
         }
 
+        // Builds a hash table over the smaller synopsis and probes it
+        // with the other one
+        void hash_join_synopsis_(time_t lwm) {
+            bool build_left = left_synopsis_->size() < right_synopsis_->size();
+
+            const Synopsis::ptr_t& build_synopsis = build_left ? left_synopsis_ : right_synopsis_;
+            const Synopsis::ptr_t& probe_synopsis = build_left ? right_synopsis_ : left_synopsis_;
+            int build_key_index = build_left ? left_key_index_ : right_key_index_;
+            int probe_key_index = build_left ? right_key_index_ : left_key_index_;
+
+            hash_table_.clear();
+            Synopsis::const_iterator build_iter = build_synopsis->begin();
+            Synopsis::const_iterator build_iter_end = build_synopsis->end();
+            for (; build_iter != build_iter_end; ++build_iter)
+                hash_table_[(*build_iter)->get_value_by_index(build_key_index)].push_back(*build_iter);
+
+            Synopsis::const_iterator probe_iter = probe_synopsis->begin();
+            Synopsis::const_iterator probe_iter_end = probe_synopsis->end();
+            for (; probe_iter != probe_iter_end; ++probe_iter) {
+                auto found = hash_table_.find((*probe_iter)->get_value_by_index(probe_key_index));
+                if (found == hash_table_.end())
+                    continue;
+
+                auto match_iter = found->second.begin();
+                auto match_iter_end = found->second.end();
+                for (; match_iter != match_iter_end; ++match_iter) {
+                    const Tuple::ptr_t& left_tuple = build_left ? *match_iter : *probe_iter;
+                    const Tuple::ptr_t& right_tuple = build_left ? *probe_iter : *match_iter;
+                    output_joined_tuple_if_satisfied_(left_tuple, right_tuple, lwm);
+                }
+            }
+        }
+
+        // New right tuples are probed against old left tuples first, and
+        // then new left tuples against the whole right window, so that
+        // each pair is output exactly once.
+        void incremental_join_(time_t lwm) {
+            auto right_iter = right_newcomers_.begin();
+            auto right_iter_end = right_newcomers_.end();
+            for (; right_iter != right_iter_end; ++right_iter) {
+                Object key = (*right_iter)->get_value_by_index(right_key_index_);
+                auto found = left_index_.find(key);
+                if (found != left_index_.end()) {
+                    auto left_iter = found->second.begin();
+                    auto left_iter_end = found->second.end();
+                    for (; left_iter != left_iter_end; ++left_iter)
+                        output_joined_tuple_if_satisfied_(*left_iter, *right_iter, lwm);
+                }
+                right_index_[key].push_back(*right_iter);
+            }
+            right_newcomers_.clear();
+
+            auto left_iter = left_newcomers_.begin();
+            auto left_iter_end = left_newcomers_.end();
+            for (; left_iter != left_iter_end; ++left_iter) {
+                Object key = (*left_iter)->get_value_by_index(left_key_index_);
+                auto found = right_index_.find(key);
+                if (found != right_index_.end()) {
+                    auto right_iter = found->second.begin();
+                    auto right_iter_end = found->second.end();
+                    for (; right_iter != right_iter_end; ++right_iter)
+                        output_joined_tuple_if_satisfied_(*left_iter, *right_iter, lwm);
+                }
+                left_index_[key].push_back(*left_iter);
+            }
+            left_newcomers_.clear();
+        }
+
+        inline void output_joined_tuple_if_satisfied_(const Tuple::ptr_t& left_tuple,
+                                                      const Tuple::ptr_t& right_tuple,
+                                                      time_t lwm) {
+            if (!residual_program_ || residual_program_->check(left_tuple, right_tuple))
+                output_joined_tuple_(left_tuple, right_tuple, lwm);
+        }
+
+        void output_joined_tuple_(const Tuple::ptr_t& left_tuple,
+                                  const Tuple::ptr_t& right_tuple,
+                                  time_t lwm) {
+            auto combined_tuple = Tuple::create_concatenated(
+                joined_schema_ptr_,
+                left_tuple,
+                right_tuple,
+                std::min(left_tuple->get_arrived_time(), right_tuple->get_arrived_time())
+            );
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            combined_tuple->set_lwm(lwm);
+#endif
+            output_tuple(combined_tuple);
+        }
+
     public:
         std::string toString() const {
             std::stringstream ss;
@@ -140,7 +377,7 @@ namespace currentia {
         }
 
         std::string get_name() const {
-            return std::string("Join");
+            return std::string(mode_ == INCREMENTAL ? "Incremental-Join" : "Join");
         }
     };
 }
@@ -29,6 +29,15 @@ namespace currentia {
             output_tuple(project_attributes(input_tuple));
         }
 
+        void process_batch(const Stream::batch_t& input_tuples) {
+            projected_tuples_.clear();
+            auto iter = input_tuples.begin();
+            auto iter_end = input_tuples.end();
+            for (; iter != iter_end; ++iter)
+                projected_tuples_.push_back(project_attributes(*iter));
+            output_tuples(projected_tuples_);
+        }
+
     private:
         target_attribute_names_t target_attribute_names_;
         target_attribute_indices_t target_attribute_indices_;
@@ -36,6 +45,8 @@ namespace currentia {
         Schema::ptr_t old_schema_ptr_;
         Schema::ptr_t new_schema_ptr_;
 
+        Stream::batch_t projected_tuples_;
+
         void build_new_schema_and_indices() {
             new_schema_ptr_ = Schema::ptr_t(new Schema());
 
@@ -63,18 +74,10 @@ namespace currentia {
         }
 
         Tuple::ptr_t project_attributes(Tuple::ptr_t target_tuple_ptr) const {
-            Tuple::data_t data;
-
-            target_attribute_indices_t::const_iterator iter = target_attribute_indices_.begin();
-
-            for (; iter != target_attribute_indices_.end(); ++iter) {
-                int attribute_index = *iter;
-                data.push_back(target_tuple_ptr->get_value_by_index(attribute_index));
-            }
-
-            auto projected_tuple = Tuple::create(new_schema_ptr_,
-                                                 data,
-                                                 target_tuple_ptr->get_arrived_time());
+            auto projected_tuple = Tuple::create_projected(new_schema_ptr_,
+                                                           target_tuple_ptr,
+                                                           target_attribute_indices_,
+                                                           target_tuple_ptr->get_arrived_time());
 #ifdef CURRENTIA_ENABLE_TRANSACTION
             projected_tuple->set_lwm(target_tuple_ptr->get_lwm());
 #endif
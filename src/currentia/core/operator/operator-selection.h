@@ -5,7 +5,9 @@
 
 #include "currentia/core/object.h"
 #include "currentia/core/operator/condition.h"
+#include "currentia/core/operator/condition-program.h"
 #include "currentia/core/operator/single-input-operator.h"
+#include "currentia/core/operator/vectorized-selection.h"
 #include "currentia/core/stream.h"
 #include "currentia/core/tuple.h"
 #include "currentia/trait/pointable.h"
@@ -14,10 +16,15 @@ namespace currentia {
     class OperatorSelection: public SingleInputOperator,
                              public Pointable<OperatorSelection> {
         Condition::ptr_t condition_ptr_;
+        ConditionProgram::ptr_t condition_program_;
+        // for batches (NULL if no conjunct can be evaluated column-at-a-time)
+        VectorizedSelection::ptr_t vectorized_selection_;
 
         int input_tuple_count_;
         int selected_tuple_count_;
 
+        Stream::batch_t selected_tuples_;
+
     public:
         typedef Pointable<OperatorSelection>::ptr_t ptr_t;
 
@@ -28,18 +35,45 @@ namespace currentia {
             condition_ptr_(condition_ptr),
             input_tuple_count_(0),
             selected_tuple_count_(0) {
+            // resolve attributes in the condition (missing ones are
+            // looked up, and reported, on evaluation)
+            Schema::ptr_t input_schema_ptr = parent_operator_ptr->get_output_schema_ptr();
+            try {
+                condition_ptr_->obey_schema(input_schema_ptr, input_schema_ptr);
+            } catch (const std::string& error) {
+            }
+            condition_program_ = ConditionProgram::compile(condition_ptr_);
+            vectorized_selection_ = VectorizedSelection::create(condition_ptr_);
             // Arrange an output stream
             set_output_stream(Stream::from_schema(parent_operator_ptr->get_output_schema_ptr()));
         }
 
         void process_single_input(Tuple::ptr_t input_tuple) {
             input_tuple_count_++;
-            if (condition_ptr_->check(input_tuple)) {
+            if (condition_program_->check(input_tuple)) {
                 selected_tuple_count_++;
                 output_tuple(input_tuple);
             }
         }
 
+        void process_batch(const Stream::batch_t& input_tuples) {
+            selected_tuples_.clear();
+            if (vectorized_selection_) {
+                vectorized_selection_->select(input_tuples, selected_tuples_);
+            } else {
+                auto iter = input_tuples.begin();
+                auto iter_end = input_tuples.end();
+                for (; iter != iter_end; ++iter) {
+                    if (condition_program_->check(*iter))
+                        selected_tuples_.push_back(*iter);
+                }
+            }
+            input_tuple_count_ += input_tuples.size();
+            selected_tuple_count_ += selected_tuples_.size();
+            if (!selected_tuples_.empty())
+                output_tuples(selected_tuples_);
+        }
+
         double get_selectivity() {
             if (input_tuple_count_ == 0)
                 return 0.0;
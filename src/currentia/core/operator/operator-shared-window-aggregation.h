@@ -0,0 +1,159 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_OPERATOR_SHARED_WINDOW_AGGREGATION_H_
+#define CURRENTIA_OPERATOR_SHARED_WINDOW_AGGREGATION_H_
+
+#include "currentia/core/operator/operator-aggregation.h"
+#include "currentia/core/operator/pane-aggregation.h"
+#include "currentia/core/operator/single-input-operator.h"
+#include "currentia/core/schema.h"
+#include "currentia/core/stream.h"
+#include "currentia/core/tuple.h"
+#include "currentia/core/window.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace currentia {
+    // Aggregates of one input stream over several tuple-based windows
+    // (e.g., those of queries aggregating the same stream with
+    // different [recent W slide S]), evaluated on shared panes (see
+    // PaneWindowAggregator) instead of a synopsis per window. The
+    // results of each window go to an output stream of its own
+    // (get_window_output_stream()); get_output_stream() is that of the
+    // first window. System messages go to every window stream.
+    //
+    // With tag_windows, the results of all the windows go to
+    // get_output_stream() instead, led by an INT attribute WINDOW (the
+    // index of the window), so that a CPL query with several windows
+    // derives one stream (aggregate sum s.x [recent 10 slide 5],
+    // [recent 20 slide 5]).
+    //
+    // Tuples are not kept, so the windows cannot be checked for
+    // reference consistency; this operator does not serve as a commit
+    // operator of concurrency control.
+    class OperatorSharedWindowAggregation: public SingleInputOperator {
+    public:
+        typedef OperatorAggregation::Specification Specification;
+        typedef OperatorAggregation::specifications_t specifications_t;
+
+    private:
+        specifications_t specifications_;
+        bool tag_windows_;
+        std::vector<Stream::ptr_t> window_output_streams_;
+        PaneWindowAggregator aggregator_;
+
+    public:
+        OperatorSharedWindowAggregation(Operator::ptr_t parent_operator_ptr,
+                                        const std::vector<Window>& windows,
+                                        const specifications_t& specifications,
+                                        bool tag_windows = false):
+            SingleInputOperator(parent_operator_ptr),
+            specifications_(specifications),
+            tag_windows_(tag_windows),
+            aggregator_(create_aggregator_(parent_operator_ptr->get_output_schema_ptr(),
+                                           windows,
+                                           specifications,
+                                           this)) {
+            if (specifications_.empty())
+                throw std::string("OperatorSharedWindowAggregation: no aggregate is specified");
+
+            Schema::ptr_t input_schema = parent_operator_ptr->get_output_schema_ptr();
+            Schema::ptr_t output_stream_schema(new Schema());
+            if (tag_windows_)
+                output_stream_schema->add_attribute("WINDOW", Object::INT);
+            for (auto iter = specifications_.begin(); iter != specifications_.end(); ++iter) {
+                AggregateFunction::ptr_t aggregate =
+                    AggregateFunction::create(iter->type, input_schema, iter->attribute_name);
+                OperatorAggregation::add_result_attribute(output_stream_schema,
+                                                          *iter,
+                                                          aggregate->get_result_type());
+            }
+            for (size_t i = 0; i < (tag_windows_ ? 1 : windows.size()); ++i)
+                window_output_streams_.push_back(Stream::from_schema(output_stream_schema));
+            set_output_stream(window_output_streams_.front());
+        }
+
+        void process_single_input(Tuple::ptr_t input_tuple) {
+            aggregator_.insert(*input_tuple);
+        }
+
+        // Windows start over from the next tuple, as a synopsis does
+        void reset() {
+            aggregator_.clear();
+        }
+
+        // get_output_stream() for every window with tag_windows
+        Stream::ptr_t get_window_output_stream(size_t window_index) const {
+            return window_output_streams_[tag_windows_ ? 0 : window_index];
+        }
+
+        const PaneWindowAggregator& get_aggregator() const {
+            return aggregator_;
+        }
+
+        std::string toString() const {
+            std::stringstream ss;
+            ss << parent_operator_ptr_->toString() << "\n -> " << get_name() << "(";
+            for (auto iter = specifications_.begin(); iter != specifications_.end(); ++iter)
+                ss << iter->toString() << ", ";
+            const std::vector<Window>& windows = aggregator_.get_windows();
+            for (auto iter = windows.begin(); iter != windows.end(); ++iter)
+                ss << iter->toString() << ", ";
+            ss << "pane " << aggregator_.get_pane_size() << ")";
+            return ss.str();
+        }
+
+        std::string get_name() const {
+            return std::string("SharedWindowAggregation");
+        }
+
+    protected:
+        void output_system_message(const Tuple::ptr_t& message) {
+            total_output_++;
+            for (auto iter = window_output_streams_.begin(), iter_end = window_output_streams_.end();
+                 iter != iter_end;
+                 ++iter) {
+                (*iter)->enqueue(message);
+            }
+        }
+
+    private:
+        static PaneWindowAggregator create_aggregator_(const Schema::ptr_t& schema_ptr,
+                                                       const std::vector<Window>& windows,
+                                                       const specifications_t& specifications,
+                                                       OperatorSharedWindowAggregation* self) {
+            try {
+                return PaneWindowAggregator(schema_ptr, windows, specifications,
+                                            std::bind(&OperatorSharedWindowAggregation::output_window_,
+                                                      self,
+                                                      std::placeholders::_1,
+                                                      std::placeholders::_2,
+                                                      std::placeholders::_3));
+            } catch (const std::string& error) {
+                throw "OperatorSharedWindowAggregation: " + error;
+            }
+        }
+
+        void output_window_(size_t window_index, const Tuple::data_t& results, time_t lwm) {
+            Tuple::ptr_t window_tuple;
+            if (tag_windows_) {
+                Tuple::data_t tagged_results;
+                tagged_results.reserve(results.size() + 1);
+                tagged_results.push_back(Object(static_cast<int>(window_index)));
+                tagged_results.insert(tagged_results.end(), results.begin(), results.end());
+                window_tuple = Tuple::create(get_output_schema_ptr(), tagged_results);
+            } else {
+                window_tuple = Tuple::create(get_output_schema_ptr(), results);
+            }
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            window_tuple->set_lwm(lwm);
+#endif
+            total_output_++;
+            get_window_output_stream(window_index)->enqueue(window_tuple);
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_OPERATOR_SHARED_WINDOW_AGGREGATION_H_ */
@@ -5,16 +5,20 @@
 
 #include "currentia/core/object.h"
 #include "currentia/core/operator/condition.h"
+#include "currentia/core/operator/condition-program.h"
 #include "currentia/core/operator/single-input-operator.h"
 #include "currentia/core/operator/trait-resource-reference-operator.h"
 #include "currentia/core/operator/synopsis.h"
 #include "currentia/core/relation.h"
+#include "currentia/core/relation-index.h"
 #include "currentia/core/stream.h"
 #include "currentia/core/thread.h"
 #include "currentia/core/tuple.h"
 #include "currentia/core/window.h"
 #include "currentia/trait/pointable.h"
 
+#include <list>
+
 namespace currentia {
     // Equi-Join
     class OperatorSimpleRelationJoin: public SingleInputOperator,
@@ -22,9 +26,20 @@ namespace currentia {
                                       public Pointable<OperatorSimpleRelationJoin> {
         Relation::ptr_t relation_;
         Condition::ptr_t join_condition_;
-
-        std::string join_attribute_name_stream_;
-        std::string join_attribute_name_relation_;
+        ConditionProgram::ptr_t join_program_;
+
+        // Conjuncts "stream.attr <comparator> relation.attr" which an
+        // index on relation.attr can answer. The first one whose
+        // attribute has a suitable index at evaluation time is used.
+        struct IndexCandidate {
+            int stream_attribute_index;
+            int relation_attribute_index;
+            // comparator for "relation.attr <comparator> stream.attr"
+            Comparator::Type comparator;
+            // rest of the conjuncts (NULL if nothing remains)
+            ConditionProgram::ptr_t residual_program;
+        };
+        std::list<IndexCandidate> index_candidates_;
 
         Schema::ptr_t stream_schema_ptr_;
         Schema::ptr_t relation_schema_ptr_;
@@ -51,28 +66,24 @@ namespace currentia {
                 parent_operator_ptr->get_output_stream()->get_schema(),
                 relation->get_schema()
             );
+            join_program_ = ConditionProgram::compile(join_condition_);
             // snapshot pointers
             set_reference_to_snapshots({ &relation_ });
+            // find conjuncts an index can answer
+            collect_index_candidates_();
         }
 
         void process_single_input(Tuple::ptr_t input_tuple) {
             reference_operation_begin(cc_mode_);
 
-            // TODO: Use index
-            auto relation_iter = relation_->get_tuple_iterator();
-            auto relation_iter_end = relation_->get_tuple_iterator_end();
-            for (; relation_iter != relation_iter_end; ++relation_iter) {
-                if (join_condition_->check(input_tuple, *relation_iter)) {
-                    Tuple::data_t combined_data = input_tuple->get_concatenated_data(*relation_iter);
-                    Tuple::ptr_t combined_tuple = Tuple::create(joined_schema_ptr_,
-                                                                combined_data,
-                                                                input_tuple->get_arrived_time());
-#ifdef CURRENTIA_ENABLE_TRANSACTION
-                    combined_tuple->set_lwm(input_tuple->get_lwm());
-                    combined_tuple->set_referenced_version_number(relation_, relation_->get_version_number());
-#endif
-
-                    output_tuple(combined_tuple);
+            // never waits for writers of the relation
+            Relation::View view = relation_->get_view();
+            if (!join_with_index_(input_tuple, view)) {
+                auto relation_iter = view.begin();
+                auto relation_iter_end = view.end();
+                for (; relation_iter != relation_iter_end; ++relation_iter) {
+                    if (join_program_->check(input_tuple, *relation_iter))
+                        output_joined_tuple_(input_tuple, *relation_iter, view);
                 }
             }
 
@@ -84,6 +95,83 @@ namespace currentia {
         }
 
     private:
+        void collect_index_candidates_() {
+            std::list<Condition::ptr_t> conjuncts;
+            collect_conjuncts(join_condition_, conjuncts);
+
+            auto iter = conjuncts.begin();
+            auto iter_end = conjuncts.end();
+            for (; iter != iter_end; ++iter) {
+                ConditionAttributeComparator::ptr_t comparator =
+                    std::dynamic_pointer_cast<ConditionAttributeComparator>(*iter);
+                if (!comparator ||
+                    comparator->is_negated() ||
+                    comparator->get_comparator_type() == Comparator::NOT_EQUAL)
+                    continue;
+
+                IndexCandidate candidate;
+                candidate.stream_attribute_index =
+                    stream_schema_ptr_->get_attribute_index_by_name(comparator->get_left_attribute_name());
+                candidate.relation_attribute_index =
+                    relation_schema_ptr_->get_attribute_index_by_name(comparator->get_right_attribute_name());
+                candidate.comparator = Comparator::mirror(comparator->get_comparator_type());
+
+                std::list<Condition::ptr_t> residual_conjuncts;
+                auto residual_iter = conjuncts.begin();
+                for (; residual_iter != iter_end; ++residual_iter) {
+                    if (residual_iter != iter)
+                        residual_conjuncts.push_back(*residual_iter);
+                }
+                Condition::ptr_t residual_condition = conjoin_conditions(residual_conjuncts);
+                if (residual_condition)
+                    candidate.residual_program = ConditionProgram::compile(residual_condition);
+
+                // equalities first, as they are the most selective
+                if (candidate.comparator == Comparator::EQUAL)
+                    index_candidates_.push_front(candidate);
+                else
+                    index_candidates_.push_back(candidate);
+            }
+        }
+
+        // Returns false if no index can answer the join condition.
+        // Indices are looked up on every call, since relation_ is
+        // replaced by snapshots and indices may be created later.
+        bool join_with_index_(const Tuple::ptr_t& input_tuple, const Relation::View& view) {
+            auto iter = index_candidates_.begin();
+            auto iter_end = index_candidates_.end();
+            for (; iter != iter_end; ++iter) {
+                RelationIndex::ptr_t index = view.get_index(iter->relation_attribute_index);
+                if (!index || !index->supports(iter->comparator))
+                    continue;
+
+                const ConditionProgram::ptr_t& residual_program = iter->residual_program;
+                index->for_each_match(
+                    iter->comparator,
+                    input_tuple->get_value_by_index(iter->stream_attribute_index),
+                    [&](const Tuple::ptr_t& relation_tuple) {
+                        if (!residual_program || residual_program->check(input_tuple, relation_tuple))
+                            output_joined_tuple_(input_tuple, relation_tuple, view);
+                    });
+                return true;
+            }
+            return false;
+        }
+
+        void output_joined_tuple_(const Tuple::ptr_t& input_tuple,
+                                  const Tuple::ptr_t& relation_tuple,
+                                  const Relation::View& view) {
+            Tuple::ptr_t combined_tuple = Tuple::create_concatenated(joined_schema_ptr_,
+                                                                     input_tuple,
+                                                                     relation_tuple,
+                                                                     input_tuple->get_arrived_time());
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            combined_tuple->set_lwm(input_tuple->get_lwm());
+            combined_tuple->set_referenced_version_number(relation_, view.get_version_number());
+#endif
+
+            output_tuple(combined_tuple);
+        }
 
         Schema::ptr_t build_joined_schema_() {
             return concat_schemas(stream_schema_ptr_, relation_schema_ptr_);
@@ -0,0 +1,322 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_OPERATOR_SKETCH_AGGREGATION_H_
+#define CURRENTIA_OPERATOR_SKETCH_AGGREGATION_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/operator/pane-aggregation.h"
+#include "currentia/core/operator/single-input-operator.h"
+#include "currentia/core/operator/sketch-function.h"
+#include "currentia/core/operator/trait-aggregation-operator.h"
+#include "currentia/core/schema.h"
+#include "currentia/core/stream.h"
+#include "currentia/core/tuple.h"
+#include "currentia/core/window.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace currentia {
+    // Aggregation operator computing approximate aggregates (see
+    // SketchFunction) over a tuple-based window without keeping its
+    // tuples. The window is split into panes of gcd(width, stride)
+    // tuples; the synopsis holds the current pane only, each completed
+    // pane is summarized by a sketch per specification, and the result
+    // of a window is computed from the merged sketches of its panes.
+    // Memory depends on the error bounds and on width / pane, not on
+    // the width.
+    //
+    // Each window is emitted as a single tuple holding the results in
+    // the order of the specifications.
+    class OperatorSketchAggregation: public SingleInputOperator,
+                                     public TraitAggregationOperator {
+    public:
+        typedef SketchFunction::Specification Specification;
+        typedef std::vector<Specification> specifications_t;
+        typedef std::vector<SketchFunction::ptr_t> sketches_t;
+
+    private:
+        struct Pane {
+            sketches_t sketches;
+            Tuple::ptr_t first_tuple;
+            time_t lwm;
+            // all the tuples of the pane referenced the same versions
+            bool consistent;
+        };
+
+        specifications_t specifications_;
+        // sketches of the tuples accepted into the current pane
+        sketches_t current_sketches_;
+        // completed panes of the window, the newest at the back
+        std::deque<Pane> panes_;
+        long pane_size_;
+        long window_panes_count_;
+        long stride_panes_count_;
+        // since the last reset()
+        long completed_panes_count_;
+
+    public:
+        OperatorSketchAggregation(Operator::ptr_t parent_operator_ptr,
+                                  Window window,
+                                  const specifications_t& specifications):
+            SingleInputOperator(parent_operator_ptr),
+            TraitAggregationOperator(window,
+                                     get_pane_window(window),
+                                     std::bind(&OperatorSketchAggregation::complete_pane_, this)),
+            specifications_(specifications),
+            completed_panes_count_(0) {
+            if (specifications_.empty())
+                throw std::string("OperatorSketchAggregation: no aggregate is specified");
+
+            pane_size_ = get_pane_window(window).width;
+            window_panes_count_ = window.width / pane_size_;
+            stride_panes_count_ = window.stride / pane_size_;
+
+            Schema::ptr_t input_schema = parent_operator_ptr->get_output_schema_ptr();
+            for (auto iter = specifications_.begin(); iter != specifications_.end(); ++iter) {
+                try {
+                    current_sketches_.push_back(SketchFunction::create(*iter, input_schema));
+                } catch (const std::string& error) {
+                    throw "OperatorSketchAggregation: " + error;
+                }
+            }
+
+            Schema::ptr_t output_stream_schema(new Schema());
+            for (size_t i = 0; i < specifications_.size(); ++i)
+                add_result_attribute(output_stream_schema,
+                                     specifications_[i],
+                                     current_sketches_[i]->get_result_type());
+            set_output_stream(Stream::from_schema(output_stream_schema));
+
+            synopsis_->set_on_insert([this](const Tuple::ptr_t& tuple) {
+                for (auto iter = current_sketches_.begin(); iter != current_sketches_.end(); ++iter)
+                    (*iter)->insert(*tuple);
+            });
+        }
+
+        // The window of the panes; throws a std::string for invalid
+        // windows (see compute_pane_size())
+        static Window get_pane_window(const Window& window) {
+            try {
+                long pane_size = compute_pane_size(std::vector<Window>(1, window));
+                return Window(pane_size, pane_size);
+            } catch (const std::string& error) {
+                throw "OperatorSketchAggregation: " + error;
+            }
+        }
+
+        void process_single_input(Tuple::ptr_t input_tuple) {
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            check_window_committed_(in_pessimistic_cc(), input_tuple);
+#endif
+            synopsis_->enqueue(input_tuple);
+        }
+
+        // Windows start over from the next tuple
+        void reset() {
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            reset_window_output_();
+#endif
+            synopsis_->reset();
+            panes_.clear();
+            for (auto iter = current_sketches_.begin(); iter != current_sketches_.end(); ++iter)
+                (*iter)->clear();
+            completed_panes_count_ = 0;
+        }
+
+        // The oldest tuple of the window is not kept but for the first
+        // tuple of each pane
+        time_t get_window_beginning_lwm() const {
+            if (panes_.empty())
+                return TraitAggregationOperator::get_window_beginning_lwm();
+            return panes_.front().first_tuple->get_lwm();
+        }
+
+        const specifications_t& get_specifications() const {
+            return specifications_;
+        }
+
+        long get_pane_size() const {
+            return pane_size_;
+        }
+
+        // Bytes of the sketches held
+        size_t get_memory_size() const {
+            size_t memory_size = 0;
+            for (auto iter = current_sketches_.begin(); iter != current_sketches_.end(); ++iter)
+                memory_size += (*iter)->get_memory_size();
+            for (auto pane_iter = panes_.begin(); pane_iter != panes_.end(); ++pane_iter) {
+                for (auto iter = pane_iter->sketches.begin(); iter != pane_iter->sketches.end(); ++iter)
+                    memory_size += (*iter)->get_memory_size();
+            }
+            return memory_size;
+        }
+
+        // Result attributes are named after the aggregated attributes,
+        // or "<TYPE>_<attribute>" when the name is already taken
+        static void add_result_attribute(const Schema::ptr_t& schema_ptr,
+                                         const Specification& specification,
+                                         Object::Type result_type) {
+            std::string name = specification.attribute_name;
+            if (schema_ptr->get_attribute_index_by_name(name) >= 0)
+                name = SketchFunction::type_to_string(specification.type) + "_" + name;
+            schema_ptr->add_attribute(name, result_type);
+        }
+
+    protected:
+        // Outputs the merged sketches of a window
+        virtual void output_window_(const sketches_t& sketches, time_t lwm) {
+            Tuple::data_t results;
+            for (auto iter = sketches.begin(); iter != sketches.end(); ++iter)
+                results.push_back((*iter)->get_result());
+
+            Tuple::ptr_t aggregated_tuple = Tuple::create(get_output_schema_ptr(), results);
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            aggregated_tuple->set_lwm(lwm);
+#endif
+            output_tuple(aggregated_tuple);
+        }
+
+    private:
+        void complete_pane_() {
+            Pane pane;
+            // the sketches of the pane leaving the window are reused
+            // for the next one
+            sketches_t next_sketches;
+            if (static_cast<long>(panes_.size()) == window_panes_count_) {
+                next_sketches.swap(panes_.front().sketches);
+                panes_.pop_front();
+                for (auto iter = next_sketches.begin(); iter != next_sketches.end(); ++iter)
+                    (*iter)->clear();
+            } else {
+                for (auto iter = current_sketches_.begin(); iter != current_sketches_.end(); ++iter)
+                    next_sketches.push_back((*iter)->create_empty());
+            }
+            pane.sketches.swap(current_sketches_);
+            current_sketches_.swap(next_sketches);
+
+            pane.first_tuple = synopsis_->get_window_beginning_tuple();
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            pane.lwm = synopsis_->get_lwm();
+            pane.consistent = !is_commit_operator() || synopsis_->has_reference_consistency();
+#else
+            pane.lwm = 0;
+            pane.consistent = true;
+#endif
+            panes_.push_back(pane);
+            completed_panes_count_++;
+
+            if (completed_panes_count_ >= window_panes_count_ &&
+                (completed_panes_count_ - window_panes_count_) % stride_panes_count_ == 0)
+                output_merged_panes_();
+        }
+
+        bool has_reference_consistency_() const {
+            for (auto iter = panes_.begin(); iter != panes_.end(); ++iter) {
+                if (!iter->consistent ||
+                    !Synopsis::have_same_referenced_versions(*panes_.front().first_tuple, *iter->first_tuple))
+                    return false;
+            }
+            return true;
+        }
+
+        void output_merged_panes_() {
+            time_t lwm = 0;
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            lwm = panes_.front().lwm;
+            for (auto iter = panes_.begin(); iter != panes_.end(); ++iter)
+                lwm = std::min(lwm, iter->lwm);
+            count_window_output_(cc_mode_, is_commit_operator(), [this]() {
+                return has_reference_consistency_();
+            });
+#endif
+            sketches_t sketches;
+            for (auto iter = current_sketches_.begin(); iter != current_sketches_.end(); ++iter)
+                sketches.push_back((*iter)->create_empty());
+            for (auto pane_iter = panes_.begin(); pane_iter != panes_.end(); ++pane_iter) {
+                for (size_t i = 0; i < sketches.size(); ++i)
+                    sketches[i]->merge(*pane_iter->sketches[i]);
+            }
+
+            output_window_(sketches, lwm);
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            end_window_output_(cc_mode_);
+#endif
+        }
+
+    public:
+        std::string toString() const {
+            std::stringstream ss;
+            ss << parent_operator_ptr_->toString() << "\n -> " << get_name() << "(";
+            for (auto iter = specifications_.begin(); iter != specifications_.end(); ++iter)
+                ss << iter->toString() << ", ";
+            ss << window_.toString() << ", pane " << get_pane_size() << ")";
+            return ss.str();
+        }
+
+        std::string get_name() const {
+            return std::string("SketchAggregation");
+        }
+    };
+
+    // Most frequent values of an attribute in a window (heavy hitters)
+    // in SpaceSaving sketches. Each window is emitted as up to `count`
+    // tuples of a value and its estimated number of occurrences
+    // ("COUNT_<attribute>", at most error * width too many), from the
+    // most frequent.
+    class OperatorHeavyHitters: public OperatorSketchAggregation {
+        std::string attribute_name_;
+
+    public:
+        OperatorHeavyHitters(Operator::ptr_t parent_operator_ptr,
+                             Window window,
+                             const std::string& attribute_name,
+                             long count,
+                             double error = SketchFunction::DEFAULT_ERROR):
+            OperatorSketchAggregation(parent_operator_ptr,
+                                      window,
+                                      specifications_t(1, Specification(SketchFunction::TOP,
+                                                                        attribute_name,
+                                                                        count,
+                                                                        error))),
+            attribute_name_(attribute_name) {
+            Schema::ptr_t input_schema = parent_operator_ptr->get_output_schema_ptr();
+            Schema::ptr_t output_stream_schema(new Schema());
+            output_stream_schema->add_attribute(attribute_name,
+                                                input_schema->get_attribute_type_by_index(
+                                                    input_schema->get_attribute_index_by_name(attribute_name)));
+            output_stream_schema->add_attribute("COUNT_" + attribute_name, Object::INT);
+            set_output_stream(Stream::from_schema(output_stream_schema));
+        }
+
+        std::string get_name() const {
+            return std::string("HeavyHitters");
+        }
+
+    protected:
+        void output_window_(const sketches_t& sketches, time_t lwm) {
+            std::vector<SpaceSaving::Counter> top =
+                static_cast<const SketchTop&>(*sketches.front()).get_top();
+
+            Stream::batch_t top_tuples;
+            top_tuples.reserve(top.size());
+            for (auto iter = top.begin(); iter != top.end(); ++iter) {
+                Tuple::data_t values;
+                values.push_back(iter->item);
+                values.push_back(Object(iter->count));
+                Tuple::ptr_t top_tuple = Tuple::create(get_output_schema_ptr(), values);
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+                top_tuple->set_lwm(lwm);
+#endif
+                top_tuples.push_back(top_tuple);
+            }
+            output_tuples(top_tuples);
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_OPERATOR_SKETCH_AGGREGATION_H_ */
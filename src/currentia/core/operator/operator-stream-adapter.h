@@ -14,6 +14,7 @@ namespace currentia {
                                  public VisitableOperator<OperatorStreamAdapter> {
         Stream::ptr_t input_stream_ptr_;
         std::string stream_name_;
+        Stream::batch_t input_batch_;
 
     public:
         OperatorStreamAdapter(Stream::ptr_t input_stream_ptr,
@@ -34,6 +35,33 @@ namespace currentia {
             output_tuple(input_tuple);
         }
 
+        void next_batch_implementation(int batch_count) {
+            input_batch_.clear();
+            size_t dequeued_count = input_stream_ptr_->dequeue_batch(input_batch_, batch_count);
+            if (dequeued_count == 0)
+                return;
+#ifdef CURRENTIA_CHECK_STATISTICS
+            evaluation_count_ += dequeued_count;
+#endif
+            output_tuples(input_batch_);
+        }
+
+        bool has_input() const {
+            return input_stream_ptr_->has_tuple();
+        }
+
+        size_t get_input_tuples_count() const {
+            return input_stream_ptr_->get_tuples_count();
+        }
+
+        time_t get_oldest_input_time() const {
+            return get_input_time_(input_stream_ptr_->peek());
+        }
+
+        void collect_external_input_streams(std::vector<Stream::ptr_t>& streams) const {
+            streams.push_back(input_stream_ptr_);
+        }
+
         Stream::ptr_t get_input_stream() {
             return input_stream_ptr_;
         }
@@ -4,6 +4,7 @@
 #define CURRENTIA_OPERATOR_VISITOR_SERIALIZER_H_
 
 #include <iostream>
+#include <map>
 
 #include "currentia/core/operator/double-input-operator.h"
 #include "currentia/core/operator/operator-abstract-visitor.h"
@@ -16,6 +17,7 @@ namespace currentia {
     class OperatorVisitorSerializer : public OperatorAbstractVisitor,
                                       public Pointable<OperatorVisitorSerializer> {
         std::vector<Operator*> operators_;
+        std::map<Operator*, Operator*> consumers_;
 
     public:
         typedef Pointable<OperatorVisitorSerializer>::ptr_t ptr_t;
@@ -35,19 +37,35 @@ namespace currentia {
             return serializer.get_sorted_operators();
         }
 
+        // Maps each operator of a tree to the operator reading its
+        // output stream (the root has none)
+        static std::map<Operator*, Operator*>
+        find_consumers(Operator* root_operator_ptr) {
+            OperatorVisitorSerializer serializer;
+            serializer.dispatch(root_operator_ptr);
+            return serializer.get_consumers();
+        }
+
         std::vector<Operator*> get_sorted_operators() const {
             return operators_;
         }
 
+        std::map<Operator*, Operator*> get_consumers() const {
+            return consumers_;
+        }
+
         void visit(SingleInputOperator* op) {
             dispatch(op->get_parent_operator().get());
             operators_.push_back(op);
+            consumers_[op->get_parent_operator().get()] = op;
         }
 
         void visit(DoubleInputOperator* op) {
             dispatch(op->get_parent_left_operator().get());
             dispatch(op->get_parent_right_operator().get());
             operators_.push_back(op);
+            consumers_[op->get_parent_left_operator().get()] = op;
+            consumers_[op->get_parent_right_operator().get()] = op;
         }
 
         void visit(OperatorStreamAdapter* op) {
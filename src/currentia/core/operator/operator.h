@@ -12,6 +12,9 @@
 #include "currentia/trait/pointable.h"
 #include "currentia/trait/show.h"
 
+#include <climits>
+#include <vector>
+
 namespace currentia {
     class Operator: private NonCopyable<Operator>,
                     public Pointable<Operator>,
@@ -53,7 +56,11 @@ namespace currentia {
         Operator():
             is_redo_area_leaf_(false),
             evaluation_count_(0),
-            total_output_(0) {
+            total_output_(0)
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            , cc_mode_(NONE)
+#endif
+        {
             set_is_commit_operator(false);
         }
         virtual ~Operator() = 0;
@@ -63,17 +70,45 @@ namespace currentia {
             if (batch_count == 1) {
                 next_implementation();
             } else {
-                for (int i = 0; i < batch_count; ++i) {
-                    next_implementation();
-                }
+                next_batch_implementation(batch_count);
             }
         }
 
         virtual void next_implementation() = 0;
 
+        // Process at most batch_count tuples. Operators which can
+        // take tuples from their input streams at once override this.
+        virtual void next_batch_implementation(int batch_count) {
+            for (int i = 0; i < batch_count; ++i) {
+                next_implementation();
+            }
+        }
+
         virtual void reset() {
         }
 
+        // Whether process_next() would consume a tuple now. Only
+        // meaningful to the thread about to run the operator.
+        virtual bool has_input() const = 0;
+
+        // Number of tuples waiting for the operator (in the input
+        // streams process_next() would read)
+        virtual size_t get_input_tuples_count() const = 0;
+
+        // arrived_time of the oldest tuple process_next() would read
+        // (0 for a system message), or NO_INPUT_TIME without input.
+        // Same caveat as has_input().
+        virtual time_t get_oldest_input_time() const = 0;
+
+        static const time_t NO_INPUT_TIME = LONG_MAX;
+
+        // Appends the input streams which other threads fill (e.g.,
+        // senders), whose arrivals make the operator ready while the
+        // thread evaluating it is idle. Streams between operators of
+        // the tree are filled by the evaluating thread itself.
+        virtual void collect_external_input_streams(std::vector<Stream::ptr_t>& streams) const {
+        }
+
         void set_is_commit_operator(bool is_commit_operator) {
             is_commit_operator_ = is_commit_operator;
         }
@@ -94,6 +129,10 @@ namespace currentia {
             return evaluation_count_;
         }
 
+        long get_output_count() const {
+            return total_output_;
+        }
+
 #ifdef CURRENTIA_ENABLE_TRANSACTION
         void set_cc_mode(enum CCMode cc_mode) {
             cc_mode_ = cc_mode;
@@ -133,10 +172,22 @@ namespace currentia {
             // }
         }
 
+        void output_tuples(const Stream::batch_t& tuples) {
+            total_output_ += tuples.size();
+            output_stream_->enqueue_batch(tuples);
+        }
+
         double get_selectivity() const {
             return static_cast<double>(total_output_) / evaluation_count_;
         }
 
+    protected:
+        static time_t get_input_time_(const Tuple::ptr_t& tuple) {
+            return tuple ? tuple->get_arrived_time() : NO_INPUT_TIME;
+        }
+
+    public:
+
         virtual std::string get_name() const = 0;
     };
 
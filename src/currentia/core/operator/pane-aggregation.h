@@ -0,0 +1,290 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_PANE_AGGREGATION_H_
+#define CURRENTIA_PANE_AGGREGATION_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/operation/typed-operations.h"
+#include "currentia/core/operator/aggregate-function.h"
+#include "currentia/core/operator/operator-aggregation.h"
+#include "currentia/core/schema.h"
+#include "currentia/core/tuple.h"
+#include "currentia/core/window.h"
+
+#include <algorithm>            // std::min, std::max
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace currentia {
+    // Partial aggregate of an attribute over a pane (a run of
+    // consecutive tuples). Partials of adjacent panes merge into the
+    // aggregate of a window made of whole panes.
+    class PanePartial {
+        long count_;
+        long long int_sum_;
+        double float_sum_;
+        double minimum_;
+        double maximum_;
+
+    public:
+        PanePartial() {
+            clear();
+        }
+
+        void clear() {
+            count_ = 0;
+            int_sum_ = 0;
+            float_sum_ = 0;
+            minimum_ = 0;
+            maximum_ = 0;
+        }
+
+        void add_int(int value) {
+            int_sum_ += value;
+            add_extremum_(value);
+        }
+
+        void add_float(double value) {
+            float_sum_ += value;
+            add_extremum_(value);
+        }
+
+        // Tuples of a COUNT (whose attribute may not be a number)
+        void add_tuple() {
+            count_++;
+        }
+
+        void merge(const PanePartial& partial) {
+            if (partial.count_ == 0)
+                return;
+            if (count_ == 0) {
+                minimum_ = partial.minimum_;
+                maximum_ = partial.maximum_;
+            } else {
+                minimum_ = std::min(minimum_, partial.minimum_);
+                maximum_ = std::max(maximum_, partial.maximum_);
+            }
+            count_ += partial.count_;
+            int_sum_ += partial.int_sum_;
+            float_sum_ += partial.float_sum_;
+        }
+
+        // Result over a non-empty window (attribute_type is that of the
+        // aggregated attribute; see AggregateFunction for result types)
+        Object get_result(AggregateFunction::Type type, Object::Type attribute_type) const {
+            bool is_int = attribute_type == Object::INT;
+            switch (type) {
+            case AggregateFunction::SUM:
+                return is_int ? AggregateFunction::int_sum_to_object(int_sum_) : Object(float_sum_);
+            case AggregateFunction::COUNT:
+                return Object(count_);
+            case AggregateFunction::MIN:
+                return is_int ? Object(static_cast<int>(minimum_)) : Object(minimum_);
+            case AggregateFunction::MAX:
+                return is_int ? Object(static_cast<int>(maximum_)) : Object(maximum_);
+            case AggregateFunction::MEAN:
+            default:
+                return Object((is_int ? static_cast<double>(int_sum_) : float_sum_) / count_);
+            }
+        }
+
+    private:
+        void add_extremum_(double value) {
+            if (count_ == 0) {
+                minimum_ = value;
+                maximum_ = value;
+            } else {
+                minimum_ = std::min(minimum_, value);
+                maximum_ = std::max(maximum_, value);
+            }
+            count_++;
+        }
+    };
+
+    // Size of the panes (gcd of the widths and the strides) splitting
+    // tuple-based windows into whole panes; throws a std::string for
+    // other windows and for a width or a stride below one
+    inline long compute_pane_size(const std::vector<Window>& windows) {
+        if (windows.empty())
+            throw std::string("no window is given");
+
+        long pane_size = 0;
+        for (auto iter = windows.begin(), iter_end = windows.end();
+             iter != iter_end;
+             ++iter) {
+            if (iter->type != Window::TUPLE_BASE)
+                throw std::string("panes are only supported for tuple-based windows");
+            if (iter->width < 1 || iter->stride < 1)
+                throw std::string("the width and the stride of a window have to be positive");
+            long values[] = { iter->width, iter->stride };
+            for (int i = 0; i < 2; ++i) {
+                long value = values[i];
+                while (value != 0) {
+                    long remainder = pane_size % value;
+                    pane_size = value;
+                    value = remainder;
+                }
+            }
+        }
+        return pane_size;
+    }
+
+    // Evaluates tuple-based windows of different widths and strides
+    // over one stream with shared state. The stream is split into panes
+    // of gcd(widths, strides) tuples, partial aggregates are computed
+    // once per pane, and the result of a window is merged from its
+    // panes. State and work per tuple depend on the number of panes in
+    // the widest window, not on the number of windows times their
+    // widths.
+    //
+    // Windows accept tuples as TupleBaseSynopsis does: the first result
+    // comes after `width` tuples, then every `stride` tuples.
+    class PaneWindowAggregator {
+    public:
+        typedef OperatorAggregation::Specification Specification;
+        typedef OperatorAggregation::specifications_t specifications_t;
+        // Called with the index of the window, the results (in the
+        // order of the specifications) and the lwm of the window (0
+        // without transactions)
+        typedef std::function<void(size_t, const Tuple::data_t&, time_t)> callback_t;
+
+    private:
+        struct Pane {
+            std::vector<PanePartial> partials; // one per specification
+            time_t lwm;
+        };
+
+        std::vector<Window> windows_;
+        specifications_t specifications_;
+        std::vector<int> attribute_indices_;
+        std::vector<Object::Type> attribute_types_;
+        callback_t on_window_;
+
+        long pane_size_;
+        size_t max_panes_count_;
+
+        Pane current_pane_;
+        long current_pane_tuples_count_;
+        // the newest at the back
+        std::deque<Pane> panes_;
+        // since the last clear()
+        long completed_panes_count_;
+
+    public:
+        PaneWindowAggregator(const Schema::ptr_t& schema_ptr,
+                             const std::vector<Window>& windows,
+                             const specifications_t& specifications,
+                             const callback_t& on_window):
+            windows_(windows),
+            specifications_(specifications),
+            on_window_(on_window),
+            pane_size_(compute_pane_size(windows)),
+            max_panes_count_(0) {
+            for (auto iter = windows_.begin(); iter != windows_.end(); ++iter)
+                max_panes_count_ = std::max(max_panes_count_, static_cast<size_t>(iter->width / pane_size_));
+
+            for (auto iter = specifications_.begin(); iter != specifications_.end(); ++iter) {
+                // validates the attribute
+                AggregateFunction::create(iter->type, schema_ptr, iter->attribute_name);
+                int attribute_index = schema_ptr->get_attribute_index_by_name(iter->attribute_name);
+                attribute_indices_.push_back(attribute_index);
+                attribute_types_.push_back(iter->type == AggregateFunction::COUNT
+                                           ? Object::UNKNOWN
+                                           : schema_ptr->get_attribute_type_by_index(attribute_index));
+            }
+
+            current_pane_.partials.resize(specifications_.size());
+            clear();
+        }
+
+        // Forgets all the panes; windows restart from the next tuple
+        void clear() {
+            panes_.clear();
+            completed_panes_count_ = 0;
+            clear_current_pane_();
+        }
+
+        void insert(const Tuple& tuple) {
+            for (size_t i = 0; i < specifications_.size(); ++i) {
+                switch (attribute_types_[i]) {
+                case Object::INT:
+                    current_pane_.partials[i].add_int(tuple.get_int_by_index(attribute_indices_[i]));
+                    break;
+                case Object::FLOAT:
+                    current_pane_.partials[i].add_float(tuple.get_float_by_index(attribute_indices_[i]));
+                    break;
+                default:
+                    current_pane_.partials[i].add_tuple();
+                    break;
+                }
+            }
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            if (current_pane_tuples_count_ == 0)
+                current_pane_.lwm = tuple.get_lwm();
+            else
+                current_pane_.lwm = std::min(current_pane_.lwm, tuple.get_lwm());
+#endif
+
+            if (++current_pane_tuples_count_ == pane_size_)
+                complete_pane_();
+        }
+
+        long get_pane_size() const {
+            return pane_size_;
+        }
+
+        // Number of completed panes held
+        size_t get_panes_count() const {
+            return panes_.size();
+        }
+
+        const std::vector<Window>& get_windows() const {
+            return windows_;
+        }
+
+    private:
+        void clear_current_pane_() {
+            for (auto iter = current_pane_.partials.begin(); iter != current_pane_.partials.end(); ++iter)
+                iter->clear();
+            current_pane_.lwm = 0;
+            current_pane_tuples_count_ = 0;
+        }
+
+        void complete_pane_() {
+            panes_.push_back(current_pane_);
+            if (panes_.size() > max_panes_count_)
+                panes_.pop_front();
+            completed_panes_count_++;
+            clear_current_pane_();
+
+            for (size_t i = 0; i < windows_.size(); ++i) {
+                long width_panes = windows_[i].width / pane_size_;
+                long stride_panes = windows_[i].stride / pane_size_;
+                if (completed_panes_count_ >= width_panes &&
+                    (completed_panes_count_ - width_panes) % stride_panes == 0)
+                    emit_window_(i, width_panes);
+            }
+        }
+
+        void emit_window_(size_t window_index, long width_panes) {
+            std::vector<PanePartial> partials(specifications_.size());
+            time_t lwm = 0;
+            auto iter = panes_.end() - width_panes;
+            for (bool first = true; iter != panes_.end(); ++iter, first = false) {
+                for (size_t i = 0; i < partials.size(); ++i)
+                    partials[i].merge(iter->partials[i]);
+                lwm = first ? iter->lwm : std::min(lwm, iter->lwm);
+            }
+
+            Tuple::data_t results;
+            results.reserve(partials.size());
+            for (size_t i = 0; i < partials.size(); ++i)
+                results.push_back(partials[i].get_result(specifications_[i].type, attribute_types_[i]));
+            on_window_(window_index, results, lwm);
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_PANE_AGGREGATION_H_ */
@@ -33,16 +33,78 @@ namespace currentia {
 #endif
 
             if (input_tuple->is_system_message()) {
-                output_tuple(input_tuple);
+                output_system_message(input_tuple);
                 return;
             }
 
             process_single_input(input_tuple);
         }
 
+        void next_batch_implementation(int batch_count) {
+            input_batch_.clear();
+            size_t dequeued_count = input_stream_->dequeue_batch(input_batch_, batch_count);
+            if (dequeued_count == 0)
+                return;
+
+#ifdef CURRENTIA_CHECK_STATISTICS
+            evaluation_count_ += dequeued_count;
+#endif
+
+            // System messages split the batch so that they keep their
+            // position relative to data tuples
+            data_batch_.clear();
+            auto iter = input_batch_.begin();
+            auto iter_end = input_batch_.end();
+            for (; iter != iter_end; ++iter) {
+                if ((*iter)->is_system_message()) {
+                    if (!data_batch_.empty()) {
+                        process_batch(data_batch_);
+                        data_batch_.clear();
+                    }
+                    output_system_message(*iter);
+                } else {
+                    data_batch_.push_back(*iter);
+                }
+            }
+            if (!data_batch_.empty())
+                process_batch(data_batch_);
+        }
+
         virtual void process_single_input(Tuple::ptr_t input_tuple) = 0;
 
+        // Processes consecutive data tuples (no system messages).
+        // Commit operators are always driven tuple by tuple
+        // (process_next() with batch count 1), so an exception thrown
+        // for concurrency control never cuts a batch short.
+        virtual void process_batch(const Stream::batch_t& input_tuples) {
+            auto iter = input_tuples.begin();
+            auto iter_end = input_tuples.end();
+            for (; iter != iter_end; ++iter)
+                process_single_input(*iter);
+        }
+
+        // Passes a system message (e.g., EOS) on to the output
+        virtual void output_system_message(const Tuple::ptr_t& message) {
+            output_tuple(message);
+        }
+
+    private:
+        Stream::batch_t input_batch_;
+        Stream::batch_t data_batch_;
+
     public:
+        bool has_input() const {
+            return input_stream_->has_tuple();
+        }
+
+        size_t get_input_tuples_count() const {
+            return input_stream_->get_tuples_count();
+        }
+
+        time_t get_oldest_input_time() const {
+            return get_input_time_(input_stream_->peek());
+        }
+
         const Operator::ptr_t get_parent_operator() const {
             return parent_operator_ptr_;
         }
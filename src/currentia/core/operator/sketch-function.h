@@ -0,0 +1,268 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_SKETCH_FUNCTION_H_
+#define CURRENTIA_SKETCH_FUNCTION_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/operation/typed-operations.h"
+#include "currentia/core/operator/sketches.h"
+#include "currentia/core/schema.h"
+#include "currentia/core/tuple.h"
+#include "currentia/trait/non-copyable.h"
+#include "currentia/trait/pointable.h"
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace currentia {
+    // An approximate aggregate of an attribute, kept in a sketch of
+    // bounded size. Unlike AggregateFunction, tuples cannot be evicted;
+    // the sketches of consecutive parts of a window are merge()d
+    // instead.
+    class SketchFunction: private NonCopyable<SketchFunction>,
+                          public Pointable<SketchFunction> {
+    public:
+        typedef Pointable<SketchFunction>::ptr_t ptr_t;
+
+        enum Type {
+            DISTINCT,           // number of distinct values (HyperLogLog)
+            QUANTILE,           // value of a rank (KLL)
+            TOP                 // most frequent values (SpaceSaving)
+        };
+
+        static const double DEFAULT_ERROR;
+
+        // parameter: the rank (in [0, 1]) of QUANTILE, the number of
+        // values of TOP
+        struct Specification {
+            Type type;
+            std::string attribute_name;
+            double parameter;
+            double error;
+
+            Specification(Type type,
+                          const std::string& attribute_name,
+                          double parameter = 0,
+                          double error = DEFAULT_ERROR):
+                type(type),
+                attribute_name(attribute_name),
+                parameter(parameter),
+                error(error) {
+            }
+
+            std::string toString() const {
+                std::stringstream ss;
+                ss << type_to_string(type);
+                if (type != DISTINCT)
+                    ss << " " << parameter;
+                ss << "(" << attribute_name << " +-" << error << ")";
+                return ss.str();
+            }
+        };
+
+        static std::string type_to_string(Type type) {
+            switch (type) {
+            case DISTINCT:
+                return "DISTINCT";
+            case QUANTILE:
+                return "QUANTILE";
+            case TOP:
+                return "TOP";
+            default:
+                return "UNKNOWN SKETCH";
+            }
+        }
+
+        // Throws a std::string when the attribute is missing from the
+        // schema (or is not a number for QUANTILE) or the parameters
+        // are out of range
+        static ptr_t create(const Specification& specification,
+                            const Schema::ptr_t& schema_ptr);
+
+        virtual ~SketchFunction() = 0;
+
+        virtual void clear() = 0;
+        virtual void insert(const Tuple& tuple) = 0;
+        // other has to be created from the same specification
+        virtual void merge(const SketchFunction& other) = 0;
+        // An empty sketch of the same specification
+        virtual ptr_t create_empty() const = 0;
+
+        virtual Object::Type get_result_type() const = 0;
+        // Result over a non-empty window
+        virtual Object get_result() const = 0;
+
+        virtual size_t get_memory_size() const = 0;
+    };
+    SketchFunction::~SketchFunction() {}
+    const double SketchFunction::DEFAULT_ERROR = 0.01;
+
+    // Number of distinct values of any type (INT)
+    class SketchDistinct: public SketchFunction {
+        int attribute_index_;
+        HyperLogLog sketch_;
+
+    public:
+        SketchDistinct(int attribute_index, int precision):
+            attribute_index_(attribute_index),
+            sketch_(precision) {
+        }
+
+        void clear() {
+            sketch_.clear();
+        }
+
+        void insert(const Tuple& tuple) {
+            sketch_.add_hash(sketch::hash_object(tuple.get_value_by_index(attribute_index_)));
+        }
+
+        void merge(const SketchFunction& other) {
+            sketch_.merge(static_cast<const SketchDistinct&>(other).sketch_);
+        }
+
+        ptr_t create_empty() const {
+            return ptr_t(new SketchDistinct(attribute_index_, sketch_.get_precision()));
+        }
+
+        size_t get_memory_size() const {
+            return sketch_.get_memory_size();
+        }
+
+        Object::Type get_result_type() const {
+            return Object::INT;
+        }
+
+        Object get_result() const {
+            return Object(static_cast<long>(std::floor(sketch_.estimate() + 0.5)));
+        }
+    };
+
+    // Value of a rank of a numeric attribute (FLOAT)
+    class SketchQuantile: public SketchFunction {
+        NumericAttribute attribute_;
+        double fraction_;
+        int k_;
+        KLLSketch sketch_;
+
+    public:
+        SketchQuantile(const NumericAttribute& attribute, double fraction, int k):
+            attribute_(attribute),
+            fraction_(fraction),
+            k_(k),
+            sketch_(k) {
+        }
+
+        void clear() {
+            sketch_.clear();
+        }
+
+        void insert(const Tuple& tuple) {
+            sketch_.add(attribute_.get_float(tuple));
+        }
+
+        void merge(const SketchFunction& other) {
+            sketch_.merge(static_cast<const SketchQuantile&>(other).sketch_);
+        }
+
+        ptr_t create_empty() const {
+            return ptr_t(new SketchQuantile(attribute_, fraction_, k_));
+        }
+
+        size_t get_memory_size() const {
+            return sketch_.get_memory_size();
+        }
+
+        Object::Type get_result_type() const {
+            return Object::FLOAT;
+        }
+
+        Object get_result() const {
+            return Object(sketch_.quantile(fraction_));
+        }
+    };
+
+    // Most frequent values of any type, with their (over)estimated
+    // numbers of occurrences. The result is the most frequent value.
+    class SketchTop: public SketchFunction {
+        int attribute_index_;
+        Object::Type attribute_type_;
+        size_t count_;
+        SpaceSaving sketch_;
+
+    public:
+        SketchTop(int attribute_index, Object::Type attribute_type, size_t count, size_t capacity):
+            attribute_index_(attribute_index),
+            attribute_type_(attribute_type),
+            count_(count),
+            sketch_(std::max(count, capacity)) {
+        }
+
+        void clear() {
+            sketch_.clear();
+        }
+
+        void insert(const Tuple& tuple) {
+            sketch_.add(tuple.get_value_by_index(attribute_index_));
+        }
+
+        void merge(const SketchFunction& other) {
+            sketch_.merge(static_cast<const SketchTop&>(other).sketch_);
+        }
+
+        ptr_t create_empty() const {
+            return ptr_t(new SketchTop(attribute_index_, attribute_type_, count_, sketch_.get_capacity()));
+        }
+
+        size_t get_memory_size() const {
+            return sketch_.get_memory_size();
+        }
+
+        Object::Type get_result_type() const {
+            return attribute_type_;
+        }
+
+        Object get_result() const {
+            return sketch_.get_top(1).front().item;
+        }
+
+        // From the most frequent
+        std::vector<SpaceSaving::Counter> get_top() const {
+            return sketch_.get_top(count_);
+        }
+    };
+
+    SketchFunction::ptr_t SketchFunction::create(const Specification& specification,
+                                                 const Schema::ptr_t& schema_ptr) {
+        if (!(specification.error > 0 && specification.error < 1))
+            throw std::string("the error of a sketch has to be in (0, 1)");
+
+        int attribute_index = schema_ptr->get_attribute_index_by_name(specification.attribute_name);
+        if (attribute_index < 0)
+            throw specification.attribute_name + " is not in " + schema_ptr->toString();
+
+        switch (specification.type) {
+        case DISTINCT:
+            return ptr_t(new SketchDistinct(attribute_index,
+                                            HyperLogLog::precision_for_error(specification.error)));
+        case QUANTILE:
+            if (!(specification.parameter >= 0 && specification.parameter <= 1))
+                throw std::string("the rank of QUANTILE has to be in [0, 1]");
+            return ptr_t(new SketchQuantile(NumericAttribute(schema_ptr, specification.attribute_name),
+                                            specification.parameter,
+                                            KLLSketch::k_for_error(specification.error)));
+        case TOP:
+            if (specification.parameter < 1)
+                throw std::string("TOP needs at least one value");
+            return ptr_t(new SketchTop(attribute_index,
+                                       schema_ptr->get_attribute_type_by_index(attribute_index),
+                                       static_cast<size_t>(specification.parameter),
+                                       SpaceSaving::capacity_for_error(specification.error)));
+        default:
+            throw std::string("unknown sketch function");
+        }
+    }
+}
+
+#endif  /* ! CURRENTIA_SKETCH_FUNCTION_H_ */
@@ -0,0 +1,434 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_SKETCHES_H_
+#define CURRENTIA_SKETCHES_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/open-addressing-map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>              // size_t
+#include <stdint.h>
+#include <string>
+#include <utility>              // std::pair
+#include <vector>
+
+// Summaries of a stream in memory bounded by their error parameter,
+// not by the number of items. Sketches of the same parameters merge
+// into the sketch of the concatenated streams, so that a window can be
+// assembled from sketches of its panes.
+
+namespace currentia {
+    namespace sketch {
+        // 64-bit finalizer of SplitMix64; spreads the bits of hash
+        // values such as those of std::hash<int> (the identity)
+        inline uint64_t mix_hash(uint64_t value) {
+            value += 0x9e3779b97f4a7c15ULL;
+            value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+            return value ^ (value >> 31);
+        }
+
+        inline uint64_t hash_object(const Object& object) {
+            return mix_hash(object.hash());
+        }
+    }
+
+    // Number of distinct items (HyperLogLog). The relative standard
+    // error is about 1.04 / sqrt(2^precision) with one byte per
+    // register.
+    class HyperLogLog {
+        int precision_;
+        std::vector<unsigned char> registers_;
+
+    public:
+        static const int MIN_PRECISION = 4;
+        static const int MAX_PRECISION = 18;
+
+        explicit HyperLogLog(int precision):
+            precision_(std::min(std::max(precision, static_cast<int>(MIN_PRECISION)),
+                                static_cast<int>(MAX_PRECISION))),
+            registers_(static_cast<size_t>(1) << precision_, 0) {
+        }
+
+        // Smallest precision achieving the relative standard error
+        static int precision_for_error(double error) {
+            int precision = MIN_PRECISION;
+            while (precision < MAX_PRECISION &&
+                   1.04 / std::sqrt(static_cast<double>(1 << precision)) > error)
+                precision++;
+            return precision;
+        }
+
+        void clear() {
+            std::fill(registers_.begin(), registers_.end(), 0);
+        }
+
+        // hash has to be uniform over 64 bits (see sketch::mix_hash())
+        void add_hash(uint64_t hash) {
+            size_t index = hash >> (64 - precision_);
+            // the rank of the first 1 in the rest, which ends with a
+            // sentinel 1 so that the rank is at most 64 - precision + 1
+            uint64_t rest = (hash << precision_) | (static_cast<uint64_t>(1) << (precision_ - 1));
+            unsigned char rank = 1;
+            for (; !(rest & (static_cast<uint64_t>(1) << 63)); rest <<= 1)
+                rank++;
+            if (registers_[index] < rank)
+                registers_[index] = rank;
+        }
+
+        void merge(const HyperLogLog& other) {
+            if (other.precision_ != precision_)
+                throw std::string("cannot merge HyperLogLog sketches of different precisions");
+            for (size_t i = 0; i < registers_.size(); ++i)
+                registers_[i] = std::max(registers_[i], other.registers_[i]);
+        }
+
+        double estimate() const {
+            double registers_count = registers_.size();
+            double inverse_sum = 0;
+            size_t zeros_count = 0;
+            for (auto iter = registers_.begin(); iter != registers_.end(); ++iter) {
+                inverse_sum += std::ldexp(1.0, -*iter);
+                if (*iter == 0)
+                    zeros_count++;
+            }
+            double alpha = 0.7213 / (1 + 1.079 / registers_count);
+            double estimate = alpha * registers_count * registers_count / inverse_sum;
+            // linear counting for small cardinalities
+            if (estimate <= 2.5 * registers_count && zeros_count > 0)
+                estimate = registers_count * std::log(registers_count / zeros_count);
+            return estimate;
+        }
+
+        int get_precision() const {
+            return precision_;
+        }
+
+        size_t get_memory_size() const {
+            return registers_.size();
+        }
+    };
+
+    // Quantiles of a stream of numbers (KLL). Items are kept in
+    // compactors of exponentially growing weights; a full compactor
+    // sorts its items and promotes every other one (randomly the odd
+    // or the even ones) to the next. The rank error is about
+    // 2.3 / k^0.97 of the number of items, with O(k) items kept.
+    class KLLSketch {
+        int k_;
+        // levels_[h] holds items of weight 2^h
+        std::vector<std::vector<double> > levels_;
+        long count_;
+        size_t retained_count_;
+        uint64_t random_state_;
+
+    public:
+        static const int MIN_K = 8;
+
+        explicit KLLSketch(int k):
+            k_(std::max(k, static_cast<int>(MIN_K))),
+            levels_(1),
+            count_(0),
+            retained_count_(0),
+            random_state_(1) {
+        }
+
+        // Smallest k achieving the normalized rank error
+        static int k_for_error(double error) {
+            int k = MIN_K;
+            while (2.296 / std::pow(static_cast<double>(k), 0.9723) > error)
+                k++;
+            return k;
+        }
+
+        void clear() {
+            levels_.assign(1, std::vector<double>());
+            count_ = 0;
+            retained_count_ = 0;
+        }
+
+        void add(double value) {
+            levels_[0].push_back(value);
+            count_++;
+            retained_count_++;
+            compress_();
+        }
+
+        void merge(const KLLSketch& other) {
+            if (other.k_ != k_)
+                throw std::string("cannot merge KLL sketches of different k");
+            if (levels_.size() < other.levels_.size())
+                levels_.resize(other.levels_.size());
+            for (size_t level = 0; level < other.levels_.size(); ++level)
+                levels_[level].insert(levels_[level].end(),
+                                      other.levels_[level].begin(),
+                                      other.levels_[level].end());
+            count_ += other.count_;
+            retained_count_ += other.retained_count_;
+            compress_();
+        }
+
+        // Item of (approximately) rank fraction * count in a non-empty
+        // sketch
+        double quantile(double fraction) const {
+            std::vector<std::pair<double, long> > weighted_items;
+            weighted_items.reserve(retained_count_);
+            for (size_t level = 0; level < levels_.size(); ++level) {
+                for (auto iter = levels_[level].begin(); iter != levels_[level].end(); ++iter)
+                    weighted_items.push_back(std::make_pair(*iter, 1L << level));
+            }
+            std::sort(weighted_items.begin(), weighted_items.end());
+
+            double target_rank = std::min(std::max(fraction, 0.0), 1.0) * count_;
+            long rank = 0;
+            for (auto iter = weighted_items.begin(); iter != weighted_items.end(); ++iter) {
+                rank += iter->second;
+                if (rank >= target_rank)
+                    return iter->first;
+            }
+            return weighted_items.back().first;
+        }
+
+        long get_count() const {
+            return count_;
+        }
+
+        size_t get_retained_count() const {
+            return retained_count_;
+        }
+
+        size_t get_memory_size() const {
+            return retained_count_ * sizeof(double);
+        }
+
+    private:
+        // Capacity of a level; lower levels get geometrically (by 2/3)
+        // smaller ones
+        size_t get_capacity_(size_t level) const {
+            double depth = levels_.size() - level - 1;
+            return std::max(2, static_cast<int>(std::ceil(k_ * std::pow(2.0 / 3.0, depth))));
+        }
+
+        size_t get_total_capacity_() const {
+            size_t capacity = 0;
+            for (size_t level = 0; level < levels_.size(); ++level)
+                capacity += get_capacity_(level);
+            return capacity;
+        }
+
+        bool random_bit_() {
+            // xorshift64
+            random_state_ ^= random_state_ << 13;
+            random_state_ ^= random_state_ >> 7;
+            random_state_ ^= random_state_ << 17;
+            return random_state_ & 1;
+        }
+
+        void compress_() {
+            while (retained_count_ > get_total_capacity_()) {
+                size_t level = 0;
+                while (levels_[level].size() < get_capacity_(level))
+                    level++;
+                if (level + 1 == levels_.size())
+                    levels_.resize(levels_.size() + 1);
+                compact_(level);
+            }
+        }
+
+        void compact_(size_t level) {
+            std::vector<double>& items = levels_[level];
+            std::sort(items.begin(), items.end());
+            // an odd item out stays
+            double odd_item = items.back();
+            bool has_odd_item = items.size() % 2 == 1;
+            if (has_odd_item)
+                items.pop_back();
+
+            std::vector<double>& next_items = levels_[level + 1];
+            for (size_t i = random_bit_() ? 1 : 0; i < items.size(); i += 2)
+                next_items.push_back(items[i]);
+            retained_count_ -= items.size() / 2;
+
+            items.clear();
+            if (has_odd_item)
+                items.push_back(odd_item);
+        }
+    };
+
+    // Frequent items (SpaceSaving) with a fixed number of counters. A
+    // new item takes over the counter of the least frequent one when
+    // all are used, so counts are overestimated by at most
+    // (number of items) / (number of counters), and every item more
+    // frequent than that holds a counter.
+    class SpaceSaving {
+    public:
+        struct Counter {
+            Object item;
+            long count;
+            long error;         // overestimation bound of count
+
+            Counter(const Object& item, long count, long error):
+                item(item),
+                count(count),
+                error(error) {
+            }
+        };
+
+    private:
+        size_t capacity_;
+        // a binary min-heap on count, so that the least frequent item
+        // is at the front
+        std::vector<Counter> counters_;
+        OpenAddressingMap<Object, size_t> positions_; // item -> index in counters_
+
+    public:
+        explicit SpaceSaving(size_t capacity):
+            capacity_(std::max(capacity, static_cast<size_t>(1))),
+            positions_(Object(0)) {
+            counters_.reserve(capacity_);
+        }
+
+        // Number of counters bounding the overestimation by error times
+        // the number of items
+        static size_t capacity_for_error(double error) {
+            return static_cast<size_t>(std::ceil(1.0 / error));
+        }
+
+        void clear() {
+            counters_.clear();
+            positions_.clear();
+        }
+
+        void add(const Object& item) {
+            size_t* position = positions_.find(item);
+            if (position) {
+                size_t index = *position;
+                counters_[index].count++;
+                sift_down_(index);
+                return;
+            }
+            if (counters_.size() < capacity_) {
+                positions_[item] = counters_.size();
+                counters_.push_back(Counter(item, 1, 0));
+                sift_up_(counters_.size() - 1);
+                return;
+            }
+            Counter& minimum = counters_.front();
+            positions_.erase(minimum.item);
+            minimum.error = minimum.count;
+            minimum.count++;
+            minimum.item = item;
+            positions_[item] = 0;
+            sift_down_(0);
+        }
+
+        // An item missing from a full summary may have occurred up to
+        // its minimum count times
+        void merge(const SpaceSaving& other) {
+            long minimum_count = get_minimum_count_();
+            long other_minimum_count = other.get_minimum_count_();
+
+            std::vector<Counter> merged;
+            merged.reserve(counters_.size() + other.counters_.size());
+            for (auto iter = counters_.begin(); iter != counters_.end(); ++iter) {
+                const size_t* other_position = other.positions_.find(iter->item);
+                if (other_position) {
+                    const Counter& other_counter = other.counters_[*other_position];
+                    merged.push_back(Counter(iter->item,
+                                             iter->count + other_counter.count,
+                                             iter->error + other_counter.error));
+                } else {
+                    merged.push_back(Counter(iter->item,
+                                             iter->count + other_minimum_count,
+                                             iter->error + other_minimum_count));
+                }
+            }
+            for (auto iter = other.counters_.begin(); iter != other.counters_.end(); ++iter) {
+                if (!positions_.find(iter->item))
+                    merged.push_back(Counter(iter->item,
+                                             iter->count + minimum_count,
+                                             iter->error + minimum_count));
+            }
+
+            if (merged.size() > capacity_) {
+                std::nth_element(merged.begin(), merged.begin() + capacity_, merged.end(), more_frequent_);
+                merged.erase(merged.begin() + capacity_, merged.end());
+            }
+            std::make_heap(merged.begin(), merged.end(), more_frequent_);
+            counters_.swap(merged);
+            rebuild_positions_();
+        }
+
+        // Up to `count` counters from the most frequent item
+        std::vector<Counter> get_top(size_t count) const {
+            std::vector<Counter> top(counters_);
+            std::sort(top.begin(), top.end(), more_frequent_);
+            if (top.size() > count)
+                top.erase(top.begin() + count, top.end());
+            return top;
+        }
+
+        size_t get_capacity() const {
+            return capacity_;
+        }
+
+        size_t get_memory_size() const {
+            return capacity_ * (sizeof(Counter) + sizeof(Object) + 2 * sizeof(size_t));
+        }
+
+    private:
+        // std::*_heap() with this comparison keeps the minimum at the
+        // front
+        static bool more_frequent_(const Counter& left, const Counter& right) {
+            return left.count > right.count;
+        }
+
+        long get_minimum_count_() const {
+            return counters_.size() < capacity_ ? 0 : counters_.front().count;
+        }
+
+        void rebuild_positions_() {
+            positions_.clear();
+            for (size_t i = 0; i < counters_.size(); ++i)
+                positions_[counters_[i].item] = i;
+        }
+
+        void swap_counters_(size_t left, size_t right) {
+            std::swap(counters_[left], counters_[right]);
+            *positions_.find(counters_[left].item) = left;
+            *positions_.find(counters_[right].item) = right;
+        }
+
+        // Restores the heap after a counter was added at index
+        void sift_up_(size_t index) {
+            while (index > 0) {
+                size_t parent = (index - 1) / 2;
+                if (counters_[parent].count <= counters_[index].count)
+                    return;
+                swap_counters_(parent, index);
+                index = parent;
+            }
+        }
+
+        // Restores the heap after the count at index grew
+        void sift_down_(size_t index) {
+            for (;;) {
+                size_t smallest = index;
+                size_t left = 2 * index + 1;
+                size_t right = left + 1;
+                if (left < counters_.size() && counters_[left].count < counters_[smallest].count)
+                    smallest = left;
+                if (right < counters_.size() && counters_[right].count < counters_[smallest].count)
+                    smallest = right;
+                if (smallest == index)
+                    return;
+                swap_counters_(index, smallest);
+                index = smallest;
+            }
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_SKETCHES_H_ */
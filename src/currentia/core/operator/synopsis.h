@@ -6,8 +6,10 @@
 #include <deque>
 #include <assert.h>
 #include <functional>
+#include <map>
 
 #include "currentia/core/operator/operator.h"
+#include "currentia/core/operator/window-aggregation.h"
 #include "currentia/core/relation.h"
 #include "currentia/core/thread.h"
 #include "currentia/core/tuple.h"
@@ -22,6 +24,7 @@ namespace currentia {
                     public Show {
     public:
         typedef std::function<void(void)> callback_t;
+        typedef std::function<void(const Tuple::ptr_t&)> tuple_callback_t;
         typedef std::deque<Tuple::ptr_t>::const_iterator const_iterator;
         typedef std::deque<Tuple::ptr_t>::iterator iterator;
 
@@ -31,10 +34,43 @@ namespace currentia {
 
         Window window_;
         callback_t on_accept_;
+        // called when a tuple enters / leaves the window
+        tuple_callback_t on_insert_;
+        tuple_callback_t on_evict_;
 
+    private:
+        // The tuples in the window are tracked as they enter and leave
+        // it (in the order of arrival), so that get_lwm() and
+        // has_reference_consistency() do not scan the window.
+        struct RelationVersions {
+            long references_count; // tuples referencing the relation
+            std::map<long, long> tuples_counts; // version -> tuples
+
+            RelationVersions():
+                references_count(0) {
+            }
+        };
+        MonotonicDeque<time_t, std::less<time_t> > lwms_;
+        std::map<Relation::ptr_t, RelationVersions> relation_versions_;
+        long tracked_tuples_count_;
+        // distinct (relation, version) pairs in the window
+        long versions_count_;
+        // sum of references_count over relations
+        long references_count_;
+        // evictions to ignore, of the tuples tracked before the last
+        // forget_tracked_tuples_()
+        long stale_evictions_count_;
+
+    protected:
         Synopsis(Window &window):
             window_(window),
-            on_accept_(NULL) {
+            on_accept_(NULL),
+            on_insert_(NULL),
+            on_evict_(NULL),
+            tracked_tuples_count_(0),
+            versions_count_(0),
+            references_count_(0),
+            stale_evictions_count_(0) {
             pthread_mutex_init(&mutex_, NULL);
             pthread_cond_init(&reader_wait_, NULL);
         }
@@ -49,6 +85,10 @@ namespace currentia {
         virtual Synopsis::const_iterator begin() const = 0;
         virtual Synopsis::const_iterator end() const = 0;
 
+        size_t size() const {
+            return end() - begin();
+        }
+
         virtual Tuple::ptr_t get_window_beginning_tuple() const = 0;
         virtual Tuple::ptr_t get_latest_tuple() const = 0;
 
@@ -68,48 +108,44 @@ namespace currentia {
             on_accept_ = on_accept;
         }
 
-        bool has_reference_consistency() {
-            // TODO: stop queueing (take lock)
-
-            auto tuple_iter = begin();
-            auto tuple_iter_end = end();
-
-            Tuple::ptr_t first_tuple = *tuple_iter++;
+        void set_on_insert(tuple_callback_t on_insert) {
+            on_insert_ = on_insert;
+        }
 
-            for (; tuple_iter != tuple_iter_end; ++tuple_iter) {
-                Tuple::ptr_t non_first_tuple = *tuple_iter; // cost
+        void set_on_evict(tuple_callback_t on_evict) {
+            on_evict_ = on_evict;
+        }
 
-                auto first_version_iter = first_tuple->referenced_version_numbers_begin();
-                auto first_version_iter_end = first_tuple->referenced_version_numbers_end();
+        // true when all the tuples in the window have referenced the
+        // same version of each relation in their lineage
+        bool has_reference_consistency() const {
+            long relations_count = relation_versions_.size();
+            return versions_count_ == relations_count &&
+                references_count_ == relations_count * tracked_tuples_count_;
+        }
 
-                // For all relations in first tuple's lineage, check
-                // if the reference consistency is same for all other
-                // relations.
-                for (; first_version_iter != first_version_iter_end; ++first_version_iter) {
-                    Relation::ptr_t relation = first_version_iter->first;
-                    long version = first_version_iter->second;
-                    if (non_first_tuple->get_referenced_version_number(relation) != version) {
-                        return false;
-                    }
+        // true when `other` has referenced the same version of each
+        // relation in the lineage of `first`
+        static bool have_same_referenced_versions(const Tuple& first, const Tuple& other) {
+            auto first_version_iter = first.referenced_version_numbers_begin();
+            auto first_version_iter_end = first.referenced_version_numbers_end();
+
+            for (; first_version_iter != first_version_iter_end; ++first_version_iter) {
+                Relation::ptr_t relation = first_version_iter->first;
+                long version = first_version_iter->second;
+                if (other.get_referenced_version_number(relation) != version) {
+                    return false;
                 }
             }
 
             return true;
         }
 
-        time_t get_lwm() {
-            auto tuple_iter = begin();
-            auto tuple_iter_end = end();
-
-            if (tuple_iter == tuple_iter_end)
+        time_t get_lwm() const {
+            if (lwms_.empty())
                 throw "No tuples in the synopsis but lwm is requested";
 
-            time_t lwm = (*tuple_iter++)->get_lwm();
-            for (; tuple_iter != tuple_iter_end; ++tuple_iter) {
-                lwm = std::min(lwm, (*tuple_iter)->get_lwm());
-            }
-
-            return lwm;
+            return lwms_.get();
         }
 
         std::string get_versions_string() {
@@ -149,6 +185,72 @@ namespace currentia {
             if (on_accept_)
                 on_accept_();
         }
+
+        void insertion_notification_(const Tuple::ptr_t& tuple) {
+            track_insertion_(*tuple);
+            if (on_insert_)
+                on_insert_(tuple);
+        }
+
+        void eviction_notification_(const Tuple::ptr_t& tuple) {
+            if (!tuple)
+                return;
+            if (stale_evictions_count_ > 0)
+                stale_evictions_count_--;
+            else
+                track_eviction_(*tuple);
+            if (on_evict_)
+                on_evict_(tuple);
+        }
+
+        // For a reset() after which the tuples in the window are
+        // evicted out of the order of arrival: they are no longer
+        // tracked, and the next evictions of as many tuples are
+        // ignored.
+        void forget_tracked_tuples_() {
+            stale_evictions_count_ += tracked_tuples_count_;
+            lwms_.clear();
+            relation_versions_.clear();
+            tracked_tuples_count_ = 0;
+            versions_count_ = 0;
+            references_count_ = 0;
+        }
+
+    private:
+        void track_insertion_(const Tuple& tuple) {
+            lwms_.push(tuple.get_lwm());
+            tracked_tuples_count_++;
+
+            auto version_iter = tuple.referenced_version_numbers_begin();
+            auto version_iter_end = tuple.referenced_version_numbers_end();
+            for (; version_iter != version_iter_end; ++version_iter) {
+                RelationVersions& versions = relation_versions_[version_iter->first];
+                if (versions.tuples_counts[version_iter->second]++ == 0)
+                    versions_count_++;
+                versions.references_count++;
+                references_count_++;
+            }
+        }
+
+        void track_eviction_(const Tuple& tuple) {
+            lwms_.pop();
+            tracked_tuples_count_--;
+
+            auto version_iter = tuple.referenced_version_numbers_begin();
+            auto version_iter_end = tuple.referenced_version_numbers_end();
+            for (; version_iter != version_iter_end; ++version_iter) {
+                auto versions_iter = relation_versions_.find(version_iter->first);
+                RelationVersions& versions = versions_iter->second;
+                auto count_iter = versions.tuples_counts.find(version_iter->second);
+                if (--count_iter->second == 0) {
+                    versions.tuples_counts.erase(count_iter);
+                    versions_count_--;
+                }
+                references_count_--;
+                if (--versions.references_count == 0)
+                    relation_versions_.erase(versions_iter);
+            }
+        }
     };
     Synopsis::~Synopsis() {}
 
@@ -177,6 +279,8 @@ namespace currentia {
             newcomer_count_ = 0;
             window_filled_ = false;
             window_beginning_ = 0;
+            // the next acceptance evicts the tuples in slot order
+            forget_tracked_tuples_();
         }
 
         void enqueue(const Tuple::ptr_t& input_tuple) {
@@ -228,7 +332,10 @@ namespace currentia {
             window_beginning_ = (current_window_beginning + window_.stride) % window_.width;
 
             for (int i = 0; i < number_of_newcomer; ++i) {
-                tuples_[get_current_index_and_increment_()] = newcomer_tuples_[i];
+                Tuple::ptr_t& slot = tuples_[get_current_index_and_increment_()];
+                eviction_notification_(slot);
+                slot = newcomer_tuples_[i];
+                insertion_notification_(slot);
             }
 
             newcomer_count_ = 0;
@@ -303,6 +410,7 @@ namespace currentia {
             if (COMPARE_TIME(input_tuple->get_real_arrived_time(), <=, window_end_time_)) {
                 // (1) input_tuple is in the current window
                 tuples_.push_back(input_tuple);
+                insertion_notification_(input_tuple);
             } else {
                 // (2) input_tuple isn't in the current window
                 // Evaluate sliding windows that doesn't include the input_tuple.
@@ -321,6 +429,7 @@ namespace currentia {
                 // may not be contained in the next window.
                 if (COMPARE_TIME(input_tuple->get_real_arrived_time(), >=, window_beginning_time_)) {
                     tuples_.push_back(input_tuple);
+                    insertion_notification_(input_tuple);
                 }
                 evict_expired_tuples_();
             }
@@ -345,6 +454,7 @@ namespace currentia {
         void evict_expired_tuples_() {
             for (auto iter = tuples_.begin(); iter != tuples_.end();) {
                 if (COMPARE_TIME((*iter)->get_real_arrived_time(), <, window_beginning_time_)) {
+                    eviction_notification_(*iter);
                     iter = tuples_.erase(iter);
                 } else {
                     ++iter;
@@ -23,19 +23,48 @@ namespace currentia {
 
         Synopsis::callback_t on_accept_;
 
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+        long output_windows_count_;
+        long consistent_windows_count_;
+        bool committed_;
+#endif
+
     public:
         TraitAggregationOperator(Window window,
                                  const Synopsis::callback_t& on_accept):
             window_(window),
             synopsis_(create_synopsis_from_window(window)),
-            on_accept_(on_accept) {
+            on_accept_(on_accept)
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            , output_windows_count_(0),
+            consistent_windows_count_(0),
+            committed_(false)
+#endif
+        {
             // Setup handler
             synopsis_->set_on_accept(std::bind(&TraitAggregationOperator::on_accept_wrapper_, this));
         }
 
+        // The synopsis follows synopsis_window instead of the window
+        // (e.g., holds a pane of the window only)
+        TraitAggregationOperator(Window window,
+                                 Window synopsis_window,
+                                 const Synopsis::callback_t& on_accept):
+            window_(window),
+            synopsis_(create_synopsis_from_window(synopsis_window)),
+            on_accept_(on_accept)
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            , output_windows_count_(0),
+            consistent_windows_count_(0),
+            committed_(false)
+#endif
+        {
+            synopsis_->set_on_accept(std::bind(&TraitAggregationOperator::on_accept_wrapper_, this));
+        }
+
         virtual ~TraitAggregationOperator() = 0;
 
-        time_t get_window_beginning_lwm() const {
+        virtual time_t get_window_beginning_lwm() const {
             // print_synopsis_lwm();
             return synopsis_->get_window_beginning_tuple()->get_lwm();
         }
@@ -53,14 +82,81 @@ namespace currentia {
             return window_;
         }
 
-        virtual double get_consistent_rate() {
+        double get_consistent_rate() const {
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+            return static_cast<double>(consistent_windows_count_) /
+                static_cast<double>(output_windows_count_);
+#else
             return 0;
+#endif
         }
 
         bool has_overlapping_window() const {
             return window_.is_overlapping_window();
         }
 
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+    protected:
+        // Concurrency control around the output of an accepted window
+        // (from its on_accept callback). In pessimistic modes, a window
+        // commits the transaction, and the next input tuple starts a
+        // new one.
+
+        void check_window_committed_(bool in_pessimistic_cc, const Tuple::ptr_t& input_tuple) {
+            if (in_pessimistic_cc && committed_) {
+                committed_ = false;
+                throw input_tuple->get_lwm();
+            }
+        }
+
+        // Returns the lwm of the window, or throws LOST_CONSISTENCY to
+        // redo it
+        time_t begin_window_output_(Operator::CCMode cc_mode, bool is_commit_operator) {
+            // Eviction
+            time_t lwm = synopsis_->get_lwm();
+            Synopsis* synopsis = synopsis_.get();
+            count_window_output_(cc_mode, is_commit_operator, [synopsis]() {
+                return synopsis->has_reference_consistency();
+            });
+            return lwm;
+        }
+
+        // Same as above, for a window whose reference consistency is
+        // checked by has_reference_consistency() (only evaluated for a
+        // commit operator)
+        template <typename ConsistencyCheck>
+        void count_window_output_(Operator::CCMode cc_mode,
+                                  bool is_commit_operator,
+                                  ConsistencyCheck has_reference_consistency) {
+            if (cc_mode == Operator::OPTIMISTIC) {
+                if (is_commit_operator && !has_reference_consistency()) {
+                    // redo
+                    throw TraitAggregationOperator::LOST_CONSISTENCY;
+                } else {
+                    output_windows_count_++;
+                    consistent_windows_count_++;
+                }
+            } else {
+                output_windows_count_++;
+                if (is_commit_operator && has_reference_consistency())
+                    consistent_windows_count_++;
+            }
+        }
+
+        void end_window_output_(Operator::CCMode cc_mode) {
+            if (cc_mode == Operator::PESSIMISTIC_2PL ||
+                cc_mode == Operator::PESSIMISTIC_SNAPSHOT)
+                committed_ = true;
+
+            if (cc_mode != Operator::NONE)
+                throw TraitAggregationOperator::COMMIT;
+        }
+
+        void reset_window_output_() {
+            committed_ = false;
+        }
+#endif
+
     private:
         void on_accept_wrapper_() {
             on_accept_();
@@ -14,6 +14,7 @@ namespace currentia {
     protected:
         TraitResourceReferenceOperator(const std::vector<Relation::ptr_t>& original_resource_list):
             original_resource_list_(original_resource_list),
+            locks_held_(false),
             first_time_in_txn_(true) {
         }
 
@@ -26,22 +27,30 @@ namespace currentia {
             snapshot_ptr_list_ = snapshot_ptr_list;
         }
 
-        // Locks
+        // Locks (shared, as operators only read resources)
+
+        bool locks_held_;
 
         void get_recursive_locks() {
+            if (locks_held_)
+                return;
             auto iter = original_resource_list_.begin();
             auto iter_end = original_resource_list_.end();
             for (; iter != iter_end; ++iter) {
-                (*iter)->read_write_lock();
+                (*iter)->read_lock();
             }
+            locks_held_ = true;
         }
 
         void release_recursive_locks() {
+            if (!locks_held_)
+                return;
             auto iter = original_resource_list_.begin();
             auto iter_end = original_resource_list_.end();
             for (; iter != iter_end; ++iter) {
                 (*iter)->unlock();
             }
+            locks_held_ = false;
         }
 
         // Operation / Txn
@@ -54,25 +63,23 @@ namespace currentia {
                     get_recursive_locks();
                 break;
             case Operator::PESSIMISTIC_SNAPSHOT:
-                get_recursive_locks();
-                if (first_time_in_txn_)
+                // snapshots are taken between updates, and are
+                // private to this operator afterwards
+                if (first_time_in_txn_) {
+                    get_recursive_locks();
                     refresh_snapshots();
+                    release_recursive_locks();
+                }
                 break;
             default:
-                get_recursive_locks();
+                // operators read Relation::View without locks
+                break;
             }
             first_time_in_txn_ = false;
         }
 
         void reference_operation_end(Operator::CCMode cc_mode) {
-            switch (cc_mode) {
-            case Operator::PESSIMISTIC_2PL:
-                break;
-            case Operator::PESSIMISTIC_SNAPSHOT:
-            default:
-                release_recursive_locks();
-                break;
-            }
+            // 2PL releases locks at the end of the transaction
         }
 
         void refresh_snapshots() {
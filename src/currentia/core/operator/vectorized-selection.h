@@ -0,0 +1,353 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_VECTORIZED_SELECTION_H_
+#define CURRENTIA_VECTORIZED_SELECTION_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/stream.h"
+#include "currentia/core/tuple.h"
+#include "currentia/core/operator/column-batch.h"
+#include "currentia/core/operator/comparator.h"
+#include "currentia/core/operator/condition.h"
+#include "currentia/core/operator/condition-program.h"
+#include "currentia/trait/non-copyable.h"
+#include "currentia/trait/pointable.h"
+
+#include <algorithm>            // std::min
+#include <list>
+#include <type_traits>          // std::is_same
+#include <vector>
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace currentia {
+    // Comparisons of a column with a constant, 64 values at a time.
+    // Each returns a bitmap whose bit i is set iff "column[i] <op>
+    // constant". AVX2 or SSE2 is used when the compiler targets it,
+    // and plain comparisons otherwise.
+    namespace SelectionKernel {
+        static const size_t BLOCK_SIZE = 64;
+
+        // for blocks shorter than BLOCK_SIZE (and as the fallback)
+        template <Comparator::Type Op, typename T>
+        inline
+        uint64_t compare_scalar(const T* column, size_t count, T constant) {
+            uint64_t bits = 0;
+            for (size_t i = 0; i < count; ++i)
+                bits |= static_cast<uint64_t>(Comparator::compare(column[i], constant, Op)) << i;
+            return bits;
+        }
+
+#if defined(__AVX2__)
+        template <Comparator::Type Op>
+        inline
+        uint64_t compare_block(const int* column, int constant) {
+            const __m256i constants = _mm256_set1_epi32(constant);
+            // "<=", ">=" and "!=" are the complements of ">", "<" and "=="
+            const bool complement = (Op == Comparator::LESS_THAN_EQUAL ||
+                                     Op == Comparator::GREATER_THAN_EQUAL ||
+                                     Op == Comparator::NOT_EQUAL);
+            uint64_t bits = 0;
+            for (size_t i = 0; i < BLOCK_SIZE; i += 8) {
+                __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+                __m256i mask;
+                if (Op == Comparator::EQUAL || Op == Comparator::NOT_EQUAL)
+                    mask = _mm256_cmpeq_epi32(values, constants);
+                else if (Op == Comparator::LESS_THAN || Op == Comparator::GREATER_THAN_EQUAL)
+                    mask = _mm256_cmpgt_epi32(constants, values);
+                else
+                    mask = _mm256_cmpgt_epi32(values, constants);
+                bits |= static_cast<uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(mask))) << i;
+            }
+            return complement ? ~bits : bits;
+        }
+
+        template <Comparator::Type Op>
+        inline
+        uint64_t compare_block(const double* column, double constant) {
+            const __m256d constants = _mm256_set1_pd(constant);
+            uint64_t bits = 0;
+            for (size_t i = 0; i < BLOCK_SIZE; i += 4) {
+                __m256d values = _mm256_loadu_pd(column + i);
+                __m256d mask;
+                // NaN compares as in C++ (only "!=" holds)
+                switch (Op) {
+                case Comparator::EQUAL:              mask = _mm256_cmp_pd(values, constants, _CMP_EQ_OQ);  break;
+                case Comparator::NOT_EQUAL:          mask = _mm256_cmp_pd(values, constants, _CMP_NEQ_UQ); break;
+                case Comparator::LESS_THAN:          mask = _mm256_cmp_pd(values, constants, _CMP_LT_OQ);  break;
+                case Comparator::LESS_THAN_EQUAL:    mask = _mm256_cmp_pd(values, constants, _CMP_LE_OQ);  break;
+                case Comparator::GREATER_THAN:       mask = _mm256_cmp_pd(values, constants, _CMP_GT_OQ);  break;
+                default:                             mask = _mm256_cmp_pd(values, constants, _CMP_GE_OQ);  break;
+                }
+                bits |= static_cast<uint64_t>(_mm256_movemask_pd(mask)) << i;
+            }
+            return bits;
+        }
+#elif defined(__SSE2__)
+        template <Comparator::Type Op>
+        inline
+        uint64_t compare_block(const int* column, int constant) {
+            const __m128i constants = _mm_set1_epi32(constant);
+            // "<=", ">=" and "!=" are the complements of ">", "<" and "=="
+            const bool complement = (Op == Comparator::LESS_THAN_EQUAL ||
+                                     Op == Comparator::GREATER_THAN_EQUAL ||
+                                     Op == Comparator::NOT_EQUAL);
+            uint64_t bits = 0;
+            for (size_t i = 0; i < BLOCK_SIZE; i += 4) {
+                __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+                __m128i mask;
+                if (Op == Comparator::EQUAL || Op == Comparator::NOT_EQUAL)
+                    mask = _mm_cmpeq_epi32(values, constants);
+                else if (Op == Comparator::LESS_THAN || Op == Comparator::GREATER_THAN_EQUAL)
+                    mask = _mm_cmplt_epi32(values, constants);
+                else
+                    mask = _mm_cmpgt_epi32(values, constants);
+                bits |= static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(mask))) << i;
+            }
+            return complement ? ~bits : bits;
+        }
+
+        template <Comparator::Type Op>
+        inline
+        uint64_t compare_block(const double* column, double constant) {
+            const __m128d constants = _mm_set1_pd(constant);
+            uint64_t bits = 0;
+            for (size_t i = 0; i < BLOCK_SIZE; i += 2) {
+                __m128d values = _mm_loadu_pd(column + i);
+                __m128d mask;
+                // NaN compares as in C++ (only "!=" holds)
+                switch (Op) {
+                case Comparator::EQUAL:              mask = _mm_cmpeq_pd(values, constants);  break;
+                case Comparator::NOT_EQUAL:          mask = _mm_cmpneq_pd(values, constants); break;
+                case Comparator::LESS_THAN:          mask = _mm_cmplt_pd(values, constants);  break;
+                case Comparator::LESS_THAN_EQUAL:    mask = _mm_cmple_pd(values, constants);  break;
+                case Comparator::GREATER_THAN:       mask = _mm_cmpgt_pd(values, constants);  break;
+                default:                             mask = _mm_cmpge_pd(values, constants);  break;
+                }
+                bits |= static_cast<uint64_t>(_mm_movemask_pd(mask)) << i;
+            }
+            return bits;
+        }
+#else
+        template <Comparator::Type Op, typename T>
+        inline
+        uint64_t compare_block(const T* column, T constant) {
+            return compare_scalar<Op, T>(column, BLOCK_SIZE, constant);
+        }
+#endif
+
+        // Bitmap of "column[offset, offset + count) <op> constant"
+        // (count <= BLOCK_SIZE)
+        template <Comparator::Type Op, typename T>
+        inline
+        uint64_t compare(const T* column, size_t offset, size_t count, T constant) {
+            if (count == BLOCK_SIZE)
+                return compare_block<Op>(column + offset, constant);
+            return compare_scalar<Op, T>(column + offset, count, constant);
+        }
+    }
+
+    // Evaluates a selection condition over batches. Conjuncts comparing
+    // a numeric attribute with a constant are evaluated column-at-a-time
+    // (see ColumnBatch and SelectionKernel) into a selection bitmap;
+    // tuples which survive them are checked against the rest of the
+    // conjuncts one by one. Column conjuncts are reordered periodically
+    // so that the ones which reject most tuples run first (the rest of
+    // the conjuncts are reordered by their ConditionProgram).
+    class VectorizedSelection: private NonCopyable<VectorizedSelection>,
+                               public Pointable<VectorizedSelection> {
+        struct ColumnPredicate;
+        typedef uint64_t (*kernel_t)(ColumnBatch& columns, const ColumnPredicate& predicate,
+                                     size_t offset, size_t count);
+
+        struct ColumnPredicate {
+            kernel_t kernel;
+            int attribute_index;
+            Object::Type attribute_type;
+            int int_constant;
+            double float_constant;
+            bool negated;
+
+            // tuples tested / passed (decays on reordering)
+            long tested_count;
+            long passed_count;
+
+            double get_selectivity() const {
+                return (passed_count + 1.0) / (tested_count + 2.0);
+            }
+        };
+
+        std::vector<ColumnPredicate> column_predicates_;
+        long blocks_count_;
+        // rest of the conjuncts (NULL if nothing remains)
+        ConditionProgram::ptr_t residual_program_;
+
+        ColumnBatch columns_;
+
+        VectorizedSelection():
+            blocks_count_(0) {
+        }
+
+    public:
+        static const long REORDERING_INTERVAL = 1024; // in blocks
+
+        // Returns NULL if no conjunct of the condition (resolved by
+        // obey_schema()) can be evaluated column-at-a-time
+        static VectorizedSelection::ptr_t create(const Condition::ptr_t& condition) {
+            VectorizedSelection::ptr_t selection(new VectorizedSelection());
+
+            std::list<Condition::ptr_t> conjuncts;
+            collect_conjuncts(condition, conjuncts);
+            std::list<Condition::ptr_t> residual_conjuncts;
+
+            auto iter = conjuncts.begin();
+            auto iter_end = conjuncts.end();
+            for (; iter != iter_end; ++iter) {
+                if (!selection->add_column_predicate_(*iter))
+                    residual_conjuncts.push_back(*iter);
+            }
+
+            if (selection->column_predicates_.empty())
+                return VectorizedSelection::ptr_t();
+
+            Condition::ptr_t residual_condition = conjoin_conditions(residual_conjuncts);
+            if (residual_condition)
+                selection->residual_program_ = ConditionProgram::compile(residual_condition);
+            return selection;
+        }
+
+        // Appends tuples satisfying the condition to selected_tuples
+        // (in the order of input_tuples)
+        void select(const Stream::batch_t& input_tuples, Stream::batch_t& selected_tuples) {
+            columns_.reset(input_tuples);
+            size_t tuples_count = input_tuples.size();
+
+            for (size_t offset = 0; offset < tuples_count; offset += SelectionKernel::BLOCK_SIZE) {
+                size_t count = std::min(SelectionKernel::BLOCK_SIZE, tuples_count - offset);
+                uint64_t selected = select_block_(offset, count);
+
+                // visit set bits only
+                while (selected) {
+                    const Tuple::ptr_t& tuple = input_tuples[offset + __builtin_ctzll(selected)];
+                    if (!residual_program_ || residual_program_->check(tuple))
+                        selected_tuples.push_back(tuple);
+                    selected &= selected - 1;
+                }
+            }
+        }
+
+        size_t get_column_predicates_count() const {
+            return column_predicates_.size();
+        }
+
+        // Orders column conjuncts by their selectivities (done
+        // periodically)
+        void reorder() {
+            std::stable_sort(column_predicates_.begin(), column_predicates_.end(),
+                             [](const ColumnPredicate& x, const ColumnPredicate& y) {
+                                 return x.get_selectivity() < y.get_selectivity();
+                             });
+            auto iter = column_predicates_.begin();
+            auto iter_end = column_predicates_.end();
+            for (; iter != iter_end; ++iter) {
+                iter->tested_count /= 2;
+                iter->passed_count /= 2;
+            }
+        }
+
+    private:
+        uint64_t select_block_(size_t offset, size_t count) {
+            uint64_t valid = count == SelectionKernel::BLOCK_SIZE ? ~0ULL : (1ULL << count) - 1;
+            uint64_t selected = valid;
+            auto iter = column_predicates_.begin();
+            auto iter_end = column_predicates_.end();
+            for (; iter != iter_end && selected; ++iter) {
+                uint64_t bits = iter->kernel(columns_, *iter, offset, count);
+                iter->tested_count += __builtin_popcountll(selected);
+                selected &= iter->negated ? ~bits : bits;
+                iter->passed_count += __builtin_popcountll(selected);
+            }
+            if (++blocks_count_ % REORDERING_INTERVAL == 0)
+                reorder();
+            return selected;
+        }
+
+        bool add_column_predicate_(const Condition::ptr_t& condition) {
+            ConditionConstantComparator::ptr_t comparator =
+                std::dynamic_pointer_cast<ConditionConstantComparator>(condition);
+            if (!comparator || !comparator->target_tuple_is_left())
+                return false;
+
+            ColumnPredicate predicate;
+            predicate.attribute_index = comparator->get_target_attribute_index();
+            predicate.attribute_type = comparator->get_target_attribute_type();
+            predicate.int_constant = 0;
+            predicate.float_constant = 0;
+            predicate.negated = comparator->is_negated();
+            predicate.tested_count = 0;
+            predicate.passed_count = 0;
+
+            Object value = comparator->get_condition_value();
+            switch (comparator->get_value_comparison()) {
+            case COMPARE_INTS:
+                predicate.int_constant = value.get_int_number();
+                predicate.kernel = select_kernel_<int>(comparator->get_target_comparator_type());
+                break;
+            case COMPARE_FLOATS:
+                predicate.float_constant = value.cast_to(Object::FLOAT).get_float_number();
+                predicate.kernel = select_kernel_<double>(comparator->get_target_comparator_type());
+                break;
+            default:
+                return false;
+            }
+            if (!predicate.kernel)
+                return false;
+
+            column_predicates_.push_back(predicate);
+            return true;
+        }
+
+        template <typename T>
+        static kernel_t select_kernel_(Comparator::Type comparator) {
+            switch (comparator) {
+            case Comparator::EQUAL:
+                return &evaluate_<Comparator::EQUAL, T>;
+            case Comparator::NOT_EQUAL:
+                return &evaluate_<Comparator::NOT_EQUAL, T>;
+            case Comparator::LESS_THAN:
+                return &evaluate_<Comparator::LESS_THAN, T>;
+            case Comparator::LESS_THAN_EQUAL:
+                return &evaluate_<Comparator::LESS_THAN_EQUAL, T>;
+            case Comparator::GREATER_THAN:
+                return &evaluate_<Comparator::GREATER_THAN, T>;
+            case Comparator::GREATER_THAN_EQUAL:
+                return &evaluate_<Comparator::GREATER_THAN_EQUAL, T>;
+            default:
+                return NULL;
+            }
+        }
+
+        template <Comparator::Type Op, typename T>
+        static uint64_t evaluate_(ColumnBatch& columns, const ColumnPredicate& predicate,
+                                  size_t offset, size_t count);
+    };
+
+    template <Comparator::Type Op, typename T>
+    inline
+    uint64_t VectorizedSelection::evaluate_(ColumnBatch& columns, const ColumnPredicate& predicate,
+                                            size_t offset, size_t count) {
+        if (std::is_same<T, int>::value)
+            return SelectionKernel::compare<Op, int>(columns.get_int_column(predicate.attribute_index),
+                                                     offset, count, predicate.int_constant);
+        return SelectionKernel::compare<Op, double>(columns.get_float_column(predicate.attribute_index,
+                                                                             predicate.attribute_type),
+                                                    offset, count, predicate.float_constant);
+    }
+}
+
+#endif  /* ! CURRENTIA_VECTORIZED_SELECTION_H_ */
@@ -0,0 +1,233 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_WINDOW_AGGREGATION_H_
+#define CURRENTIA_WINDOW_AGGREGATION_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/operation/typed-operations.h"
+#include "currentia/core/schema.h"
+#include "currentia/core/tuple.h"
+
+#include <algorithm>            // std::max
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace currentia {
+    // SUM and COUNT of a numeric attribute over a window, updated as
+    // tuples enter (add()) and leave (remove()) it (see
+    // Synopsis::set_on_insert() / set_on_evict()), so that evaluating a
+    // sliding window costs O(stride) instead of O(width). INT values
+    // are summed exactly. A FLOAT sum accumulates rounding errors of
+    // subtractions, so it asks for recomputation from the window once
+    // in a while (needs_recomputation()).
+    class SlidingSum {
+        NumericAttribute attribute_;
+
+        long long int_sum_;
+        double float_sum_;
+        long count_;
+        long removals_count_;   // since the last recomputation
+
+    public:
+        // a FLOAT sum is recomputed after this many times the window
+        // size of removals (amortized O(1 / RECOMPUTATION_FACTOR))
+        static const long RECOMPUTATION_FACTOR = 64;
+
+        SlidingSum(const Schema::ptr_t& schema_ptr, const std::string& attribute_name):
+            attribute_(schema_ptr, attribute_name) {
+            clear();
+        }
+
+        void clear() {
+            int_sum_ = 0;
+            float_sum_ = 0;
+            count_ = 0;
+            removals_count_ = 0;
+        }
+
+        void add(const Tuple& tuple) {
+            if (attribute_.get_type() == Object::INT)
+                int_sum_ += tuple.get_int_by_index(attribute_.get_index());
+            else
+                float_sum_ += tuple.get_float_by_index(attribute_.get_index());
+            count_++;
+        }
+
+        void remove(const Tuple& tuple) {
+            if (attribute_.get_type() == Object::INT)
+                int_sum_ -= tuple.get_int_by_index(attribute_.get_index());
+            else
+                float_sum_ -= tuple.get_float_by_index(attribute_.get_index());
+            count_--;
+            removals_count_++;
+        }
+
+        bool needs_recomputation() const {
+            return attribute_.get_type() == Object::FLOAT &&
+                removals_count_ > RECOMPUTATION_FACTOR * std::max(count_, 1L);
+        }
+
+        // Recomputes from the tuples in the window (an iterator of
+        // Tuple::ptr_t; NULL slots of an unfilled synopsis are skipped)
+        template <typename Iterator>
+        void recompute(Iterator begin, Iterator end) {
+            clear();
+            for (; begin != end; ++begin) {
+                if (*begin)
+                    add(**begin);
+            }
+        }
+
+        double get_sum() const {
+            if (attribute_.get_type() == Object::INT)
+                return static_cast<double>(int_sum_);
+            return float_sum_;
+        }
+
+        // Exact sum of an INT attribute
+        long long get_int_sum() const {
+            return int_sum_;
+        }
+
+        long get_count() const {
+            return count_;
+        }
+
+        const NumericAttribute& get_attribute() const {
+            return attribute_;
+        }
+    };
+
+    // Aggregate of a FIFO window under an associative combine function
+    // without an inverse (min, max, ...), in amortized O(1) per
+    // insertion / eviction ("two stacks"). Insertions are pushed onto
+    // the back stack, which keeps the aggregate of its values. When the
+    // front stack runs out, the back stack is moved onto it, each entry
+    // keeping the aggregate of itself and the entries newer than it.
+    //
+    // Combine is a function object (const T&, const T&) -> T, called
+    // as combine(older, newer).
+    template <typename T, typename Combine>
+    class TwoStacksAggregate {
+        // (value, aggregate of the value and the newer values in front_)
+        std::vector<std::pair<T, T> > front_;
+        std::vector<T> back_;
+        T back_aggregate_;
+        Combine combine_;
+
+    public:
+        TwoStacksAggregate(const Combine& combine = Combine()):
+            back_aggregate_(),
+            combine_(combine) {
+        }
+
+        void clear() {
+            front_.clear();
+            back_.clear();
+        }
+
+        bool empty() const {
+            return front_.empty() && back_.empty();
+        }
+
+        size_t size() const {
+            return front_.size() + back_.size();
+        }
+
+        // Inserts the newest value
+        void push(const T& value) {
+            back_aggregate_ = back_.empty() ? value : combine_(back_aggregate_, value);
+            back_.push_back(value);
+        }
+
+        // Evicts the oldest value
+        void pop() {
+            if (front_.empty())
+                flip_();
+            front_.pop_back();
+        }
+
+        // Aggregate of all values (the window must not be empty)
+        T get() const {
+            if (front_.empty())
+                return back_aggregate_;
+            if (back_.empty())
+                return front_.back().second;
+            return combine_(front_.back().second, back_aggregate_);
+        }
+
+    private:
+        void flip_() {
+            // the newest value goes to the bottom
+            while (!back_.empty()) {
+                const T& value = back_.back();
+                front_.push_back(std::make_pair(value,
+                                                front_.empty()
+                                                ? value
+                                                : combine_(value, front_.back().second)));
+                back_.pop_back();
+            }
+        }
+    };
+
+    // MIN / MAX of a FIFO window in amortized O(1) per insertion /
+    // eviction. Only the values which may become the extremum later
+    // (those without a newer value better than or equal to them) are
+    // kept, so the front is always the extremum. Each value is numbered
+    // on insertion, and an eviction drops the front only when it is the
+    // oldest value; otherwise the oldest one was dropped on insertion.
+    //
+    // Compare is a strict weak ordering; std::less<T> gives MIN and
+    // std::greater<T> gives MAX.
+    template <typename T, typename Compare>
+    class MonotonicDeque {
+        // (value, insertion number)
+        std::deque<std::pair<T, long> > values_;
+        long pushed_count_;
+        long popped_count_;
+        Compare compare_;
+
+    public:
+        MonotonicDeque(const Compare& compare = Compare()):
+            compare_(compare) {
+            clear();
+        }
+
+        void clear() {
+            values_.clear();
+            pushed_count_ = 0;
+            popped_count_ = 0;
+        }
+
+        bool empty() const {
+            return pushed_count_ == popped_count_;
+        }
+
+        size_t size() const {
+            return pushed_count_ - popped_count_;
+        }
+
+        // Inserts the newest value
+        void push(const T& value) {
+            while (!values_.empty() && !compare_(values_.back().first, value))
+                values_.pop_back();
+            values_.push_back(std::make_pair(value, pushed_count_++));
+        }
+
+        // Evicts the oldest value
+        void pop() {
+            if (!values_.empty() && values_.front().second == popped_count_)
+                values_.pop_front();
+            popped_count_++;
+        }
+
+        // Extremum of all values (the window must not be empty)
+        const T& get() const {
+            return values_.front().first;
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_WINDOW_AGGREGATION_H_ */
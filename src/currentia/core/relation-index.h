@@ -0,0 +1,126 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_RELATION_INDEX_H_
+#define CURRENTIA_RELATION_INDEX_H_
+
+#include "currentia/core/object.h"
+#include "currentia/core/tuple.h"
+#include "currentia/core/pointer.h"
+#include "currentia/core/operator/comparator.h"
+#include "currentia/trait/non-copyable.h"
+#include "currentia/trait/pointable.h"
+
+#include <map>
+#include <unordered_map>
+
+namespace currentia {
+    // Secondary index on one attribute of a relation. A HASH index
+    // answers equality lookups; an ORDERED index answers range
+    // lookups (<, <=, >, >=) as well.
+    class RelationIndex: private NonCopyable<RelationIndex>,
+                         public Pointable<RelationIndex> {
+    public:
+        enum Type {
+            HASH,
+            ORDERED
+        };
+
+    private:
+        typedef std::unordered_multimap<Object, Tuple::ptr_t> hash_index_t;
+        typedef std::multimap<Object, Tuple::ptr_t> ordered_index_t;
+
+        Type type_;
+        int attribute_index_;
+
+        hash_index_t hash_index_;
+        ordered_index_t ordered_index_;
+
+    public:
+        RelationIndex(Type type, int attribute_index):
+            type_(type),
+            attribute_index_(attribute_index) {
+        }
+
+        Type get_type() const {
+            return type_;
+        }
+
+        int get_attribute_index() const {
+            return attribute_index_;
+        }
+
+        void insert(const Tuple::ptr_t& tuple_ptr) {
+            Object key = tuple_ptr->get_value_by_index(attribute_index_);
+            if (type_ == HASH)
+                hash_index_.insert(std::make_pair(key, tuple_ptr));
+            else
+                ordered_index_.insert(std::make_pair(key, tuple_ptr));
+        }
+
+        bool supports(Comparator::Type comparator) const {
+            switch (comparator) {
+            case Comparator::EQUAL:
+                return true;
+            case Comparator::NOT_EQUAL:
+                return false;
+            default:
+                return type_ == ORDERED;
+            }
+        }
+
+        // Calls function for each tuple whose value satisfies
+        // "value <comparator> key". Returns false when the index
+        // cannot answer the comparator (see supports()).
+        template <typename Function>
+        bool for_each_match(Comparator::Type comparator, const Object& key, Function function) const {
+            if (!supports(comparator))
+                return false;
+
+            if (type_ == HASH) {
+                auto range = hash_index_.equal_range(key);
+                for (auto iter = range.first; iter != range.second; ++iter)
+                    function(iter->second);
+                return true;
+            }
+
+            ordered_index_t::const_iterator first = ordered_index_.begin();
+            ordered_index_t::const_iterator last = ordered_index_.end();
+            switch (comparator) {
+            case Comparator::EQUAL:
+                first = ordered_index_.lower_bound(key);
+                last = ordered_index_.upper_bound(key);
+                break;
+            case Comparator::LESS_THAN:
+                last = ordered_index_.lower_bound(key);
+                break;
+            case Comparator::LESS_THAN_EQUAL:
+                last = ordered_index_.upper_bound(key);
+                break;
+            case Comparator::GREATER_THAN:
+                first = ordered_index_.upper_bound(key);
+                break;
+            case Comparator::GREATER_THAN_EQUAL:
+                first = ordered_index_.lower_bound(key);
+                break;
+            default:
+                return false;
+            }
+            for (; first != last; ++first)
+                function(first->second);
+            return true;
+        }
+
+        RelationIndex::ptr_t copy() const {
+            RelationIndex::ptr_t new_index(new RelationIndex(type_, attribute_index_));
+            new_index->hash_index_ = hash_index_;
+            new_index->ordered_index_ = ordered_index_;
+            return new_index;
+        }
+
+        size_t size() const {
+            return type_ == HASH ? hash_index_.size() : ordered_index_.size();
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_RELATION_INDEX_H_ */
@@ -3,6 +3,7 @@
 #ifndef CURRENTIA_RELATION_H_
 #define CURRENTIA_RELATION_H_
 
+#include "currentia/core/relation-index.h"
 #include "currentia/core/schema.h"
 #include "currentia/core/tuple.h"
 #include "currentia/core/pointer.h"
@@ -10,20 +11,55 @@
 #include "currentia/trait/non-copyable.h"
 #include "currentia/trait/pointable.h"
 
-#include <list>
+#include <map>
+#include <memory>
+#include <vector>
 
 namespace currentia {
+    // Tuples are kept in fixed-size chunks shared between versions of
+    // a relation (copy-on-write). A snapshot (copy()) only pins the
+    // current chunk list, and a later insertion copies the chunk list
+    // and the last chunk only if a snapshot still refers to them. A
+    // version is reclaimed as soon as the last snapshot (and the last
+    // tuple referring to it) is gone.
+    //
+    // read_lock() / read_write_lock() are shared / exclusive locks
+    // held over a transaction (2PL, updaters). Readers which do not
+    // need them take a View of the last committed version instead,
+    // which never waits for a writer: while a writer holds the lock,
+    // Views keep seeing the version pinned when the lock was taken.
     class Relation: private NonCopyable<Relation>,
                     public Pointable<Relation> {
+    public:
+        static const size_t CHUNK_SIZE = 256;
+
+    private:
+        typedef std::vector<Tuple::ptr_t> Chunk;
+        typedef std::vector<std::shared_ptr<Chunk> > ChunkList;
+
+        // secondary indices (attribute index -> index), also shared
+        // with snapshots and copied on the first write after sharing
+        typedef std::map<int, RelationIndex::ptr_t> IndicesType;
+
         Schema::ptr_t schema_ptr_;
 
-        typedef std::list<Tuple::ptr_t> RelationContainerType;
-        RelationContainerType tuple_ptrs_;
+        std::shared_ptr<ChunkList> chunks_;
+        size_t tuples_count_;
+        IndicesType indices_;
 
-        pthread_mutex_t read_mutex_;
+        // guards the members above (held only briefly)
+        mutable pthread_mutex_t state_mutex_;
+        // shared / exclusive lock for transactions
+        pthread_rwlock_t rw_lock_;
 
         long version_number_;
 
+        // version visible to Views while a writer holds rw_lock_
+        bool writing_;
+        std::shared_ptr<ChunkList> committed_chunks_;
+        IndicesType committed_indices_;
+        long committed_version_number_;
+
     public:
         class Transaction {
         public:
@@ -32,64 +68,247 @@ namespace currentia {
         };
         friend class Transaction;
 
-        Relation(Schema::ptr_t schema_ptr,
-                 // optional
-                 RelationContainerType tuple_ptrs = RelationContainerType(),
-                 long version_number = 0):
+        // Iterates tuples from the oldest one
+        class const_iterator {
+            const ChunkList* chunks_;
+            size_t chunk_index_;
+            size_t tuple_index_;
+
+        public:
+            const_iterator(const ChunkList* chunks, size_t chunk_index):
+                chunks_(chunks),
+                chunk_index_(chunk_index),
+                tuple_index_(0) {
+            }
+
+            const Tuple::ptr_t& operator*() const {
+                return (*(*chunks_)[chunk_index_])[tuple_index_];
+            }
+
+            const Tuple::ptr_t* operator->() const {
+                return &**this;
+            }
+
+            const_iterator& operator++() {
+                if (++tuple_index_ == (*chunks_)[chunk_index_]->size()) {
+                    ++chunk_index_;
+                    tuple_index_ = 0;
+                }
+                return *this;
+            }
+
+            bool operator==(const const_iterator& other) const {
+                return chunk_index_ == other.chunk_index_ && tuple_index_ == other.tuple_index_;
+            }
+
+            bool operator!=(const const_iterator& other) const {
+                return !(*this == other);
+            }
+        };
+
+        // Tuples of a committed version. Writers never modify what a
+        // View refers to, so it can be read without locks.
+        class View {
+            std::shared_ptr<ChunkList> chunks_;
+            IndicesType indices_;
+            long version_number_;
+
+        public:
+            View(const std::shared_ptr<ChunkList>& chunks,
+                 const IndicesType& indices,
+                 long version_number):
+                chunks_(chunks),
+                indices_(indices),
+                version_number_(version_number) {
+            }
+
+            const_iterator begin() const {
+                return const_iterator(chunks_.get(), 0);
+            }
+
+            const_iterator end() const {
+                return const_iterator(chunks_.get(), chunks_->size());
+            }
+
+            // Returns NULL if the attribute has no index
+            RelationIndex::ptr_t get_index(int attribute_index) const {
+                return find_index_(indices_, attribute_index);
+            }
+
+            long get_version_number() const {
+                return version_number_;
+            }
+        };
+
+        Relation(Schema::ptr_t schema_ptr):
             schema_ptr_(schema_ptr),
-            tuple_ptrs_(tuple_ptrs),
-            version_number_(version_number) {
-            // initialize recursive mutex
-            pthread_mutexattr_t mutex_attribute;
-            pthread_mutexattr_init(&mutex_attribute);
-            pthread_mutexattr_settype(&mutex_attribute, PTHREAD_MUTEX_RECURSIVE);
-            pthread_mutex_init(&read_mutex_, &mutex_attribute);
+            chunks_(new ChunkList()),
+            tuples_count_(0),
+            version_number_(0),
+            writing_(false),
+            committed_version_number_(0) {
+            init_locks_();
         }
 
+        ~Relation() {
+            pthread_rwlock_destroy(&rw_lock_);
+            pthread_mutex_destroy(&state_mutex_);
+        }
+
+    private:
+        // for snapshots
+        Relation(const Schema::ptr_t& schema_ptr,
+                 const std::shared_ptr<ChunkList>& chunks,
+                 size_t tuples_count,
+                 const IndicesType& indices,
+                 long version_number):
+            schema_ptr_(schema_ptr),
+            chunks_(chunks),
+            tuples_count_(tuples_count),
+            indices_(indices),
+            version_number_(version_number),
+            writing_(false),
+            committed_version_number_(version_number) {
+            init_locks_();
+        }
+
+        void init_locks_() {
+            pthread_mutex_init(&state_mutex_, NULL);
+            // The default (reader-preferring) kind lets a thread take
+            // the shared lock recursively, as several operators in a
+            // query may refer to the same relation.
+            pthread_rwlock_init(&rw_lock_, NULL);
+        }
+
+        static RelationIndex::ptr_t find_index_(const IndicesType& indices, int attribute_index) {
+            auto found = indices.find(attribute_index);
+            if (found == indices.end())
+                return RelationIndex::ptr_t();
+            return found->second;
+        }
+
+        // Makes the last chunk writable (and appends one if it is full)
+        Chunk& get_writable_last_chunk_() {
+            if (chunks_.use_count() > 1)
+                chunks_ = std::shared_ptr<ChunkList>(new ChunkList(*chunks_));
+
+            if (chunks_->empty() || chunks_->back()->size() >= CHUNK_SIZE) {
+                chunks_->push_back(std::shared_ptr<Chunk>(new Chunk()));
+                chunks_->back()->reserve(CHUNK_SIZE);
+            } else if (chunks_->back().use_count() > 1) {
+                std::shared_ptr<Chunk> new_chunk(new Chunk());
+                new_chunk->reserve(CHUNK_SIZE);
+                new_chunk->insert(new_chunk->end(), chunks_->back()->begin(), chunks_->back()->end());
+                chunks_->back() = new_chunk;
+            }
+
+            return *chunks_->back();
+        }
+
+        RelationIndex::ptr_t& get_writable_index_(RelationIndex::ptr_t& index) {
+            if (index.use_count() > 1)
+                index = index->copy();
+            return index;
+        }
+
+    public:
         // Blocking
         void insert(Tuple::ptr_t tuple_ptr) {
-            thread::ScopedLock lock(&read_mutex_);
-            tuple_ptrs_.push_front(tuple_ptr);
-            // tell arrival of a tuple to waiting threads
+            thread::ScopedLock lock(&state_mutex_);
+            get_writable_last_chunk_().push_back(tuple_ptr);
+            tuples_count_++;
+            auto iter = indices_.begin();
+            auto iter_end = indices_.end();
+            for (; iter != iter_end; ++iter)
+                get_writable_index_(iter->second)->insert(tuple_ptr);
+        }
+
+        // Blocking. Builds a secondary index over the tuples already
+        // in the relation; later insertions keep it up to date.
+        void create_index(const std::string& attribute_name,
+                          RelationIndex::Type type = RelationIndex::HASH) {
+            int attribute_index = schema_ptr_->get_attribute_index_by_name(attribute_name);
+            if (attribute_index < 0)
+                throw "Relation::create_index: " + attribute_name + " is not in " + schema_ptr_->toString();
+
+            thread::ScopedLock lock(&state_mutex_);
+            RelationIndex::ptr_t index(new RelationIndex(type, attribute_index));
+            auto iter = get_tuple_iterator();
+            auto iter_end = get_tuple_iterator_end();
+            for (; iter != iter_end; ++iter)
+                index->insert(*iter);
+            indices_[attribute_index] = index;
+        }
+
+        // Returns NULL if the attribute has no index
+        RelationIndex::ptr_t get_index(int attribute_index) const {
+            thread::ScopedLock lock(&state_mutex_);
+            return find_index_(indices_, attribute_index);
         }
 
         void update() {
-            thread::ScopedLock lock(&read_mutex_);
+            thread::ScopedLock lock(&state_mutex_);
             version_number_++;
         }
 
         long get_version_number() {
-            thread::ScopedLock lock(&read_mutex_);
+            thread::ScopedLock lock(&state_mutex_);
             long current_version_number = version_number_;
 
             return current_version_number;
         }
 
-        // TODO: implement read_lock() and write_lock()
+        // Shared lock
         void read_lock() {
-            pthread_mutex_lock(&read_mutex_);
+            pthread_rwlock_rdlock(&rw_lock_);
         }
 
+        // Exclusive lock. Views keep seeing the current version until
+        // unlock().
         void read_write_lock() {
-            pthread_mutex_lock(&read_mutex_);
+            pthread_rwlock_wrlock(&rw_lock_);
+            thread::ScopedLock lock(&state_mutex_);
+            writing_ = true;
+            committed_chunks_ = chunks_;
+            committed_indices_ = indices_;
+            committed_version_number_ = version_number_;
         }
 
+        // Releases the lock taken by read_lock() or read_write_lock()
         void unlock() {
-            pthread_mutex_unlock(&read_mutex_);
+            {
+                thread::ScopedLock lock(&state_mutex_);
+                if (writing_) {
+                    // publish the updates
+                    writing_ = false;
+                    committed_chunks_.reset();
+                    committed_indices_.clear();
+                }
+            }
+            pthread_rwlock_unlock(&rw_lock_);
         }
 
         // Blocking
         void do_transaction(const Transaction::ptr_t& transaction) {
-            thread::ScopedLock lock(&read_mutex_);
+            read_write_lock();
             transaction->process();
+            unlock();
         }
 
-        // Blocking
-        Relation::ptr_t copy() {
-            thread::ScopedLock lock(&read_mutex_);
-            RelationContainerType new_tuple_ptrs = tuple_ptrs_;
+        // Non-blocking (never waits for a writer)
+        View get_view() {
+            thread::ScopedLock lock(&state_mutex_);
+            if (writing_)
+                return View(committed_chunks_, committed_indices_, committed_version_number_);
+            return View(chunks_, indices_, version_number_);
+        }
 
-            return Relation::ptr_t(new Relation(schema_ptr_, new_tuple_ptrs, version_number_));
+        // Blocking, O(1). Returns a snapshot sharing the tuples (and
+        // indices) of the current version.
+        Relation::ptr_t copy() {
+            thread::ScopedLock lock(&state_mutex_);
+            return Relation::ptr_t(new Relation(schema_ptr_, chunks_, tuples_count_,
+                                                indices_, version_number_));
         }
 
         Schema::ptr_t get_schema() const {
@@ -97,12 +316,19 @@ namespace currentia {
             return schema_ptr_;
         }
 
-        RelationContainerType::const_iterator get_tuple_iterator() const {
-            return tuple_ptrs_.begin();
+        // Iterating the relation itself is not safe against concurrent
+        // insertions; see get_view()
+        const_iterator get_tuple_iterator() const {
+            return const_iterator(chunks_.get(), 0);
+        }
+
+        const_iterator get_tuple_iterator_end() const {
+            return const_iterator(chunks_.get(), chunks_->size());
         }
 
-        RelationContainerType::const_iterator get_tuple_iterator_end() const {
-            return tuple_ptrs_.end();
+        size_t get_tuples_count() const {
+            thread::ScopedLock lock(&state_mutex_);
+            return tuples_count_;
         }
     };
 }
@@ -0,0 +1,221 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_RING_BUFFER_H_
+#define CURRENTIA_RING_BUFFER_H_
+
+#include "currentia/trait/non-copyable.h"
+
+#include <atomic>
+#include <vector>
+#include <cstddef>              // size_t
+
+namespace currentia {
+    // Producer-side and consumer-side positions live on separate cache
+    // lines so that the two threads do not false-share them
+    static const size_t RING_BUFFER_CACHE_LINE_SIZE = 64;
+
+    // Rounds capacity up so that positions can be wrapped with a mask
+    inline
+    size_t ring_buffer_round_up_capacity(size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity)
+            rounded <<= 1;
+        return rounded;
+    }
+
+    // Bounded lock-free queue for exactly one producer thread and one
+    // consumer thread (Lamport queue with cached indices).
+    template <typename T>
+    class SPSCRingBuffer : private NonCopyable<SPSCRingBuffer<T> > {
+        const size_t capacity_;
+        const size_t mask_;
+        std::vector<T> slots_;
+
+        // consumer side
+        char padding_head_[RING_BUFFER_CACHE_LINE_SIZE];
+        std::atomic<size_t> head_;
+        size_t cached_tail_;
+
+        // producer side
+        char padding_tail_[RING_BUFFER_CACHE_LINE_SIZE];
+        std::atomic<size_t> tail_;
+        size_t cached_head_;
+
+    public:
+        explicit
+        SPSCRingBuffer(size_t capacity):
+            capacity_(ring_buffer_round_up_capacity(capacity)),
+            mask_(capacity_ - 1),
+            slots_(capacity_),
+            head_(0),
+            cached_tail_(0),
+            tail_(0),
+            cached_head_(0) {
+        }
+
+        // Producer only. Returns false when the buffer is full.
+        bool push(const T& value) {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - cached_head_ == capacity_) {
+                cached_head_ = head_.load(std::memory_order_acquire);
+                if (tail - cached_head_ == capacity_)
+                    return false;
+            }
+            slots_[tail & mask_] = value;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. Returns false when the buffer is empty.
+        bool pop(T& value) {
+            size_t head = head_.load(std::memory_order_relaxed);
+            if (head == cached_tail_) {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if (head == cached_tail_)
+                    return false;
+            }
+            value = slots_[head & mask_];
+            slots_[head & mask_] = T(); // drop the reference held by the slot
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. Copies the oldest element without popping it.
+        // Returns false when the buffer is empty.
+        bool front(T& value) const {
+            size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire))
+                return false;
+            value = slots_[head & mask_];
+            return true;
+        }
+
+        // Consumer only. Visits queued elements from the oldest one.
+        template <typename Function>
+        void for_each(Function function) const {
+            size_t head = head_.load(std::memory_order_relaxed);
+            size_t tail = tail_.load(std::memory_order_acquire);
+            for (; head != tail; ++head)
+                function(slots_[head & mask_]);
+        }
+
+        size_t size() const {
+            return tail_.load(std::memory_order_acquire) -
+                head_.load(std::memory_order_acquire);
+        }
+
+        size_t capacity() const {
+            return capacity_;
+        }
+    };
+
+    // Bounded lock-free queue for many producer threads and one
+    // consumer thread (D. Vyukov's bounded queue; each cell carries a
+    // sequence number telling whether it is ready to be written or
+    // read).
+    template <typename T>
+    class MPSCRingBuffer : private NonCopyable<MPSCRingBuffer<T> > {
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        const size_t capacity_;
+        const size_t mask_;
+        Cell* cells_;
+
+        char padding_enqueue_[RING_BUFFER_CACHE_LINE_SIZE];
+        std::atomic<size_t> enqueue_position_;
+        char padding_dequeue_[RING_BUFFER_CACHE_LINE_SIZE];
+        std::atomic<size_t> dequeue_position_;
+
+    public:
+        explicit
+        MPSCRingBuffer(size_t capacity):
+            capacity_(ring_buffer_round_up_capacity(capacity)),
+            mask_(capacity_ - 1),
+            cells_(new Cell[capacity_]),
+            enqueue_position_(0),
+            dequeue_position_(0) {
+            for (size_t i = 0; i < capacity_; ++i)
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        ~MPSCRingBuffer() {
+            delete[] cells_;
+        }
+
+        // Any thread. Returns false when the buffer is full.
+        bool push(const T& value) {
+            Cell* cell;
+            size_t position = enqueue_position_.load(std::memory_order_relaxed);
+            for (;;) {
+                cell = &cells_[position & mask_];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                long difference = static_cast<long>(sequence) - static_cast<long>(position);
+                if (difference == 0) {
+                    if (enqueue_position_.compare_exchange_weak(position, position + 1,
+                                                                std::memory_order_relaxed))
+                        break;
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = enqueue_position_.load(std::memory_order_relaxed);
+                }
+            }
+            cell->value = value;
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. Returns false when the buffer is empty (or
+        // when the oldest producer has not finished its write yet).
+        bool pop(T& value) {
+            size_t position = dequeue_position_.load(std::memory_order_relaxed);
+            Cell* cell = &cells_[position & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            if (sequence != position + 1)
+                return false;
+            value = cell->value;
+            cell->value = T();
+            cell->sequence.store(position + capacity_, std::memory_order_release);
+            dequeue_position_.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. Copies the oldest element without popping it
+        // (see pop() for when it returns false).
+        bool front(T& value) const {
+            size_t position = dequeue_position_.load(std::memory_order_relaxed);
+            const Cell& cell = cells_[position & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+                return false;
+            value = cell.value;
+            return true;
+        }
+
+        // Consumer only. Visits published elements from the oldest one.
+        template <typename Function>
+        void for_each(Function function) const {
+            size_t position = dequeue_position_.load(std::memory_order_relaxed);
+            for (;; ++position) {
+                const Cell& cell = cells_[position & mask_];
+                if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+                    break;
+                function(cell.value);
+            }
+        }
+
+        size_t size() const {
+            size_t enqueued = enqueue_position_.load(std::memory_order_acquire);
+            size_t dequeued = dequeue_position_.load(std::memory_order_acquire);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        size_t capacity() const {
+            return capacity_;
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_RING_BUFFER_H_ */
@@ -51,6 +51,43 @@ namespace currentia {
         virtual ~AbstractScheduler() {};
         virtual bool wake_up() = 0;
 
+        // Evaluates an operator once (a batch of tuples). wake_up()
+        // evaluates the operator chosen by the policy; multi-threaded
+        // schedulers (see WorkStealingScheduler) choose operators by
+        // themselves and call this instead.
+        virtual bool process_operator(Operator* next_operator) {
+            return process_operator_batch_(next_operator);
+        }
+
+        // Operators whose evaluation may touch the state of other
+        // operators (e.g., redo). They must be evaluated while no other
+        // operator is.
+        virtual bool is_synchronization_point(Operator* op) const {
+            return false;
+        }
+
+        // Operators which hold thread-owned resources (e.g., locks)
+        // from an evaluation to another. They must always be evaluated
+        // by the same thread.
+        virtual bool is_thread_bound(Operator* op) const {
+            return false;
+        }
+
+        const std::vector<Operator*>& get_operators() const {
+            return operators_;
+        }
+
+        // Whether an operator has input (see Operator::has_input())
+        bool has_ready_operator() const {
+            for (auto iter = operators_.begin(), iter_end = operators_.end();
+                 iter != iter_end;
+                 ++iter) {
+                if ((*iter)->has_input())
+                    return true;
+            }
+            return false;
+        }
+
     protected:
         Operator* get_next_operator_() {
             return scheduling_policy_->get_next_operator();
@@ -0,0 +1,121 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_IDLE_WAITER_H_
+#define CURRENTIA_IDLE_WAITER_H_
+
+#include "currentia/core/operator/operator.h"
+#include "currentia/core/stream.h"
+#include "currentia/core/thread.h"
+#include "currentia/trait/non-copyable.h"
+
+#include <vector>
+
+namespace currentia {
+    // Idles a thread evaluating operators in a loop (e.g., calling
+    // AbstractScheduler::wake_up()). While the thread finds no operator
+    // to evaluate, it yields for spin_count rounds (so a burst is
+    // picked up at once), then parks until a tuple arrives at an
+    // external input stream of the operators (see
+    // Operator::collect_external_input_streams()), so that an idle
+    // query burns no CPU.
+    //
+    //     IdleWaiter idle_waiter(scheduler->get_operators());
+    //     while (!stopped())
+    //         idle_waiter.after_wake_up(scheduler->wake_up());
+    //
+    // The constructor attaches its signal to the streams, so construct
+    // it before producers start (see Stream::set_arrival_signal()).
+    class IdleWaiter : private NonCopyable<IdleWaiter> {
+        const std::vector<Operator*> operators_;
+        thread::ArrivalSignal::ptr_t arrival_signal_;
+        int spin_count_;
+        int idle_count_;
+        long parks_count_;
+
+    public:
+        static const int DEFAULT_SPIN_COUNT = 1000;
+        static const int NEVER_PARK = -1;
+        // A parked thread wakes up at least this often (e.g., to
+        // notice Runnable::stop())
+        static const long PARK_TIMEOUT_USEC = 10000;
+
+        explicit IdleWaiter(const std::vector<Operator*>& operators,
+                            int spin_count = DEFAULT_SPIN_COUNT):
+            operators_(operators),
+            arrival_signal_(new thread::ArrivalSignal()),
+            spin_count_(spin_count),
+            idle_count_(0),
+            parks_count_(0) {
+            std::vector<Stream::ptr_t> streams;
+            for (auto iter = operators_.begin(), iter_end = operators_.end();
+                 iter != iter_end;
+                 ++iter) {
+                (*iter)->collect_external_input_streams(streams);
+            }
+            for (auto iter = streams.begin(), iter_end = streams.end();
+                 iter != iter_end;
+                 ++iter) {
+                (*iter)->set_arrival_signal(arrival_signal_);
+            }
+        }
+
+        // evaluated: whether an operator was evaluated (what wake_up()
+        // returned)
+        void after_wake_up(bool evaluated) {
+            after_wake_up(evaluated, []() { return false; });
+        }
+
+        // Parks only while has_work() is false too. Whatever makes it
+        // true has to be followed by a notification of
+        // get_arrival_signal().
+        template <typename Predicate>
+        void after_wake_up(bool evaluated, Predicate has_work) {
+            if (evaluated) {
+                idle_count_ = 0;
+                return;
+            }
+
+            if (spin_count_ == NEVER_PARK || idle_count_ < spin_count_) {
+                idle_count_++;
+                thread::scheduler_yield();
+                return;
+            }
+
+            // wake_up() may return false with operators left to
+            // evaluate (e.g., OptimisticCCScheduler), so check them
+            arrival_signal_->wait([&]() { return has_ready_operator_() || has_work(); },
+                                  PARK_TIMEOUT_USEC);
+            parks_count_++;
+            idle_count_ = 0;
+        }
+
+        void set_spin_count(int spin_count) {
+            spin_count_ = spin_count;
+        }
+
+        int get_spin_count() const {
+            return spin_count_;
+        }
+
+        long get_parks_count() const {
+            return parks_count_;
+        }
+
+        const thread::ArrivalSignal::ptr_t& get_arrival_signal() const {
+            return arrival_signal_;
+        }
+
+    private:
+        bool has_ready_operator_() const {
+            for (auto iter = operators_.begin(), iter_end = operators_.end();
+                 iter != iter_end;
+                 ++iter) {
+                if ((*iter)->has_input())
+                    return true;
+            }
+            return false;
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_IDLE_WAITER_H_ */
@@ -0,0 +1,294 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_PIPELINE_SCHEDULER_H_
+#define CURRENTIA_PIPELINE_SCHEDULER_H_
+
+#include "currentia/core/operator/operator.h"
+#include "currentia/core/operator/operator-visitor-serializer.h"
+#include "currentia/core/scheduler/abstract-scheduler.h"
+#include "currentia/core/scheduler/synchronization-point-lock.h"
+#include "currentia/core/stream.h"
+#include "currentia/core/thread.h"
+#include "currentia/trait/non-copyable.h"
+#include "currentia/trait/pointable.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace currentia {
+    // Evaluates the operators of a scheduler (with
+    // AbstractScheduler::process_operator()) in pipeline-parallel
+    // stages. The operators, in the order of OperatorVisitorSerializer,
+    // are cut into consecutive stages, and each stage is evaluated by
+    // its own thread pinned to a CPU (stage i to CPU i by default), so
+    // the state of an operator stays in the cache of one core.
+    //
+    // A stream from a stage to another becomes SPSC (see Stream) and
+    // is bounded: the producing operator is not evaluated while the
+    // stream holds stream_capacity tuples or more.
+    //
+    // As in WorkStealingScheduler, synchronization points run
+    // exclusively (see SynchronizationPointLock), and thread-bound
+    // operators have to be in the same stage.
+    class PipelineScheduler : private NonCopyable<PipelineScheduler>,
+                              public Pointable<PipelineScheduler> {
+        class Stage : public thread::Runnable {
+            PipelineScheduler* scheduler_;
+            std::vector<Operator*> operators_;
+            // output streams going to another stage (NULL otherwise)
+            std::vector<Stream*> bounded_streams_;
+
+        public:
+            explicit Stage(PipelineScheduler* scheduler):
+                scheduler_(scheduler) {
+            }
+
+            void add_operator(Operator* op, Stream* bounded_stream) {
+                operators_.push_back(op);
+                bounded_streams_.push_back(bounded_stream);
+            }
+
+            const std::vector<Operator*>& get_operators() const {
+                return operators_;
+            }
+
+            void run() {
+                try {
+                    while (!stopped()) {
+                        if (!scheduler_->run_stage_(operators_, bounded_streams_))
+                            thread::scheduler_yield();
+                    }
+                } catch (std::string error) {
+                    std::cerr << "PipelineScheduler: " << error << std::endl;
+                }
+            }
+        };
+
+        AbstractScheduler::ptr_t scheduler_;
+        std::vector<std::shared_ptr<Stage> > stages_;
+        size_t stream_capacity_;
+        SynchronizationPointLock synchronization_lock_;
+
+    public:
+        static const size_t DEFAULT_STREAM_CAPACITY = 1 << 10;
+
+        // A stage ends after each of stage_end_operators (and after the
+        // root). Throws a std::string when one of them is not in the
+        // tree, or when the stages separate thread-bound operators.
+        PipelineScheduler(const AbstractScheduler::ptr_t& scheduler,
+                          const std::vector<Operator*>& stage_end_operators,
+                          size_t stream_capacity = DEFAULT_STREAM_CAPACITY):
+            scheduler_(scheduler),
+            stream_capacity_(stream_capacity),
+            synchronization_lock_(*scheduler) {
+            const std::vector<Operator*>& operators = scheduler_->get_operators();
+            for (auto iter = stage_end_operators.begin(), iter_end = stage_end_operators.end();
+                 iter != iter_end;
+                 ++iter) {
+                if (std::find(operators.begin(), operators.end(), *iter) == operators.end())
+                    throw std::string("PipelineScheduler: a stage end is not in the operator tree");
+            }
+            if (stream_capacity_ < 1)
+                throw std::string("PipelineScheduler: streams between stages need a capacity");
+
+            std::map<Operator*, int> operator_stages;
+            int thread_bound_stage = -1;
+            int stage = 0;
+            for (auto iter = operators.begin(), iter_end = operators.end();
+                 iter != iter_end;
+                 ++iter) {
+                operator_stages[*iter] = stage;
+                if (scheduler_->is_thread_bound(*iter)) {
+                    if (thread_bound_stage >= 0 && thread_bound_stage != stage)
+                        throw std::string("PipelineScheduler: thread-bound operators have to be in one stage");
+                    thread_bound_stage = stage;
+                }
+                if (*iter != operators.back() &&
+                    std::find(stage_end_operators.begin(), stage_end_operators.end(), *iter) !=
+                    stage_end_operators.end())
+                    stage++;
+            }
+
+            for (int i = 0; i <= stage; ++i)
+                stages_.push_back(std::shared_ptr<Stage>(new Stage(this)));
+
+            std::map<Operator*, Operator*> consumers =
+                OperatorVisitorSerializer::find_consumers(operators.back());
+            for (auto iter = operators.begin(), iter_end = operators.end();
+                 iter != iter_end;
+                 ++iter) {
+                Stream* bounded_stream = NULL;
+                auto consumer = consumers.find(*iter);
+                if (consumer != consumers.end() &&
+                    operator_stages[consumer->second] != operator_stages[*iter]) {
+                    bounded_stream = (*iter)->get_output_stream().get();
+                    bounded_stream->set_queue_mode(Stream::SPSC, stream_capacity_);
+                }
+                stages_[operator_stages[*iter]]->add_operator(*iter, bounded_stream);
+            }
+
+            int cpus_count = std::thread::hardware_concurrency();
+            for (size_t i = 0; i < stages_.size(); ++i)
+                stages_[i]->set_cpu_affinity(cpus_count > 0 ? i % cpus_count : -1);
+        }
+
+        ~PipelineScheduler() {
+            stop_and_wait();
+        }
+
+        // Cuts operators (in the order of OperatorVisitorSerializer)
+        // into at most stages_count stages, so that the largest sum of
+        // the costs of a stage is the smallest. Returns the operators
+        // ending a stage.
+        static std::vector<Operator*> cut_by_costs(const std::vector<Operator*>& operators,
+                                                   const std::vector<double>& costs,
+                                                   int stages_count) {
+            int operators_count = operators.size();
+            if (static_cast<int>(costs.size()) != operators_count)
+                throw std::string("PipelineScheduler: a cost is needed for each operator");
+            stages_count = std::max(1, std::min(stages_count, operators_count));
+
+            std::vector<double> prefix_costs(1, 0);
+            for (int i = 0; i < operators_count; ++i)
+                prefix_costs.push_back(prefix_costs.back() + costs[i]);
+
+            // largest_costs[s][i]: the smallest largest stage cost of
+            // the first i operators in s + 1 stages, with its last cut
+            std::vector<std::vector<double> > largest_costs(
+                stages_count, std::vector<double>(operators_count + 1));
+            std::vector<std::vector<int> > last_cuts(
+                stages_count, std::vector<int>(operators_count + 1, 0));
+            for (int i = 0; i <= operators_count; ++i)
+                largest_costs[0][i] = prefix_costs[i];
+            for (int s = 1; s < stages_count; ++s) {
+                for (int i = 0; i <= operators_count; ++i) {
+                    largest_costs[s][i] = largest_costs[s - 1][i];
+                    last_cuts[s][i] = i;
+                    for (int cut = 1; cut < i; ++cut) {
+                        double largest_cost = std::max(largest_costs[s - 1][cut],
+                                                       prefix_costs[i] - prefix_costs[cut]);
+                        if (largest_cost < largest_costs[s][i]) {
+                            largest_costs[s][i] = largest_cost;
+                            last_cuts[s][i] = cut;
+                        }
+                    }
+                }
+            }
+
+            std::vector<Operator*> stage_end_operators;
+            for (int s = stages_count - 1, i = operators_count; s > 0; --s) {
+                int cut = last_cuts[s][i];
+                if (cut > 0 && cut < i)
+                    stage_end_operators.insert(stage_end_operators.begin(), operators[cut - 1]);
+                i = cut;
+            }
+            return stage_end_operators;
+        }
+
+        // Costs from the statistics of the operators: the number of
+        // tuples each one has evaluated (e.g., during a warm-up run),
+        // or 1 for each without statistics
+        static std::vector<double> get_evaluation_costs(const std::vector<Operator*>& operators) {
+            std::vector<double> costs;
+            bool has_statistics = false;
+            for (auto iter = operators.begin(), iter_end = operators.end();
+                 iter != iter_end;
+                 ++iter) {
+                costs.push_back((*iter)->get_evaluation_count());
+                if ((*iter)->get_evaluation_count() > 0)
+                    has_statistics = true;
+            }
+            if (!has_statistics)
+                std::fill(costs.begin(), costs.end(), 1);
+            return costs;
+        }
+
+        // Evaluates the operators of a scheduler on the calling thread
+        // (with wake_up()) at most evaluations_count times, or until
+        // none has input, so that get_evaluation_costs() has
+        // statistics to cut by. Returns the number of evaluations.
+        // Does nothing unless can_warm_up().
+        static long warm_up(AbstractScheduler& scheduler, long evaluations_count) {
+            if (!can_warm_up(scheduler))
+                return 0;
+
+            long count = 0;
+            for (; count < evaluations_count && scheduler.has_ready_operator(); ++count)
+                scheduler.wake_up();
+            return count;
+        }
+
+        // Whether the scheduler has no thread-bound operators, which
+        // would stay bound to the thread warming them up
+        static bool can_warm_up(const AbstractScheduler& scheduler) {
+            const std::vector<Operator*>& operators = scheduler.get_operators();
+            for (auto iter = operators.begin(), iter_end = operators.end();
+                 iter != iter_end;
+                 ++iter) {
+                if (scheduler.is_thread_bound(*iter))
+                    return false;
+            }
+            return true;
+        }
+
+        void start() {
+            for (auto iter = stages_.begin(), iter_end = stages_.end();
+                 iter != iter_end;
+                 ++iter) {
+                (*iter)->start();
+            }
+        }
+
+        void stop_and_wait() {
+            for (auto iter = stages_.begin(), iter_end = stages_.end();
+                 iter != iter_end;
+                 ++iter) {
+                (*iter)->stop_and_wait();
+            }
+        }
+
+        int get_stages_count() const {
+            return stages_.size();
+        }
+
+        const std::vector<Operator*>& get_stage_operators(int stage) const {
+            return stages_.at(stage)->get_operators();
+        }
+
+        // Pins a stage to a CPU (-1: any)
+        void set_cpu_affinity(int stage, int cpu) {
+            stages_.at(stage)->set_cpu_affinity(cpu);
+        }
+
+        int get_cpu_affinity(int stage) const {
+            return stages_.at(stage)->get_cpu_affinity();
+        }
+
+        const AbstractScheduler::ptr_t& get_scheduler() const {
+            return scheduler_;
+        }
+
+    private:
+        // Evaluates each operator of a stage with input, and returns
+        // whether any was evaluated
+        bool run_stage_(const std::vector<Operator*>& operators,
+                        const std::vector<Stream*>& bounded_streams) {
+            bool evaluated = false;
+            for (size_t i = 0; i < operators.size(); ++i) {
+                if (bounded_streams[i] && bounded_streams[i]->get_tuples_count() >= stream_capacity_)
+                    continue;
+                if (!operators[i]->has_input())
+                    continue;
+                synchronization_lock_.process_operator(*scheduler_, operators[i]);
+                evaluated = true;
+            }
+            return evaluated;
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_PIPELINE_SCHEDULER_H_ */
@@ -0,0 +1,153 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_SCHEDULING_POLICY_CHAIN_H_
+#define CURRENTIA_SCHEDULING_POLICY_CHAIN_H_
+
+#include "currentia/core/operator/operator.h"
+#include "currentia/core/operator/operator-visitor-serializer.h"
+#include "./scheduling-policy.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace currentia {
+    // Chain scheduling (Babcock et al.), which keeps the number of
+    // queued tuples low. Along each path from a leaf to the root, the
+    // progress chart plots the size of a tuple (the product of the
+    // selectivities so far) against the time spent on it (a unit per
+    // operator, as evaluation costs are not measured). An operator
+    // gets the slope of the segment of the lower envelope of the chart
+    // it lies on, and the ready operator with the steepest slope, which
+    // frees the most memory per unit of time, goes first (the one with
+    // the oldest tuple among equals).
+    //
+    // Selectivities come from the statistics of the operators (1 for
+    // an operator without them, see CURRENTIA_CHECK_STATISTICS). As
+    // they drift, slopes are recomputed every PRIORITIZATION_INTERVAL
+    // choices.
+    class ChainPolicy : public SchedulingPolicy {
+        // indices of operators_ from a leaf to the root
+        std::vector<std::vector<int> > paths_;
+        std::vector<double> priorities_;
+        int choices_count_;
+
+    public:
+        static const int PRIORITIZATION_INTERVAL = 1024;
+
+        ChainPolicy(const Operator::ptr_t& root_operator):
+            SchedulingPolicy(root_operator),
+            priorities_(number_of_operators_, 0),
+            choices_count_(0) {
+            std::map<Operator*, int> operator_indices;
+            for (int i = 0; i < number_of_operators_; ++i)
+                operator_indices[operators_[i]] = i;
+
+            std::map<Operator*, Operator*> consumers =
+                OperatorVisitorSerializer::find_consumers(root_operator_.get());
+            std::set<Operator*> consuming_operators;
+            for (auto iter = consumers.begin(), iter_end = consumers.end();
+                 iter != iter_end;
+                 ++iter) {
+                consuming_operators.insert(iter->second);
+            }
+
+            for (int i = 0; i < number_of_operators_; ++i) {
+                if (consuming_operators.count(operators_[i]))
+                    continue;
+                std::vector<int> path;
+                for (Operator* op = operators_[i]; op; ) {
+                    path.push_back(operator_indices[op]);
+                    auto consumer = consumers.find(op);
+                    op = consumer != consumers.end() ? consumer->second : NULL;
+                }
+                paths_.push_back(path);
+            }
+
+            prioritize();
+        }
+
+        Operator* get_next_operator() {
+            if (++choices_count_ >= PRIORITIZATION_INTERVAL) {
+                choices_count_ = 0;
+                prioritize();
+            }
+
+            int next_index = -1;
+            time_t next_oldest_time = Operator::NO_INPUT_TIME;
+            for (int i = 0; i < number_of_operators_; ++i) {
+                if (next_index >= 0 && priorities_[i] < priorities_[next_index])
+                    continue;
+                if (!is_ready_(operators_[i]))
+                    continue;
+                if (next_index >= 0 && priorities_[i] == priorities_[next_index]) {
+                    // a tie; oldest tuple first
+                    if (next_oldest_time == Operator::NO_INPUT_TIME)
+                        next_oldest_time = operators_[next_index]->get_oldest_input_time();
+                    time_t oldest_time = operators_[i]->get_oldest_input_time();
+                    if (oldest_time > next_oldest_time)
+                        continue;
+                    next_oldest_time = oldest_time;
+                } else {
+                    next_oldest_time = Operator::NO_INPUT_TIME;
+                }
+                next_index = i;
+            }
+
+            return next_index >= 0 ? operators_[next_index] : NULL;
+        }
+
+        // Recomputes the priorities from the current selectivities
+        void prioritize() {
+            std::fill(priorities_.begin(), priorities_.end(), -std::numeric_limits<double>::max());
+
+            for (auto path = paths_.begin(), path_end = paths_.end(); path != path_end; ++path) {
+                // sizes[k]: size of a tuple after the first k operators
+                std::vector<double> sizes(1, 1.0);
+                for (auto iter = path->begin(), iter_end = path->end(); iter != iter_end; ++iter)
+                    sizes.push_back(sizes.back() * get_selectivity_(operators_[*iter]));
+
+                size_t operators_count = path->size();
+                for (size_t begin = 0; begin < operators_count; ) {
+                    // the steepest segment from begin
+                    size_t end = begin + 1;
+                    double steepest_slope = sizes[begin] - sizes[end];
+                    for (size_t k = begin + 2; k <= operators_count; ++k) {
+                        double slope = (sizes[begin] - sizes[k]) / (k - begin);
+                        if (slope > steepest_slope) {
+                            end = k;
+                            steepest_slope = slope;
+                        }
+                    }
+                    // an operator on several paths takes its best slope
+                    for (size_t k = begin; k < end; ++k)
+                        priorities_[(*path)[k]] = std::max(priorities_[(*path)[k]], steepest_slope);
+                    begin = end;
+                }
+            }
+        }
+
+        double get_priority(const Operator* op) const {
+            auto found = std::find(operators_.begin(), operators_.end(), op);
+            return found != operators_.end() ? priorities_[found - operators_.begin()] : 0;
+        }
+
+    private:
+        static double get_selectivity_(const Operator* op) {
+            if (op->get_evaluation_count() == 0)
+                return 1.0;
+            return static_cast<double>(op->get_output_count()) / op->get_evaluation_count();
+        }
+    };
+
+    struct ChainPolicyFactory : public SchedulingPolicyFactory {
+        SchedulingPolicy*
+        create_policy_in_heap(const Operator::ptr_t& root_operator) const {
+            return new ChainPolicy(root_operator);
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_SCHEDULING_POLICY_CHAIN_H_ */
@@ -0,0 +1,45 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_SCHEDULING_POLICY_LONGEST_QUEUE_FIRST_H_
+#define CURRENTIA_SCHEDULING_POLICY_LONGEST_QUEUE_FIRST_H_
+
+#include "currentia/core/operator/operator.h"
+#include "./scheduling-policy.h"
+
+namespace currentia {
+    // Evaluates the operator with the most tuples waiting in its input
+    // streams, so that no queue grows far longer than the others.
+    // Under concurrency control, this leaves the commit operator (with
+    // a short queue) behind, and a redo replays the whole backlog
+    // before it, so prefer the other policies there.
+    class LongestQueueFirstPolicy : public SchedulingPolicy {
+    public:
+        LongestQueueFirstPolicy(const Operator::ptr_t& root_operator):
+            SchedulingPolicy(root_operator) {
+        }
+
+        Operator* get_next_operator() {
+            Operator* next_operator = NULL;
+            size_t longest_count = 0;
+            for (auto iter = operators_.begin(), iter_end = operators_.end();
+                 iter != iter_end;
+                 ++iter) {
+                size_t count = (*iter)->get_input_tuples_count();
+                if (count > longest_count && is_ready_(*iter)) {
+                    next_operator = *iter;
+                    longest_count = count;
+                }
+            }
+            return next_operator;
+        }
+    };
+
+    struct LongestQueueFirstPolicyFactory : public SchedulingPolicyFactory {
+        SchedulingPolicy*
+        create_policy_in_heap(const Operator::ptr_t& root_operator) const {
+            return new LongestQueueFirstPolicy(root_operator);
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_SCHEDULING_POLICY_LONGEST_QUEUE_FIRST_H_ */
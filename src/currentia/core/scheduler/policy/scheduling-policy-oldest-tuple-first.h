@@ -0,0 +1,46 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_SCHEDULING_POLICY_OLDEST_TUPLE_FIRST_H_
+#define CURRENTIA_SCHEDULING_POLICY_OLDEST_TUPLE_FIRST_H_
+
+#include "currentia/core/operator/operator.h"
+#include "./scheduling-policy.h"
+
+namespace currentia {
+    // Evaluates the operator holding the tuple which arrived first
+    // (see Operator::get_oldest_input_time()), which keeps the latency
+    // of the oldest tuples low. A tuple keeps its arrived_time along
+    // the tree, so among operators holding equally old tuples, the one
+    // nearest to the root wins and brings its tuple to the output.
+    class OldestTupleFirstPolicy : public SchedulingPolicy {
+    public:
+        OldestTupleFirstPolicy(const Operator::ptr_t& root_operator):
+            SchedulingPolicy(root_operator) {
+        }
+
+        Operator* get_next_operator() {
+            Operator* next_operator = NULL;
+            time_t oldest_time = Operator::NO_INPUT_TIME;
+            // operators_ lists producers before their consumers
+            for (auto iter = operators_.begin(), iter_end = operators_.end();
+                 iter != iter_end;
+                 ++iter) {
+                time_t time = (*iter)->get_oldest_input_time();
+                if (time != Operator::NO_INPUT_TIME && time <= oldest_time && is_ready_(*iter)) {
+                    next_operator = *iter;
+                    oldest_time = time;
+                }
+            }
+            return next_operator;
+        }
+    };
+
+    struct OldestTupleFirstPolicyFactory : public SchedulingPolicyFactory {
+        SchedulingPolicy*
+        create_policy_in_heap(const Operator::ptr_t& root_operator) const {
+            return new OldestTupleFirstPolicy(root_operator);
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_SCHEDULING_POLICY_OLDEST_TUPLE_FIRST_H_ */
@@ -16,11 +16,15 @@ namespace currentia {
             current_operator_index_(0) {
         }
 
+        // The next ready operator in turn
         Operator* get_next_operator() {
-            // TODO: Guarantee the returned operator is qualified (e.g., has input events)?
-            int current_index = current_operator_index_;
-            current_operator_index_ = (current_operator_index_ + 1) % number_of_operators_;
-            return operators_[current_index];
+            for (int i = 0; i < number_of_operators_; ++i) {
+                int current_index = current_operator_index_;
+                current_operator_index_ = (current_operator_index_ + 1) % number_of_operators_;
+                if (is_ready_(operators_[current_index]))
+                    return operators_[current_index];
+            }
+            return NULL;
         }
 
         void reset() {
@@ -21,9 +21,18 @@ namespace currentia {
             number_of_operators_(operators_.size()) {
         }
 
+        // Returns an operator ready to be evaluated, or NULL when no
+        // operator is
         virtual Operator* get_next_operator() = 0;
         virtual ~SchedulingPolicy() = 0;
         virtual void reset() {}
+
+    protected:
+        // An operator is ready when it has tuples to evaluate (see
+        // Operator::has_input())
+        static bool is_ready_(const Operator* op) {
+            return op->has_input();
+        }
     };
     SchedulingPolicy::~SchedulingPolicy() {};
 
@@ -0,0 +1,70 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_SYNCHRONIZATION_POINT_LOCK_H_
+#define CURRENTIA_SYNCHRONIZATION_POINT_LOCK_H_
+
+#include "currentia/core/operator/operator.h"
+#include "currentia/core/scheduler/abstract-scheduler.h"
+#include "currentia/core/thread.h"
+#include "currentia/trait/non-copyable.h"
+
+#include <pthread.h>
+
+namespace currentia {
+    // Evaluates the operators of a scheduler from several threads,
+    // running its synchronization points (see
+    // AbstractScheduler::is_synchronization_point()) exclusively: a
+    // synchronization point waits for the other evaluations to finish,
+    // and no evaluation starts until it is done. Without
+    // synchronization points, evaluations take no lock.
+    class SynchronizationPointLock : private NonCopyable<SynchronizationPointLock> {
+        bool has_synchronization_points_;
+        pthread_rwlock_t rwlock_;
+
+    public:
+        explicit SynchronizationPointLock(const AbstractScheduler& scheduler):
+            has_synchronization_points_(false) {
+            const std::vector<Operator*>& operators = scheduler.get_operators();
+            for (auto iter = operators.begin(), iter_end = operators.end();
+                 iter != iter_end;
+                 ++iter) {
+                if (scheduler.is_synchronization_point(*iter))
+                    has_synchronization_points_ = true;
+            }
+
+            pthread_rwlockattr_t rwlock_attribute;
+            pthread_rwlockattr_init(&rwlock_attribute);
+#ifdef __GLIBC__
+            // otherwise a synchronization point may wait forever for
+            // the other threads to stop evaluating operators
+            pthread_rwlockattr_setkind_np(&rwlock_attribute,
+                                          PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+            pthread_rwlock_init(&rwlock_, &rwlock_attribute);
+            pthread_rwlockattr_destroy(&rwlock_attribute);
+        }
+
+        ~SynchronizationPointLock() {
+            pthread_rwlock_destroy(&rwlock_);
+        }
+
+        bool has_synchronization_points() const {
+            return has_synchronization_points_;
+        }
+
+        bool process_operator(AbstractScheduler& scheduler, Operator* op) {
+            if (!has_synchronization_points_)
+                return scheduler.process_operator(op);
+
+            if (scheduler.is_synchronization_point(op)) {
+                thread::ScopedWriteLock lock(&rwlock_);
+                return scheduler.process_operator(op);
+            } else {
+                thread::ScopedReadLock lock(&rwlock_);
+                return scheduler.process_operator(op);
+            }
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_SYNCHRONIZATION_POINT_LOCK_H_ */
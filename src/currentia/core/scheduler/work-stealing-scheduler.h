@@ -0,0 +1,314 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_WORK_STEALING_SCHEDULER_H_
+#define CURRENTIA_WORK_STEALING_SCHEDULER_H_
+
+#include "currentia/core/operator/operator.h"
+#include "currentia/core/operator/operator-visitor-serializer.h"
+#include "currentia/core/scheduler/abstract-scheduler.h"
+#include "currentia/core/scheduler/synchronization-point-lock.h"
+#include "currentia/core/thread.h"
+#include "currentia/trait/non-copyable.h"
+#include "currentia/trait/pointable.h"
+
+#include <atomic>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace currentia {
+    // Evaluates the operators of a scheduler (with
+    // AbstractScheduler::process_operator()) on a pool of worker
+    // threads, instead of QueryProcessor calling wake_up() on a single
+    // thread.
+    //
+    // An operator with input is a task. Each worker runs the tasks at
+    // the back of its own deque, and steals the one at the front of
+    // another worker's deque when its own is empty. After running an
+    // operator, a worker pushes its consumer to the back, so tuples
+    // tend to go down the tree on the same core, and the operator
+    // itself (when it has input left) to the front, so that an operator
+    // fed faster than it runs does not starve the others. Workers
+    // with nothing to run or steal scan all the operators for input,
+    // which picks up the tuples coming from outside (stream adapters).
+    //
+    // An operator is in at most one deque or running worker at a time,
+    // so it is still evaluated by one thread at a time and each stream
+    // keeps a single consumer.
+    //
+    // Synchronization points of the scheduler (the commit operator of
+    // the CC schedulers, whose commits and redos reset other operators
+    // and streams) run exclusively: the worker waits for the running
+    // tasks to finish, and no other task starts until it is done.
+    // Thread-bound operators (the 2PL reference operators, whose locks
+    // the commit operator releases) are only run by the first worker.
+    // Without synchronization points (WithoutCCScheduler), workers
+    // never wait for each other.
+    class WorkStealingScheduler : private NonCopyable<WorkStealingScheduler>,
+                                  public Pointable<WorkStealingScheduler> {
+        struct Task {
+            Operator* op;
+            // the operator reading the output stream of op (NULL for
+            // the root)
+            Task* consumer;
+            bool thread_bound;
+            // in a deque or running
+            std::atomic<bool> scheduled;
+
+            Task(Operator* op, bool thread_bound):
+                op(op),
+                consumer(NULL),
+                thread_bound(thread_bound),
+                scheduled(false) {
+            }
+        };
+
+        class Worker : public thread::Runnable {
+            WorkStealingScheduler* scheduler_;
+            int index_;
+
+            pthread_mutex_t mutex_;
+            std::deque<Task*> tasks_;
+            // thread-bound tasks, never stolen (first worker only)
+            std::deque<Task*> bound_tasks_;
+
+            long executed_tasks_count_;
+            long stolen_tasks_count_;
+
+        public:
+            Worker(WorkStealingScheduler* scheduler, int index):
+                scheduler_(scheduler),
+                index_(index),
+                executed_tasks_count_(0),
+                stolen_tasks_count_(0) {
+                pthread_mutex_init(&mutex_, NULL);
+            }
+
+            ~Worker() {
+                pthread_mutex_destroy(&mutex_);
+            }
+
+            void run() {
+                try {
+                    while (!stopped()) {
+                        Task* task = pop_();
+                        if (!task)
+                            task = scheduler_->steal_(index_);
+                        if (!task) {
+                            if (!scheduler_->scan_(this))
+                                thread::scheduler_yield();
+                            continue;
+                        }
+                        scheduler_->run_task_(task, this);
+                        executed_tasks_count_++;
+                    }
+                } catch (std::string error) {
+                    std::cerr << "WorkStealingScheduler: " << error << std::endl;
+                }
+            }
+
+            void push(Task* task, bool to_front = false) {
+                thread::ScopedLock lock(&mutex_);
+                std::deque<Task*>& tasks = task->thread_bound ? bound_tasks_ : tasks_;
+                if (to_front)
+                    tasks.push_front(task);
+                else
+                    tasks.push_back(task);
+            }
+
+            Task* steal() {
+                thread::ScopedLock lock(&mutex_);
+                if (tasks_.empty())
+                    return NULL;
+                Task* task = tasks_.front();
+                tasks_.pop_front();
+                return task;
+            }
+
+            void count_stolen_task() {
+                stolen_tasks_count_++;
+            }
+
+            void clear() {
+                thread::ScopedLock lock(&mutex_);
+                tasks_.clear();
+                bound_tasks_.clear();
+            }
+
+            long get_executed_tasks_count() const {
+                return executed_tasks_count_;
+            }
+
+            long get_stolen_tasks_count() const {
+                return stolen_tasks_count_;
+            }
+
+        private:
+            Task* pop_() {
+                thread::ScopedLock lock(&mutex_);
+                std::deque<Task*>& tasks = bound_tasks_.empty() ? tasks_ : bound_tasks_;
+                if (tasks.empty())
+                    return NULL;
+                Task* task = tasks.back();
+                tasks.pop_back();
+                return task;
+            }
+        };
+
+        AbstractScheduler::ptr_t scheduler_;
+        std::deque<Task> tasks_;
+        std::vector<std::shared_ptr<Worker> > workers_;
+
+        SynchronizationPointLock synchronization_lock_;
+
+    public:
+        WorkStealingScheduler(const AbstractScheduler::ptr_t& scheduler, int workers_count):
+            scheduler_(scheduler),
+            synchronization_lock_(*scheduler) {
+            if (workers_count < 1)
+                throw std::string("WorkStealingScheduler: at least one worker is needed");
+
+            const std::vector<Operator*>& operators = scheduler_->get_operators();
+            std::map<Operator*, Task*> operator_tasks;
+            for (auto iter = operators.begin(), iter_end = operators.end();
+                 iter != iter_end;
+                 ++iter) {
+                tasks_.emplace_back(*iter, scheduler_->is_thread_bound(*iter));
+                operator_tasks[*iter] = &tasks_.back();
+            }
+            std::map<Operator*, Operator*> consumers =
+                OperatorVisitorSerializer::find_consumers(operators.back());
+            for (auto iter = consumers.begin(), iter_end = consumers.end();
+                 iter != iter_end;
+                 ++iter) {
+                operator_tasks[iter->first]->consumer = operator_tasks[iter->second];
+            }
+
+            for (int i = 0; i < workers_count; ++i)
+                workers_.push_back(std::shared_ptr<Worker>(new Worker(this, i)));
+        }
+
+        ~WorkStealingScheduler() {
+            stop_and_wait();
+        }
+
+        void start() {
+            for (auto iter = tasks_.begin(), iter_end = tasks_.end();
+                 iter != iter_end;
+                 ++iter) {
+                iter->scheduled = false;
+            }
+            for (auto iter = workers_.begin(), iter_end = workers_.end();
+                 iter != iter_end;
+                 ++iter) {
+                (*iter)->clear();
+                (*iter)->start();
+            }
+        }
+
+        void stop_and_wait() {
+            for (auto iter = workers_.begin(), iter_end = workers_.end();
+                 iter != iter_end;
+                 ++iter) {
+                (*iter)->stop_and_wait();
+            }
+        }
+
+        int get_workers_count() const {
+            return workers_.size();
+        }
+
+        const AbstractScheduler::ptr_t& get_scheduler() const {
+            return scheduler_;
+        }
+
+        // Operators run by the workers
+        long get_executed_tasks_count() const {
+            long count = 0;
+            for (auto iter = workers_.begin(), iter_end = workers_.end();
+                 iter != iter_end;
+                 ++iter) {
+                count += (*iter)->get_executed_tasks_count();
+            }
+            return count;
+        }
+
+        // Operators taken from the deques of other workers
+        long get_stolen_tasks_count() const {
+            long count = 0;
+            for (auto iter = workers_.begin(), iter_end = workers_.end();
+                 iter != iter_end;
+                 ++iter) {
+                count += (*iter)->get_stolen_tasks_count();
+            }
+            return count;
+        }
+
+    private:
+        // Pushes the task to a deque unless it is already scheduled or
+        // has no input. Input is checked after the task is taken, as
+        // only the thread about to run an operator may look at it.
+        bool try_schedule_(Task* task, Worker* worker) {
+            bool scheduled = false;
+            if (!task->scheduled.compare_exchange_strong(scheduled, true, std::memory_order_acq_rel))
+                return false;
+            if (!task->op->has_input()) {
+                task->scheduled.store(false, std::memory_order_release);
+                return false;
+            }
+            push_(task, worker);
+            return true;
+        }
+
+        void push_(Task* task, Worker* worker, bool to_front = false) {
+            if (task->thread_bound)
+                workers_.front()->push(task, to_front);
+            else
+                worker->push(task, to_front);
+        }
+
+        Task* steal_(int thief_index) {
+            int workers_count = workers_.size();
+            for (int i = 1; i < workers_count; ++i) {
+                Worker& victim = *workers_[(thief_index + i) % workers_count];
+                if (Task* task = victim.steal()) {
+                    workers_[thief_index]->count_stolen_task();
+                    return task;
+                }
+            }
+            return NULL;
+        }
+
+        // Schedules the operators with input. A producer which found
+        // its consumer already scheduled may have raced with the
+        // consumer finding its input empty, so this also catches the
+        // tasks missed that way.
+        bool scan_(Worker* worker) {
+            bool found = false;
+            for (auto iter = tasks_.begin(), iter_end = tasks_.end();
+                 iter != iter_end;
+                 ++iter) {
+                if (!iter->scheduled.load(std::memory_order_relaxed) &&
+                    try_schedule_(&*iter, worker))
+                    found = true;
+            }
+            return found;
+        }
+
+        void run_task_(Task* task, Worker* worker) {
+            synchronization_lock_.process_operator(*scheduler_, task->op);
+
+            if (task->op->has_input())
+                push_(task, worker, true);
+            else
+                task->scheduled.store(false, std::memory_order_release);
+            if (task->consumer && !task->consumer->scheduled.load(std::memory_order_relaxed))
+                try_schedule_(task->consumer, worker);
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_WORK_STEALING_SCHEDULER_H_ */
@@ -7,6 +7,7 @@
 #include "currentia/core/pointer.h"
 #include "currentia/core/thread.h"
 #include "currentia/core/attribute.h"
+#include "currentia/core/tuple-allocator.h"
 
 #include "currentia/trait/non-copyable.h"
 #include "currentia/trait/printable.h"
@@ -27,6 +28,9 @@ namespace currentia {
         return next_schema_id++;
     }
 
+    // Besides attribute names and types, a schema decides the layout
+    // of tuples: a row of fixed-width slots (one per attribute)
+    // followed by a variable-length area holding strings.
     class Schema: private NonCopyable<Schema>,
                   public Pointable<Schema>,
                   public Show {
@@ -35,6 +39,8 @@ namespace currentia {
         typedef std::vector<Attribute> attributes_t;
         typedef std::map<std::string, int> attributes_index_t;
 
+        static const size_t SLOT_SIZE = 8;
+
     private:
         long id_;
         // TODO: give relation name
@@ -44,6 +50,15 @@ namespace currentia {
         attributes_t attributes_;
         attributes_index_t attributes_index_;
 
+        // for tuple layout
+        std::vector<Object::Type> attribute_types_;
+        std::vector<int> string_attribute_indices_;
+
+        TupleAllocator::ptr_t tuple_allocator_;
+        // a thread may still be creating a tuple with them (see
+        // get_tuple_allocator())
+        std::list<TupleAllocator::ptr_t> retired_tuple_allocators_;
+
     public:
         // TODO: use builder pattern? (e.g., builder.add_attribute(xx).add_attribute(yy).build())
         // TODO: Schema decides relation. So we need relation name!
@@ -84,8 +99,12 @@ namespace currentia {
         int add_attribute(const std::string& name, Object::Type type) {
             thread::ScopedLock lock(&schema_lock_);
 
-            if (!is_schema_freezed_)
+            if (!is_schema_freezed_) {
                 attributes_.push_back(Attribute(name, type));
+                attribute_types_.push_back(type);
+                if (type == Object::STRING)
+                    string_attribute_indices_.push_back(attributes_.size() - 1);
+            }
 
             // TODO: check if this schema already has attribute with given name
             size_t current_size = this->size();
@@ -117,6 +136,33 @@ namespace currentia {
             return attributes_[attribute_index];
         }
 
+        // Unlike get_attribute_by_index(), does not copy the name
+        inline
+        Object::Type get_attribute_type_by_index(int attribute_index) const {
+            return attribute_types_[attribute_index];
+        }
+
+        // Size of the fixed-width part of a tuple
+        size_t get_fixed_size() const {
+            return attributes_.size() * SLOT_SIZE;
+        }
+
+        const std::vector<int>& get_string_attribute_indices() const {
+            return string_attribute_indices_;
+        }
+
+        // Allocator for tuples of this schema (NULL for the default one)
+        void set_tuple_allocator(const TupleAllocator::ptr_t& tuple_allocator) {
+            thread::ScopedLock lock(&schema_lock_);
+            if (tuple_allocator_)
+                retired_tuple_allocators_.push_back(tuple_allocator_);
+            tuple_allocator_ = tuple_allocator;
+        }
+
+        TupleAllocator* get_tuple_allocator() const {
+            return tuple_allocator_ ? tuple_allocator_.get() : TupleAllocator::get_default().get();
+        }
+
         bool has_attribute(const std::string& name) const {
             return attributes_index_.find(name) != attributes_index_.end();
         }
@@ -6,23 +6,46 @@
 #include "currentia/core/schema.h"
 #include "currentia/core/tuple.h"
 #include "currentia/core/pointer.h"
+#include "currentia/core/ring-buffer.h"
 #include "currentia/core/thread.h"
 #include "currentia/trait/non-copyable.h"
 #include "currentia/trait/pointable.h"
 #include "currentia/trait/show.h"
 
 #include <deque>
+#include <vector>
+#include <atomic>
 #include <algorithm>
+#include <cerrno>
 
 namespace currentia {
     /* Stream: just a queue for tuples with concurrent access possiblity */
     class Stream: private NonCopyable<Stream>,
                   public Pointable<Stream>,
                   public Show {
+    public:
+        // How tuples are queued. LOCKED guards a deque with a mutex
+        // and works for any number of producers and consumers. SPSC
+        // and MPSC use a bounded lock-free ring buffer instead, and
+        // require that only one thread dequeues from the stream.
+        enum QueueMode {
+            LOCKED,
+            SPSC,               // one producer (e.g., an upstream operator)
+            MPSC                // many producers (e.g., StreamSenders)
+        };
+
+        static const size_t DEFAULT_RING_CAPACITY = 1 << 14;
+
+        typedef std::vector<Tuple::ptr_t> batch_t;
+
     private:
         Schema::ptr_t schema_ptr_;
 
         typedef std::deque<Tuple::ptr_t> QueueType;
+        // In LOCKED mode, this holds all the queued tuples. In ring
+        // buffer modes, this holds tuples pushed back to the head of
+        // the stream (unshift(), insert_head() and redo), which are
+        // dequeued before the ones in the ring buffer.
         QueueType tuple_ptrs_;
 
         mutable pthread_mutex_t mutex_;
@@ -31,31 +54,164 @@ namespace currentia {
         QueueType backup_tuple_ptrs_;
         bool do_backup_;
 
+        QueueMode mode_;
+        std::unique_ptr<SPSCRingBuffer<Tuple::ptr_t> > spsc_ring_;
+        std::unique_ptr<MPSCRingBuffer<Tuple::ptr_t> > mpsc_ring_;
+        std::atomic<size_t> head_tuples_count_;
+        // Tuples which did not fit in the ring buffer. Once a tuple
+        // overflows, producers keep appending here until the
+        // consumer drains it, so the FIFO order is preserved and
+        // an operator never blocks on its own (full) output stream.
+        QueueType overflow_tuple_ptrs_;
+        std::atomic<size_t> overflow_tuples_count_;
+        std::atomic<int> waiting_readers_count_;
+
+        // notified on each enqueue (see set_arrival_signal())
+        thread::ArrivalSignal::ptr_t arrival_signal_;
+
     public:
         explicit
-        Stream(Schema::ptr_t schema_ptr):
+        Stream(Schema::ptr_t schema_ptr,
+               QueueMode mode = LOCKED,
+               size_t ring_capacity = DEFAULT_RING_CAPACITY):
             schema_ptr_(schema_ptr),
-            do_backup_(false) {
+            do_backup_(false),
+            mode_(LOCKED),
+            head_tuples_count_(0),
+            overflow_tuples_count_(0),
+            waiting_readers_count_(0) {
             // initialize values for thread synchronization
             pthread_mutexattr_t mutex_attribute;
             pthread_mutexattr_init(&mutex_attribute);
             pthread_mutexattr_settype(&mutex_attribute, PTHREAD_MUTEX_RECURSIVE);
             pthread_mutex_init(&mutex_, &mutex_attribute);
             pthread_cond_init(&reader_wait_, NULL);
+
+            if (mode != LOCKED)
+                set_queue_mode(mode, ring_capacity);
+        }
+
+        static Stream::ptr_t from_schema(const Schema::ptr_t& schema,
+                                         QueueMode mode = LOCKED) {
+            return Stream::ptr_t(new Stream(schema, mode));
+        }
+
+        QueueMode get_queue_mode() const {
+            return mode_;
         }
 
-        static Stream::ptr_t from_schema(const Schema::ptr_t& schema) {
-            return Stream::ptr_t(new Stream(schema));
+        bool is_lock_free() const {
+            return mode_ != LOCKED;
+        }
+
+        // Switch the queueing strategy. Queued tuples are carried
+        // over. Must not race with enqueue / dequeue (call it while
+        // building a plan, before the threads start).
+        void set_queue_mode(QueueMode mode,
+                            size_t ring_capacity = DEFAULT_RING_CAPACITY) {
+            thread::ScopedLock lock(&mutex_);
+
+            std::vector<Tuple::ptr_t> pending_tuples = get_pending_tuples_();
+            tuple_ptrs_.clear();
+            overflow_tuple_ptrs_.clear();
+            head_tuples_count_ = 0;
+            overflow_tuples_count_ = 0;
+
+            mode_ = mode;
+            spsc_ring_.reset(mode == SPSC ? new SPSCRingBuffer<Tuple::ptr_t>(ring_capacity) : NULL);
+            mpsc_ring_.reset(mode == MPSC ? new MPSCRingBuffer<Tuple::ptr_t>(ring_capacity) : NULL);
+
+            auto iter = pending_tuples.begin();
+            auto iter_end = pending_tuples.end();
+            for (; iter != iter_end; ++iter) {
+                if (mode_ == LOCKED)
+                    tuple_ptrs_.push_front(*iter);
+                else
+                    ring_enqueue_(*iter);
+            }
+        }
+
+        // Lets a consumer evaluating this stream among others (e.g., a
+        // QueryProcessor) park on the signal until a tuple is
+        // enqueued. Same restriction as set_queue_mode().
+        void set_arrival_signal(const thread::ArrivalSignal::ptr_t& arrival_signal) {
+            thread::ScopedLock lock(&mutex_);
+            arrival_signal_ = arrival_signal;
+        }
+
+        const thread::ArrivalSignal::ptr_t& get_arrival_signal() const {
+            return arrival_signal_;
         }
 
         // TODO: not exception safe
         void enqueue(const Tuple::ptr_t& tuple_ptr) {
+            if (mode_ != LOCKED) {
+                if (do_backup_) {
+                    // keep the queue and its backup in the same order
+                    thread::ScopedLock lock(&mutex_);
+                    backup_tuple_ptrs_.push_front(tuple_ptr);
+                    ring_enqueue_(tuple_ptr);
+                } else {
+                    ring_enqueue_(tuple_ptr);
+                }
+                notify_waiting_readers_();
+                notify_arrival_signal_();
+                return;
+            }
+
+            {
+                thread::ScopedLock lock(&mutex_);
+                tuple_ptrs_.push_front(tuple_ptr);
+                if (do_backup_)
+                    backup_tuple_ptrs_.push_front(tuple_ptr);
+                // tell arrival of a tuple to waiting threads
+                pthread_cond_broadcast(&reader_wait_);
+            }
+            notify_arrival_signal_();
+        }
+
+        // Enqueue tuples under one lock acquisition
+        void enqueue_batch(const batch_t& tuple_ptrs) {
+            if (tuple_ptrs.empty())
+                return;
+
+            if (mode_ != LOCKED) {
+                if (do_backup_) {
+                    thread::ScopedLock lock(&mutex_);
+                    backup_tuple_ptrs_.insert(backup_tuple_ptrs_.begin(),
+                                              tuple_ptrs.rbegin(), tuple_ptrs.rend());
+                    ring_enqueue_batch_(tuple_ptrs);
+                } else {
+                    ring_enqueue_batch_(tuple_ptrs);
+                }
+                notify_waiting_readers_();
+                notify_arrival_signal_();
+                return;
+            }
+
+            {
+                thread::ScopedLock lock(&mutex_);
+                tuple_ptrs_.insert(tuple_ptrs_.begin(), tuple_ptrs.rbegin(), tuple_ptrs.rend());
+                if (do_backup_)
+                    backup_tuple_ptrs_.insert(backup_tuple_ptrs_.begin(),
+                                              tuple_ptrs.rbegin(), tuple_ptrs.rend());
+                pthread_cond_broadcast(&reader_wait_);
+            }
+            notify_arrival_signal_();
+        }
+
+        // Dequeue at most max_count tuples under one lock acquisition
+        // and append them to tuple_ptrs (non-blocking). Returns the
+        // number of dequeued tuples.
+        size_t dequeue_batch(batch_t& tuple_ptrs, size_t max_count) {
+            if (mode_ != LOCKED)
+                return ring_dequeue_batch_(tuple_ptrs, max_count);
+
             thread::ScopedLock lock(&mutex_);
-            tuple_ptrs_.push_front(tuple_ptr);
-            if (do_backup_)
-                backup_tuple_ptrs_.push_front(tuple_ptr);
-            // tell arrival of a tuple to waiting threads
-            pthread_cond_broadcast(&reader_wait_);
+            size_t count = std::min(max_count, tuple_ptrs_.size());
+            tuple_ptrs.insert(tuple_ptrs.end(), tuple_ptrs_.rbegin(), tuple_ptrs_.rbegin() + count);
+            tuple_ptrs_.erase(tuple_ptrs_.end() - count, tuple_ptrs_.end());
+            return count;
         }
 
         // blocking
@@ -66,6 +222,9 @@ namespace currentia {
         // TODO: not exception safe
         // timeout version
         Tuple::ptr_t dequeue_timed_wait(const struct timespec* timeout) {
+            if (mode_ != LOCKED)
+                return ring_dequeue_timed_wait_(timeout);
+
             thread::ScopedLock lock(&mutex_);
 
             while (tuple_ptrs_.empty()) {
@@ -86,15 +245,18 @@ namespace currentia {
         void unshift(const Tuple::ptr_t& tuple_ptr) {
             thread::ScopedLock lock(&mutex_);
             tuple_ptrs_.push_back(tuple_ptr);
+            head_tuples_count_++;
         }
 
         bool has_tuple() const {
-            thread::ScopedLock lock(&mutex_);
-            return tuple_ptrs_.empty();
+            return get_tuples_count() > 0;
         }
 
         // Dequeue an elemen from stream. If the stream is empty, returns NULL.
         Tuple::ptr_t non_blocking_dequeue() {
+            if (mode_ != LOCKED)
+                return ring_dequeue_();
+
             thread::ScopedLock lock(&mutex_);
 
             if (tuple_ptrs_.empty())
@@ -105,6 +267,20 @@ namespace currentia {
             return tuple_ptr;
         }
 
+        // The tuple non_blocking_dequeue() would return, left in the
+        // stream (NULL if the stream is empty). Consumer only.
+        Tuple::ptr_t peek() const {
+            if (mode_ != LOCKED)
+                return ring_peek_();
+
+            thread::ScopedLock lock(&mutex_);
+
+            if (tuple_ptrs_.empty())
+                return Tuple::ptr_t();
+
+            return tuple_ptrs_.back();
+        }
+
         void lock() const {
             pthread_mutex_lock(&mutex_);
         }
@@ -123,6 +299,9 @@ namespace currentia {
         }
 
         size_t get_tuples_count() const {
+            if (mode_ != LOCKED)
+                return head_tuples_count_.load() + ring_size_() + overflow_tuples_count_.load();
+
             thread::ScopedLock lock(&mutex_);
             return tuple_ptrs_.size();
         }
@@ -130,6 +309,15 @@ namespace currentia {
         void clear() {
             thread::ScopedLock lock(&mutex_);
 
+            if (mode_ != LOCKED) {
+                Tuple::ptr_t dropped_tuple;
+                while (ring_pop_(dropped_tuple))
+                    ;
+                overflow_tuple_ptrs_.clear();
+                overflow_tuples_count_ = 0;
+                head_tuples_count_ = 0;
+            }
+
 #if 0
             bool stream_has_system_message = false;
             {
@@ -170,9 +358,14 @@ namespace currentia {
         void insert_head(const Stream::ptr_t& another_stream) {
             thread::ScopedLock lock(&mutex_);
             thread::ScopedLock another_lock(&(another_stream->mutex_));
-            tuple_ptrs_.insert(tuple_ptrs_.end(),
-                               another_stream->tuple_ptrs_.begin(),
-                               another_stream->tuple_ptrs_.end());
+            if (another_stream->mode_ == LOCKED) {
+                insert_head(another_stream->tuple_ptrs_);
+            } else {
+                // pending tuples come in dequeue order; QueueType
+                // keeps the next tuple to be dequeued at its back
+                std::vector<Tuple::ptr_t> another_tuples = another_stream->get_pending_tuples_();
+                insert_head(QueueType(another_tuples.rbegin(), another_tuples.rend()));
+            }
         }
 
         // TODO: take all iterable
@@ -181,14 +374,27 @@ namespace currentia {
             tuple_ptrs_.insert(tuple_ptrs_.end(),
                                another_tuples.begin(),
                                another_tuples.end());
+            head_tuples_count_ += another_tuples.size();
         }
 
         std::string toString() const {
             thread::ScopedLock lock(&mutex_);
 
+            if (mode_ != LOCKED) {
+                // same order as LOCKED mode (latest tuple first)
+                std::vector<Tuple::ptr_t> pending_tuples = get_pending_tuples_();
+                QueueType queue(pending_tuples.rbegin(), pending_tuples.rend());
+                return queue_to_string_(queue);
+            }
+
+            return queue_to_string_(tuple_ptrs_);
+        }
+
+    private:
+        static std::string queue_to_string_(const QueueType& tuple_ptrs) {
             std::stringstream ss;
-            auto iter = tuple_ptrs_.begin();
-            auto iter_end = tuple_ptrs_.end();
+            auto iter = tuple_ptrs.begin();
+            auto iter_end = tuple_ptrs.end();
             while (iter != iter_end) {
                 ss << (*iter)->toString();
                 iter++;
@@ -200,13 +406,200 @@ namespace currentia {
             return ss.str();
         }
 
-    private:
         inline Tuple::ptr_t dequeue_a_tuple_ptr_() {
             Tuple::ptr_t tuple_ptr = tuple_ptrs_.back();
             tuple_ptrs_.pop_back();
             return tuple_ptr;
         }
 
+        // Ring buffer modes
+
+        inline bool ring_push_(const Tuple::ptr_t& tuple_ptr) {
+            return mode_ == SPSC ? spsc_ring_->push(tuple_ptr) : mpsc_ring_->push(tuple_ptr);
+        }
+
+        inline bool ring_pop_(Tuple::ptr_t& tuple_ptr) {
+            return mode_ == SPSC ? spsc_ring_->pop(tuple_ptr) : mpsc_ring_->pop(tuple_ptr);
+        }
+
+        inline size_t ring_size_() const {
+            return mode_ == SPSC ? spsc_ring_->size() : mpsc_ring_->size();
+        }
+
+        void ring_enqueue_(const Tuple::ptr_t& tuple_ptr) {
+            if (overflow_tuples_count_.load(std::memory_order_acquire) == 0 &&
+                ring_push_(tuple_ptr))
+                return;
+
+            thread::ScopedLock lock(&mutex_);
+            overflow_tuple_ptrs_.push_front(tuple_ptr);
+            overflow_tuples_count_++;
+        }
+
+        void ring_enqueue_batch_(const batch_t& tuple_ptrs) {
+            auto iter = tuple_ptrs.begin();
+            auto iter_end = tuple_ptrs.end();
+            if (overflow_tuples_count_.load(std::memory_order_acquire) == 0) {
+                for (; iter != iter_end && ring_push_(*iter); ++iter)
+                    ;
+            }
+            if (iter == iter_end)
+                return;
+
+            thread::ScopedLock lock(&mutex_);
+            for (; iter != iter_end; ++iter) {
+                overflow_tuple_ptrs_.push_front(*iter);
+                overflow_tuples_count_++;
+            }
+        }
+
+        size_t ring_dequeue_batch_(batch_t& tuple_ptrs, size_t max_count) {
+            size_t count = 0;
+
+            if (head_tuples_count_.load(std::memory_order_acquire) > 0) {
+                thread::ScopedLock lock(&mutex_);
+                for (; count < max_count && !tuple_ptrs_.empty(); ++count) {
+                    tuple_ptrs.push_back(dequeue_a_tuple_ptr_());
+                    head_tuples_count_--;
+                }
+            }
+
+            Tuple::ptr_t tuple_ptr;
+            for (; count < max_count && ring_pop_(tuple_ptr); ++count)
+                tuple_ptrs.push_back(tuple_ptr);
+
+            if (count < max_count &&
+                ring_size_() == 0 &&
+                overflow_tuples_count_.load(std::memory_order_acquire) > 0) {
+                thread::ScopedLock lock(&mutex_);
+                for (; count < max_count && !overflow_tuple_ptrs_.empty(); ++count) {
+                    tuple_ptrs.push_back(overflow_tuple_ptrs_.back());
+                    overflow_tuple_ptrs_.pop_back();
+                    overflow_tuples_count_--;
+                }
+            }
+
+            return count;
+        }
+
+        // Consumer side: head tuples, then the ring buffer, then overflowed tuples
+        Tuple::ptr_t ring_dequeue_() {
+            Tuple::ptr_t tuple_ptr;
+
+            if (head_tuples_count_.load(std::memory_order_acquire) > 0) {
+                thread::ScopedLock lock(&mutex_);
+                if (!tuple_ptrs_.empty()) {
+                    head_tuples_count_--;
+                    return dequeue_a_tuple_ptr_();
+                }
+            }
+
+            if (ring_pop_(tuple_ptr))
+                return tuple_ptr;
+
+            // An MPSC pop also fails while the oldest producer is still
+            // writing its slot; overflowed tuples are newer than that
+            // one, so wait until the ring is really empty.
+            if (ring_size_() > 0)
+                return tuple_ptr;
+
+            if (overflow_tuples_count_.load(std::memory_order_acquire) > 0) {
+                thread::ScopedLock lock(&mutex_);
+                if (!overflow_tuple_ptrs_.empty()) {
+                    tuple_ptr = overflow_tuple_ptrs_.back();
+                    overflow_tuple_ptrs_.pop_back();
+                    overflow_tuples_count_--;
+                }
+            }
+
+            return tuple_ptr;
+        }
+
+        // Same order as ring_dequeue_()
+        Tuple::ptr_t ring_peek_() const {
+            Tuple::ptr_t tuple_ptr;
+
+            if (head_tuples_count_.load(std::memory_order_acquire) > 0) {
+                thread::ScopedLock lock(&mutex_);
+                if (!tuple_ptrs_.empty())
+                    return tuple_ptrs_.back();
+            }
+
+            bool found = mode_ == SPSC ? spsc_ring_->front(tuple_ptr) : mpsc_ring_->front(tuple_ptr);
+            if (found || ring_size_() > 0)
+                return tuple_ptr;
+
+            if (overflow_tuples_count_.load(std::memory_order_acquire) > 0) {
+                thread::ScopedLock lock(&mutex_);
+                if (!overflow_tuple_ptrs_.empty())
+                    tuple_ptr = overflow_tuple_ptrs_.back();
+            }
+
+            return tuple_ptr;
+        }
+
+        // Producers signal the condition variable only when a reader
+        // is parked, so enqueue() stays lock-free in the common case.
+        Tuple::ptr_t ring_dequeue_timed_wait_(const struct timespec* timeout) {
+            for (;;) {
+                Tuple::ptr_t tuple_ptr = ring_dequeue_();
+                if (tuple_ptr)
+                    return tuple_ptr;
+
+                thread::ScopedLock lock(&mutex_);
+                waiting_readers_count_++;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (get_tuples_count() == 0) {
+                    if (timeout) {
+                        if (pthread_cond_timedwait(&reader_wait_, &mutex_, timeout) == ETIMEDOUT) {
+                            waiting_readers_count_--;
+                            return ring_dequeue_(); // NULL if still empty
+                        }
+                    } else {
+                        pthread_cond_wait(&reader_wait_, &mutex_);
+                    }
+                }
+                waiting_readers_count_--;
+            }
+        }
+
+        void notify_waiting_readers_() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiting_readers_count_.load(std::memory_order_relaxed) > 0) {
+                thread::ScopedLock lock(&mutex_);
+                pthread_cond_broadcast(&reader_wait_);
+            }
+        }
+
+        // Called outside the stream mutex, which the woken consumer
+        // takes at once to dequeue
+        void notify_arrival_signal_() {
+            if (arrival_signal_)
+                arrival_signal_->notify();
+        }
+
+        // Queued tuples in dequeue order (the caller must be the
+        // consumer or hold the consumer off)
+        std::vector<Tuple::ptr_t> get_pending_tuples_() const {
+            std::vector<Tuple::ptr_t> pending_tuples(tuple_ptrs_.rbegin(), tuple_ptrs_.rend());
+
+            if (mode_ == SPSC) {
+                spsc_ring_->for_each([&](const Tuple::ptr_t& tuple_ptr) {
+                    pending_tuples.push_back(tuple_ptr);
+                });
+            } else if (mode_ == MPSC) {
+                mpsc_ring_->for_each([&](const Tuple::ptr_t& tuple_ptr) {
+                    pending_tuples.push_back(tuple_ptr);
+                });
+            }
+
+            pending_tuples.insert(pending_tuples.end(),
+                                  overflow_tuple_ptrs_.rbegin(),
+                                  overflow_tuple_ptrs_.rend());
+
+            return pending_tuples;
+        }
+
         // Backup
     public:
         void set_backup_state(bool backup) {
@@ -6,9 +6,14 @@
 // TODO: more portable (platform independent)
 #include <pthread.h>
 #include <sched.h>
+#include <atomic>
+#include <cerrno>
+#include <ctime>
+#include <string>
 #include <thread>
 
 #include "currentia/trait/non-copyable.h"
+#include "currentia/trait/pointable.h"
 
 namespace currentia {
     namespace thread {
@@ -26,6 +31,34 @@ namespace currentia {
             }
         };
 
+        class ScopedReadLock : private NonCopyable<ScopedReadLock> {
+            pthread_rwlock_t* rwlock_;
+
+        public:
+            ScopedReadLock(pthread_rwlock_t* rwlock):
+                rwlock_(rwlock) {
+                pthread_rwlock_rdlock(rwlock_);
+            }
+
+            ~ScopedReadLock() {
+                pthread_rwlock_unlock(rwlock_);
+            }
+        };
+
+        class ScopedWriteLock : private NonCopyable<ScopedWriteLock> {
+            pthread_rwlock_t* rwlock_;
+
+        public:
+            ScopedWriteLock(pthread_rwlock_t* rwlock):
+                rwlock_(rwlock) {
+                pthread_rwlock_wrlock(rwlock_);
+            }
+
+            ~ScopedWriteLock() {
+                pthread_rwlock_unlock(rwlock_);
+            }
+        };
+
         // The scheduler_yield() function shall force the running thread to
         // relinquish the processor until  it again becomes the head of
         // its thread list. It takes no arguments.
@@ -38,12 +71,80 @@ namespace currentia {
             return sched_yield();
         }
 
+        // Parks an idle consumer until a producer notifies an arrival.
+        // notify() costs a fence and a load while nobody is parked, so
+        // producers can call it on every enqueue.
+        class ArrivalSignal : private NonCopyable<ArrivalSignal>,
+                              public Pointable<ArrivalSignal> {
+            pthread_mutex_t mutex_;
+            pthread_cond_t arrival_;
+            std::atomic<unsigned long> notifications_count_;
+            std::atomic<int> waiters_count_;
+
+        public:
+            ArrivalSignal():
+                notifications_count_(0),
+                waiters_count_(0) {
+                pthread_mutex_init(&mutex_, NULL);
+                pthread_cond_init(&arrival_, NULL);
+            }
+
+            ~ArrivalSignal() {
+                pthread_cond_destroy(&arrival_);
+                pthread_mutex_destroy(&mutex_);
+            }
+
+            // Call after making the arrival visible (e.g., enqueued)
+            void notify() {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (waiters_count_.load(std::memory_order_relaxed) > 0) {
+                    ScopedLock lock(&mutex_);
+                    notifications_count_++;
+                    pthread_cond_broadcast(&arrival_);
+                }
+            }
+
+            // Blocks until a notification, or timeout_usec, unless
+            // has_arrival() holds. has_arrival() runs without the
+            // mutex, after the waiter is counted, so an arrival
+            // notified while checking is not missed. Returns whether
+            // it returned without timing out (it may also wake up
+            // spuriously).
+            template <typename Predicate>
+            bool wait(Predicate has_arrival, long timeout_usec) {
+                unsigned long notifications_count = notifications_count_.load();
+                waiters_count_++;   // sequentially consistent
+                bool timed_out = false;
+                if (!has_arrival()) {
+                    struct timespec deadline;
+                    clock_gettime(CLOCK_REALTIME, &deadline);
+                    deadline.tv_sec += timeout_usec / 1000000;
+                    deadline.tv_nsec += timeout_usec % 1000000 * 1000;
+                    if (deadline.tv_nsec >= 1000000000) {
+                        deadline.tv_sec++;
+                        deadline.tv_nsec -= 1000000000;
+                    }
+
+                    ScopedLock lock(&mutex_);
+                    while (notifications_count_.load() == notifications_count && !timed_out)
+                        timed_out = pthread_cond_timedwait(&arrival_, &mutex_, &deadline) == ETIMEDOUT;
+                }
+                waiters_count_--;
+                return !timed_out;
+            }
+
+            int get_waiters_count() const {
+                return waiters_count_.load();
+            }
+        };
+
         class Runnable : private NonCopyable<Runnable> {
             std::thread thread_;
             volatile bool stopped_;      // atomic
+            int cpu_;                    // -1: any
 
         public:
-            Runnable(): stopped_(true) {
+            Runnable(): stopped_(true), cpu_(-1) {
             }
 
             virtual ~Runnable() {
@@ -57,6 +158,24 @@ namespace currentia {
             void start() {
                 stopped_ = false;
                 thread_ = launch_thread();
+                if (cpu_ >= 0)
+                    pin_thread_(cpu_);
+            }
+
+            // Pins the thread to a CPU (-1 lets it run on any). Takes
+            // effect at start(), or at once when the thread is
+            // running. Throws a std::string when the CPU does not
+            // exist.
+            void set_cpu_affinity(int cpu) {
+                if (cpu >= static_cast<int>(std::thread::hardware_concurrency()) || cpu >= CPU_SETSIZE)
+                    throw std::string("Runnable: no such CPU");
+                cpu_ = cpu < 0 ? -1 : cpu;
+                if (thread_.joinable())
+                    pin_thread_(cpu_);
+            }
+
+            int get_cpu_affinity() const {
+                return cpu_;
             }
 
             std::thread launch_thread() {
@@ -90,6 +209,18 @@ namespace currentia {
             void run_runnable(thread::Runnable* runnable) {
                 runnable->run();
             }
+
+            void pin_thread_(int cpu) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                if (cpu < 0) {
+                    for (unsigned int i = 0; i < std::thread::hardware_concurrency() && i < CPU_SETSIZE; ++i)
+                        CPU_SET(i, &cpus);
+                } else {
+                    CPU_SET(cpu, &cpus);
+                }
+                pthread_setaffinity_np(thread_.native_handle(), sizeof(cpus), &cpus);
+            }
         };
     }
 }
@@ -0,0 +1,270 @@
+// -*- c++ -*-
+
+#ifndef CURRENTIA_TUPLE_ALLOCATOR_H_
+#define CURRENTIA_TUPLE_ALLOCATOR_H_
+
+#include "currentia/core/pointer.h"
+#include "currentia/core/thread.h"
+#include "currentia/trait/non-copyable.h"
+#include "currentia/trait/pointable.h"
+
+#include <atomic>
+#include <vector>
+#include <new>
+#include <cstddef>              // size_t
+
+namespace currentia {
+    // Memory for tuples (a tuple object together with its reference
+    // count, and its row). An allocator is chosen per schema (see
+    // Schema::set_tuple_allocator()). Memory may be released from a
+    // thread other than the allocating one. Every tuple shares the
+    // ownership of its allocator, which thus outlives the tuples
+    // (even when their schema is gone).
+    class TupleAllocator: private NonCopyable<TupleAllocator>,
+                          public Pointable<TupleAllocator>,
+                          public std::enable_shared_from_this<TupleAllocator> {
+    public:
+        static const size_t ALIGNMENT = 16;
+
+        virtual ~TupleAllocator() {}
+
+        virtual void* allocate(size_t size) = 0;
+        virtual void deallocate(void* pointer, size_t size) = 0;
+
+        static const TupleAllocator::ptr_t& get_default();
+
+    protected:
+        static size_t round_up_(size_t size) {
+            return size == 0 ? ALIGNMENT : (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        }
+    };
+
+    // Plain operator new / delete
+    class HeapTupleAllocator: public TupleAllocator {
+    public:
+        void* allocate(size_t size) {
+            return ::operator new(size);
+        }
+
+        void deallocate(void* pointer, size_t size) {
+            ::operator delete(pointer);
+        }
+    };
+
+    inline
+    const TupleAllocator::ptr_t& TupleAllocator::get_default() {
+        static TupleAllocator::ptr_t default_allocator(new HeapTupleAllocator());
+        return default_allocator;
+    }
+
+    // Free lists of fixed-size blocks carved from large slabs, one list
+    // per size class. Rows of a schema without strings always have the
+    // same size, so they keep reusing the blocks freed by expired
+    // tuples. Slabs are returned to the system when the allocator is
+    // destructed.
+    class SlabTupleAllocator: public TupleAllocator {
+    public:
+        static const size_t SLAB_SIZE = 64 * 1024;
+        static const size_t MAX_BLOCK_SIZE = 1024;
+
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        std::vector<FreeBlock*> free_lists_;
+        std::vector<char*> slabs_;
+        pthread_mutex_t mutex_;
+
+    public:
+        SlabTupleAllocator():
+            free_lists_(MAX_BLOCK_SIZE / ALIGNMENT + 1, NULL) {
+            pthread_mutex_init(&mutex_, NULL);
+        }
+
+        ~SlabTupleAllocator() {
+            auto iter = slabs_.begin();
+            auto iter_end = slabs_.end();
+            for (; iter != iter_end; ++iter)
+                delete[] *iter;
+            pthread_mutex_destroy(&mutex_);
+        }
+
+        void* allocate(size_t size) {
+            size = round_up_(size);
+            if (size > MAX_BLOCK_SIZE)
+                return ::operator new(size);
+
+            FreeBlock*& free_list = free_lists_[size / ALIGNMENT];
+            thread::ScopedLock lock(&mutex_);
+            if (!free_list)
+                carve_slab_(free_list, size);
+            FreeBlock* block = free_list;
+            free_list = block->next;
+            return block;
+        }
+
+        void deallocate(void* pointer, size_t size) {
+            size = round_up_(size);
+            if (size > MAX_BLOCK_SIZE) {
+                ::operator delete(pointer);
+                return;
+            }
+
+            FreeBlock*& free_list = free_lists_[size / ALIGNMENT];
+            FreeBlock* block = static_cast<FreeBlock*>(pointer);
+            thread::ScopedLock lock(&mutex_);
+            block->next = free_list;
+            free_list = block;
+        }
+
+    private:
+        void carve_slab_(FreeBlock*& free_list, size_t block_size) {
+            char* slab = new char[SLAB_SIZE];
+            slabs_.push_back(slab);
+            for (size_t offset = 0; offset + block_size <= SLAB_SIZE; offset += block_size) {
+                FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + offset);
+                block->next = free_list;
+                free_list = block;
+            }
+        }
+    };
+
+    // Bump allocation from chunks. Each chunk counts the blocks still
+    // in use, and is freed at once when the last of them is released,
+    // so tuples created together (a window, a batch) are freed in
+    // bulk. begin_region() starts a new chunk, so that tuples of the
+    // next window do not keep the chunk of the previous one alive.
+    // Chunks outlive the allocator as long as their tuples live.
+    class ArenaTupleAllocator: public TupleAllocator {
+    public:
+        static const size_t CHUNK_SIZE = 16 * 1024;
+
+    private:
+        struct Chunk {
+            // blocks in use (+1 while the chunk is the current one)
+            std::atomic<long> live_count;
+        };
+
+        // every block is preceded by a pointer to its chunk
+        static const size_t HEADER_SIZE = ALIGNMENT;
+        static const size_t CHUNK_HEADER_SIZE = ALIGNMENT;
+
+        Chunk* current_chunk_;
+        size_t current_offset_;
+        pthread_mutex_t mutex_;
+
+    public:
+        ArenaTupleAllocator():
+            current_chunk_(NULL),
+            current_offset_(0) {
+            pthread_mutex_init(&mutex_, NULL);
+        }
+
+        ~ArenaTupleAllocator() {
+            release_chunk_(current_chunk_);
+            pthread_mutex_destroy(&mutex_);
+        }
+
+        void* allocate(size_t size) {
+            size = round_up_(size) + HEADER_SIZE;
+
+            thread::ScopedLock lock(&mutex_);
+            Chunk* chunk;
+            char* block;
+            if (size > CHUNK_SIZE - CHUNK_HEADER_SIZE) {
+                // dedicated chunk
+                chunk = new_chunk_(CHUNK_HEADER_SIZE + size, 0);
+                block = reinterpret_cast<char*>(chunk) + CHUNK_HEADER_SIZE;
+            } else {
+                if (!current_chunk_ || current_offset_ + size > CHUNK_SIZE)
+                    replace_current_chunk_(new_chunk_(CHUNK_SIZE, 1));
+                chunk = current_chunk_;
+                block = reinterpret_cast<char*>(chunk) + current_offset_;
+                current_offset_ += size;
+            }
+
+            chunk->live_count.fetch_add(1, std::memory_order_relaxed);
+            *reinterpret_cast<Chunk**>(block) = chunk;
+            return block + HEADER_SIZE;
+        }
+
+        void deallocate(void* pointer, size_t size) {
+            char* block = static_cast<char*>(pointer) - HEADER_SIZE;
+            release_chunk_(*reinterpret_cast<Chunk**>(block));
+        }
+
+        void begin_region() {
+            thread::ScopedLock lock(&mutex_);
+            if (current_chunk_ && current_offset_ > CHUNK_HEADER_SIZE)
+                replace_current_chunk_(NULL);
+        }
+
+    private:
+        static Chunk* new_chunk_(size_t size, long live_count) {
+            Chunk* chunk = reinterpret_cast<Chunk*>(new char[size]);
+            new (&chunk->live_count) std::atomic<long>(live_count);
+            return chunk;
+        }
+
+        static void release_chunk_(Chunk* chunk) {
+            if (chunk && chunk->live_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete[] reinterpret_cast<char*>(chunk);
+        }
+
+        void replace_current_chunk_(Chunk* chunk) {
+            release_chunk_(current_chunk_);
+            current_chunk_ = chunk;
+            current_offset_ = CHUNK_HEADER_SIZE;
+        }
+    };
+
+    // Adapts TupleAllocator to the standard allocator interface (for
+    // std::allocate_shared). The copy kept in the control block of a
+    // tuple owns the allocator until the tuple is freed.
+    template <typename T>
+    class TupleAllocatorAdapter {
+        TupleAllocator::ptr_t allocator_;
+
+    public:
+        typedef T value_type;
+
+        template <typename U>
+        struct rebind {
+            typedef TupleAllocatorAdapter<U> other;
+        };
+
+        TupleAllocatorAdapter(const TupleAllocator::ptr_t& allocator):
+            allocator_(allocator) {
+        }
+
+        template <typename U>
+        TupleAllocatorAdapter(const TupleAllocatorAdapter<U>& other):
+            allocator_(other.get_allocator()) {
+        }
+
+        T* allocate(size_t count) {
+            return static_cast<T*>(allocator_->allocate(count * sizeof(T)));
+        }
+
+        void deallocate(T* pointer, size_t count) {
+            allocator_->deallocate(pointer, count * sizeof(T));
+        }
+
+        const TupleAllocator::ptr_t& get_allocator() const {
+            return allocator_;
+        }
+
+        template <typename U>
+        bool operator==(const TupleAllocatorAdapter<U>& other) const {
+            return allocator_ == other.get_allocator();
+        }
+
+        template <typename U>
+        bool operator!=(const TupleAllocatorAdapter<U>& other) const {
+            return allocator_ != other.get_allocator();
+        }
+    };
+}
+
+#endif  /* ! CURRENTIA_TUPLE_ALLOCATOR_H_ */
@@ -6,13 +6,17 @@
 #include "currentia/core/object.h"
 #include "currentia/core/pointer.h"
 #include "currentia/core/schema.h"
+#include "currentia/core/tuple-allocator.h"
 #include "currentia/trait/non-copyable.h"
 #include "currentia/trait/pointable.h"
 #include "currentia/trait/show.h"
 
 #include <sstream>              // string_stream
 #include <vector>
+#include <atomic>
 #include <ctime>
+#include <cstring>              // memcpy
+#include <stdint.h>             // uint32_t
 
 #ifdef CURRENTIA_ENABLE_TRANSACTION
 #include <unordered_map>
@@ -31,7 +35,13 @@ namespace currentia {
     class Relation;
 #endif
 
-    // Immutable
+    // Immutable. Values are packed into one buffer laid out by the
+    // schema: a fixed-width slot per attribute, followed by the
+    // characters of strings. Slots are read by offset, and joined or
+    // projected tuples are built by copying slots and string bytes.
+    //
+    // A tuple, its reference count and its row are allocated by the
+    // allocator of its schema (see TupleAllocator).
     class Tuple: private NonCopyable<Tuple>,
                  public Pointable<Tuple>,
                  public Show {
@@ -44,10 +54,23 @@ namespace currentia {
         };
 
     private:
+        union Slot {
+            int int_number;
+            double float_number;
+            struct {
+                uint32_t offset; // from the beginning of the string area
+                uint32_t length;
+            } string;
+            Object::blob_ptr_t blob_ptr;
+        };
+
         Type type_;
 
         Schema::ptr_t schema_ptr_;
-        data_t data_;
+        // owned by the control block of the tuple (see allocate_())
+        TupleAllocator* allocator_;
+        size_t row_size_;
+        char* row_;
         time_t arrived_time_; // system timestamp (logical one)
 
 #ifdef CURRENTIA_ENABLE_TIME_BASED_WINDOW
@@ -90,10 +113,21 @@ namespace currentia {
     private:
 #endif
 
-        Tuple(Schema::ptr_t schema_ptr, data_t data, time_t arrived_time):
+        // Only Tuple can name it, while std::allocate_shared can call
+        // the constructor taking it
+        class ConstructionKey {
+            friend class Tuple;
+            ConstructionKey() {}
+        };
+
+    public:
+        Tuple(const ConstructionKey&, const Schema::ptr_t& schema_ptr,
+              TupleAllocator* allocator, size_t strings_size, time_t arrived_time):
             type_(DATA),
             schema_ptr_(schema_ptr),
-            data_(data),
+            allocator_(allocator),
+            row_size_(schema_ptr->get_fixed_size() + strings_size),
+            row_(static_cast<char*>(allocator->allocate(row_size_))),
             arrived_time_(arrived_time) {
 #ifdef CURRENTIA_ENABLE_TRANSACTION
             set_lwm(arrived_time);
@@ -103,32 +137,184 @@ namespace currentia {
 #endif
         }
 
-        Tuple(Type type): type_(type) {
+    private:
+        // System messages count as older than any data tuple
+        Tuple(Type type):
+            type_(type),
+            allocator_(NULL),
+            row_size_(0),
+            row_(NULL),
+            arrived_time_(0) {
+        }
+
+        // Allocates a tuple with a row of the schema, having
+        // strings_size bytes for strings
+        static Tuple::ptr_t allocate_(const Schema::ptr_t& schema_ptr,
+                                      size_t strings_size,
+                                      time_t arrived_time) {
+            TupleAllocator* allocator = schema_ptr->get_tuple_allocator();
+            return std::allocate_shared<Tuple>(TupleAllocatorAdapter<Tuple>(allocator->shared_from_this()),
+                                               ConstructionKey(), schema_ptr, allocator,
+                                               strings_size, arrived_time);
+        }
+
+        Slot* get_slots_() const {
+            return reinterpret_cast<Slot*>(row_);
+        }
+
+        char* get_strings_() const {
+            return row_ + schema_ptr_->get_fixed_size();
+        }
+
+        size_t get_strings_size_() const {
+            return row_size_ - schema_ptr_->get_fixed_size();
         }
 
     public:
+        ~Tuple() {
+            if (row_)
+                allocator_->deallocate(row_, row_size_);
+        }
+
         static Tuple::ptr_t create_eos() {
             return Tuple::ptr_t(new Tuple(EOS));
         }
 
         static time_t get_current_time() {
-            static long current_time = 1;
+            // tuples may be created by several sender threads at once
+            static std::atomic<long> current_time(1);
             return current_time++;
         }
 
-        static Tuple::ptr_t create(Schema::ptr_t schema_ptr,
-                                   data_t data) {
+        static Tuple::ptr_t create(const Schema::ptr_t& schema_ptr,
+                                   const data_t& data) {
             return Tuple::create(schema_ptr, data, get_current_time());
         }
 
-        static Tuple::ptr_t create(Schema::ptr_t schema_ptr,
-                                   data_t data,
+        static Tuple::ptr_t create(const Schema::ptr_t& schema_ptr,
+                                   const data_t& data,
                                    time_t arrived_time) {
             if (!schema_ptr->validate_data(data)) {
                 return Tuple::ptr_t(); // NULL pointer
             }
 
-            return Tuple::ptr_t(new Tuple(schema_ptr, data, arrived_time));
+            size_t strings_size = 0;
+            auto iter = data.begin();
+            auto iter_end = data.end();
+            for (; iter != iter_end; ++iter) {
+                if (iter->get_type() == Object::STRING)
+                    strings_size += iter->get_string_ptr()->size();
+            }
+
+            Tuple::ptr_t tuple = allocate_(schema_ptr, strings_size, arrived_time);
+            Slot* slots = tuple->get_slots_();
+            char* strings = tuple->get_strings_();
+            uint32_t strings_offset = 0;
+
+            int index = 0;
+            for (iter = data.begin(); iter != iter_end; ++iter, ++index) {
+                switch (iter->get_type()) {
+                case Object::INT:
+                    slots[index].int_number = iter->get_int_number();
+                    break;
+                case Object::FLOAT:
+                    slots[index].float_number = iter->get_float_number();
+                    break;
+                case Object::STRING: {
+                    const std::string& string = *iter->get_string_ptr();
+                    slots[index].string.offset = strings_offset;
+                    slots[index].string.length = string.size();
+                    std::memcpy(strings + strings_offset, string.data(), string.size());
+                    strings_offset += string.size();
+                    break;
+                }
+                case Object::BLOB:
+                    slots[index].blob_ptr = iter->get_blob_ptr();
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            return tuple;
+        }
+
+        // Tuple having attributes of left_tuple followed by those of
+        // right_tuple (schema_ptr should be the concatenated schema)
+        static Tuple::ptr_t create_concatenated(const Schema::ptr_t& schema_ptr,
+                                                const Tuple::ptr_t& left_tuple,
+                                                const Tuple::ptr_t& right_tuple,
+                                                time_t arrived_time) {
+            const Schema::ptr_t& left_schema_ptr = left_tuple->schema_ptr_;
+            const Schema::ptr_t& right_schema_ptr = right_tuple->schema_ptr_;
+            if (schema_ptr->size() != left_schema_ptr->size() + right_schema_ptr->size())
+                throw "Tuple::create_concatenated: schema does not match the tuples";
+
+            size_t left_strings_size = left_tuple->get_strings_size_();
+            size_t right_strings_size = right_tuple->get_strings_size_();
+            Tuple::ptr_t tuple = allocate_(schema_ptr, left_strings_size + right_strings_size, arrived_time);
+
+            size_t left_fixed_size = left_schema_ptr->get_fixed_size();
+            std::memcpy(tuple->row_, left_tuple->row_, left_fixed_size);
+            std::memcpy(tuple->row_ + left_fixed_size, right_tuple->row_, right_schema_ptr->get_fixed_size());
+
+            char* strings = tuple->get_strings_();
+            std::memcpy(strings, left_tuple->get_strings_(), left_strings_size);
+            std::memcpy(strings + left_strings_size, right_tuple->get_strings_(), right_strings_size);
+
+            // strings of right_tuple are placed after those of left_tuple
+            if (left_strings_size > 0) {
+                Slot* right_slots = tuple->get_slots_() + left_schema_ptr->size();
+                const std::vector<int>& string_indices = right_schema_ptr->get_string_attribute_indices();
+                auto iter = string_indices.begin();
+                auto iter_end = string_indices.end();
+                for (; iter != iter_end; ++iter)
+                    right_slots[*iter].string.offset += left_strings_size;
+            }
+
+            return tuple;
+        }
+
+        // Tuple having attributes of source_tuple at attribute_indices
+        // (schema_ptr should have the attributes in the same order)
+        static Tuple::ptr_t create_projected(const Schema::ptr_t& schema_ptr,
+                                             const Tuple::ptr_t& source_tuple,
+                                             const std::vector<int>& attribute_indices,
+                                             time_t arrived_time) {
+            if (schema_ptr->size() != attribute_indices.size())
+                throw "Tuple::create_projected: schema does not match the attributes";
+
+            const Schema::ptr_t& source_schema_ptr = source_tuple->schema_ptr_;
+            const Slot* source_slots = source_tuple->get_slots_();
+
+            size_t strings_size = 0;
+            auto iter = attribute_indices.begin();
+            auto iter_end = attribute_indices.end();
+            for (; iter != iter_end; ++iter) {
+                source_tuple->assert_has_attribute_(*iter);
+                if (source_schema_ptr->get_attribute_type_by_index(*iter) == Object::STRING)
+                    strings_size += source_slots[*iter].string.length;
+            }
+
+            Tuple::ptr_t tuple = allocate_(schema_ptr, strings_size, arrived_time);
+            Slot* slots = tuple->get_slots_();
+            char* strings = tuple->get_strings_();
+            const char* source_strings = source_tuple->get_strings_();
+            uint32_t strings_offset = 0;
+
+            int index = 0;
+            for (iter = attribute_indices.begin(); iter != iter_end; ++iter, ++index) {
+                slots[index] = source_slots[*iter];
+                if (source_schema_ptr->get_attribute_type_by_index(*iter) == Object::STRING) {
+                    slots[index].string.offset = strings_offset;
+                    std::memcpy(strings + strings_offset,
+                                source_strings + source_slots[*iter].string.offset,
+                                slots[index].string.length);
+                    strings_offset += slots[index].string.length;
+                }
+            }
+
+            return tuple;
         }
 
         std::string toString() const {
@@ -137,16 +323,14 @@ namespace currentia {
             ss << "Tuple(";
             switch (type_) {
             case DATA:
-                if (data_.size() > 0) {
+                if (schema_ptr_->size() > 0) {
                     ss << "\n";
-                    int column = 0;
-                    for (data_t::const_iterator it = data_.begin();
-                         it != data_.end();
-                         ++it, ++column) {
+                    int columns_count = schema_ptr_->size();
+                    for (int column = 0; column < columns_count; ++column) {
                         ss << "  "
                            << get_schema()->get_attribute_by_index(column).toString()
                            << ": "
-                           << it->toString() << "\n";
+                           << get_value_by_index(column).toString() << "\n";
                     }
                 }
                 break;
@@ -179,21 +363,55 @@ namespace currentia {
 
         Object get_value_by_index(int attribute_index) const {
             assert_has_attribute_(attribute_index);
-            return data_[attribute_index];
+            const Slot& slot = get_slots_()[attribute_index];
+            switch (schema_ptr_->get_attribute_type_by_index(attribute_index)) {
+            case Object::INT:
+                return Object(slot.int_number);
+            case Object::FLOAT:
+                return Object(slot.float_number);
+            case Object::STRING:
+                return Object(get_strings_() + slot.string.offset, slot.string.length);
+            case Object::BLOB:
+                return Object(slot.blob_ptr);
+            default:
+                throw "This tuple has an attribute of unknown type";
+            }
         }
 
-        Object get_value_by_attribute_name(const std::string& attribute_name) const {
-            int attribute_index = schema_ptr_->get_attribute_index_by_name(attribute_name);
-            return get_value_by_index(attribute_index);
+        // Typed accessors (no Object is created)
+
+        int get_int_by_index(int attribute_index) const {
+            assert_attribute_type_(attribute_index, Object::INT);
+            return get_slots_()[attribute_index].int_number;
         }
 
-        data_t get_concatenated_data(const Tuple::ptr_t& target) const {
-            data_t new_data;
+        double get_float_by_index(int attribute_index) const {
+            assert_attribute_type_(attribute_index, Object::FLOAT);
+            return get_slots_()[attribute_index].float_number;
+        }
 
-            new_data.insert(new_data.end(), data_.begin(), data_.end());
-            new_data.insert(new_data.end(), target->data_.begin(), target->data_.end());
+        std::string get_string_by_index(int attribute_index) const {
+            assert_attribute_type_(attribute_index, Object::STRING);
+            const Slot& slot = get_slots_()[attribute_index];
+            return std::string(get_strings_() + slot.string.offset, slot.string.length);
+        }
 
-            return new_data;
+        // Characters of a string in the row (not NUL-terminated)
+        const char* get_string_data_by_index(int attribute_index, size_t& length) const {
+            assert_attribute_type_(attribute_index, Object::STRING);
+            const Slot& slot = get_slots_()[attribute_index];
+            length = slot.string.length;
+            return get_strings_() + slot.string.offset;
+        }
+
+        Object::blob_ptr_t get_blob_by_index(int attribute_index) const {
+            assert_attribute_type_(attribute_index, Object::BLOB);
+            return get_slots_()[attribute_index].blob_ptr;
+        }
+
+        Object get_value_by_attribute_name(const std::string& attribute_name) const {
+            int attribute_index = schema_ptr_->get_attribute_index_by_name(attribute_name);
+            return get_value_by_index(attribute_index);
         }
 
         time_t get_arrived_time() const {
@@ -224,12 +442,19 @@ namespace currentia {
 
     private:
         void assert_has_attribute_(int index) const {
-            if (index < 0 || static_cast<unsigned int>(index) >= data_.size()) {
-                std::cerr << "Requested " << index << " but size is " << data_.size() << std::endl;
+            size_t size = row_ ? schema_ptr_->size() : 0;
+            if (index < 0 || static_cast<unsigned int>(index) >= size) {
+                std::cerr << "Requested " << index << " but size is " << size << std::endl;
                 throw "This tuple does not have a requested attribute";
             }
         }
 
+        void assert_attribute_type_(int index, Object::Type type) const {
+            assert_has_attribute_(index);
+            if (schema_ptr_->get_attribute_type_by_index(index) != type)
+                throw "This tuple has an attribute of another type";
+        }
+
     public:
         // Easy helper (See tools/create_easy_generator.rb)
 
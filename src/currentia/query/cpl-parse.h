@@ -10,9 +10,10 @@ namespace currentia {
     // TODO: This method should create `Stream` instances into
     // SchemaManager, not into CPLQueryContainer (current
     // implementation).
-    CPLQueryContainer::ptr_t parse_cpl(CPLLexer* lexer) {
+    // See CPLQueryContainer::partitions_count for partitions_count
+    CPLQueryContainer::ptr_t parse_cpl(CPLLexer* lexer, int partitions_count = 1) {
         lemon::yyParser* yy_parser = reinterpret_cast<lemon::yyParser*>(lemon::CPLParseAlloc(malloc));
-        CPLQueryContainer* query_container = new CPLQueryContainer();
+        CPLQueryContainer* query_container = new CPLQueryContainer(partitions_count);
 
         int token;
         while ((token = lexer->get_next_token()) != CPLLexer::TOKEN_EOS) {
@@ -38,9 +39,9 @@ namespace currentia {
         return CPLQueryContainer::ptr_t(query_container);
     }
 
-    CPLQueryContainer::ptr_t parse_cpl(std::istream* ifs_ptr) {
+    CPLQueryContainer::ptr_t parse_cpl(std::istream* ifs_ptr, int partitions_count = 1) {
         CPLLexer lexer(ifs_ptr);
-        return parse_cpl(&lexer);
+        return parse_cpl(&lexer, partitions_count);
     }
 };
 
@@ -161,9 +161,86 @@ operation(A) ::= PROJECT fields(F).         { A = new CPLOperationInfo(CPLOperat
 operation(A) ::= MEAN fields(F) window(W).  { A = new CPLOperationInfo(CPLOperationInfo::MEAN, F, W); }
 operation(A) ::= SUM fields(F) window(W).   { A = new CPLOperationInfo(CPLOperationInfo::SUM, F, W); }
 operation(A) ::= ELECT fields(F) window(W). { A = new CPLOperationInfo(CPLOperationInfo::ELECT, F, W); }
+operation(A) ::= AGGREGATE aggregates(Aggregates) window(W). {
+    A = new CPLOperationInfo(Aggregates, NULL, W);
+}
+operation(A) ::= AGGREGATE aggregates(Aggregates) GROUP BY field(Key) window(W). {
+    A = new CPLOperationInfo(Aggregates, Key, W);
+}
+// Several windows over shared panes (see OperatorSharedWindowAggregation)
+operation(A) ::= AGGREGATE aggregates(Aggregates) window(W) COMMA windows(Windows). {
+    Windows->push_front(W);
+    A = new CPLOperationInfo(Aggregates, Windows);
+}
+operation(A) ::= APPROXIMATE sketch_aggregates(Aggregates) window(W). {
+    A = new CPLOperationInfo(Aggregates, W);
+}
+operation(A) ::= APPROXIMATE TOP INTEGER(K) field(F) sketch_error(E) window(W). {
+    std::list<CPLSketchAggregate*>* aggregates = new std::list<CPLSketchAggregate*>();
+    aggregates->push_back(new CPLSketchAggregate(SketchFunction::TOP, CPLLexer::parse_int(*K), F, E));
+    A = new CPLOperationInfo(aggregates, W);
+}
 operation(A) ::= COMBINE NAME(N) WHERE condition(C). {
     A = new CPLOperationInfo(CPLOperationInfo::COMBINE, *N, C);
 }
+// Ends a pipeline stage after the preceding operator (see PipelineScheduler)
+operation(A) ::= STAGE. { A = new CPLOperationInfo(CPLOperationInfo::STAGE); }
+
+// ------------------------------------------------------------
+// Aggregate (sum stream.field1, max stream.field2, ... [group by stream.field3])
+// ------------------------------------------------------------
+
+%type aggregates { std::list<CPLAggregate*>* }
+%destructor aggregates { delete $$; }
+aggregates(A) ::= aggregates(Aggregates) COMMA aggregate(Aggregate). {
+    A = Aggregates;
+    Aggregates->push_back(Aggregate);
+}
+aggregates(A) ::= aggregate(Aggregate). {
+    A = new std::list<CPLAggregate*>();
+    A->push_back(Aggregate);
+}
+
+%type aggregate { CPLAggregate* }
+%destructor aggregate { delete $$; }
+aggregate(A) ::= aggregate_function(T) field(F). {
+    A = new CPLAggregate(T, F);
+}
+
+%type aggregate_function { AggregateFunction::Type }
+aggregate_function(T) ::= SUM.   { T = AggregateFunction::SUM; }
+aggregate_function(T) ::= COUNT. { T = AggregateFunction::COUNT; }
+aggregate_function(T) ::= MIN.   { T = AggregateFunction::MIN; }
+aggregate_function(T) ::= MAX.   { T = AggregateFunction::MAX; }
+aggregate_function(T) ::= MEAN.  { T = AggregateFunction::MEAN; }
+
+// ------------------------------------------------------------
+// Approximate aggregate (distinct stream.field1, quantile 0.99 stream.field2 error 0.001, ...)
+// ------------------------------------------------------------
+
+%type sketch_aggregates { std::list<CPLSketchAggregate*>* }
+%destructor sketch_aggregates { delete $$; }
+sketch_aggregates(A) ::= sketch_aggregates(Aggregates) COMMA sketch_aggregate(Aggregate). {
+    A = Aggregates;
+    Aggregates->push_back(Aggregate);
+}
+sketch_aggregates(A) ::= sketch_aggregate(Aggregate). {
+    A = new std::list<CPLSketchAggregate*>();
+    A->push_back(Aggregate);
+}
+
+%type sketch_aggregate { CPLSketchAggregate* }
+%destructor sketch_aggregate { delete $$; }
+sketch_aggregate(A) ::= DISTINCT field(F) sketch_error(E). {
+    A = new CPLSketchAggregate(SketchFunction::DISTINCT, 0, F, E);
+}
+sketch_aggregate(A) ::= QUANTILE number(Q) field(F) sketch_error(E). {
+    A = new CPLSketchAggregate(SketchFunction::QUANTILE, Q, F, E);
+}
+
+%type sketch_error { double }
+sketch_error(E) ::= ERROR number(N). { E = N; }
+sketch_error(E) ::= .                { E = SketchFunction::DEFAULT_ERROR; }
 
 // ------------------------------------------------------------
 // Window
@@ -175,6 +252,17 @@ window(A) ::= LBRACKET window_info(Info) RBRACKET. {
     A = Info;
 }
 
+%type windows { std::list<Window*>* }
+%destructor windows { delete $$; }
+windows(A) ::= windows(Windows) COMMA window(W). {
+    A = Windows;
+    Windows->push_back(W);
+}
+windows(A) ::= window(W). {
+    A = new std::list<Window*>();
+    A->push_back(W);
+}
+
 %type window_info { Window* }
 %destructor window_info { delete $$; }
 window_info(A) ::= RECENT window_value_tuple(Width) SLIDE window_value_tuple(Slide). {
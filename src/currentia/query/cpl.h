@@ -4,18 +4,26 @@
 #define CURRENTIA_QUERY_CPL_H_
 
 #include "currentia/core/attribute.h"
+#include "currentia/core/operator/aggregate-function.h"
 #include "currentia/core/operator/condition.h"
 #include "currentia/core/operator/double-input-operator.h"
 #include "currentia/core/operator/operator-abstract-visitor.h"
+#include "currentia/core/operator/operator-aggregation.h"
 #include "currentia/core/operator/operator-election.h"
+#include "currentia/core/operator/operator-exchange.h"
+#include "currentia/core/operator/operator-grouped-aggregation.h"
 #include "currentia/core/operator/operator-join.h"
 #include "currentia/core/operator/operator-mean.h"
 #include "currentia/core/operator/operator-projection.h"
 #include "currentia/core/operator/operator-selection.h"
+#include "currentia/core/operator/operator-shared-window-aggregation.h"
 #include "currentia/core/operator/operator-simple-relation-join.h"
+#include "currentia/core/operator/operator-sketch-aggregation.h"
 #include "currentia/core/operator/operator-stream-adapter.h"
+#include "currentia/core/operator/operator-visitor-serializer.h"
 #include "currentia/core/operator/operator.h"
 #include "currentia/core/operator/single-input-operator.h"
+#include "currentia/core/operator/sketch-function.h"
 #include "currentia/core/pointer.h"
 #include "currentia/core/relation.h"
 #include "currentia/core/stream.h"
@@ -23,6 +31,10 @@
 #include "currentia/query/cpl-lexer.h"
 #include "currentia/trait/pointable.h"
 
+#include <algorithm>
+#include <list>
+#include <vector>
+
 // CPL stands for 'C'urrentia 'P'lan 'L'anguage
 
 namespace currentia {
@@ -41,9 +53,16 @@ namespace currentia {
         std::map<std::string, Relation::ptr_t> relations;
         std::map<std::string, Stream::ptr_t> streams;
         std::map<Stream::ptr_t, Operator::ptr_t> root_operators;
+        // operators ending a pipeline stage ("stage" in a query)
+        std::list<Operator::ptr_t> stage_end_operators;
+        // Consecutive partitionable operations of a derived stream are
+        // replicated on this many threads behind an exchange (see
+        // CPLDerivedStream::get_operator_tree()). 1 disables it.
+        int partitions_count;
 
-        CPLQueryContainer():
-            state(NEUTRAL) {
+        CPLQueryContainer(int partitions_count = 1):
+            state(NEUTRAL),
+            partitions_count(partitions_count) {
         }
 
         void define_relation(const std::string& relation_name,
@@ -104,6 +123,22 @@ namespace currentia {
         Operator::ptr_t get_root_operator_by_stream_name(const std::string& name) const {
             return get_root_operator_for_stream(get_stream_by_name(name));
         }
+
+        void add_stage_end_operator(const Operator::ptr_t& op) {
+            stage_end_operators.push_back(op);
+        }
+
+        // Stage ends within the tree rooted by root_operator
+        std::vector<Operator*> get_stage_end_operators(const Operator::ptr_t& root_operator) const {
+            std::vector<Operator*> operators = OperatorVisitorSerializer::serialize_tree(root_operator);
+            std::vector<Operator*> stage_end_operators_in_tree;
+            for (auto iter = stage_end_operators.begin(), iter_end = stage_end_operators.end();
+                 iter != iter_end; ++iter) {
+                if (std::find(operators.begin(), operators.end(), iter->get()) != operators.end())
+                    stage_end_operators_in_tree.push_back(iter->get());
+            }
+            return stage_end_operators_in_tree;
+        }
     };
 
     struct CPLRelationDeclaration {
@@ -195,6 +230,32 @@ namespace currentia {
         }
     };
 
+    // SUM stream.field1
+    struct CPLAggregate {
+        AggregateFunction::Type type;
+        CPLField* field_ptr;
+
+        CPLAggregate(AggregateFunction::Type type, CPLField* field_ptr):
+            type(type),
+            field_ptr(field_ptr) {
+        }
+    };
+
+    // DISTINCT stream.field1 ERROR 0.01, QUANTILE 0.99 stream.field2
+    struct CPLSketchAggregate {
+        SketchFunction::Type type;
+        double parameter;
+        CPLField* field_ptr;
+        double error;
+
+        CPLSketchAggregate(SketchFunction::Type type, double parameter, CPLField* field_ptr, double error):
+            type(type),
+            parameter(parameter),
+            field_ptr(field_ptr),
+            error(error) {
+        }
+    };
+
     struct CPLOperationInfo {
         enum Type {
             SELECT,
@@ -202,14 +263,22 @@ namespace currentia {
             MEAN,
             SUM,
             ELECT,
-            COMBINE
+            COMBINE,
+            AGGREGATE,
+            APPROXIMATE,
+            STAGE               // not an operator
         };
 
         Type type;
         std::string relation_name;
         Condition::ptr_t condition_ptr;
         std::list<CPLField*>* fields_ptr;
+        std::list<CPLAggregate*>* aggregates_ptr;
+        CPLField* group_by_field_ptr;
+        std::list<CPLSketchAggregate*>* sketch_aggregates_ptr;
         Window* window_ptr;
+        // AGGREGATE over several windows (NULL for one window_ptr)
+        std::list<Window*>* windows_ptr;
 
         CPLOperationInfo(Type type): type(type) {
         }
@@ -225,6 +294,32 @@ namespace currentia {
             window_ptr(window_ptr) {
         }
 
+        CPLOperationInfo(std::list<CPLAggregate*>* aggregates_ptr,
+                         CPLField* group_by_field_ptr,
+                         Window* window_ptr):
+            type(AGGREGATE),
+            aggregates_ptr(aggregates_ptr),
+            group_by_field_ptr(group_by_field_ptr),
+            window_ptr(window_ptr),
+            windows_ptr(NULL) {
+        }
+
+        CPLOperationInfo(std::list<CPLAggregate*>* aggregates_ptr,
+                         std::list<Window*>* windows_ptr):
+            type(AGGREGATE),
+            aggregates_ptr(aggregates_ptr),
+            group_by_field_ptr(NULL),
+            window_ptr(NULL),
+            windows_ptr(windows_ptr) {
+        }
+
+        CPLOperationInfo(std::list<CPLSketchAggregate*>* sketch_aggregates_ptr,
+                         Window* window_ptr):
+            type(APPROXIMATE),
+            sketch_aggregates_ptr(sketch_aggregates_ptr),
+            window_ptr(window_ptr) {
+        }
+
         CPLOperationInfo(Type type, const std::string& relation_name, Condition* condition_ptr):
             type(type),
             relation_name(relation_name),
@@ -244,13 +339,25 @@ namespace currentia {
             // }
         }
 
+        // Whether the operator gives the same result when each part of
+        // a hash-partitioned stream goes through its own instance
+        // (windows are over the whole stream, so only operators
+        // without windows are)
+        bool is_partitionable() const {
+            return type == SELECT || type == PROJECT || type == COMBINE;
+        }
+
+        // A replicated operator gets its own copy of the condition
+        // (see Condition::clone())
         Operator::ptr_t to_operator(const Operator::ptr_t& parent_operator,
-                                    CPLQueryContainer* query_container) {
+                                    CPLQueryContainer* query_container,
+                                    bool replicated = false) {
             Operator* op = NULL;
+            Condition::ptr_t condition = condition_ptr && replicated ? condition_ptr->clone() : condition_ptr;
 
             switch (type) {
             case SELECT:
-                op = new OperatorSelection(parent_operator, condition_ptr);
+                op = new OperatorSelection(parent_operator, condition);
                 break;
             case PROJECT: {
                 std::list<std::string> attribute_names;
@@ -264,9 +371,60 @@ namespace currentia {
             case MEAN:
                 op = new OperatorMean(parent_operator, *window_ptr, fields_ptr->front()->field_name);
                 break;
-            case SUM:
-                throw "SUM is not supported for now";
+            case SUM: {
+                // one SUM per field, computed in one pass
+                OperatorAggregation::specifications_t specifications;
+                std::list<CPLField*>::const_iterator iter = fields_ptr->begin();
+                std::list<CPLField*>::const_iterator iter_end = fields_ptr->end();
+                for (; iter != iter_end; ++iter)
+                    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::SUM,
+                                                                                (*iter)->field_name));
+                op = new OperatorAggregation(parent_operator, *window_ptr, specifications);
+                break;
+            }
+            case AGGREGATE: {
+                OperatorAggregation::specifications_t specifications;
+                std::list<CPLAggregate*>::const_iterator iter = aggregates_ptr->begin();
+                std::list<CPLAggregate*>::const_iterator iter_end = aggregates_ptr->end();
+                for (; iter != iter_end; ++iter)
+                    specifications.push_back(OperatorAggregation::Specification((*iter)->type,
+                                                                                (*iter)->field_ptr->field_name));
+                if (windows_ptr) {
+                    // results of all the windows in one stream, told
+                    // apart by the WINDOW attribute
+                    std::vector<Window> windows;
+                    for (auto window_iter = windows_ptr->begin(), window_iter_end = windows_ptr->end();
+                         window_iter != window_iter_end;
+                         ++window_iter) {
+                        windows.push_back(**window_iter);
+                    }
+                    op = new OperatorSharedWindowAggregation(parent_operator, windows, specifications, true);
+                } else if (group_by_field_ptr)
+                    op = new OperatorGroupedAggregation(parent_operator, *window_ptr,
+                                                        group_by_field_ptr->field_name, specifications);
+                else
+                    op = new OperatorAggregation(parent_operator, *window_ptr, specifications);
+                break;
+            }
+            case APPROXIMATE: {
+                CPLSketchAggregate* front = sketch_aggregates_ptr->front();
+                if (front->type == SketchFunction::TOP) {
+                    // TOP comes alone (see the grammar)
+                    op = new OperatorHeavyHitters(parent_operator, *window_ptr, front->field_ptr->field_name,
+                                                  static_cast<long>(front->parameter), front->error);
+                    break;
+                }
+                OperatorSketchAggregation::specifications_t specifications;
+                std::list<CPLSketchAggregate*>::const_iterator iter = sketch_aggregates_ptr->begin();
+                std::list<CPLSketchAggregate*>::const_iterator iter_end = sketch_aggregates_ptr->end();
+                for (; iter != iter_end; ++iter)
+                    specifications.push_back(SketchFunction::Specification((*iter)->type,
+                                                                           (*iter)->field_ptr->field_name,
+                                                                           (*iter)->parameter,
+                                                                           (*iter)->error));
+                op = new OperatorSketchAggregation(parent_operator, *window_ptr, specifications);
                 break;
+            }
             case ELECT:
                 op = new OperatorElection(parent_operator, *window_ptr);
                 break;
@@ -274,7 +432,7 @@ namespace currentia {
                 op = new OperatorSimpleRelationJoin(
                     parent_operator,
                     query_container->get_relation_by_name(relation_name),
-                    condition_ptr
+                    condition
                 );
                 break;
             default:
@@ -312,20 +470,62 @@ namespace currentia {
             return stream_name == "";
         }
 
+        // With query_container->partitions_count > 1, each run of
+        // partitionable operations is replicated behind an
+        // OperatorExchange. Any key gives the same result for them, so
+        // the stream is partitioned by its first attribute.
         Operator::ptr_t get_operator_tree(CPLQueryContainer* query_container) {
             Operator::ptr_t current_root = get_source_operator(query_container);
 
             if (operations_ptr) {
+                std::vector<CPLOperationInfo*> partitioned_operations;
                 std::list<CPLOperationInfo*>::const_iterator iter = operations_ptr->begin();
                 std::list<CPLOperationInfo*>::const_iterator iter_end = operations_ptr->end();
                 for (; iter != iter_end; ++iter) {
-                    current_root = (*iter)->to_operator(current_root, query_container);
+                    if (query_container->partitions_count > 1 && (*iter)->is_partitionable()) {
+                        partitioned_operations.push_back(*iter);
+                        continue;
+                    }
+                    current_root = partition_operations(current_root, partitioned_operations, query_container);
+                    if ((*iter)->type == CPLOperationInfo::STAGE)
+                        query_container->add_stage_end_operator(current_root);
+                    else
+                        current_root = (*iter)->to_operator(current_root, query_container);
                 }
+                current_root = partition_operations(current_root, partitioned_operations, query_container);
             }
 
             return current_root;
         }
 
+        // Replicates the operations (and clears them) behind an
+        // exchange on top of parent_operator
+        static Operator::ptr_t partition_operations(const Operator::ptr_t& parent_operator,
+                                                    std::vector<CPLOperationInfo*>& operations,
+                                                    CPLQueryContainer* query_container) {
+            if (operations.empty())
+                return parent_operator;
+
+            std::vector<CPLOperationInfo*> replicated_operations;
+            replicated_operations.swap(operations);
+            return OperatorExchange::ptr_t(
+                new OperatorExchange(
+                    parent_operator,
+                    parent_operator->get_output_schema_ptr()->get_attribute_by_index(0).name,
+                    query_container->partitions_count,
+                    [&](const Operator::ptr_t& source) {
+                        Operator::ptr_t replica = source;
+                        for (auto iter = replicated_operations.begin(), iter_end = replicated_operations.end();
+                             iter != iter_end;
+                             ++iter) {
+                            replica = (*iter)->to_operator(replica, query_container, true);
+                        }
+                        return replica;
+                    }
+                )
+            );
+        }
+
         Stream::ptr_t get_stream(CPLQueryContainer* query_container,
                                  const Operator::ptr_t& operator_tree) {
             return operator_tree->get_output_stream();
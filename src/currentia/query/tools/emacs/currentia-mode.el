@@ -37,27 +37,38 @@
 (setq currentia-keywords
       (make-regexp (mapcar (lambda (keyword) (concat "\\_<" keyword "\\_>"))
                            (list
+                            "aggregate"
                             "and"
+                            "approximate"
+                            "by"
                             "combine"
+                            "count"
                             "day"
+                            "distinct"
                             "elect"
+                            "error"
                             "inject"
                             "from"
+                            "group"
                             "hour"
+                            "max"
                             "mean"
                             "min"
                             "msec"
                             "not"
                             "or"
                             "project\\(ion\\)?"
+                            "quantile"
                             "recent"
                             "relation"
                             "rows"
                             "sec"
                             "select\\(ion\\)?"
                             "slide"
+                            "stage"
                             "stream"
                             "sum"
+                            "top"
                             "where"))))
 
 (setq currentia-comment "#.*$")
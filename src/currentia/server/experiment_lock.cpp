@@ -10,6 +10,7 @@
 #include "currentia/core/scheduler/policy/scheduling-policy-round-robin.h"
 
 #include "currentia/core/scheduler/abstract-scheduler.h"
+#include "currentia/core/scheduler/idle-waiter.h"
 #include "currentia/core/cc/without-cc-scheduler.h"
 #include "currentia/core/cc/optimistic-cc-scheduler.h"
 #include "currentia/core/cc/lock-cc-scheduler.h"
@@ -93,12 +94,12 @@ void consume_output_stream_thread_body()
 }
 
 AbstractScheduler *scheduler;
+IdleWaiter *idle_waiter;
 void process_stream_thread_body()
 {
     try {
         while (true) {
-            scheduler->wake_up();
-            thread::scheduler_yield();
+            idle_waiter->after_wake_up(scheduler->wake_up());
         }
     } catch (const char* error_message) {
         std::cerr << "Error while processing stream: " << error_message << std::endl;
@@ -198,6 +199,7 @@ void initialize(const cmdline::parser& cmd_parser)
         scheduler = new SnapshotCCScheduler(query_ptr, scheduling_policy_factory, txn_joint_count);
     else
         scheduler = new WithoutCCScheduler(query_ptr, scheduling_policy_factory);
+    idle_waiter = new IdleWaiter(scheduler->get_operators());
 }
 
 void set_parameters_from_option(cmdline::parser& cmd_parser)
@@ -308,13 +310,13 @@ int main(int argc, char **argv)
     }
     if (AbstractCCScheduler* acc = dynamic_cast<AbstractCCScheduler*>(scheduler)) {
         std::clog << "Consistent Rate: " << acc->get_consistent_rate() << std::endl;
-        TraitAggregationOperator* op = dynamic_cast<OperatorMean*>(acc->get_commit_operator());
+        TraitAggregationOperator* op = dynamic_cast<TraitAggregationOperator*>(acc->get_commit_operator());
         std::clog << "Window: " << op->get_window() << std::endl;
     }
     // TODO: Create common ancestor class for AbstractCCScheduler and WithoutCCScheduler
     if (WithoutCCScheduler* rcc = dynamic_cast<WithoutCCScheduler*>(scheduler)) {
         std::clog << "Consistent Rate: " << rcc->get_consistent_rate() << std::endl;
-        TraitAggregationOperator* op = dynamic_cast<OperatorMean*>(rcc->get_commit_operator());
+        TraitAggregationOperator* op = dynamic_cast<TraitAggregationOperator*>(rcc->get_commit_operator());
         std::clog << "Window: " << op->get_window() << std::endl;
     }
 
@@ -7,9 +7,14 @@
 #include "currentia/core/relation.h"
 
 #include "currentia/core/scheduler/policy/scheduling-policy.h"
+#include "currentia/core/scheduler/policy/scheduling-policy-chain.h"
+#include "currentia/core/scheduler/policy/scheduling-policy-longest-queue-first.h"
+#include "currentia/core/scheduler/policy/scheduling-policy-oldest-tuple-first.h"
 #include "currentia/core/scheduler/policy/scheduling-policy-round-robin.h"
 
 #include "currentia/core/scheduler/abstract-scheduler.h"
+#include "currentia/core/scheduler/pipeline-scheduler.h"
+#include "currentia/core/scheduler/work-stealing-scheduler.h"
 #include "currentia/core/cc/without-cc-scheduler.h"
 #include "currentia/core/cc/optimistic-cc-scheduler.h"
 #include "currentia/core/cc/lock-cc-scheduler.h"
@@ -33,6 +38,7 @@
 #include <thread>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <cstdlib>
 
 namespace currentia {
@@ -67,14 +73,28 @@ namespace currentia {
         ExperimentScheduling(std::istream& istream,
                              cmdline::parser& cmd_parser):
             cmd_parser_(cmd_parser) {
-            query_container_ = parse_cpl(&istream);
+            // replicate partitionable operators behind exchanges (hiding
+            // them from concurrency control)
+            int partitions_count = cmd_parser_.get<int>("partitions");
+            if (partitions_count > 1 && cmd_parser_.get<std::string>("method") != "none")
+                throw std::string("Partitioned operators need --method none");
+            query_container_ = parse_cpl(&istream, partitions_count);
         }
 
         AbstractScheduler* create_scheduler(const Operator::ptr_t& query_ptr) {
             std::string cc_method = cmd_parser_.get<std::string>("method");
             int txn_joint_count = cmd_parser_.get<int>("txn-joint-count");
 
-            SchedulingPolicyFactory::ptr_t scheduling_policy_factory(new RoundRobinPolicyFactory());
+            std::string scheduling_policy = cmd_parser_.get<std::string>("scheduling-policy");
+            SchedulingPolicyFactory::ptr_t scheduling_policy_factory;
+            if (scheduling_policy == "chain")
+                scheduling_policy_factory.reset(new ChainPolicyFactory());
+            else if (scheduling_policy == "longest-queue")
+                scheduling_policy_factory.reset(new LongestQueueFirstPolicyFactory());
+            else if (scheduling_policy == "oldest-tuple")
+                scheduling_policy_factory.reset(new OldestTupleFirstPolicyFactory());
+            else
+                scheduling_policy_factory.reset(new RoundRobinPolicyFactory());
 
             if (!CommitOperatorFinder::find_commit_operator(query_ptr.get())) {
                 // When commit operator isn't available in the plan,
@@ -121,12 +141,31 @@ namespace currentia {
             }
         }
 
+        // Inner edges have exactly one producer (the upstream
+        // operator) and one consumer, while an input stream may be
+        // fed by several senders.
+        void use_lock_free_streams(const Operator::ptr_t& query_ptr) {
+            auto operators = OperatorVisitorSerializer::serialize_tree(query_ptr);
+            for (auto iter = operators.begin(), iter_end = operators.end();
+                 iter != iter_end; ++iter) {
+                (*iter)->get_output_stream()->set_queue_mode(Stream::SPSC);
+                if (auto adapter = dynamic_cast<OperatorStreamAdapter*>(*iter))
+                    adapter->get_input_stream()->set_queue_mode(Stream::MPSC);
+            }
+        }
+
         void run(std::ostream& result_ios = std::cout) {
             long total_events = cmd_parser_.get<int>("total-events");
             useconds_t update_interval = cmd_parser_.get<useconds_t>("update-interval");
             useconds_t update_duration = cmd_parser_.get<useconds_t>("update-duration");
 
             auto relation = query_container_->get_relation_by_name("R");
+            std::string relation_index = cmd_parser_.get<std::string>("relation-index");
+            if (relation_index != "none") {
+                // index on the goods id (the 1st attribute)
+                relation->create_index(relation->get_schema()->get_attribute_by_index(0).name,
+                                       relation_index == "hash" ? RelationIndex::HASH : RelationIndex::ORDERED);
+            }
             insert_tuples_to_relation(relation, total_events);
 
             auto query_ptr = query_container_->get_root_operator_by_stream_name("ResultStream");
@@ -136,6 +175,10 @@ namespace currentia {
                 scheduler->set_efficient_scheduling_enabled(true);
             }
 
+            if (cmd_parser_.get<std::string>("stream-queue") == "lock-free") {
+                use_lock_free_streams(query_ptr);
+            }
+
             if (cmd_parser_.exist("output-dot")) {
                 std::ofstream dot_ofs("/tmp/query_tree.dot", std::ios::out | std::ios::trunc);
                 OperatorVisualizeDot::output_tree_as_dot(query_ptr, dot_ofs);
@@ -148,6 +191,31 @@ namespace currentia {
             StreamConsumer stream_consumer(query_container_->get_stream_by_name("ResultStream"));
             RelationUpdater relation_updater(query_container_->get_relation_by_name("R"), update_interval, update_duration);
             QueryProcessor query_processor(scheduler);
+            // evaluate operators on a pool of workers instead
+            int workers_count = cmd_parser_.get<int>("workers");
+            WorkStealingScheduler::ptr_t work_stealing_scheduler;
+            if (workers_count > 0)
+                work_stealing_scheduler.reset(new WorkStealingScheduler(scheduler, workers_count));
+            // or in pipeline stages, cut where the query says "stage"
+            // (or by the operator costs after a warm-up, see below)
+            int stages_count = cmd_parser_.get<int>("pipeline-stages");
+            long warm_up_count = cmd_parser_.get<long>("pipeline-warm-up");
+            long warm_up_evaluations_count = 0;
+            PipelineScheduler::ptr_t pipeline_scheduler;
+            if (stages_count > 0 && !work_stealing_scheduler) {
+                std::vector<Operator*> stage_end_operators = query_container_->get_stage_end_operators(query_ptr);
+                if (stage_end_operators.empty() &&
+                    (warm_up_count <= 0 || !PipelineScheduler::can_warm_up(*scheduler))) {
+                    // without statistics, operators cost the same
+                    stage_end_operators = PipelineScheduler::cut_by_costs(
+                        scheduler->get_operators(),
+                        PipelineScheduler::get_evaluation_costs(scheduler->get_operators()),
+                        stages_count);
+                    pipeline_scheduler.reset(new PipelineScheduler(scheduler, stage_end_operators));
+                } else if (!stage_end_operators.empty()) {
+                    pipeline_scheduler.reset(new PipelineScheduler(scheduler, stage_end_operators));
+                }
+            }
 
             // First, insert whole streams
             ConcreteStreamSender stream_sender(query_container_->get_adapter_input_stream_by_name("InputStream"), total_events);
@@ -163,12 +231,33 @@ namespace currentia {
             stream_consumer.start();
             relation_updater.start();
             TIME_IT(elapsed_seconds) {
-                query_processor.start();
+                if (stages_count > 0 && !pipeline_scheduler && !work_stealing_scheduler) {
+                    // the costs are the numbers of tuples the operators
+                    // evaluate in the warm-up
+                    warm_up_evaluations_count = PipelineScheduler::warm_up(*scheduler, warm_up_count);
+                    std::vector<Operator*> stage_end_operators = PipelineScheduler::cut_by_costs(
+                        scheduler->get_operators(),
+                        PipelineScheduler::get_evaluation_costs(scheduler->get_operators()),
+                        stages_count);
+                    pipeline_scheduler.reset(new PipelineScheduler(scheduler, stage_end_operators));
+                }
+
+                if (work_stealing_scheduler)
+                    work_stealing_scheduler->start();
+                else if (pipeline_scheduler)
+                    pipeline_scheduler->start();
+                else
+                    query_processor.start();
                 stream_consumer.wait(); // wait for whole results
             }
 
             relation_updater.stop();
-            query_processor.stop_and_wait();
+            if (work_stealing_scheduler)
+                work_stealing_scheduler->stop_and_wait();
+            else if (pipeline_scheduler)
+                pipeline_scheduler->stop_and_wait();
+            else
+                query_processor.stop_and_wait();
 
             result_ios << "OK, finished loop" << std::endl;
 
@@ -190,11 +279,35 @@ namespace currentia {
             OUTPUT_ENTRY("Query Throughput", throughput_query << " tps");
             OUTPUT_ENTRY("Update Throughput", throughput_update << " qps");
 
+            OUTPUT_ENTRY("Scheduling Policy", cmd_parser_.get<std::string>("scheduling-policy"));
+            OUTPUT_ENTRY("Stream Queue", cmd_parser_.get<std::string>("stream-queue"));
+            OUTPUT_ENTRY("Relation Index", cmd_parser_.get<std::string>("relation-index"));
             OUTPUT_ENTRY("Scheduler Batch Process Count", cmd_parser_.get<int>("max-events-n-consume") << " tuples");
+            if (work_stealing_scheduler) {
+                OUTPUT_ENTRY("Workers", workers_count);
+                OUTPUT_ENTRY("Stolen Tasks", work_stealing_scheduler->get_stolen_tasks_count() << " / "
+                             << work_stealing_scheduler->get_executed_tasks_count());
+            }
+            if (cmd_parser_.get<int>("partitions") > 1) {
+                OUTPUT_ENTRY("Partitions", cmd_parser_.get<int>("partitions"));
+            }
+            if (pipeline_scheduler) {
+                if (warm_up_evaluations_count > 0) {
+                    OUTPUT_ENTRY("Pipeline Warm-up", warm_up_evaluations_count << " evaluations");
+                }
+                for (int stage = 0; stage < pipeline_scheduler->get_stages_count(); ++stage) {
+                    std::stringstream operator_names;
+                    auto operators = pipeline_scheduler->get_stage_operators(stage);
+                    for (auto iter = operators.begin(), iter_end = operators.end(); iter != iter_end; ++iter)
+                        operator_names << (*iter)->get_name() << " ";
+                    OUTPUT_ENTRY("Stage " << stage << " (CPU " << pipeline_scheduler->get_cpu_affinity(stage) << ")",
+                                 operator_names.str());
+                }
+            }
 
             if (auto acc = std::dynamic_pointer_cast<AbstractCCScheduler>(scheduler)) {
                 OUTPUT_ENTRY("Redo", acc->get_redo_counts() << " times");
-                auto commit_op = dynamic_cast<OperatorMean*>(acc->get_commit_operator());
+                auto commit_op = dynamic_cast<TraitAggregationOperator*>(acc->get_commit_operator());
                 if (commit_op) {
                     OUTPUT_ENTRY("Consistent Rate", commit_op->get_consistent_rate());
                     OUTPUT_ENTRY("Window", commit_op->get_window().toString());
@@ -233,9 +346,16 @@ void parse_option(cmdline::parser& cmd_parser, int argc, char** argv)
     cmd_parser.add<std::string>("method", '\0', "consistency preserving method", false, "none",
                                 cmdline::oneof<std::string>("optimistic", "2pl", "snapshot", "none"));
 
+    cmd_parser.add<std::string>("scheduling-policy", '\0', "order in which the scheduler evaluates operators with input", false, "round-robin",
+                                cmdline::oneof<std::string>("round-robin", "chain", "longest-queue", "oldest-tuple"));
+
     cmd_parser.add<int>("txn-joint-count", '\0', "Joint count for txn", false, 1);
 
     cmd_parser.add<int>("max-events-n-consume", '\0', "Maximum number of events to be evaluated at once", false, 1);
+    cmd_parser.add<int>("pipeline-stages", '\0', "Number of pipeline stages pinned to cores, unless the query cuts them (0: single thread)", false, 0);
+    cmd_parser.add<long>("pipeline-warm-up", '\0', "Operator evaluations on one thread before cutting pipeline stages by the numbers of tuples each operator evaluated (0, or with 2pl: cut evenly by operator count)", false, 10000);
+    cmd_parser.add<int>("partitions", '\0', "Number of threads running replicas of partitionable operators (selections, projections and stream-relation joins) behind an exchange (1: none)", false, 1);
+    cmd_parser.add<int>("workers", '\0', "Number of worker threads evaluating operators with work stealing (0: single thread)", false, 0);
 
     cmd_parser.add<useconds_t>("update-interval", '\0', "update interval", false, 1000);
     cmd_parser.add<useconds_t>("update-duration", '\0', "time needed to update a relation", false, 10);
@@ -244,6 +364,10 @@ void parse_option(cmdline::parser& cmd_parser, int argc, char** argv)
     cmd_parser.add("output-dot", '\0', "Output operator tree as a dot file");
     cmd_parser.add("no-color", '\0', "Suppress colored output");
     cmd_parser.add("efficient-scheduling", '\0', "Enable efficient scheduling mode (constraint)");
+    cmd_parser.add<std::string>("stream-queue", '\0', "queue implementation of streams", false, "locked",
+                                cmdline::oneof<std::string>("locked", "lock-free"));
+    cmd_parser.add<std::string>("relation-index", '\0', "secondary index on the relation", false, "none",
+                                cmdline::oneof<std::string>("none", "hash", "ordered"));
 
     cmd_parser.parse_check(argc, argv);
 }
@@ -5,21 +5,25 @@
 
 #include "currentia/core/thread.h"
 #include "currentia/core/scheduler/abstract-scheduler.h"
+#include "currentia/core/scheduler/idle-waiter.h"
 
 namespace currentia {
     class QueryProcessor : public thread::Runnable {
         AbstractScheduler::ptr_t scheduler_;
+        IdleWaiter idle_waiter_;
 
     public:
-        explicit QueryProcessor(const AbstractScheduler::ptr_t& scheduler):
-            scheduler_(scheduler) {
+        // Construct it before streams are sent (see IdleWaiter)
+        explicit QueryProcessor(const AbstractScheduler::ptr_t& scheduler,
+                                int spin_count = IdleWaiter::DEFAULT_SPIN_COUNT):
+            scheduler_(scheduler),
+            idle_waiter_(scheduler->get_operators(), spin_count) {
         }
 
         void run() {
             try {
                 while (!stopped()) {
-                    scheduler_->wake_up();
-                    thread::scheduler_yield();
+                    idle_waiter_.after_wake_up(scheduler_->wake_up());
                 }
             } catch (std::string error) {
                 std::cerr << "QueryProcessor: " << error << std::endl;
@@ -29,6 +33,10 @@ namespace currentia {
             std::cout << "QueryProcessor Finished" << std::endl;
 #endif
         }
+
+        const IdleWaiter& get_idle_waiter() const {
+            return idle_waiter_;
+        }
     };
 }
 
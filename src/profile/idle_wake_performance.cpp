@@ -0,0 +1,98 @@
+#include "currentia/core/cc/without-cc-scheduler.h"
+#include "currentia/core/operator/operator-selection.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+#include "currentia/core/scheduler/idle-waiter.h"
+#include "currentia/core/scheduler/policy/scheduling-policy-round-robin.h"
+#include "currentia/server/query-processor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace currentia;
+
+static const int ROUNDS = 200;
+static const int IDLE_MILLISECONDS = 500;
+static const int PAUSE_MILLISECONDS = 5;
+
+static double get_cpu_seconds()
+{
+    struct timespec cpu_time;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_time);
+    return cpu_time.tv_sec + cpu_time.tv_nsec / 1e9;
+}
+
+// Microseconds from enqueueing a tuple to dequeuing it from the output
+// of the query, pausing pause_milliseconds between tuples
+static std::vector<double> measure_latencies(const Schema::ptr_t& schema,
+                                             const Stream::ptr_t& input_stream,
+                                             const Stream::ptr_t& output_stream,
+                                             int pause_milliseconds)
+{
+    std::vector<double> latencies;
+    for (int round = 0; round < ROUNDS; ++round) {
+        if (pause_milliseconds > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(pause_milliseconds));
+        auto begin_time = std::chrono::steady_clock::now();
+        input_stream->enqueue(Tuple::create_easy(schema, round));
+        output_stream->dequeue();   // blocking
+        auto end_time = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - begin_time).count() / 1e3);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+static void print_latencies(const char* label, const std::vector<double>& latencies)
+{
+    std::cout << "  " << label << ": median " << latencies[latencies.size() / 2]
+              << " us, 0.99 " << latencies[latencies.size() * 99 / 100] << " us" << std::endl;
+}
+
+// CPU used by a QueryProcessor while no tuple arrives, and the latency
+// of a tuple arriving at an idle (parked) QueryProcessor and at a busy
+// one, yielding forever (the former behavior) or spinning then parking
+int main(int argc, char **argv)
+{
+    Schema::ptr_t schema(new Schema);
+    schema->add_attribute("id", Object::INT);
+    schema->freeze();
+
+    int spin_counts[] = { IdleWaiter::NEVER_PARK, IdleWaiter::DEFAULT_SPIN_COUNT };
+    const char* labels[] = { "yield", "spin then park" };
+    for (int i = 0; i < 2; ++i) {
+        Stream::ptr_t input_stream = Stream::from_schema(schema);
+        Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+        Operator::ptr_t root(new OperatorSelection(
+            adapter,
+            Condition::ptr_t(new ConditionConstantComparator("id", Comparator::GREATER_THAN_EQUAL,
+                                                             Object(0)))));
+        AbstractScheduler::ptr_t scheduler(
+            new WithoutCCScheduler(root, SchedulingPolicyFactory::ptr_t(new RoundRobinPolicyFactory())));
+        QueryProcessor query_processor(scheduler, spin_counts[i]);
+        query_processor.start();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        double begin_cpu_seconds = get_cpu_seconds();
+        std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MILLISECONDS));
+        double idle_cpu_seconds = get_cpu_seconds() - begin_cpu_seconds;
+
+        std::vector<double> idle_latencies =
+            measure_latencies(schema, input_stream, root->get_output_stream(), PAUSE_MILLISECONDS);
+        std::vector<double> busy_latencies =
+            measure_latencies(schema, input_stream, root->get_output_stream(), 0);
+
+        query_processor.stop_and_wait();
+
+        std::cout << labels[i] << ":" << std::endl;
+        std::cout << "  idle CPU: " << idle_cpu_seconds * 1e3 / IDLE_MILLISECONDS * 100 << " % of a core" << std::endl;
+        print_latencies("latency after a pause", idle_latencies);
+        print_latencies("latency back to back", busy_latencies);
+        std::cout << "  parks: " << query_processor.get_idle_waiter().get_parks_count() << std::endl;
+    }
+
+    return 0;
+}
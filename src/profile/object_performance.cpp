@@ -1,14 +1,93 @@
 #include "currentia/core/object.h"
+#include "currentia/core/tuple.h"
+#include "currentia/core/tuple-allocator.h"
 
-int main(int argc, char **argv)
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Counts heap allocations made through operator new (the default
+// operator delete releases memory with free())
+static long allocations_count = 0;
+
+__attribute__((noinline))
+void* operator new(size_t size)
+{
+    allocations_count++;
+    void* pointer = std::malloc(size ? size : 1);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+using namespace currentia;
+
+static const int TUPLES_COUNT = 1000000;
+static const int WINDOW_SIZE = 100;
+
+// Creates tuples in windows of WINDOW_SIZE (a window expires when the
+// next one is full), as a window operator does
+static void profile_tuples(const std::string& label,
+                           const Schema::ptr_t& schema,
+                           const Schema::ptr_t& joined_schema,
+                           const TupleAllocator::ptr_t& allocator)
 {
-    using namespace currentia;
+    schema->set_tuple_allocator(allocator);
+    joined_schema->set_tuple_allocator(allocator);
+
+    Tuple::data_t data;
+    data.push_back(Object(1));
+    data.push_back(Object("fofofo"));
+
+    std::vector<Tuple::ptr_t> window;
+    window.reserve(WINDOW_SIZE);
 
+    long allocations_count_before = allocations_count;
+    auto begin_time = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < TUPLES_COUNT; ++i) {
+        if (window.size() == WINDOW_SIZE) {
+            window.clear();
+            ArenaTupleAllocator* arena = dynamic_cast<ArenaTupleAllocator*>(allocator.get());
+            if (arena)
+                arena->begin_region();
+        }
+        Tuple::ptr_t tuple = Tuple::create(schema, data, i);
+        window.push_back(Tuple::create_concatenated(joined_schema, tuple, tuple, i));
+    }
+    window.clear();
+
+    auto end_time = std::chrono::steady_clock::now();
+    double elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - begin_time).count();
+
+    // 2 tuples (a tuple and a joined one) per iteration
+    std::cout << label << ": "
+              << static_cast<double>(allocations_count - allocations_count_before) / (2 * TUPLES_COUNT)
+              << " allocations per tuple, "
+              << elapsed_ns / (2 * TUPLES_COUNT) << " ns per tuple" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
     Object number_obj(2378);
     Object string_obj("fofofo");
 
     std::cout << "sizeof number_obj: " << sizeof(number_obj) << std::endl;
     std::cout << "sizeof string_obj: " << sizeof(string_obj) << std::endl;
+    std::cout << "sizeof tuple: " << sizeof(Tuple) << std::endl;
+
+    Schema::ptr_t schema(new Schema);
+    schema->add_attribute("ID", Object::INT);
+    schema->add_attribute("NAME", Object::STRING);
+    schema->freeze();
+    Schema::ptr_t joined_schema = concat_schemas(schema, schema);
+
+    // "heap" allocates a tuple (with its reference count) and its row
+    // separately from the heap
+    profile_tuples("heap", schema, joined_schema, TupleAllocator::ptr_t());
+    profile_tuples("slab", schema, joined_schema, TupleAllocator::ptr_t(new SlabTupleAllocator()));
+    profile_tuples("arena", schema, joined_schema, TupleAllocator::ptr_t(new ArenaTupleAllocator()));
 
     return 0;
 }
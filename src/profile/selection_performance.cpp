@@ -0,0 +1,60 @@
+#include "currentia/core/operator/condition.h"
+#include "currentia/core/operator/condition-program.h"
+#include "currentia/core/operator/vectorized-selection.h"
+
+#include <chrono>
+#include <cstdlib>
+
+using namespace currentia;
+
+static const int BATCH_SIZE = 1024;
+static const int ROUNDS = 2000;
+
+// Runs "select goods.price < 5000" over batches of BATCH_SIZE
+// tuples, tuple-at-a-time and column-at-a-time
+int main(int argc, char **argv)
+{
+    Schema::ptr_t goods_schema(new Schema);
+    goods_schema->add_attribute("id", Object::INT);
+    goods_schema->add_attribute("price", Object::INT);
+    goods_schema->freeze();
+
+    Stream::batch_t goods;
+    for (int i = 0; i < BATCH_SIZE; ++i)
+        goods.push_back(Tuple::create_easy(goods_schema, i, std::rand() % 10000));
+
+    Condition::ptr_t condition(new ConditionConstantComparator("price", Comparator::LESS_THAN, Object(5000)));
+    condition->obey_schema(goods_schema, goods_schema);
+    ConditionProgram::ptr_t program = ConditionProgram::compile(condition);
+    VectorizedSelection::ptr_t vectorized_selection = VectorizedSelection::create(condition);
+
+    Stream::batch_t selected_tuples;
+    selected_tuples.reserve(BATCH_SIZE);
+    size_t selected_count = 0;
+
+    for (int method = 0; method < 3; ++method) {
+        auto begin_time = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; ++round) {
+            selected_tuples.clear();
+            if (method == 2) {
+                vectorized_selection->select(goods, selected_tuples);
+            } else {
+                for (int i = 0; i < BATCH_SIZE; ++i) {
+                    if (method == 0 ? condition->check(goods[i]) : program->check(goods[i]))
+                        selected_tuples.push_back(goods[i]);
+                }
+            }
+            selected_count += selected_tuples.size();
+        }
+        auto end_time = std::chrono::steady_clock::now();
+        double elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - begin_time).count();
+
+        const char* labels[] = { "condition", "program", "vectorized" };
+        std::cout << labels[method] << ": "
+                  << elapsed_ns / (static_cast<double>(ROUNDS) * BATCH_SIZE) << " ns per tuple" << std::endl;
+    }
+
+    std::cout << "(selected " << selected_count << ")" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include "currentia/core/operator/operator-sketch-aggregation.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace currentia;
+
+static const int TUPLES_COUNT = 1000000;
+static const int WINDOW_WIDTH = 100000;
+static const int WINDOW_STRIDE = 20000;
+static const int USERS_COUNT = 50000;
+static const int TOP_COUNT = 10;
+
+// Exact results of a window
+struct ExactResult {
+    long distinct_count;
+    std::vector<double> sorted_latencies;
+    std::unordered_map<int, long> user_counts;
+};
+
+// Users are Zipf-like distributed (user i appears about 1 / i as
+// often as user 1)
+static std::vector<Tuple::ptr_t> generate_tuples(const Schema::ptr_t& schema)
+{
+    std::vector<double> cumulative_weights;
+    double total_weight = 0;
+    for (int user = 1; user <= USERS_COUNT; ++user)
+        cumulative_weights.push_back(total_weight += 1.0 / user);
+
+    std::srand(1);
+    std::vector<Tuple::ptr_t> tuples;
+    tuples.reserve(TUPLES_COUNT);
+    for (int i = 0; i < TUPLES_COUNT; ++i) {
+        double point = static_cast<double>(std::rand()) / RAND_MAX * total_weight;
+        int user = std::lower_bound(cumulative_weights.begin(), cumulative_weights.end(), point)
+            - cumulative_weights.begin() + 1;
+        double latency = std::exp(static_cast<double>(std::rand()) / RAND_MAX * 8);
+        tuples.push_back(Tuple::create_easy(schema, user, latency));
+    }
+    return tuples;
+}
+
+static double elapsed_ns_per_tuple(std::chrono::steady_clock::time_point begin_time)
+{
+    auto end_time = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - begin_time).count() /
+        static_cast<double>(TUPLES_COUNT);
+}
+
+// Recomputes the results from the tuples held in the window, as an
+// exact aggregation over a synopsis does
+static std::vector<ExactResult> run_exact(const std::vector<Tuple::ptr_t>& tuples)
+{
+    std::vector<ExactResult> results;
+    std::deque<Tuple::ptr_t> window;
+    long newcomers_count = 0;
+
+    auto begin_time = std::chrono::steady_clock::now();
+    for (auto iter = tuples.begin(); iter != tuples.end(); ++iter) {
+        window.push_back(*iter);
+        if (window.size() > static_cast<size_t>(WINDOW_WIDTH))
+            window.pop_front();
+        newcomers_count++;
+        if (window.size() < static_cast<size_t>(WINDOW_WIDTH) ||
+            (results.size() > 0 && newcomers_count < WINDOW_STRIDE))
+            continue;
+        newcomers_count = 0;
+
+        ExactResult result;
+        std::unordered_set<int> users;
+        for (auto tuple_iter = window.begin(); tuple_iter != window.end(); ++tuple_iter) {
+            int user = (*tuple_iter)->get_int_by_index(0);
+            users.insert(user);
+            result.user_counts[user]++;
+            result.sorted_latencies.push_back((*tuple_iter)->get_float_by_index(1));
+        }
+        result.distinct_count = users.size();
+        std::sort(result.sorted_latencies.begin(), result.sorted_latencies.end());
+        results.push_back(result);
+    }
+
+    std::cout << "exact: " << elapsed_ns_per_tuple(begin_time) << " ns per tuple, "
+              << WINDOW_WIDTH * tuples.front()->get_schema()->get_fixed_size()
+              << " bytes of tuples in a window" << std::endl;
+    return results;
+}
+
+static double get_rank(const std::vector<double>& sorted_values, double value)
+{
+    return static_cast<double>(std::upper_bound(sorted_values.begin(), sorted_values.end(), value)
+                               - sorted_values.begin()) / sorted_values.size();
+}
+
+static void run_sketches(const std::vector<Tuple::ptr_t>& tuples,
+                         const std::vector<ExactResult>& exact_results,
+                         double error)
+{
+    Schema::ptr_t schema = tuples.front()->get_schema();
+    Stream::ptr_t input_stream = Stream::from_schema(schema);
+    Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+
+    OperatorSketchAggregation::specifications_t specifications;
+    specifications.push_back(SketchFunction::Specification(SketchFunction::DISTINCT, "user", 0, error));
+    specifications.push_back(SketchFunction::Specification(SketchFunction::QUANTILE, "latency", 0.99, error));
+    OperatorSketchAggregation* aggregation =
+        new OperatorSketchAggregation(adapter, Window(WINDOW_WIDTH, WINDOW_STRIDE), specifications);
+    Operator::ptr_t aggregation_ptr(aggregation);
+    // fed from its own adapter, since operators of a stream compete
+    // for its tuples
+    Stream::ptr_t heavy_hitters_input_stream = Stream::from_schema(schema);
+    Operator::ptr_t heavy_hitters_adapter(new OperatorStreamAdapter(heavy_hitters_input_stream));
+    OperatorHeavyHitters* heavy_hitters =
+        new OperatorHeavyHitters(heavy_hitters_adapter, Window(WINDOW_WIDTH, WINDOW_STRIDE),
+                                 "user", TOP_COUNT, error);
+    Operator::ptr_t heavy_hitters_ptr(heavy_hitters);
+
+    size_t memory_size = 0;
+    auto begin_time = std::chrono::steady_clock::now();
+    for (auto iter = tuples.begin(); iter != tuples.end(); ++iter) {
+        input_stream->enqueue(*iter);
+        adapter->process_next();
+        aggregation_ptr->process_next();
+        heavy_hitters_input_stream->enqueue(*iter);
+        heavy_hitters_adapter->process_next();
+        heavy_hitters_ptr->process_next();
+        if (aggregation_ptr->get_output_stream()->get_tuples_count() > 0)
+            memory_size = std::max(memory_size,
+                                   aggregation->get_memory_size() + heavy_hitters->get_memory_size());
+    }
+    double ns_per_tuple = elapsed_ns_per_tuple(begin_time);
+
+    double distinct_error = 0;
+    double quantile_error = 0;
+    double top_count_error = 0;
+    Stream::ptr_t output_stream = aggregation_ptr->get_output_stream();
+    Stream::ptr_t heavy_hitters_stream = heavy_hitters_ptr->get_output_stream();
+    for (auto iter = exact_results.begin(); iter != exact_results.end(); ++iter) {
+        Tuple::ptr_t result = output_stream->dequeue();
+        distinct_error = std::max(distinct_error,
+                                  std::fabs(result->get_int_by_index(0) - iter->distinct_count) /
+                                  iter->distinct_count);
+        quantile_error = std::max(quantile_error,
+                                  std::fabs(get_rank(iter->sorted_latencies, result->get_float_by_index(1)) - 0.99));
+        for (int i = 0; i < TOP_COUNT; ++i) {
+            Tuple::ptr_t top = heavy_hitters_stream->dequeue();
+            long exact_count = iter->user_counts.find(top->get_int_by_index(0))->second;
+            top_count_error = std::max(top_count_error,
+                                       static_cast<double>(top->get_int_by_index(1) - exact_count) / WINDOW_WIDTH);
+        }
+    }
+
+    std::cout << "sketches (error " << error << "): " << ns_per_tuple << " ns per tuple, "
+              << memory_size << " bytes of sketches; max errors: distinct " << distinct_error
+              << ", 0.99 quantile rank " << quantile_error
+              << ", top " << TOP_COUNT << " counts " << top_count_error << std::endl;
+}
+
+// Distinct users, the 0.99 quantile of latencies and the top users over
+// windows of WINDOW_WIDTH tuples sliding by WINDOW_STRIDE, computed
+// exactly from the tuples of each window and from sketches of panes
+int main(int argc, char **argv)
+{
+    Schema::ptr_t schema(new Schema);
+    schema->add_attribute("user", Object::INT);
+    schema->add_attribute("latency", Object::FLOAT);
+    schema->freeze();
+
+    std::vector<Tuple::ptr_t> tuples = generate_tuples(schema);
+    std::vector<ExactResult> exact_results = run_exact(tuples);
+
+    double errors[] = { 0.05, 0.01, 0.005 };
+    for (size_t i = 0; i < sizeof(errors) / sizeof(errors[0]); ++i)
+        run_sketches(tuples, exact_results, errors[i]);
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/operator/operator-projection.h"
+#include "currentia/core/operator/operator-selection.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+
+using namespace currentia;
+
+class TestBatchOperator : public ::testing::Test {
+protected:
+    Schema::ptr_t man_schema;
+    Stream::ptr_t input_stream;
+    Operator::ptr_t adapter;
+
+    TestBatchOperator():
+        man_schema(create_man_schema()),
+        input_stream(Stream::from_schema(man_schema)),
+        adapter(new OperatorStreamAdapter(input_stream)) {
+    }
+
+    virtual ~TestBatchOperator() {
+    }
+
+    Schema::ptr_t create_man_schema() {
+        Schema::ptr_t schema_ptr(new Schema);
+        schema_ptr->add_attribute("NAME", Object::STRING);
+        schema_ptr->add_attribute("AGE", Object::INT);
+        schema_ptr->freeze();
+
+        return schema_ptr;
+    }
+
+    Tuple::ptr_t create_man_tuple(const std::string& name, int age) {
+        return Tuple::create_easy(man_schema, name, age);
+    }
+};
+
+TEST_F (TestBatchOperator, selection_keeps_system_message_position) {
+    Condition::ptr_t condition(new ConditionConstantComparator("AGE", Comparator::GREATER_THAN,
+                                                               Object(2)));
+    Operator::ptr_t selection(new OperatorSelection(adapter, condition));
+
+    Tuple::ptr_t eos = Tuple::create_eos();
+    for (int i = 0; i < 5; ++i)
+        input_stream->enqueue(create_man_tuple("A", i));
+    input_stream->enqueue(eos);
+    input_stream->enqueue(create_man_tuple("B", 10));
+
+    adapter->process_next(100);
+    selection->process_next(100);
+
+    Stream::ptr_t output_stream = selection->get_output_stream();
+    EXPECT_EQ(4u, output_stream->get_tuples_count());
+    EXPECT_EQ(3, output_stream->dequeue()->get_value_by_index(1).get_int_number());
+    EXPECT_EQ(4, output_stream->dequeue()->get_value_by_index(1).get_int_number());
+    EXPECT_EQ(eos, output_stream->dequeue());
+    EXPECT_EQ(10, output_stream->dequeue()->get_value_by_index(1).get_int_number());
+}
+
+TEST_F (TestBatchOperator, projection) {
+    OperatorProjection::target_attribute_names_t names;
+    names.push_back("AGE");
+    Operator::ptr_t projection(new OperatorProjection(adapter, names));
+
+    for (int i = 0; i < 5; ++i)
+        input_stream->enqueue(create_man_tuple("A", i));
+
+    adapter->process_next(3);
+    projection->process_next(3);
+    EXPECT_EQ(3u, projection->get_output_stream()->get_tuples_count());
+
+    adapter->process_next(3);
+    projection->process_next(3);
+
+    Stream::ptr_t output_stream = projection->get_output_stream();
+    for (int i = 0; i < 5; ++i) {
+        Tuple::ptr_t tuple = output_stream->dequeue();
+        EXPECT_EQ(1u, tuple->get_schema()->size());
+        EXPECT_EQ(i, tuple->get_value_by_index(0).get_int_number());
+    }
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/operator/condition.h"
+#include "currentia/core/operator/condition-program.h"
+
+using namespace currentia;
+
+class TestCondition : public ::testing::Test {
+protected:
+    Schema::ptr_t man_schema;
+    Schema::ptr_t goods_schema;
+
+    TestCondition():
+        man_schema(new Schema),
+        goods_schema(new Schema) {
+        man_schema->add_attribute("NAME", Object::STRING);
+        man_schema->add_attribute("AGE", Object::INT);
+        man_schema->freeze();
+
+        goods_schema->add_attribute("TITLE", Object::STRING);
+        goods_schema->add_attribute("PRICE", Object::FLOAT);
+        goods_schema->freeze();
+    }
+
+    virtual ~TestCondition() {
+    }
+
+    Condition::ptr_t constant_condition(const std::string& attribute_name,
+                                        Comparator::Type comparator,
+                                        const Object& value,
+                                        bool resolve = true) {
+        Condition::ptr_t condition(new ConditionConstantComparator(attribute_name, comparator, value));
+        if (resolve)
+            condition->obey_schema(man_schema, goods_schema);
+        return condition;
+    }
+};
+
+TEST_F (TestCondition, constant_comparator) {
+    Tuple::ptr_t alice = Tuple::create_easy(man_schema, "ALICE", 7);
+    Tuple::ptr_t book = Tuple::create_easy(goods_schema, "BOOK", 12.5);
+
+    for (int resolve = 0; resolve < 2; ++resolve) {
+        EXPECT_TRUE(constant_condition("AGE", Comparator::EQUAL, Object(7), resolve)->check(alice));
+        EXPECT_TRUE(constant_condition("AGE", Comparator::LESS_THAN, Object(7.5), resolve)->check(alice));
+        EXPECT_FALSE(constant_condition("AGE", Comparator::GREATER_THAN, Object(7), resolve)->check(alice));
+        EXPECT_TRUE(constant_condition("NAME", Comparator::EQUAL, Object("ALICE"), resolve)->check(alice));
+        EXPECT_TRUE(constant_condition("NAME", Comparator::LESS_THAN, Object("ALICEA"), resolve)->check(alice));
+        EXPECT_TRUE(constant_condition("NAME", Comparator::GREATER_THAN, Object("ALIC"), resolve)->check(alice));
+        EXPECT_FALSE(constant_condition("NAME", Comparator::EQUAL, Object("BOB"), resolve)->check(alice));
+    }
+
+    // attribute of the right tuple
+    Condition::ptr_t price_condition = constant_condition("PRICE", Comparator::GREATER_THAN_EQUAL, Object(12));
+    EXPECT_TRUE(price_condition->check(alice, book));
+}
+
+TEST_F (TestCondition, attribute_comparator) {
+    Tuple::ptr_t alice = Tuple::create_easy(man_schema, "ALICE", 7);
+    Tuple::ptr_t book = Tuple::create_easy(goods_schema, "ALICE", 7.0);
+    Tuple::ptr_t pen = Tuple::create_easy(goods_schema, "PEN", 6.5);
+
+    // written in reverse order (resolved by obey_schema())
+    Condition::ptr_t price_condition(new ConditionAttributeComparator("PRICE", Comparator::LESS_THAN, "AGE"));
+    price_condition->obey_schema(man_schema, goods_schema);
+    EXPECT_FALSE(price_condition->check(alice, book));
+    EXPECT_TRUE(price_condition->check(alice, pen));
+
+    Condition::ptr_t name_condition(new ConditionAttributeComparator("NAME", Comparator::EQUAL, "TITLE"));
+    name_condition->obey_schema(man_schema, goods_schema);
+    EXPECT_TRUE(name_condition->check(alice, book));
+    EXPECT_FALSE(name_condition->check(alice, pen));
+}
+
+TEST_F (TestCondition, missing_attribute) {
+    EXPECT_THROW(constant_condition("HEIGHT", Comparator::EQUAL, Object(1)), std::string);
+}
+
+TEST_F (TestCondition, negated_conjunctive) {
+    Tuple::ptr_t alice = Tuple::create_easy(man_schema, "ALICE", 7);
+
+    Condition::ptr_t condition(new ConditionConjunctive(constant_condition("AGE", Comparator::EQUAL, Object(7)),
+                                                        constant_condition("NAME", Comparator::EQUAL, Object("ALICE")),
+                                                        ConditionConjunctive::AND));
+    EXPECT_TRUE(condition->check(alice));
+    condition->negate();
+    EXPECT_FALSE(condition->check(alice));
+}
+
+TEST_F (TestCondition, program_agrees_with_condition) {
+    std::vector<Tuple::ptr_t> men;
+    men.push_back(Tuple::create_easy(man_schema, "ALICE", 7));
+    men.push_back(Tuple::create_easy(man_schema, "BOB", 12));
+    men.push_back(Tuple::create_easy(man_schema, "CHRIS", 30));
+
+    for (int resolve = 0; resolve < 2; ++resolve) {
+        // !(AGE < 10 || NAME == "BOB") && (AGE >= 7.5 || !(NAME > "B"))
+        Condition::ptr_t young_or_bob(
+            new ConditionConjunctive(constant_condition("AGE", Comparator::LESS_THAN, Object(10), resolve),
+                                     constant_condition("NAME", Comparator::EQUAL, Object("BOB"), resolve),
+                                     ConditionConjunctive::OR));
+        young_or_bob->negate();
+        Condition::ptr_t name_condition = constant_condition("NAME", Comparator::GREATER_THAN, Object("B"), resolve);
+        name_condition->negate();
+        Condition::ptr_t old_or_a(
+            new ConditionConjunctive(constant_condition("AGE", Comparator::GREATER_THAN_EQUAL, Object(7.5), resolve),
+                                     name_condition,
+                                     ConditionConjunctive::OR));
+        Condition::ptr_t condition(new ConditionConjunctive(young_or_bob, old_or_a, ConditionConjunctive::AND));
+
+        ConditionProgram::ptr_t program = ConditionProgram::compile(condition);
+        EXPECT_EQ(4u, program->size());
+        for (size_t i = 0; i < men.size(); ++i)
+            EXPECT_EQ(condition->check(men[i]), program->check(men[i])) << men[i]->toString();
+        EXPECT_TRUE(program->check(men[2]));
+
+        condition->negate();
+        program = ConditionProgram::compile(condition);
+        for (size_t i = 0; i < men.size(); ++i)
+            EXPECT_EQ(condition->check(men[i]), program->check(men[i])) << men[i]->toString();
+    }
+}
+
+TEST_F (TestCondition, program_for_join) {
+    Tuple::ptr_t alice = Tuple::create_easy(man_schema, "ALICE", 7);
+    Tuple::ptr_t book = Tuple::create_easy(goods_schema, "ALICE", 7.0);
+    Tuple::ptr_t pen = Tuple::create_easy(goods_schema, "PEN", 6.5);
+
+    // AGE == PRICE || (NAME != TITLE && PRICE < 7)
+    Condition::ptr_t name_and_price(
+        new ConditionConjunctive(Condition::ptr_t(new ConditionAttributeComparator("NAME", Comparator::NOT_EQUAL, "TITLE")),
+                                 constant_condition("PRICE", Comparator::LESS_THAN, Object(7)),
+                                 ConditionConjunctive::AND));
+    Condition::ptr_t condition(
+        new ConditionConjunctive(Condition::ptr_t(new ConditionAttributeComparator("AGE", Comparator::EQUAL, "PRICE")),
+                                 name_and_price,
+                                 ConditionConjunctive::OR));
+    condition->obey_schema(man_schema, goods_schema);
+
+    ConditionProgram::ptr_t program = ConditionProgram::compile(condition);
+    EXPECT_TRUE(program->check(alice, book));
+    EXPECT_TRUE(program->check(alice, pen));
+    EXPECT_EQ(condition->check(alice, book), program->check(alice, book));
+    EXPECT_EQ(condition->check(alice, pen), program->check(alice, pen));
+
+    // attribute comparisons need two tuples
+    EXPECT_THROW(program->check(alice), std::string);
+}
+
+TEST_F (TestCondition, reorder_by_selectivity) {
+    std::vector<Tuple::ptr_t> men;
+    for (int age = 0; age < 100; ++age)
+        men.push_back(Tuple::create_easy(man_schema, "ALICE", age));
+
+    // the string comparison is expensive and holds for everyone
+    Condition::ptr_t alice = constant_condition("NAME", Comparator::EQUAL, Object("ALICE"));
+    Condition::ptr_t child = constant_condition("AGE", Comparator::LESS_THAN, Object(10));
+    ConditionConjunctive::ptr_t both(new ConditionConjunctive(alice, child, ConditionConjunctive::AND));
+    Condition::ptr_t old = constant_condition("AGE", Comparator::GREATER_THAN_EQUAL, Object(90));
+    ConditionConjunctive::ptr_t either(new ConditionConjunctive(old, alice, ConditionConjunctive::OR));
+
+    for (size_t i = 0; i < men.size(); ++i) {
+        EXPECT_EQ(both->check(men[i], men[i]), both->sample(men[i], men[i]));
+        EXPECT_EQ(either->check(men[i], men[i]), either->sample(men[i], men[i]));
+    }
+    EXPECT_NEAR(0.1, child->get_selectivity(), 0.02);
+
+    // AND: the term most likely to fail first
+    both->reorder();
+    EXPECT_EQ(child, both->get_left_condition());
+    EXPECT_EQ(alice, both->get_right_condition());
+
+    // OR: the term most likely to hold first
+    either->reorder();
+    EXPECT_EQ(alice, either->get_left_condition());
+    EXPECT_EQ(old, either->get_right_condition());
+}
+
+TEST_F (TestCondition, adaptive_program) {
+    std::vector<Tuple::ptr_t> men;
+    for (int age = 0; age < 100; ++age)
+        men.push_back(Tuple::create_easy(man_schema, age % 2 ? "ALICE" : "BOB", age));
+
+    // NAME != "CHRIS" && NAME == "ALICE" && AGE < 5
+    Condition::ptr_t condition = conjoin_conditions({
+            constant_condition("NAME", Comparator::NOT_EQUAL, Object("CHRIS")),
+            constant_condition("NAME", Comparator::EQUAL, Object("ALICE")),
+            constant_condition("AGE", Comparator::LESS_THAN, Object(5))
+        });
+    std::list<Condition::ptr_t> initial_conjuncts;
+    collect_conjuncts(condition, initial_conjuncts);
+    Condition::ptr_t age_condition = initial_conjuncts.back();
+
+    ConditionProgram::ptr_t program = ConditionProgram::compile(condition);
+    long checks_count = ConditionProgram::SAMPLING_INTERVAL * ConditionProgram::REORDERING_INTERVAL;
+    for (long i = 0; i < checks_count; ++i) {
+        const Tuple::ptr_t& man = men[i % men.size()];
+        ASSERT_EQ(condition->check(man), program->check(man));
+    }
+
+    // the most selective (and cheapest) conjunct comes first
+    std::list<Condition::ptr_t> conjuncts;
+    collect_conjuncts(condition, conjuncts);
+    EXPECT_EQ(age_condition, conjuncts.front());
+    for (size_t i = 0; i < men.size(); ++i)
+        EXPECT_EQ(condition->check(men[i]), program->check(men[i]));
+}
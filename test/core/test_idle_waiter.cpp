@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/cc/without-cc-scheduler.h"
+#include "currentia/core/operator/operator-selection.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+#include "currentia/core/scheduler/idle-waiter.h"
+#include "currentia/core/scheduler/policy/scheduling-policy-round-robin.h"
+#include "currentia/core/thread.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace currentia;
+
+TEST (TestArrivalSignal, wait_times_out) {
+    thread::ArrivalSignal signal;
+    auto begin_time = std::chrono::steady_clock::now();
+    EXPECT_FALSE(signal.wait([]() { return false; }, 20000));
+    EXPECT_LE(20, std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - begin_time).count());
+    EXPECT_EQ(0, signal.get_waiters_count());
+
+    // no notification without waiters
+    signal.notify();
+    EXPECT_FALSE(signal.wait([]() { return false; }, 1000));
+}
+
+TEST (TestArrivalSignal, notify_wakes_up_waiter) {
+    thread::ArrivalSignal signal;
+    EXPECT_TRUE(signal.wait([]() { return true; }, 10000000));
+
+    std::atomic<bool> arrived(false);
+    std::thread waiter([&]() {
+        while (!arrived)
+            EXPECT_TRUE(signal.wait([&]() { return arrived.load(); }, 10000000));
+    });
+    while (signal.get_waiters_count() == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    arrived = true;
+    signal.notify();
+    waiter.join();
+}
+
+class TestIdleWaiter : public ::testing::Test {
+protected:
+    Schema::ptr_t man_schema;
+    Stream::ptr_t input_stream;
+    Operator::ptr_t adapter;
+    Operator::ptr_t root;
+    AbstractScheduler::ptr_t scheduler;
+
+    TestIdleWaiter():
+        man_schema(create_man_schema()),
+        input_stream(Stream::from_schema(man_schema)),
+        adapter(new OperatorStreamAdapter(input_stream)) {
+        root = Operator::ptr_t(new OperatorSelection(
+            adapter,
+            Condition::ptr_t(new ConditionConstantComparator("AGE", Comparator::GREATER_THAN_EQUAL,
+                                                             Object(20)))));
+        scheduler = AbstractScheduler::ptr_t(
+            new WithoutCCScheduler(root, SchedulingPolicyFactory::ptr_t(new RoundRobinPolicyFactory())));
+    }
+
+    virtual ~TestIdleWaiter() {
+    }
+
+    Schema::ptr_t create_man_schema() {
+        Schema::ptr_t schema_ptr(new Schema);
+        schema_ptr->add_attribute("NAME", Object::STRING);
+        schema_ptr->add_attribute("AGE", Object::INT);
+        schema_ptr->freeze();
+
+        return schema_ptr;
+    }
+};
+
+TEST_F (TestIdleWaiter, watches_external_input_streams) {
+    IdleWaiter idle_waiter(scheduler->get_operators());
+    EXPECT_EQ(idle_waiter.get_arrival_signal(), input_stream->get_arrival_signal());
+    EXPECT_FALSE(adapter->get_output_stream()->get_arrival_signal());
+    EXPECT_FALSE(scheduler->has_ready_operator());
+
+    input_stream->enqueue(Tuple::create_easy(man_schema, "A", 30));
+    EXPECT_TRUE(scheduler->has_ready_operator());
+}
+
+TEST_F (TestIdleWaiter, enqueue_notifies_arrival) {
+    IdleWaiter idle_waiter(scheduler->get_operators());
+    const thread::ArrivalSignal::ptr_t& signal = idle_waiter.get_arrival_signal();
+
+    Stream::QueueMode modes[] = { Stream::LOCKED, Stream::SPSC, Stream::MPSC };
+    for (int i = 0; i < 3; ++i) {
+        input_stream->clear();
+        input_stream->set_queue_mode(modes[i]);
+        std::thread waiter([&]() {
+            // notified long before the timeout
+            EXPECT_TRUE(signal->wait([&]() { return input_stream->has_tuple(); }, 10000000));
+        });
+        while (signal->get_waiters_count() == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (i % 2)
+            input_stream->enqueue_batch(Stream::batch_t(2, Tuple::create_easy(man_schema, "A", 30)));
+        else
+            input_stream->enqueue(Tuple::create_easy(man_schema, "A", 30));
+        waiter.join();
+    }
+}
+
+TEST_F (TestIdleWaiter, parks_until_arrival) {
+    IdleWaiter idle_waiter(scheduler->get_operators(), 10);
+    std::atomic<bool> stopped(false);
+    std::thread processor([&]() {
+        while (!stopped)
+            idle_waiter.after_wake_up(scheduler->wake_up());
+    });
+
+    Stream::ptr_t output_stream = root->get_output_stream();
+    for (int i = 0; i < 3; ++i) {
+        while (idle_waiter.get_arrival_signal()->get_waiters_count() == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        input_stream->enqueue(Tuple::create_easy(man_schema, "A", 30 + i));
+        for (int j = 0; j < 5000 && !output_stream->has_tuple(); ++j)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ASSERT_TRUE(output_stream->has_tuple());
+        EXPECT_EQ(30 + i, output_stream->dequeue()->get_int_by_index(1));
+    }
+
+    stopped = true;
+    processor.join();
+    EXPECT_LE(3, idle_waiter.get_parks_count());
+}
+
+TEST_F (TestIdleWaiter, never_parks) {
+    IdleWaiter idle_waiter(scheduler->get_operators(), IdleWaiter::NEVER_PARK);
+    for (int i = 0; i < 100; ++i)
+        idle_waiter.after_wake_up(false);
+    EXPECT_EQ(0, idle_waiter.get_parks_count());
+}
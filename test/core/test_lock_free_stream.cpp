@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/stream.h"
+
+#include <thread>
+#include <vector>
+
+using namespace currentia;
+
+class TestLockFreeStream : public ::testing::TestWithParam<Stream::QueueMode> {
+protected:
+    Schema::ptr_t man_schema;
+    Stream::ptr_t stream;
+
+    TestLockFreeStream():
+        man_schema(create_man_schema()),
+        stream(new Stream(man_schema, GetParam(), 4)) {
+    }
+
+    virtual ~TestLockFreeStream() {
+    }
+
+    Schema::ptr_t create_man_schema() {
+        Schema::ptr_t schema_ptr(new Schema);
+        schema_ptr->add_attribute("NAME", Object::STRING);
+        schema_ptr->add_attribute("AGE", Object::INT);
+        schema_ptr->freeze();
+
+        return schema_ptr;
+    }
+
+    Tuple::ptr_t create_man_tuple(const std::string& name, int age) {
+        return Tuple::create_easy(man_schema, name, age);
+    }
+};
+
+TEST_P (TestLockFreeStream, enqueue_dequeue) {
+    Tuple::ptr_t tuple_a = create_man_tuple("A", 1);
+    Tuple::ptr_t tuple_b = create_man_tuple("B", 2);
+    Tuple::ptr_t tuple_c = create_man_tuple("C", 3);
+
+    stream->enqueue(tuple_a);
+    stream->enqueue(tuple_b);
+    stream->enqueue(tuple_c);
+
+    EXPECT_EQ(3u, stream->get_tuples_count());
+    EXPECT_EQ(tuple_a, stream->dequeue());
+    EXPECT_EQ(tuple_b, stream->dequeue());
+    EXPECT_EQ(tuple_c, stream->dequeue());
+    EXPECT_FALSE(stream->non_blocking_dequeue());
+}
+
+TEST_P (TestLockFreeStream, overflow_keeps_order) {
+    std::vector<Tuple::ptr_t> tuples;
+    for (int i = 0; i < 10; ++i) {
+        tuples.push_back(create_man_tuple("A", i));
+        stream->enqueue(tuples.back());
+    }
+
+    EXPECT_EQ(10u, stream->get_tuples_count());
+    for (int i = 0; i < 10; ++i)
+        EXPECT_EQ(tuples[i], stream->non_blocking_dequeue());
+    EXPECT_FALSE(stream->non_blocking_dequeue());
+}
+
+TEST_P (TestLockFreeStream, insert) {
+    Tuple::ptr_t tuple_a = create_man_tuple("A", 1);
+    Tuple::ptr_t tuple_b = create_man_tuple("B", 2);
+    Tuple::ptr_t tuple_d = create_man_tuple("D", 4);
+    Tuple::ptr_t tuple_e = create_man_tuple("E", 5);
+
+    stream->enqueue(tuple_a);
+    stream->enqueue(tuple_b);
+
+    auto another_stream = Stream::from_schema(man_schema, GetParam());
+    another_stream->enqueue(tuple_d);
+    another_stream->enqueue(tuple_e);
+
+    stream->insert_head(another_stream);
+
+    EXPECT_EQ(tuple_d, stream->dequeue());
+    EXPECT_EQ(tuple_e, stream->dequeue());
+    EXPECT_EQ(tuple_a, stream->dequeue());
+    EXPECT_EQ(tuple_b, stream->dequeue());
+}
+
+TEST_P (TestLockFreeStream, recover_from_backup) {
+    Tuple::ptr_t tuple_a = create_man_tuple("A", 1);
+    Tuple::ptr_t tuple_b = create_man_tuple("B", 2);
+    Tuple::ptr_t tuple_c = create_man_tuple("C", 3);
+
+    stream->set_backup_state(true);
+    stream->enqueue(tuple_a);
+    stream->enqueue(tuple_b);
+    stream->enqueue(tuple_c);
+
+    EXPECT_EQ(tuple_a, stream->non_blocking_dequeue());
+
+    stream->evict_backup_tuples_older_than(tuple_b->get_arrived_time());
+    stream->clear();
+    stream->recover_from_backup();
+
+    EXPECT_EQ(tuple_b, stream->non_blocking_dequeue());
+    EXPECT_EQ(tuple_c, stream->non_blocking_dequeue());
+    EXPECT_FALSE(stream->non_blocking_dequeue());
+}
+
+TEST_P (TestLockFreeStream, set_queue_mode) {
+    Tuple::ptr_t tuple_a = create_man_tuple("A", 1);
+    Tuple::ptr_t tuple_b = create_man_tuple("B", 2);
+
+    auto locked_stream = Stream::from_schema(man_schema);
+    locked_stream->enqueue(tuple_a);
+    locked_stream->enqueue(tuple_b);
+    locked_stream->set_queue_mode(GetParam());
+
+    EXPECT_TRUE(locked_stream->is_lock_free());
+    EXPECT_EQ(tuple_a, locked_stream->non_blocking_dequeue());
+    EXPECT_EQ(tuple_b, locked_stream->non_blocking_dequeue());
+}
+
+TEST_P (TestLockFreeStream, batch) {
+    Tuple::ptr_t tuple_head = create_man_tuple("H", 0);
+
+    Stream::batch_t tuples;
+    for (int i = 0; i < 10; ++i)
+        tuples.push_back(create_man_tuple("A", i));
+
+    // overflows the ring buffer of capacity 4
+    stream->enqueue_batch(tuples);
+    stream->unshift(tuple_head);
+    tuples.insert(tuples.begin(), tuple_head);
+
+    Stream::batch_t dequeued_tuples;
+    EXPECT_EQ(7u, stream->dequeue_batch(dequeued_tuples, 7));
+    EXPECT_EQ(4u, stream->dequeue_batch(dequeued_tuples, 7));
+    EXPECT_FALSE(stream->non_blocking_dequeue());
+
+    EXPECT_TRUE(tuples == dequeued_tuples);
+}
+
+INSTANTIATE_TEST_CASE_P(QueueModes, TestLockFreeStream,
+                        ::testing::Values(Stream::SPSC, Stream::MPSC));
+
+TEST (TestMPSCStream, concurrent_producers) {
+    Schema::ptr_t schema(new Schema);
+    schema->add_attribute("PRODUCER", Object::INT);
+    schema->add_attribute("SEQUENCE", Object::INT);
+    schema->freeze();
+
+    Stream::ptr_t stream = Stream::from_schema(schema, Stream::MPSC);
+
+    const int producers_count = 4;
+    const int tuples_per_producer = 10000;
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < producers_count; ++producer) {
+        producers.push_back(std::thread([=]() {
+            for (int i = 0; i < tuples_per_producer; ++i)
+                stream->enqueue(Tuple::create_easy(schema, producer, i));
+        }));
+    }
+
+    // tuples from one producer must keep their order
+    std::vector<int> next_sequences(producers_count, 0);
+    for (int received = 0; received < producers_count * tuples_per_producer; ++received) {
+        Tuple::ptr_t tuple = stream->dequeue();
+        int producer = tuple->get_value_by_index(0).get_int_number();
+        EXPECT_EQ(next_sequences[producer]++, tuple->get_value_by_index(1).get_int_number());
+    }
+
+    for (auto iter = producers.begin(); iter != producers.end(); ++iter)
+        iter->join();
+
+    EXPECT_FALSE(stream->non_blocking_dequeue());
+}
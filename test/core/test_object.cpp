@@ -10,3 +10,19 @@ TEST (TestObject, equality) {
 
     EXPECT_TRUE(number1.compare(number2, Comparator::EQUAL));
 }
+
+TEST (TestObject, string_equality) {
+    Object string1("foo");
+    Object string2("foo");
+    Object string3("bar");
+
+    EXPECT_TRUE(string1 == string2);
+    EXPECT_FALSE(string1 == string3);
+    EXPECT_TRUE(string3 < string1);
+}
+
+TEST (TestObject, hash) {
+    EXPECT_EQ(Object("foo").hash(), Object("foo").hash());
+    // INT and FLOAT are compared as FLOAT
+    EXPECT_EQ(Object(10).hash(), Object(10.0).hash());
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/open-addressing-map.h"
+
+#include <cstdlib>
+#include <map>
+#include <string>
+
+using namespace currentia;
+
+// Few distinct hash values, so that probe sequences are long and wrap
+// around the table
+struct CollidingHash {
+    size_t operator()(int key) const {
+        return key % 5 == 0 ? 15 : key % 3;
+    }
+};
+
+template <typename Map>
+void expect_same_entries(const std::map<int, int>& expected, Map& map) {
+    EXPECT_EQ(expected.size(), map.size());
+    for (auto iter = expected.begin(); iter != expected.end(); ++iter) {
+        const int* value = map.find(iter->first);
+        ASSERT_TRUE(value != NULL) << iter->first;
+        EXPECT_EQ(iter->second, *value);
+    }
+    size_t visited_count = 0;
+    map.for_each([&](int key, int value) {
+            visited_count++;
+            EXPECT_EQ(1u, expected.count(key));
+        });
+    EXPECT_EQ(expected.size(), visited_count);
+}
+
+TEST (TestOpenAddressingMap, insert_find_erase) {
+    OpenAddressingMap<std::string, int> map;
+    EXPECT_TRUE(map.empty());
+    map["alice"] = 1;
+    map["bob"] += 2;
+    map["bob"] += 3;
+    EXPECT_EQ(2u, map.size());
+    EXPECT_EQ(1, *map.find("alice"));
+    EXPECT_EQ(5, *map.find("bob"));
+    EXPECT_TRUE(map.find("carol") == NULL);
+
+    EXPECT_TRUE(map.erase("alice"));
+    EXPECT_FALSE(map.erase("alice"));
+    EXPECT_TRUE(map.find("alice") == NULL);
+    EXPECT_EQ(5, *map.find("bob"));
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.find("bob") == NULL);
+}
+
+TEST (TestOpenAddressingMap, agrees_with_std_map) {
+    OpenAddressingMap<int, int, CollidingHash> map;
+    std::map<int, int> expected;
+
+    std::srand(1);
+    for (int i = 0; i < 5000; ++i) {
+        int key = std::rand() % 64;
+        if (std::rand() % 3) {
+            map[key] += i;
+            expected[key] += i;
+        } else {
+            EXPECT_EQ(expected.erase(key) == 1, map.erase(key)) << key;
+        }
+        if (i % 500 == 0)
+            expect_same_entries(expected, map);
+    }
+    expect_same_entries(expected, map);
+    size_t max_load_percent = OpenAddressingMap<int, int>::MAX_LOAD_PERCENT;
+    EXPECT_LE(map.size() * 100, map.capacity() * max_load_percent);
+
+    // erase the odd keys
+    size_t odd_keys_count = 0;
+    for (auto iter = expected.begin(); iter != expected.end();) {
+        if (iter->first % 2) {
+            expected.erase(iter++);
+            odd_keys_count++;
+        } else {
+            ++iter;
+        }
+    }
+    EXPECT_EQ(odd_keys_count, map.erase_if([](int key, int value) { return key % 2 == 1; }));
+    expect_same_entries(expected, map);
+}
@@ -50,3 +50,28 @@ TEST (TestOperation, divide) {
     EXPECT_TRUE(Operation::divide(Object(1.3), Object(2)).compare(Object(0.65), Comparator::EQUAL));
     EXPECT_THROW(Operation::divide(Object("abc"), Object(3.0)), Operation::OPERATION_ERROR);
 }
+
+TEST (TestOperation, numeric_attribute) {
+    Schema::ptr_t goods_schema(new Schema);
+    goods_schema->add_attribute("TITLE", Object::STRING);
+    goods_schema->add_attribute("STOCK", Object::INT);
+    goods_schema->add_attribute("PRICE", Object::FLOAT);
+    goods_schema->freeze();
+
+    std::vector<Tuple::ptr_t> goods;
+    goods.push_back(Tuple::create_easy(goods_schema, "BOOK", 3, 12.5));
+    goods.push_back(Tuple::create_easy(goods_schema, "PEN", 10, 1.25));
+    goods.push_back(Tuple::create_easy(goods_schema, "CUP", -2, 4.0));
+
+    NumericAttribute stock(goods_schema, "STOCK");
+    EXPECT_EQ(Object::INT, stock.get_type());
+    EXPECT_DOUBLE_EQ(11.0, stock.sum(goods.begin(), goods.end()));
+    EXPECT_DOUBLE_EQ(10.0, stock.get_float(*goods[1]));
+
+    NumericAttribute price(goods_schema, "PRICE");
+    EXPECT_DOUBLE_EQ(17.75, price.sum(goods.begin(), goods.end()));
+    EXPECT_DOUBLE_EQ(0.0, price.sum(goods.begin(), goods.begin()));
+
+    EXPECT_THROW(NumericAttribute(goods_schema, "TITLE"), std::string);
+    EXPECT_THROW(NumericAttribute(goods_schema, "WEIGHT"), std::string);
+}
@@ -0,0 +1,385 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/operator/operator-aggregation.h"
+#include "currentia/core/operator/operator-grouped-aggregation.h"
+#include "currentia/core/operator/operator-shared-window-aggregation.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+#include "currentia/core/operator/window-aggregation.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+using namespace currentia;
+
+class TestOperatorAggregation : public ::testing::Test {
+protected:
+    Schema::ptr_t goods_schema;
+
+    TestOperatorAggregation():
+        goods_schema(new Schema) {
+        goods_schema->add_attribute("STOCK", Object::INT);
+        goods_schema->add_attribute("PRICE", Object::FLOAT);
+        goods_schema->freeze();
+    }
+
+    virtual ~TestOperatorAggregation() {
+    }
+};
+
+TEST_F (TestOperatorAggregation, monotonic_deque) {
+    MonotonicDeque<int, std::less<int> > minimum;
+    MonotonicDeque<int, std::greater<int> > maximum;
+    std::deque<int> values;
+
+    std::srand(1);
+    for (int i = 0; i < 1000; ++i) {
+        if (values.empty() || std::rand() % 3) {
+            // few distinct values, so that equal ones meet
+            int value = std::rand() % 10;
+            minimum.push(value);
+            maximum.push(value);
+            values.push_back(value);
+        } else {
+            minimum.pop();
+            maximum.pop();
+            values.pop_front();
+        }
+        ASSERT_EQ(values.size(), minimum.size());
+        if (!values.empty()) {
+            ASSERT_EQ(*std::min_element(values.begin(), values.end()), minimum.get());
+            ASSERT_EQ(*std::max_element(values.begin(), values.end()), maximum.get());
+        }
+    }
+}
+
+TEST_F (TestOperatorAggregation, aggregates_in_one_tuple) {
+    Stream::ptr_t input_stream = Stream::from_schema(goods_schema);
+    Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+
+    OperatorAggregation::specifications_t specifications;
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::SUM, "STOCK"));
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::COUNT, "STOCK"));
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::MIN, "PRICE"));
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::MAX, "STOCK"));
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::MEAN, "PRICE"));
+    Operator::ptr_t aggregation(new OperatorAggregation(adapter, Window(4, 2), specifications));
+
+    Schema::ptr_t output_schema = aggregation->get_output_schema_ptr();
+    ASSERT_EQ(5u, output_schema->size());
+    EXPECT_EQ(0, output_schema->get_attribute_index_by_name("STOCK"));
+    EXPECT_EQ(1, output_schema->get_attribute_index_by_name("COUNT_STOCK"));
+    EXPECT_EQ(2, output_schema->get_attribute_index_by_name("PRICE"));
+    EXPECT_EQ(3, output_schema->get_attribute_index_by_name("MAX_STOCK"));
+    EXPECT_EQ(4, output_schema->get_attribute_index_by_name("MEAN_PRICE"));
+    EXPECT_EQ(Object::INT, output_schema->get_attribute_type_by_index(0));
+    EXPECT_EQ(Object::FLOAT, output_schema->get_attribute_type_by_index(2));
+
+    Stream::ptr_t output_stream = aggregation->get_output_stream();
+    std::deque<Tuple::ptr_t> window;
+    int newcomers_count = 0;
+    bool window_filled = false;
+
+    std::srand(2);
+    for (int i = 0; i < 40; ++i) {
+        Tuple::ptr_t tuple = Tuple::create_easy(goods_schema, std::rand() % 10, (std::rand() % 40) * 0.25);
+        input_stream->enqueue(tuple);
+        adapter->process_next();
+        aggregation->process_next();
+
+        window.push_back(tuple);
+        if (window.size() > 4)
+            window.pop_front();
+        newcomers_count++;
+        if (newcomers_count == (window_filled ? 2 : 4)) {
+            newcomers_count = 0;
+            window_filled = true;
+
+            int stock_sum = 0, stock_max = 0;
+            double price_sum = 0, price_min = 1e10;
+            for (size_t j = 0; j < window.size(); ++j) {
+                stock_sum += window[j]->get_int_by_index(0);
+                stock_max = std::max(stock_max, window[j]->get_int_by_index(0));
+                price_sum += window[j]->get_float_by_index(1);
+                price_min = std::min(price_min, window[j]->get_float_by_index(1));
+            }
+
+            ASSERT_EQ(1u, output_stream->get_tuples_count()) << i;
+            Tuple::ptr_t result = output_stream->dequeue();
+            EXPECT_EQ(stock_sum, result->get_int_by_index(0));
+            EXPECT_EQ(4, result->get_int_by_index(1));
+            EXPECT_DOUBLE_EQ(price_min, result->get_float_by_index(2));
+            EXPECT_EQ(stock_max, result->get_int_by_index(3));
+            EXPECT_DOUBLE_EQ(price_sum / 4, result->get_float_by_index(4));
+        } else {
+            ASSERT_EQ(0u, output_stream->get_tuples_count()) << i;
+        }
+
+        // as on redo; the window starts over from the next tuples
+        if (i == 17 || i == 28) {
+            aggregation->reset();
+            window.clear();
+            newcomers_count = 0;
+            window_filled = false;
+        }
+    }
+}
+
+TEST_F (TestOperatorAggregation, unknown_attribute) {
+    Stream::ptr_t input_stream = Stream::from_schema(goods_schema);
+    Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+
+    OperatorAggregation::specifications_t specifications;
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::MAX, "TITLE"));
+    EXPECT_THROW(OperatorAggregation(adapter, Window(4, 2), specifications), std::string);
+}
+
+TEST_F (TestOperatorAggregation, int_sum_out_of_range) {
+    OperatorAggregation::specifications_t specifications;
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::SUM, "STOCK"));
+
+    for (int shared = 0; shared < 2; ++shared) {
+        Stream::ptr_t input_stream = Stream::from_schema(goods_schema);
+        Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+        Operator::ptr_t aggregation;
+        if (shared)
+            aggregation.reset(new OperatorSharedWindowAggregation(adapter, std::vector<Window>(1, Window(3, 3)),
+                                                                  specifications));
+        else
+            aggregation.reset(new OperatorAggregation(adapter, Window(3, 3), specifications));
+
+        // exact while summing, in range at last
+        int stocks[] = { INT_MAX, 1, -2 };
+        for (int i = 0; i < 3; ++i)
+            input_stream->enqueue(Tuple::create_easy(goods_schema, stocks[i], 0.5));
+        adapter->process_next(3);
+        aggregation->process_next(3);
+        EXPECT_EQ(INT_MAX - 1, aggregation->get_output_stream()->dequeue()->get_int_by_index(0)) << shared;
+
+        int overflowing_stocks[] = { INT_MAX, 1, 0 };
+        for (int i = 0; i < 3; ++i)
+            input_stream->enqueue(Tuple::create_easy(goods_schema, overflowing_stocks[i], 0.5));
+        adapter->process_next(3);
+        EXPECT_THROW(aggregation->process_next(3), std::string) << shared;
+    }
+}
+
+TEST_F (TestOperatorAggregation, grouped_aggregation) {
+    Stream::ptr_t input_stream = Stream::from_schema(goods_schema);
+    Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+
+    OperatorAggregation::specifications_t specifications;
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::COUNT, "PRICE"));
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::MAX, "PRICE"));
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::SUM, "PRICE"));
+    OperatorGroupedAggregation* grouped_aggregation =
+        new OperatorGroupedAggregation(adapter, Window(6, 3), "STOCK", specifications);
+    Operator::ptr_t aggregation(grouped_aggregation);
+
+    Schema::ptr_t output_schema = aggregation->get_output_schema_ptr();
+    ASSERT_EQ(4u, output_schema->size());
+    EXPECT_EQ(0, output_schema->get_attribute_index_by_name("STOCK"));
+    EXPECT_EQ(1, output_schema->get_attribute_index_by_name("PRICE"));
+    EXPECT_EQ(2, output_schema->get_attribute_index_by_name("MAX_PRICE"));
+    EXPECT_EQ(3, output_schema->get_attribute_index_by_name("SUM_PRICE"));
+
+    Stream::ptr_t output_stream = aggregation->get_output_stream();
+    std::deque<Tuple::ptr_t> window;
+    int newcomers_count = 0;
+    bool window_filled = false;
+
+    std::srand(3);
+    for (int i = 0; i < 60; ++i) {
+        // keys come and go
+        int key = i / 10 * 2 + std::rand() % 3;
+        Tuple::ptr_t tuple = Tuple::create_easy(goods_schema, key, (std::rand() % 40) * 0.25);
+        input_stream->enqueue(tuple);
+        adapter->process_next();
+        aggregation->process_next();
+
+        window.push_back(tuple);
+        if (window.size() > 6)
+            window.pop_front();
+        newcomers_count++;
+        if (newcomers_count != (window_filled ? 3 : 6)) {
+            ASSERT_EQ(0u, output_stream->get_tuples_count()) << i;
+        } else {
+            newcomers_count = 0;
+            window_filled = true;
+
+            // key -> (count, max, sum)
+            std::map<int, std::pair<int, std::pair<double, double> > > expected;
+            for (size_t j = 0; j < window.size(); ++j) {
+                int stock = window[j]->get_int_by_index(0);
+                double price = window[j]->get_float_by_index(1);
+                if (!expected.count(stock))
+                    expected[stock] = std::make_pair(0, std::make_pair(price, 0.0));
+                expected[stock].first++;
+                expected[stock].second.first = std::max(expected[stock].second.first, price);
+                expected[stock].second.second += price;
+            }
+
+            EXPECT_EQ(expected.size(), grouped_aggregation->get_groups_count()) << i;
+            ASSERT_EQ(expected.size(), output_stream->get_tuples_count()) << i;
+            while (output_stream->get_tuples_count() > 0) {
+                Tuple::ptr_t result = output_stream->dequeue();
+                int key = result->get_int_by_index(0);
+                ASSERT_EQ(1u, expected.count(key)) << i;
+                EXPECT_EQ(expected[key].first, result->get_int_by_index(1));
+                EXPECT_DOUBLE_EQ(expected[key].second.first, result->get_float_by_index(2));
+                EXPECT_DOUBLE_EQ(expected[key].second.second, result->get_float_by_index(3));
+                expected.erase(key);
+            }
+        }
+
+        if (i == 31) {
+            aggregation->reset();
+            window.clear();
+            newcomers_count = 0;
+            window_filled = false;
+        }
+    }
+}
+
+TEST_F (TestOperatorAggregation, shared_window_aggregation) {
+    OperatorAggregation::specifications_t specifications;
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::SUM, "STOCK"));
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::MAX, "PRICE"));
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::MEAN, "PRICE"));
+
+    std::vector<Window> windows;
+    windows.push_back(Window(6, 2));
+    windows.push_back(Window(4, 4));
+    windows.push_back(Window(12, 6));
+
+    Stream::ptr_t shared_input_stream = Stream::from_schema(goods_schema);
+    Operator::ptr_t shared_adapter(new OperatorStreamAdapter(shared_input_stream));
+    OperatorSharedWindowAggregation* shared_aggregation =
+        new OperatorSharedWindowAggregation(shared_adapter, windows, specifications);
+    Operator::ptr_t shared(shared_aggregation);
+    EXPECT_EQ(2, shared_aggregation->get_aggregator().get_pane_size());
+
+    // one aggregation operator per window
+    std::vector<Stream::ptr_t> input_streams;
+    std::vector<Operator::ptr_t> adapters;
+    std::vector<Operator::ptr_t> aggregations;
+    for (size_t i = 0; i < windows.size(); ++i) {
+        input_streams.push_back(Stream::from_schema(goods_schema));
+        adapters.push_back(Operator::ptr_t(new OperatorStreamAdapter(input_streams.back())));
+        aggregations.push_back(Operator::ptr_t(new OperatorAggregation(adapters.back(), windows[i], specifications)));
+    }
+
+    std::srand(4);
+    for (int i = 0; i < 50; ++i) {
+        Tuple::ptr_t tuple = Tuple::create_easy(goods_schema, std::rand() % 10, (std::rand() % 40) * 0.25);
+        shared_input_stream->enqueue(tuple);
+        shared_adapter->process_next();
+        shared->process_next();
+        for (size_t j = 0; j < windows.size(); ++j) {
+            input_streams[j]->enqueue(tuple);
+            adapters[j]->process_next();
+            aggregations[j]->process_next();
+        }
+        if (i == 23) {
+            shared->reset();
+            for (size_t j = 0; j < windows.size(); ++j)
+                aggregations[j]->reset();
+        }
+    }
+    EXPECT_GE(6u, shared_aggregation->get_aggregator().get_panes_count());
+
+    for (size_t i = 0; i < windows.size(); ++i) {
+        Stream::ptr_t expected_stream = aggregations[i]->get_output_stream();
+        Stream::ptr_t shared_stream = shared_aggregation->get_window_output_stream(i);
+        ASSERT_LT(0u, expected_stream->get_tuples_count());
+        ASSERT_EQ(expected_stream->get_tuples_count(), shared_stream->get_tuples_count()) << i;
+        while (expected_stream->get_tuples_count() > 0) {
+            Tuple::ptr_t expected = expected_stream->dequeue();
+            Tuple::ptr_t result = shared_stream->dequeue();
+            EXPECT_EQ(expected->get_int_by_index(0), result->get_int_by_index(0));
+            EXPECT_DOUBLE_EQ(expected->get_float_by_index(1), result->get_float_by_index(1));
+            EXPECT_DOUBLE_EQ(expected->get_float_by_index(2), result->get_float_by_index(2));
+        }
+    }
+}
+
+TEST_F (TestOperatorAggregation, pane_size) {
+    std::vector<Window> windows;
+    windows.push_back(Window(12, 8));
+    EXPECT_EQ(4, compute_pane_size(windows));
+    windows.push_back(Window(18, 18));
+    EXPECT_EQ(2, compute_pane_size(windows));
+    windows.push_back(Window(7, 7));
+    EXPECT_EQ(1, compute_pane_size(windows));
+
+    EXPECT_THROW(compute_pane_size(std::vector<Window>()), std::string);
+    EXPECT_THROW(compute_pane_size(std::vector<Window>(1, Window(10, 5, Window::TIME_BASE))), std::string);
+}
+
+TEST_F (TestOperatorAggregation, shared_window_aggregation_rejects_empty_windows) {
+    Stream::ptr_t input_stream = Stream::from_schema(goods_schema);
+    Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+
+    OperatorAggregation::specifications_t specifications;
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::SUM, "STOCK"));
+    Window invalid_windows[] = { Window(4, 0), Window(0, 2), Window(-2, 2) };
+    for (int i = 0; i < 3; ++i) {
+        std::vector<Window> windows;
+        windows.push_back(Window(4, 2));
+        windows.push_back(invalid_windows[i]);
+        EXPECT_THROW(OperatorSharedWindowAggregation(adapter, windows, specifications), std::string) << i;
+    }
+}
+
+TEST_F (TestOperatorAggregation, shared_window_aggregation_forwards_system_messages) {
+    OperatorAggregation::specifications_t specifications;
+    specifications.push_back(OperatorAggregation::Specification(AggregateFunction::SUM, "STOCK"));
+    std::vector<Window> windows;
+    windows.push_back(Window(4, 2));
+    windows.push_back(Window(6, 6));
+
+    bool tag_windows_modes[] = { false, true };
+    for (int mode = 0; mode < 2; ++mode) {
+        Stream::ptr_t input_stream = Stream::from_schema(goods_schema);
+        Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+        OperatorSharedWindowAggregation* shared_aggregation =
+            new OperatorSharedWindowAggregation(adapter, windows, specifications, tag_windows_modes[mode]);
+        Operator::ptr_t shared(shared_aggregation);
+
+        for (int i = 1; i <= 6; ++i)
+            input_stream->enqueue(Tuple::create_easy(goods_schema, i, 0.5));
+        input_stream->enqueue(Tuple::create_eos());
+        adapter->process_next(7);
+        shared->process_next(7);
+
+        if (tag_windows_modes[mode]) {
+            // windows of 4 (twice) and of 6, then EOS, in one stream
+            Stream::ptr_t output_stream = shared->get_output_stream();
+            EXPECT_EQ(std::string("WINDOW"), output_stream->get_schema()->get_attribute_by_index(0).name);
+            int expected_windows[] = { 0, 0, 1 };
+            int expected_sums[] = { 10, 18, 21 };
+            for (int i = 0; i < 3; ++i) {
+                Tuple::ptr_t tuple = output_stream->dequeue();
+                EXPECT_EQ(expected_windows[i], tuple->get_int_by_index(0));
+                EXPECT_EQ(expected_sums[i], tuple->get_int_by_index(1));
+            }
+            EXPECT_TRUE(output_stream->dequeue()->is_eos());
+            EXPECT_EQ(0u, output_stream->get_tuples_count());
+        } else {
+            // EOS follows the results of each window
+            for (size_t i = 0; i < windows.size(); ++i) {
+                Stream::ptr_t window_stream = shared_aggregation->get_window_output_stream(i);
+                Tuple::ptr_t tuple;
+                while ((tuple = window_stream->non_blocking_dequeue()) && !tuple->is_system_message())
+                    ;
+                ASSERT_TRUE(tuple) << i;
+                EXPECT_TRUE(tuple->is_eos()) << i;
+                EXPECT_EQ(0u, window_stream->get_tuples_count()) << i;
+            }
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/operator/operator-exchange.h"
+#include "currentia/core/operator/operator-projection.h"
+#include "currentia/core/operator/operator-selection.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+using namespace currentia;
+
+class TestOperatorExchange : public ::testing::Test {
+protected:
+    Schema::ptr_t man_schema;
+    Stream::ptr_t input_stream;
+    Operator::ptr_t adapter;
+
+    TestOperatorExchange():
+        man_schema(create_man_schema()),
+        input_stream(Stream::from_schema(man_schema)),
+        adapter(new OperatorStreamAdapter(input_stream)) {
+    }
+
+    virtual ~TestOperatorExchange() {
+    }
+
+    Schema::ptr_t create_man_schema() {
+        Schema::ptr_t schema_ptr(new Schema);
+        schema_ptr->add_attribute("NAME", Object::STRING);
+        schema_ptr->add_attribute("AGE", Object::INT);
+        schema_ptr->freeze();
+
+        return schema_ptr;
+    }
+
+    // selection (AGE >= 20) -> projection (AGE)
+    static Operator::ptr_t build_adult_ages(const Operator::ptr_t& source) {
+        Operator::ptr_t adults(new OperatorSelection(
+            source,
+            Condition::ptr_t(new ConditionConstantComparator("AGE", Comparator::GREATER_THAN_EQUAL,
+                                                             Object(20)))));
+        OperatorProjection::target_attribute_names_t names;
+        names.push_back("AGE");
+        return Operator::ptr_t(new OperatorProjection(adults, names));
+    }
+
+    // Evaluates the adapter and the exchange until the output stream
+    // has count tuples (or a few seconds)
+    void evaluate(const Operator::ptr_t& exchange, size_t count) {
+        Stream::ptr_t output_stream = exchange->get_output_stream();
+        for (int i = 0; i < 5000 && output_stream->get_tuples_count() < count; ++i) {
+            while (adapter->has_input())
+                adapter->process_next(64);
+            while (exchange->has_input() && output_stream->get_tuples_count() < count)
+                exchange->process_next(64);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+TEST_F (TestOperatorExchange, keeps_order_of_arrival) {
+    OperatorExchange::ptr_t exchange(new OperatorExchange(adapter, "AGE", 4, build_adult_ages));
+    ASSERT_EQ(4, exchange->get_partitions_count());
+    EXPECT_EQ(1u, exchange->get_output_schema_ptr()->size());
+
+    for (int i = 0; i < 20000; ++i)
+        input_stream->enqueue(Tuple::create_easy(man_schema, "A", i % 100));
+    evaluate(exchange, 20000 / 100 * 80);
+    exchange->stop_partitions();
+
+    Stream::ptr_t output_stream = exchange->get_output_stream();
+    ASSERT_EQ(20000u / 100 * 80, output_stream->get_tuples_count());
+    time_t last_arrived_time = 0;
+    for (int i = 0; i < 20000; ++i) {
+        if (i % 100 < 20)
+            continue;
+        Tuple::ptr_t tuple = output_stream->dequeue();
+        EXPECT_EQ(i % 100, tuple->get_int_by_index(0));
+        EXPECT_LT(last_arrived_time, tuple->get_arrived_time());
+        last_arrived_time = tuple->get_arrived_time();
+    }
+
+    // each replica got a part of the keys
+    for (int i = 0; i < exchange->get_partitions_count(); ++i) {
+        Operator* selection = dynamic_cast<SingleInputOperator*>(
+            exchange->get_replica(i).get())->get_parent_operator().get();
+        EXPECT_LT(0, selection->get_evaluation_count());
+        EXPECT_GT(20000, selection->get_evaluation_count());
+    }
+}
+
+TEST_F (TestOperatorExchange, system_messages_wait_for_tuples_before_them) {
+    OperatorExchange::ptr_t exchange(new OperatorExchange(adapter, "AGE", 3, build_adult_ages));
+
+    for (int i = 0; i < 1000; ++i)
+        input_stream->enqueue(Tuple::create_easy(man_schema, "A", i % 100));
+    input_stream->enqueue(Tuple::create_eos());
+    for (int i = 0; i < 100; ++i)
+        input_stream->enqueue(Tuple::create_easy(man_schema, "A", 50));
+    evaluate(exchange, 1000 / 100 * 80 + 1 + 100);
+    exchange->stop_partitions();
+
+    Stream::ptr_t output_stream = exchange->get_output_stream();
+    ASSERT_EQ(1000u / 100 * 80 + 1 + 100, output_stream->get_tuples_count());
+    for (int i = 0; i < 1000 / 100 * 80; ++i)
+        EXPECT_FALSE(output_stream->dequeue()->is_system_message());
+    EXPECT_TRUE(output_stream->dequeue()->is_system_message());
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(50, output_stream->dequeue()->get_int_by_index(0));
+}
+
+TEST_F (TestOperatorExchange, idle_partitions_park) {
+    OperatorExchange::ptr_t exchange(new OperatorExchange(adapter, "AGE", 4, build_adult_ages));
+    for (int i = 0; i < 1000; ++i)
+        input_stream->enqueue(Tuple::create_easy(man_schema, "A", i % 100));
+    evaluate(exchange, 1000 / 100 * 80);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // four yielding threads would take the whole CPU
+    struct timespec begin_cpu_time, end_cpu_time;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &begin_cpu_time);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end_cpu_time);
+    double cpu_milliseconds = (end_cpu_time.tv_sec - begin_cpu_time.tv_sec) * 1e3 +
+        (end_cpu_time.tv_nsec - begin_cpu_time.tv_nsec) / 1e6;
+    EXPECT_GT(50, cpu_milliseconds);
+
+    // and wake up for new tuples
+    for (int i = 0; i < 100; ++i)
+        input_stream->enqueue(Tuple::create_easy(man_schema, "A", i));
+    evaluate(exchange, 1000 / 100 * 80 + 80);
+    exchange->stop_partitions();
+    EXPECT_EQ(1000u / 100 * 80 + 80, exchange->get_output_stream()->get_tuples_count());
+}
+
+TEST_F (TestOperatorExchange, partitions_by_existing_key) {
+    EXPECT_THROW(OperatorExchange(adapter, "HEIGHT", 2, build_adult_ages), std::string);
+    EXPECT_THROW(OperatorExchange(adapter, "AGE", 0, build_adult_ages), std::string);
+}
+
+TEST (TestConditionClone, clone_has_same_expression) {
+    Condition::ptr_t condition(
+        new ConditionConjunctive(
+            Condition::ptr_t(new ConditionConstantComparator("AGE", Comparator::LESS_THAN, Object(20))),
+            Condition::ptr_t((new ConditionAttributeComparator("AGE", Comparator::EQUAL, "R_AGE"))->negate()),
+            ConditionConjunctive::OR));
+    Condition::ptr_t clone = condition->clone();
+
+    EXPECT_NE(condition.get(), clone.get());
+    EXPECT_TRUE(condition->equal_to(clone));
+    EXPECT_EQ(condition->toString(), clone->toString());
+}
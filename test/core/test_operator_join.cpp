@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/operator/operator-join.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+
+#include <set>
+#include <vector>
+
+using namespace currentia;
+
+class TestOperatorJoin : public ::testing::Test {
+protected:
+    Schema::ptr_t purchase_schema;
+    Schema::ptr_t user_schema;
+    Stream::ptr_t purchase_stream;
+    Stream::ptr_t user_stream;
+    Operator::ptr_t purchase_adapter;
+    Operator::ptr_t user_adapter;
+
+    TestOperatorJoin():
+        purchase_schema(create_schema("PURCHASE_USER", "PRICE")),
+        user_schema(create_schema("USER_ID", "AGE")),
+        purchase_stream(Stream::from_schema(purchase_schema)),
+        user_stream(Stream::from_schema(user_schema)),
+        purchase_adapter(new OperatorStreamAdapter(purchase_stream)),
+        user_adapter(new OperatorStreamAdapter(user_stream)) {
+    }
+
+    virtual ~TestOperatorJoin() {
+    }
+
+    Schema::ptr_t create_schema(const std::string& key_name, const std::string& value_name) {
+        Schema::ptr_t schema_ptr(new Schema);
+        schema_ptr->add_attribute(key_name, Object::INT);
+        schema_ptr->add_attribute(value_name, Object::INT);
+        schema_ptr->freeze();
+
+        return schema_ptr;
+    }
+
+    // Runs a join over windows of the given widths and returns pairs
+    // of (PRICE, AGE) in joined tuples
+    std::multiset<std::pair<int, int> > join(const Condition::ptr_t& condition,
+                                             int purchase_width, int user_width) {
+        Operator::ptr_t join(new OperatorJoin(purchase_adapter, Window(purchase_width, purchase_width),
+                                              user_adapter, Window(user_width, user_width),
+                                              condition));
+
+        for (int i = 0; i < purchase_width; ++i)
+            purchase_stream->enqueue(Tuple::create_easy(purchase_schema, i % 3, i));
+        for (int i = 0; i < user_width; ++i)
+            user_stream->enqueue(Tuple::create_easy(user_schema, i % 4, 100 + i));
+
+        purchase_adapter->process_next(purchase_width);
+        user_adapter->process_next(user_width);
+        join->process_next(std::max(purchase_width, user_width));
+
+        std::multiset<std::pair<int, int> > pairs;
+        Tuple::ptr_t tuple;
+        while ((tuple = join->get_output_stream()->non_blocking_dequeue())) {
+            pairs.insert(std::make_pair(tuple->get_value_by_index(1).get_int_number(),
+                                        tuple->get_value_by_index(3).get_int_number()));
+        }
+
+        return pairs;
+    }
+
+    std::multiset<std::pair<int, int> > expected_pairs(int purchase_width, int user_width,
+                                                       int min_age) {
+        std::multiset<std::pair<int, int> > pairs;
+        for (int i = 0; i < purchase_width; ++i)
+            for (int j = 0; j < user_width; ++j)
+                if (i % 3 == j % 4 && 100 + j >= min_age)
+                    pairs.insert(std::make_pair(i, 100 + j));
+        return pairs;
+    }
+};
+
+TEST_F (TestOperatorJoin, equi_join) {
+    Condition::ptr_t condition(
+        new ConditionAttributeComparator("USER_ID", Comparator::EQUAL, "PURCHASE_USER"));
+
+    EXPECT_EQ(expected_pairs(6, 8, 0), join(condition, 6, 8));
+}
+
+TEST_F (TestOperatorJoin, equi_join_building_left) {
+    Condition::ptr_t condition(
+        new ConditionAttributeComparator("PURCHASE_USER", Comparator::EQUAL, "USER_ID"));
+
+    EXPECT_EQ(expected_pairs(9, 5, 0), join(condition, 9, 5));
+}
+
+TEST_F (TestOperatorJoin, equi_join_with_residual) {
+    Condition::ptr_t condition(
+        new ConditionConjunctive(
+            Condition::ptr_t(new ConditionConstantComparator("AGE", Comparator::GREATER_THAN_EQUAL,
+                                                             Object(103))),
+            Condition::ptr_t(new ConditionAttributeComparator("PURCHASE_USER", Comparator::EQUAL,
+                                                              "USER_ID")),
+            ConditionConjunctive::AND));
+
+    EXPECT_EQ(expected_pairs(6, 8, 103), join(condition, 6, 8));
+}
+
+TEST_F (TestOperatorJoin, nested_loop_join) {
+    // an OR cannot be answered by the hash table
+    Condition::ptr_t condition(
+        new ConditionConjunctive(
+            Condition::ptr_t(new ConditionConstantComparator("AGE", Comparator::GREATER_THAN,
+                                                             Object(1000))),
+            Condition::ptr_t(new ConditionAttributeComparator("PURCHASE_USER", Comparator::EQUAL,
+                                                              "USER_ID")),
+            ConditionConjunctive::OR));
+
+    EXPECT_EQ(expected_pairs(6, 8, 0), join(condition, 6, 8));
+}
+
+TEST_F (TestOperatorJoin, incremental_join_on_sliding_windows) {
+    Condition::ptr_t condition(
+        new ConditionAttributeComparator("PURCHASE_USER", Comparator::EQUAL, "USER_ID"));
+
+    const int width = 4, stride = 2, tuples_count = 10;
+    Operator::ptr_t join(new OperatorJoin(purchase_adapter, Window(width, stride),
+                                          user_adapter, Window(width, stride),
+                                          condition, OperatorJoin::INCREMENTAL));
+
+    for (int i = 0; i < tuples_count; ++i) {
+        purchase_stream->enqueue(Tuple::create_easy(purchase_schema, i % 3, i));
+        user_stream->enqueue(Tuple::create_easy(user_schema, i % 4, 100 + i));
+    }
+    purchase_adapter->process_next(tuples_count);
+    user_adapter->process_next(tuples_count);
+    for (int i = 0; i < tuples_count; ++i)
+        join->process_next(tuples_count);
+
+    // pairs which were in the same windows at some evaluation, each once
+    std::multiset<std::pair<int, int> > expected;
+    for (int i = 0; i < tuples_count; ++i)
+        for (int j = 0; j < tuples_count; ++j) {
+            bool share_window = false;
+            for (int end = width; end <= tuples_count; end += stride)
+                share_window = share_window ||
+                    (end - width <= i && i < end && end - width <= j && j < end);
+            if (share_window && i % 3 == j % 4)
+                expected.insert(std::make_pair(i, 100 + j));
+        }
+
+    std::multiset<std::pair<int, int> > pairs;
+    Tuple::ptr_t tuple;
+    while ((tuple = join->get_output_stream()->non_blocking_dequeue())) {
+        pairs.insert(std::make_pair(tuple->get_value_by_index(1).get_int_number(),
+                                    tuple->get_value_by_index(3).get_int_number()));
+    }
+
+    EXPECT_EQ(expected, pairs);
+}
+
+TEST_F (TestOperatorJoin, joined_tuples_outlive_join) {
+    Condition::ptr_t condition(
+        new ConditionAttributeComparator("USER_ID", Comparator::EQUAL, "PURCHASE_USER"));
+    // the join (and its output arena) is dropped before its tuples
+    std::vector<Tuple::ptr_t> tuples;
+    {
+        Operator::ptr_t join(new OperatorJoin(purchase_adapter, Window(6, 6),
+                                              user_adapter, Window(8, 8),
+                                              condition));
+        for (int i = 0; i < 6; ++i)
+            purchase_stream->enqueue(Tuple::create_easy(purchase_schema, i % 3, i));
+        for (int i = 0; i < 8; ++i)
+            user_stream->enqueue(Tuple::create_easy(user_schema, i % 4, 100 + i));
+        purchase_adapter->process_next(6);
+        user_adapter->process_next(8);
+        join->process_next(8);
+
+        Tuple::ptr_t tuple;
+        while ((tuple = join->get_output_stream()->non_blocking_dequeue()))
+            tuples.push_back(tuple);
+    }
+
+    std::multiset<std::pair<int, int> > pairs;
+    for (auto iter = tuples.begin(), iter_end = tuples.end();
+         iter != iter_end;
+         ++iter) {
+        pairs.insert(std::make_pair((*iter)->get_value_by_index(1).get_int_number(),
+                                    (*iter)->get_value_by_index(3).get_int_number()));
+    }
+    EXPECT_EQ(expected_pairs(6, 8, 0), pairs);
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/cc/without-cc-scheduler.h"
+#include "currentia/core/operator/operator-projection.h"
+#include "currentia/core/operator/operator-selection.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+#include "currentia/core/scheduler/pipeline-scheduler.h"
+#include "currentia/core/scheduler/policy/scheduling-policy-round-robin.h"
+#include "currentia/core/thread.h"
+
+#include <atomic>
+#include <chrono>
+#include <sched.h>
+#include <thread>
+
+using namespace currentia;
+
+class TestPipelineScheduler : public ::testing::Test {
+protected:
+    Schema::ptr_t man_schema;
+    Stream::ptr_t input_stream;
+    Operator::ptr_t adapter;
+    Operator::ptr_t root;
+    AbstractScheduler::ptr_t scheduler;
+
+    TestPipelineScheduler():
+        man_schema(create_man_schema()),
+        input_stream(Stream::from_schema(man_schema)),
+        adapter(new OperatorStreamAdapter(input_stream)) {
+        // adapter -> selection -> projection -> selection
+        Operator::ptr_t adults(new OperatorSelection(
+            adapter,
+            Condition::ptr_t(new ConditionConstantComparator("AGE", Comparator::GREATER_THAN_EQUAL,
+                                                             Object(20)))));
+        OperatorProjection::target_attribute_names_t names;
+        names.push_back("AGE");
+        Operator::ptr_t ages(new OperatorProjection(adults, names));
+        root = Operator::ptr_t(new OperatorSelection(
+            ages,
+            Condition::ptr_t(new ConditionConstantComparator("AGE", Comparator::LESS_THAN,
+                                                             Object(60)))));
+        scheduler = AbstractScheduler::ptr_t(
+            new WithoutCCScheduler(root, SchedulingPolicyFactory::ptr_t(new RoundRobinPolicyFactory())));
+    }
+
+    virtual ~TestPipelineScheduler() {
+    }
+
+    Schema::ptr_t create_man_schema() {
+        Schema::ptr_t schema_ptr(new Schema);
+        schema_ptr->add_attribute("NAME", Object::STRING);
+        schema_ptr->add_attribute("AGE", Object::INT);
+        schema_ptr->freeze();
+
+        return schema_ptr;
+    }
+};
+
+TEST_F (TestPipelineScheduler, cut_by_costs) {
+    const std::vector<Operator*>& operators = scheduler->get_operators();
+    ASSERT_EQ(4u, operators.size());
+
+    double costs[] = { 1, 2, 8, 1 };
+    std::vector<double> cost_vector(costs, costs + 4);
+    std::vector<Operator*> stage_end_operators = PipelineScheduler::cut_by_costs(operators, cost_vector, 3);
+    // [1, 2] [8] [1]
+    ASSERT_EQ(2u, stage_end_operators.size());
+    EXPECT_EQ(operators[1], stage_end_operators[0]);
+    EXPECT_EQ(operators[2], stage_end_operators[1]);
+
+    // no more stages than operators, nor than needed
+    EXPECT_EQ(3u, PipelineScheduler::cut_by_costs(operators, std::vector<double>(4, 1), 10).size());
+    EXPECT_EQ(2u, PipelineScheduler::cut_by_costs(operators, cost_vector, 10).size());
+    EXPECT_EQ(0u,PipelineScheduler::cut_by_costs(operators, cost_vector, 1).size());
+    EXPECT_THROW(PipelineScheduler::cut_by_costs(operators, std::vector<double>(3, 1), 2), std::string);
+
+    // without statistics, operators cost the same
+    std::vector<double> evaluation_costs = PipelineScheduler::get_evaluation_costs(operators);
+    EXPECT_EQ(std::vector<double>(4, 1), evaluation_costs);
+    stage_end_operators = PipelineScheduler::cut_by_costs(operators, evaluation_costs, 2);
+    ASSERT_EQ(1u, stage_end_operators.size());
+    EXPECT_EQ(operators[1], stage_end_operators[0]);
+}
+
+TEST_F (TestPipelineScheduler, cut_after_warm_up) {
+    const std::vector<Operator*>& operators = scheduler->get_operators();
+    for (int i = 0; i < 1000; ++i)
+        input_stream->enqueue(Tuple::create_easy(man_schema, "A", i % 100));
+
+    EXPECT_EQ(0, PipelineScheduler::warm_up(*scheduler, 0));
+    long warm_up_count = PipelineScheduler::warm_up(*scheduler, 100000);
+    EXPECT_LT(0, warm_up_count);
+    EXPECT_GT(100000, warm_up_count);
+    EXPECT_FALSE(scheduler->has_ready_operator());
+
+    // 1000, 1000, 800 and 800 tuples
+    std::vector<double> evaluation_costs = PipelineScheduler::get_evaluation_costs(operators);
+    double costs[] = { 1000, 1000, 800, 800 };
+    EXPECT_EQ(std::vector<double>(costs, costs + 4), evaluation_costs);
+    std::vector<Operator*> stage_end_operators = PipelineScheduler::cut_by_costs(operators, evaluation_costs, 3);
+    // [1000] [1000] [800, 800]
+    ASSERT_EQ(2u, stage_end_operators.size());
+    EXPECT_EQ(operators[0], stage_end_operators[0]);
+    EXPECT_EQ(operators[1], stage_end_operators[1]);
+}
+
+TEST_F (TestPipelineScheduler, keeps_order_of_tuples) {
+    const std::vector<Operator*>& operators = scheduler->get_operators();
+    std::vector<Operator*> stage_end_operators(1, operators[1]);
+    PipelineScheduler pipeline_scheduler(scheduler, stage_end_operators, 64);
+
+    ASSERT_EQ(2, pipeline_scheduler.get_stages_count());
+    EXPECT_EQ(2u, pipeline_scheduler.get_stage_operators(0).size());
+    EXPECT_EQ(Stream::SPSC, operators[1]->get_output_stream()->get_queue_mode());
+    EXPECT_EQ(Stream::LOCKED, operators[2]->get_output_stream()->get_queue_mode());
+
+    pipeline_scheduler.start();
+    for (int i = 0; i < 20000; ++i)
+        input_stream->enqueue(Tuple::create_easy(man_schema, "A", i % 100));
+
+    Stream::ptr_t output_stream = root->get_output_stream();
+    for (int i = 0; i < 5000 && output_stream->get_tuples_count() < 20000u / 100 * 40; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    pipeline_scheduler.stop_and_wait();
+
+    ASSERT_EQ(20000u / 100 * 40, output_stream->get_tuples_count());
+    for (int i = 0; i < 20000; ++i) {
+        if (i % 100 < 20 || i % 100 >= 60)
+            continue;
+        EXPECT_EQ(i % 100, output_stream->dequeue()->get_int_by_index(0));
+    }
+}
+
+TEST_F (TestPipelineScheduler, stage_ends_in_the_tree) {
+    Operator::ptr_t other_adapter(new OperatorStreamAdapter(Stream::from_schema(man_schema)));
+    EXPECT_THROW(PipelineScheduler(scheduler, std::vector<Operator*>(1, other_adapter.get())), std::string);
+
+    // the root ends the last stage anyway
+    PipelineScheduler pipeline_scheduler(scheduler, std::vector<Operator*>(1, root.get()));
+    EXPECT_EQ(1, pipeline_scheduler.get_stages_count());
+}
+
+class CPURecorder : public thread::Runnable {
+public:
+    std::atomic<int> cpu;
+
+    CPURecorder(): cpu(-1) {
+    }
+
+    void run() {
+        cpu = sched_getcpu();
+    }
+};
+
+TEST_F (TestPipelineScheduler, cpu_affinity) {
+    CPURecorder recorder;
+    EXPECT_THROW(recorder.set_cpu_affinity(std::thread::hardware_concurrency()), std::string);
+
+    recorder.set_cpu_affinity(0);
+    EXPECT_EQ(0, recorder.get_cpu_affinity());
+    recorder.start();
+    recorder.wait();
+    EXPECT_EQ(0, recorder.cpu);
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/relation.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace currentia;
+
+class TestRelation : public ::testing::Test {
+protected:
+    Schema::ptr_t schema;
+    Relation::ptr_t relation;
+
+    TestRelation():
+        schema(new Schema) {
+        schema->add_attribute("ID", Object::INT);
+        schema->freeze();
+
+        relation = Relation::ptr_t(new Relation(schema));
+    }
+
+    virtual ~TestRelation() {
+    }
+
+    std::vector<int> get_ids(const Relation::ptr_t& target) {
+        std::vector<int> ids;
+        auto iter = target->get_tuple_iterator();
+        auto iter_end = target->get_tuple_iterator_end();
+        for (; iter != iter_end; ++iter)
+            ids.push_back((*iter)->get_value_by_index(0).get_int_number());
+        return ids;
+    }
+
+    std::vector<int> get_ids(const Relation::View& view) {
+        std::vector<int> ids;
+        auto iter = view.begin();
+        auto iter_end = view.end();
+        for (; iter != iter_end; ++iter)
+            ids.push_back((*iter)->get_value_by_index(0).get_int_number());
+        return ids;
+    }
+
+    std::vector<int> range(int from, int to) {
+        std::vector<int> ids;
+        for (int id = from; id < to; ++id)
+            ids.push_back(id);
+        return ids;
+    }
+};
+
+TEST_F (TestRelation, insert_over_chunks) {
+    const int count = Relation::CHUNK_SIZE * 2 + 3;
+    for (int id = 0; id < count; ++id)
+        relation->insert(Tuple::create_easy(schema, id));
+
+    EXPECT_EQ(static_cast<size_t>(count), relation->get_tuples_count());
+    EXPECT_EQ(range(0, count), get_ids(relation));
+}
+
+TEST_F (TestRelation, snapshot_isolation) {
+    const int count = Relation::CHUNK_SIZE + 10;
+    for (int id = 0; id < count; ++id)
+        relation->insert(Tuple::create_easy(schema, id));
+
+    Relation::ptr_t snapshot = relation->copy();
+    relation->insert(Tuple::create_easy(schema, count));
+    Relation::ptr_t snapshot2 = relation->copy();
+    relation->insert(Tuple::create_easy(schema, count + 1));
+
+    EXPECT_EQ(range(0, count), get_ids(snapshot));
+    EXPECT_EQ(range(0, count + 1), get_ids(snapshot2));
+    EXPECT_EQ(range(0, count + 2), get_ids(relation));
+
+    // dropping the snapshot lets the relation write in place again
+    snapshot.reset();
+    snapshot2.reset();
+    relation->insert(Tuple::create_easy(schema, count + 2));
+    EXPECT_EQ(range(0, count + 3), get_ids(relation));
+}
+
+TEST_F (TestRelation, snapshot_keeps_index) {
+    relation->create_index("ID");
+    relation->insert(Tuple::create_easy(schema, 1));
+
+    Relation::ptr_t snapshot = relation->copy();
+    relation->insert(Tuple::create_easy(schema, 1));
+
+    EXPECT_EQ(1u, snapshot->get_index(0)->size());
+    EXPECT_EQ(2u, relation->get_index(0)->size());
+}
+
+TEST_F (TestRelation, shared_locks) {
+    relation->read_lock();
+
+    // another reader is not blocked
+    std::atomic<bool> locked(false);
+    std::thread reader([&]() {
+        relation->read_lock();
+        locked = true;
+        relation->unlock();
+    });
+    reader.join();
+    EXPECT_TRUE(locked);
+
+    // a writer waits for the reader
+    locked = false;
+    std::thread writer([&]() {
+        relation->read_write_lock();
+        locked = true;
+        relation->unlock();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(locked);
+
+    relation->unlock();
+    writer.join();
+    EXPECT_TRUE(locked);
+}
+
+TEST_F (TestRelation, view_does_not_wait_for_writer) {
+    relation->insert(Tuple::create_easy(schema, 0));
+
+    relation->read_write_lock();
+    relation->insert(Tuple::create_easy(schema, 1));
+    relation->update();
+
+    // readers keep seeing the version before the lock
+    std::vector<int> ids;
+    long version = -1;
+    std::thread reader([&]() {
+        Relation::View view = relation->get_view();
+        ids = get_ids(view);
+        version = view.get_version_number();
+    });
+    reader.join();
+    EXPECT_EQ(range(0, 1), ids);
+    EXPECT_EQ(0, version);
+
+    relation->unlock();
+
+    Relation::View view = relation->get_view();
+    EXPECT_EQ(range(0, 2), get_ids(view));
+    EXPECT_EQ(1, view.get_version_number());
+}
+
+TEST_F (TestRelation, tuples_count_during_inserts) {
+    const int count = Relation::CHUNK_SIZE * 4;
+    std::thread inserter([&]() {
+        for (int id = 0; id < count; ++id)
+            relation->insert(Tuple::create_easy(schema, id));
+    });
+
+    size_t last_tuples_count = 0;
+    while (last_tuples_count < static_cast<size_t>(count)) {
+        size_t tuples_count = relation->get_tuples_count();
+        ASSERT_LE(last_tuples_count, tuples_count);
+        last_tuples_count = tuples_count;
+    }
+    inserter.join();
+    EXPECT_EQ(static_cast<size_t>(count), relation->get_tuples_count());
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/relation.h"
+#include "currentia/core/operator/operator-simple-relation-join.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+
+#include <set>
+
+using namespace currentia;
+
+class TestRelationIndex : public ::testing::Test {
+protected:
+    Schema::ptr_t goods_schema;
+    Schema::ptr_t purchase_schema;
+    Relation::ptr_t goods;
+
+    TestRelationIndex():
+        goods_schema(new Schema),
+        purchase_schema(new Schema) {
+        goods_schema->add_attribute("GOODS_ID", Object::INT);
+        goods_schema->add_attribute("PRICE", Object::INT);
+        goods_schema->freeze();
+
+        purchase_schema->add_attribute("PURCHASE_GOODS_ID", Object::INT);
+        purchase_schema->add_attribute("AMOUNT", Object::INT);
+        purchase_schema->freeze();
+
+        goods = Relation::ptr_t(new Relation(goods_schema));
+        for (int i = 0; i < 10; ++i)
+            goods->insert(Tuple::create_easy(goods_schema, i % 5, 100 * i));
+    }
+
+    virtual ~TestRelationIndex() {
+    }
+
+    std::multiset<int> lookup(const Relation::ptr_t& relation, Comparator::Type comparator, int key) {
+        std::multiset<int> prices;
+        bool supported = relation->get_index(0)->for_each_match(
+            comparator, Object(key), [&](const Tuple::ptr_t& tuple) {
+                prices.insert(tuple->get_value_by_index(1).get_int_number());
+            });
+        EXPECT_TRUE(supported);
+        return prices;
+    }
+
+    // (AMOUNT, PRICE) pairs output by a relation join
+    std::multiset<std::pair<int, int> > join(const Condition::ptr_t& condition) {
+        Stream::ptr_t purchase_stream = Stream::from_schema(purchase_schema);
+        Operator::ptr_t adapter(new OperatorStreamAdapter(purchase_stream));
+        Operator::ptr_t join(new OperatorSimpleRelationJoin(adapter, goods, condition));
+#ifdef CURRENTIA_ENABLE_TRANSACTION
+        join->set_cc_mode(Operator::NONE);
+#endif
+
+        for (int i = 0; i < 6; ++i)
+            purchase_stream->enqueue(Tuple::create_easy(purchase_schema, i, i));
+        adapter->process_next(6);
+        join->process_next(6);
+
+        std::multiset<std::pair<int, int> > pairs;
+        Tuple::ptr_t tuple;
+        while ((tuple = join->get_output_stream()->non_blocking_dequeue())) {
+            pairs.insert(std::make_pair(tuple->get_value_by_index(1).get_int_number(),
+                                        tuple->get_value_by_index(3).get_int_number()));
+        }
+        return pairs;
+    }
+};
+
+TEST_F (TestRelationIndex, hash_index) {
+    goods->create_index("GOODS_ID");
+    goods->insert(Tuple::create_easy(goods_schema, 3, 1000));
+
+    std::multiset<int> expected = { 300, 800, 1000 };
+    EXPECT_EQ(expected, lookup(goods, Comparator::EQUAL, 3));
+    EXPECT_FALSE(goods->get_index(0)->supports(Comparator::LESS_THAN));
+    EXPECT_FALSE(goods->get_index(1));
+}
+
+TEST_F (TestRelationIndex, ordered_index) {
+    goods->create_index("GOODS_ID", RelationIndex::ORDERED);
+
+    std::multiset<int> expected = { 0, 500, 100, 600 };
+    EXPECT_EQ(expected, lookup(goods, Comparator::LESS_THAN, 2));
+    EXPECT_EQ(4u, lookup(goods, Comparator::GREATER_THAN_EQUAL, 3).size());
+}
+
+TEST_F (TestRelationIndex, copy_keeps_index) {
+    goods->create_index("GOODS_ID");
+    Relation::ptr_t snapshot = goods->copy();
+    goods->insert(Tuple::create_easy(goods_schema, 3, 1000));
+
+    std::multiset<int> expected = { 300, 800 };
+    EXPECT_EQ(expected, lookup(snapshot, Comparator::EQUAL, 3));
+}
+
+TEST_F (TestRelationIndex, relation_join_uses_index) {
+    Condition::ptr_t condition(
+        new ConditionConjunctive(
+            Condition::ptr_t(new ConditionAttributeComparator("GOODS_ID", Comparator::EQUAL,
+                                                              "PURCHASE_GOODS_ID")),
+            Condition::ptr_t(new ConditionConstantComparator("PRICE", Comparator::GREATER_THAN,
+                                                             Object(200))),
+            ConditionConjunctive::AND));
+
+    std::multiset<std::pair<int, int> > scanned = join(condition);
+    goods->create_index("GOODS_ID");
+    std::multiset<std::pair<int, int> > indexed = join(condition);
+
+    EXPECT_EQ(7u, scanned.size());
+    EXPECT_EQ(scanned, indexed);
+}
+
+TEST_F (TestRelationIndex, relation_join_uses_ordered_index) {
+    Condition::ptr_t condition(
+        new ConditionAttributeComparator("GOODS_ID", Comparator::LESS_THAN, "PURCHASE_GOODS_ID"));
+
+    std::multiset<std::pair<int, int> > scanned = join(condition);
+    goods->create_index("GOODS_ID", RelationIndex::ORDERED);
+    std::multiset<std::pair<int, int> > indexed = join(condition);
+
+    EXPECT_EQ(scanned, indexed);
+    EXPECT_EQ(scanned.count(std::make_pair(1, 0)), 1u);
+    EXPECT_EQ(scanned.count(std::make_pair(1, 100)), 0u);
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/operator/operator-projection.h"
+#include "currentia/core/operator/operator-selection.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+#include "currentia/core/scheduler/policy/scheduling-policy-chain.h"
+#include "currentia/core/scheduler/policy/scheduling-policy-longest-queue-first.h"
+#include "currentia/core/scheduler/policy/scheduling-policy-oldest-tuple-first.h"
+#include "currentia/core/scheduler/policy/scheduling-policy-round-robin.h"
+
+using namespace currentia;
+
+class TestSchedulingPolicy : public ::testing::Test {
+protected:
+    Schema::ptr_t man_schema;
+    Stream::ptr_t input_stream;
+    Operator::ptr_t adapter;
+    Operator::ptr_t adults;
+    Operator::ptr_t ages;
+    Operator::ptr_t root;
+
+    TestSchedulingPolicy():
+        man_schema(create_man_schema()),
+        input_stream(Stream::from_schema(man_schema)),
+        adapter(new OperatorStreamAdapter(input_stream)) {
+        // adapter -> selection -> projection -> selection
+        adults = Operator::ptr_t(new OperatorSelection(
+            adapter,
+            Condition::ptr_t(new ConditionConstantComparator("AGE", Comparator::GREATER_THAN_EQUAL,
+                                                             Object(20)))));
+        OperatorProjection::target_attribute_names_t names;
+        names.push_back("AGE");
+        ages = Operator::ptr_t(new OperatorProjection(adults, names));
+        root = Operator::ptr_t(new OperatorSelection(
+            ages,
+            Condition::ptr_t(new ConditionConstantComparator("AGE", Comparator::LESS_THAN,
+                                                             Object(60)))));
+    }
+
+    virtual ~TestSchedulingPolicy() {
+    }
+
+    Schema::ptr_t create_man_schema() {
+        Schema::ptr_t schema_ptr(new Schema);
+        schema_ptr->add_attribute("NAME", Object::STRING);
+        schema_ptr->add_attribute("AGE", Object::INT);
+        schema_ptr->freeze();
+
+        return schema_ptr;
+    }
+
+    void enqueue_ages(int count, int age) {
+        for (int i = 0; i < count; ++i)
+            input_stream->enqueue(Tuple::create_easy(man_schema, "A", age));
+    }
+};
+
+TEST_F (TestSchedulingPolicy, round_robin_skips_operators_without_input) {
+    RoundRobinPolicy policy(root);
+    EXPECT_EQ(NULL, policy.get_next_operator());
+
+    enqueue_ages(2, 30);
+    EXPECT_EQ(adapter.get(), policy.get_next_operator());
+    adapter->process_next();
+    EXPECT_EQ(adults.get(), policy.get_next_operator());
+    EXPECT_EQ(adapter.get(), policy.get_next_operator());
+    adapter->process_next();
+    adults->process_next();
+    adults->process_next();
+    EXPECT_EQ(ages.get(), policy.get_next_operator());
+    EXPECT_EQ(ages.get(), policy.get_next_operator());
+}
+
+TEST_F (TestSchedulingPolicy, longest_queue_first) {
+    LongestQueueFirstPolicy policy(root);
+    EXPECT_EQ(NULL, policy.get_next_operator());
+
+    enqueue_ages(5, 30);
+    adapter->process_next(5);
+    adults->process_next(3);
+    enqueue_ages(1, 30);
+    // adults: 2, ages: 3, adapter: 1
+    EXPECT_EQ(3u, ages->get_input_tuples_count());
+    EXPECT_EQ(ages.get(), policy.get_next_operator());
+    ages->process_next(2);
+    EXPECT_EQ(adults.get(), policy.get_next_operator());
+}
+
+TEST_F (TestSchedulingPolicy, oldest_tuple_first) {
+    OldestTupleFirstPolicy policy(root);
+    EXPECT_EQ(NULL, policy.get_next_operator());
+
+    enqueue_ages(2, 30);
+    time_t first_time = input_stream->peek()->get_arrived_time();
+    EXPECT_EQ(first_time, adapter->get_oldest_input_time());
+    EXPECT_EQ(adapter.get(), policy.get_next_operator());
+
+    adapter->process_next();
+    // the first tuple is older, and nearer to the root
+    EXPECT_EQ(adults.get(), policy.get_next_operator());
+    adults->process_next();
+    EXPECT_EQ(ages.get(), policy.get_next_operator());
+    EXPECT_TRUE(adults->get_oldest_input_time() == Operator::NO_INPUT_TIME);
+
+    // system messages go first
+    adapter->process_next();
+    adults->process_next();
+    input_stream->enqueue(Tuple::create_eos());
+    adapter->process_next();
+    EXPECT_EQ(0, adults->get_oldest_input_time());
+    EXPECT_EQ(adults.get(), policy.get_next_operator());
+}
+
+TEST_F (TestSchedulingPolicy, chain_prefers_selective_operators) {
+    ChainPolicy policy(root);
+    // no statistics: every operator keeps tuples as they are
+    EXPECT_EQ(0, policy.get_priority(adapter.get()));
+    EXPECT_EQ(0, policy.get_priority(root.get()));
+
+    // adults drops half of the tuples, and root all of them
+    for (int i = 0; i < 100; ++i)
+        enqueue_ages(1, i % 2 ? 10 : 70);
+    while (adapter->has_input() || adults->has_input() || ages->has_input() || root->has_input()) {
+        adapter->process_next(7);
+        adults->process_next(7);
+        ages->process_next(7);
+        root->process_next(7);
+    }
+    policy.prioritize();
+
+    // the envelope drops by 1 over the four operators
+    EXPECT_DOUBLE_EQ(0.25, policy.get_priority(adapter.get()));
+    EXPECT_DOUBLE_EQ(0.25, policy.get_priority(root.get()));
+
+    enqueue_ages(3, 30);
+    adapter->process_next(2);
+    adults->process_next(1);
+    // same priorities: the oldest tuple first
+    EXPECT_EQ(ages.get(), policy.get_next_operator());
+}
+
+TEST_F (TestSchedulingPolicy, chain_envelope_segments) {
+    ChainPolicy policy(root);
+
+    // root drops nothing, adults keeps a tenth
+    for (int i = 0; i < 100; ++i)
+        enqueue_ages(1, i % 10 ? 10 : 30);
+    while (adapter->has_input() || adults->has_input() || ages->has_input() || root->has_input()) {
+        adapter->process_next(7);
+        adults->process_next(7);
+        ages->process_next(7);
+        root->process_next(7);
+    }
+    policy.prioritize();
+
+    // sizes 1, 1, 0.1, 0.1, 0.1: the steepest segment ends at adults
+    EXPECT_DOUBLE_EQ(0.45, policy.get_priority(adapter.get()));
+    EXPECT_DOUBLE_EQ(0.45, policy.get_priority(adults.get()));
+    EXPECT_DOUBLE_EQ(0, policy.get_priority(ages.get()));
+    EXPECT_DOUBLE_EQ(0, policy.get_priority(root.get()));
+
+    enqueue_ages(1, 30);
+    adapter->process_next();
+    adults->process_next();
+    enqueue_ages(1, 30);
+    // ages holds an older tuple, but a lower priority
+    EXPECT_EQ(adapter.get(), policy.get_next_operator());
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/operator/operator-sketch-aggregation.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+#include "currentia/core/operator/sketches.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace currentia;
+
+class TestSketches : public ::testing::Test {
+protected:
+    Schema::ptr_t access_schema;
+
+    TestSketches():
+        access_schema(new Schema) {
+        access_schema->add_attribute("USER", Object::INT);
+        access_schema->add_attribute("LATENCY", Object::FLOAT);
+        access_schema->freeze();
+    }
+
+    virtual ~TestSketches() {
+    }
+};
+
+// Fraction of values less than or equal to value
+static double get_rank(std::vector<double> values, double value) {
+    return static_cast<double>(std::upper_bound(values.begin(), values.end(), value) - values.begin()) /
+        values.size();
+}
+
+TEST_F (TestSketches, hyper_log_log) {
+    int precision = HyperLogLog::precision_for_error(0.02);
+    EXPECT_GE(0.02, 1.04 / std::sqrt(static_cast<double>(1 << precision)));
+
+    HyperLogLog small(precision), first(precision), second(precision);
+    for (int i = 0; i < 10; ++i)
+        small.add_hash(sketch::hash_object(Object(i % 5)));
+    EXPECT_NEAR(5, small.estimate(), 0.5);
+
+    for (int i = 0; i < 60000; ++i)
+        first.add_hash(sketch::hash_object(Object(i)));
+    for (int i = 30000; i < 100000; ++i)
+        second.add_hash(sketch::hash_object(Object(i)));
+    EXPECT_NEAR(60000, first.estimate(), 60000 * 0.02 * 3);
+
+    // the union
+    first.merge(second);
+    EXPECT_NEAR(100000, first.estimate(), 100000 * 0.02 * 3);
+    EXPECT_EQ(static_cast<size_t>(1) << precision, first.get_memory_size());
+}
+
+TEST_F (TestSketches, kll_sketch) {
+    double error = 0.01;
+    KLLSketch first(KLLSketch::k_for_error(error)), second(KLLSketch::k_for_error(error));
+    std::vector<double> values;
+
+    std::srand(1);
+    for (int i = 0; i < 100000; ++i) {
+        double value = std::rand() % 100000 / 10.0;
+        values.push_back(value);
+        (i < 40000 ? first : second).add(value);
+    }
+    first.merge(second);
+    std::sort(values.begin(), values.end());
+
+    EXPECT_EQ(100000, first.get_count());
+    EXPECT_GT(5000u, first.get_retained_count());
+    for (double fraction = 0.05; fraction < 1; fraction += 0.05)
+        EXPECT_NEAR(fraction, get_rank(values, first.quantile(fraction)), error * 2) << fraction;
+}
+
+TEST_F (TestSketches, space_saving) {
+    SpaceSaving first(20), second(20);
+    std::map<int, long> counts;
+
+    // Zipf-like: i appears about 1000 / i times
+    std::srand(1);
+    for (int i = 0; i < 20000; ++i) {
+        int item = 1;
+        while (item < 1000 && std::rand() % (item + 1) != 0)
+            item++;
+        counts[item]++;
+        (i % 2 ? first : second).add(Object(item));
+    }
+    first.merge(second);
+
+    std::vector<SpaceSaving::Counter> top = first.get_top(5);
+    ASSERT_EQ(5u, top.size());
+    for (size_t i = 0; i < top.size(); ++i) {
+        int item = top[i].item.get_int_number();
+        EXPECT_EQ(static_cast<int>(i) + 1, item);
+        // overestimated by at most the error bound, here 20000 / 20
+        EXPECT_LE(counts[item], top[i].count);
+        EXPECT_GE(counts[item] + 20000 / 20, top[i].count);
+        EXPECT_GE(counts[item], top[i].count - top[i].error);
+    }
+}
+
+TEST_F (TestSketches, sketch_aggregation) {
+    Stream::ptr_t input_stream = Stream::from_schema(access_schema);
+    Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+
+    double error = 0.02;
+    OperatorSketchAggregation::specifications_t specifications;
+    specifications.push_back(SketchFunction::Specification(SketchFunction::DISTINCT, "USER", 0, error));
+    specifications.push_back(SketchFunction::Specification(SketchFunction::QUANTILE, "LATENCY", 0.5, error));
+    specifications.push_back(SketchFunction::Specification(SketchFunction::QUANTILE, "LATENCY", 0.99, error));
+    OperatorSketchAggregation* aggregation =
+        new OperatorSketchAggregation(adapter, Window(3000, 2000), specifications);
+    Operator::ptr_t aggregation_ptr(aggregation);
+    EXPECT_EQ(1000, aggregation->get_pane_size());
+
+    Schema::ptr_t output_schema = aggregation->get_output_schema_ptr();
+    EXPECT_EQ(3u, output_schema->size());
+    EXPECT_EQ(2, output_schema->get_attribute_index_by_name("QUANTILE_LATENCY"));
+
+    std::deque<Tuple::ptr_t> window;
+    std::srand(2);
+    int windows_count = 0;
+    for (int i = 0; i < 12000; ++i) {
+        Tuple::ptr_t tuple = Tuple::create_easy(access_schema, std::rand() % 5000, std::rand() % 1000 * 0.5);
+        window.push_back(tuple);
+        if (window.size() > 3000)
+            window.pop_front();
+        input_stream->enqueue(tuple);
+        adapter->process_next();
+        aggregation_ptr->process_next();
+
+        if (i == 4499) {
+            // drops the incomplete pane too
+            aggregation_ptr->reset();
+            window.clear();
+            continue;
+        }
+
+        Stream::ptr_t output_stream = aggregation_ptr->get_output_stream();
+        if (output_stream->get_tuples_count() == 0)
+            continue;
+        windows_count++;
+        ASSERT_EQ(3000u, window.size()) << i;
+
+        std::set<int> users;
+        std::vector<double> latencies;
+        for (auto iter = window.begin(); iter != window.end(); ++iter) {
+            users.insert((*iter)->get_int_by_index(0));
+            latencies.push_back((*iter)->get_float_by_index(1));
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        Tuple::ptr_t result = output_stream->dequeue();
+        EXPECT_NEAR(users.size(), result->get_int_by_index(0), users.size() * error * 3);
+        EXPECT_NEAR(0.5, get_rank(latencies, result->get_float_by_index(1)), error * 2);
+        EXPECT_NEAR(0.99, get_rank(latencies, result->get_float_by_index(2)), error * 2);
+    }
+    // at 3000 (5000 is dropped by the reset), then at 7500, 9500, 11500
+    EXPECT_EQ(4, windows_count);
+    // the window, and the sketches of the current pane
+    EXPECT_GE(4u * 3 * (1 << HyperLogLog::precision_for_error(error)) * 2,
+              aggregation->get_memory_size());
+}
+
+TEST_F (TestSketches, heavy_hitters) {
+    Stream::ptr_t input_stream = Stream::from_schema(access_schema);
+    Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+    Operator::ptr_t heavy_hitters(new OperatorHeavyHitters(adapter, Window(400, 100), "USER", 2, 0.05));
+
+    Schema::ptr_t output_schema = heavy_hitters->get_output_schema_ptr();
+    EXPECT_EQ(0, output_schema->get_attribute_index_by_name("USER"));
+    EXPECT_EQ(1, output_schema->get_attribute_index_by_name("COUNT_USER"));
+
+    // user 7 in half of the tuples, user 3 in a quarter
+    for (int i = 0; i < 1000; ++i) {
+        int user = i % 2 == 0 ? 7 : i % 4 == 1 ? 3 : 100 + i;
+        input_stream->enqueue(Tuple::create_easy(access_schema, user, 1.0));
+        adapter->process_next();
+        heavy_hitters->process_next();
+    }
+
+    Stream::ptr_t output_stream = heavy_hitters->get_output_stream();
+    // windows at 400, 500, ..., 1000
+    ASSERT_EQ(7u * 2, output_stream->get_tuples_count());
+    while (output_stream->get_tuples_count() > 0) {
+        Tuple::ptr_t first = output_stream->dequeue();
+        Tuple::ptr_t second = output_stream->dequeue();
+        EXPECT_EQ(7, first->get_int_by_index(0));
+        EXPECT_NEAR(200, first->get_int_by_index(1), 400 * 0.05);
+        EXPECT_EQ(3, second->get_int_by_index(0));
+        EXPECT_NEAR(100, second->get_int_by_index(1), 400 * 0.05);
+    }
+}
+
+TEST_F (TestSketches, invalid_specifications) {
+    Stream::ptr_t input_stream = Stream::from_schema(access_schema);
+    Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+
+    OperatorSketchAggregation::specifications_t unknown_attribute(
+        1, SketchFunction::Specification(SketchFunction::DISTINCT, "NAME"));
+    EXPECT_THROW(OperatorSketchAggregation(adapter, Window(10, 5), unknown_attribute), std::string);
+
+    OperatorSketchAggregation::specifications_t out_of_range_error(
+        1, SketchFunction::Specification(SketchFunction::QUANTILE, "LATENCY", 0.5, 2));
+    EXPECT_THROW(OperatorSketchAggregation(adapter, Window(10, 5), out_of_range_error), std::string);
+
+    EXPECT_THROW(OperatorHeavyHitters(adapter, Window(10, 5, Window::TIME_BASE), "USER", 3), std::string);
+
+    OperatorSketchAggregation::specifications_t distinct_users(
+        1, SketchFunction::Specification(SketchFunction::DISTINCT, "USER"));
+    EXPECT_THROW(OperatorSketchAggregation(adapter, Window(10, 0), distinct_users), std::string);
+}
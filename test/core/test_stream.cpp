@@ -84,3 +84,19 @@ TEST_F (TestStream, insert) {
     EXPECT_EQ(tuple_b->toString(), stream->dequeue()->toString());
     EXPECT_EQ(tuple_c->toString(), stream->dequeue()->toString());
 }
+
+TEST_F (TestStream, batch) {
+    Stream::batch_t tuples;
+    for (int i = 0; i < 5; ++i)
+        tuples.push_back(create_man_tuple("A", i));
+
+    stream->enqueue_batch(tuples);
+    EXPECT_EQ(5u, stream->get_tuples_count());
+
+    Stream::batch_t dequeued_tuples;
+    EXPECT_EQ(3u, stream->dequeue_batch(dequeued_tuples, 3));
+    EXPECT_EQ(2u, stream->dequeue_batch(dequeued_tuples, 3));
+    EXPECT_EQ(0u, stream->dequeue_batch(dequeued_tuples, 3));
+
+    EXPECT_TRUE(tuples == dequeued_tuples);
+}
@@ -40,3 +40,40 @@ protected:
 
 TEST_F (TestTuple, copy) {
 }
+
+TEST_F (TestTuple, typed_accessors) {
+    EXPECT_EQ(std::string("ALICE"), man_tuple_alice->get_string_by_index(0));
+    EXPECT_EQ(7, man_tuple_alice->get_int_by_index(1));
+    EXPECT_EQ(Object("BOB"), man_tuple_bob->get_value_by_index(0));
+    EXPECT_EQ(Object(22), man_tuple_bob->get_value_by_index(1));
+
+    EXPECT_THROW(man_tuple_alice->get_float_by_index(1), const char*);
+    EXPECT_THROW(man_tuple_alice->get_value_by_index(2), const char*);
+}
+
+TEST_F (TestTuple, concatenate) {
+    Schema::ptr_t schema = concat_schemas(man_tuple_alice->get_schema(), man_tuple_bob->get_schema());
+    Tuple::ptr_t couple = Tuple::create_concatenated(schema, man_tuple_alice, man_tuple_bob,
+                                                     man_tuple_alice->get_arrived_time());
+
+    EXPECT_EQ(std::string("ALICE"), couple->get_string_by_index(0));
+    EXPECT_EQ(7, couple->get_int_by_index(1));
+    EXPECT_EQ(std::string("BOB"), couple->get_string_by_index(2));
+    EXPECT_EQ(22, couple->get_int_by_index(3));
+}
+
+TEST_F (TestTuple, project) {
+    Schema::ptr_t schema(new Schema);
+    schema->add_attribute("AGE", Object::INT);
+    schema->add_attribute("NAME", Object::STRING);
+    schema->freeze();
+
+    std::vector<int> attribute_indices;
+    attribute_indices.push_back(1);
+    attribute_indices.push_back(0);
+    Tuple::ptr_t projected = Tuple::create_projected(schema, man_tuple_bob, attribute_indices,
+                                                     man_tuple_bob->get_arrived_time());
+
+    EXPECT_EQ(22, projected->get_int_by_index(0));
+    EXPECT_EQ(std::string("BOB"), projected->get_string_by_index(1));
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/tuple.h"
+#include "currentia/core/tuple-allocator.h"
+
+#include <vector>
+
+using namespace currentia;
+
+class TestTupleAllocator : public ::testing::Test {
+protected:
+    Schema::ptr_t schema;
+
+    TestTupleAllocator():
+        schema(new Schema) {
+        schema->add_attribute("ID", Object::INT);
+        schema->add_attribute("NAME", Object::STRING);
+        schema->freeze();
+    }
+
+    virtual ~TestTupleAllocator() {
+    }
+};
+
+TEST_F (TestTupleAllocator, slab_reuses_blocks) {
+    SlabTupleAllocator allocator;
+
+    void* block = allocator.allocate(40);
+    allocator.deallocate(block, 40);
+    // same size class
+    EXPECT_EQ(block, allocator.allocate(48));
+
+    void* large_block = allocator.allocate(SlabTupleAllocator::MAX_BLOCK_SIZE + 1);
+    EXPECT_TRUE(large_block != NULL);
+    allocator.deallocate(large_block, SlabTupleAllocator::MAX_BLOCK_SIZE + 1);
+}
+
+TEST_F (TestTupleAllocator, arena_regions) {
+    ArenaTupleAllocator allocator;
+
+    char* first = static_cast<char*>(allocator.allocate(32));
+    char* second = static_cast<char*>(allocator.allocate(32));
+    // bump allocation (each block has a header)
+    EXPECT_EQ(first + 32 + TupleAllocator::ALIGNMENT, second);
+
+    allocator.begin_region();
+    char* third = static_cast<char*>(allocator.allocate(32));
+    EXPECT_NE(second + 32 + TupleAllocator::ALIGNMENT, third);
+
+    allocator.deallocate(first, 32);
+    allocator.deallocate(second, 32);
+    allocator.deallocate(third, 32);
+}
+
+TEST_F (TestTupleAllocator, tuples_use_schema_allocator) {
+    std::vector<TupleAllocator::ptr_t> allocators;
+    allocators.push_back(TupleAllocator::ptr_t(new SlabTupleAllocator()));
+    allocators.push_back(TupleAllocator::ptr_t(new ArenaTupleAllocator()));
+
+    std::vector<Tuple::ptr_t> tuples;
+    auto iter = allocators.begin();
+    for (; iter != allocators.end(); ++iter) {
+        schema->set_tuple_allocator(*iter);
+        for (int id = 0; id < 1000; ++id)
+            tuples.push_back(Tuple::create_easy(schema, id, "NAME"));
+    }
+    // allocators are kept by the schema while their tuples live
+    allocators.clear();
+    schema->set_tuple_allocator(TupleAllocator::ptr_t());
+
+    for (size_t i = 0; i < tuples.size(); ++i) {
+        EXPECT_EQ(static_cast<int>(i % 1000), tuples[i]->get_int_by_index(0));
+        EXPECT_EQ(std::string("NAME"), tuples[i]->get_string_by_index(1));
+    }
+}
+
+TEST_F (TestTupleAllocator, tuples_outlive_schema) {
+    std::vector<TupleAllocator::ptr_t> allocators;
+    allocators.push_back(TupleAllocator::ptr_t(new SlabTupleAllocator()));
+    allocators.push_back(TupleAllocator::ptr_t(new ArenaTupleAllocator()));
+    allocators.push_back(TupleAllocator::ptr_t());
+
+    std::vector<Tuple::ptr_t> tuples;
+    for (auto iter = allocators.begin(), iter_end = allocators.end();
+         iter != iter_end;
+         ++iter) {
+        Schema::ptr_t dropped_schema(new Schema);
+        dropped_schema->add_attribute("ID", Object::INT);
+        dropped_schema->add_attribute("NAME", Object::STRING);
+        dropped_schema->freeze();
+        dropped_schema->set_tuple_allocator(*iter);
+        for (int id = 0; id < 100; ++id)
+            tuples.push_back(Tuple::create_easy(dropped_schema, id, "NAME"));
+    }
+    // tuples (not the schema, nor anyone else) keep their allocators
+    allocators.clear();
+
+    for (size_t i = 0; i < tuples.size(); ++i) {
+        EXPECT_EQ(static_cast<int>(i % 100), tuples[i]->get_int_by_index(0));
+        EXPECT_EQ(std::string("NAME"), tuples[i]->get_string_by_index(1));
+    }
+    // freed into live allocators
+    tuples.clear();
+}
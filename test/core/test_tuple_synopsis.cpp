@@ -6,6 +6,9 @@
 
 #include "currentia/util/log.h"
 
+#include <algorithm>
+#include <cstdlib>
+
 using namespace currentia;
 
 class TestSynopsis : public ::testing::Test {
@@ -127,3 +130,39 @@ TEST_F (TestSynopsis, multiple_relation_difference_state) {
 
     EXPECT_TRUE(synopsis->has_reference_consistency());
 }
+
+TEST_F (TestSynopsis, tracking_agrees_with_scan) {
+    Window sliding_window(5, 2);
+    Synopsis::ptr_t sliding_synopsis = create_synopsis_from_window(sliding_window);
+    Relation::ptr_t another_relation = dummy_relation->copy();
+
+    int accepted_count = 0;
+    sliding_synopsis->set_on_accept([&]() {
+        accepted_count++;
+        time_t lwm = (*sliding_synopsis->begin())->get_lwm();
+        bool consistent = true;
+        for (auto iter = sliding_synopsis->begin(); iter != sliding_synopsis->end(); ++iter) {
+            lwm = std::min(lwm, (*iter)->get_lwm());
+            consistent = consistent &&
+                Synopsis::have_same_referenced_versions(**sliding_synopsis->begin(), **iter);
+        }
+        EXPECT_EQ(lwm, sliding_synopsis->get_lwm());
+        EXPECT_EQ(consistent, sliding_synopsis->has_reference_consistency());
+    });
+
+    std::srand(1);
+    long version = 1;
+    for (int i = 0; i < 1000; ++i) {
+        if (std::rand() % 4 == 0)
+            version++;
+        Tuple::ptr_t tuple = Tuple::create_easy(schema, i);
+        tuple->set_lwm(std::rand() % 100);
+        tuple->set_referenced_version_number(dummy_relation, version);
+        tuple->set_referenced_version_number(another_relation, std::rand() % 8 ? 1 : 2);
+        sliding_synopsis->enqueue(tuple);
+        // the window is refilled out of the order of arrival
+        if (std::rand() % 50 == 0)
+            sliding_synopsis->reset();
+    }
+    EXPECT_LT(300, accepted_count);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/operator/vectorized-selection.h"
+
+#include <cstdlib>
+
+using namespace currentia;
+
+class TestVectorizedSelection : public ::testing::Test {
+protected:
+    Schema::ptr_t goods_schema;
+    Stream::batch_t goods;
+
+    TestVectorizedSelection():
+        goods_schema(new Schema) {
+        goods_schema->add_attribute("TITLE", Object::STRING);
+        goods_schema->add_attribute("STOCK", Object::INT);
+        goods_schema->add_attribute("PRICE", Object::FLOAT);
+        goods_schema->freeze();
+
+        // not a multiple of the block size
+        std::srand(1);
+        for (int i = 0; i < 300; ++i) {
+            std::string title = i % 3 ? "BOOK" : "PEN";
+            goods.push_back(Tuple::create_easy(goods_schema, title, std::rand() % 20 - 10,
+                                               (std::rand() % 200) / 4.0));
+        }
+    }
+
+    virtual ~TestVectorizedSelection() {
+    }
+
+    Condition::ptr_t constant_condition(const std::string& attribute_name,
+                                        Comparator::Type comparator,
+                                        const Object& value) {
+        return Condition::ptr_t(new ConditionConstantComparator(attribute_name, comparator, value));
+    }
+
+    void expect_same_selection(const Condition::ptr_t& condition) {
+        condition->obey_schema(goods_schema, goods_schema);
+        VectorizedSelection::ptr_t selection = VectorizedSelection::create(condition);
+        ASSERT_TRUE(selection) << condition->toString();
+
+        Stream::batch_t expected;
+        for (size_t i = 0; i < goods.size(); ++i) {
+            if (condition->check(goods[i]))
+                expected.push_back(goods[i]);
+        }
+
+        Stream::batch_t selected;
+        selection->select(goods, selected);
+        EXPECT_EQ(expected, selected) << condition->toString();
+    }
+};
+
+TEST_F (TestVectorizedSelection, agrees_with_condition) {
+    const Comparator::Type comparators[] = {
+        Comparator::EQUAL, Comparator::NOT_EQUAL,
+        Comparator::LESS_THAN, Comparator::LESS_THAN_EQUAL,
+        Comparator::GREATER_THAN, Comparator::GREATER_THAN_EQUAL
+    };
+
+    for (size_t i = 0; i < sizeof(comparators) / sizeof(comparators[0]); ++i) {
+        for (int negated = 0; negated < 2; ++negated) {
+            Condition::ptr_t conditions[] = {
+                constant_condition("STOCK", comparators[i], Object(3)),
+                constant_condition("STOCK", comparators[i], Object(2.5)),
+                constant_condition("PRICE", comparators[i], Object(25)),
+                constant_condition("PRICE", comparators[i], Object(12.25))
+            };
+            for (size_t j = 0; j < sizeof(conditions) / sizeof(conditions[0]); ++j) {
+                if (negated)
+                    conditions[j]->negate();
+                expect_same_selection(conditions[j]);
+            }
+        }
+    }
+}
+
+TEST_F (TestVectorizedSelection, residual_conjuncts) {
+    // STOCK > 0 && PRICE < 30 && TITLE == "BOOK"
+    Condition::ptr_t condition(
+        new ConditionConjunctive(
+            Condition::ptr_t(new ConditionConjunctive(constant_condition("STOCK", Comparator::GREATER_THAN, Object(0)),
+                                                      constant_condition("PRICE", Comparator::LESS_THAN, Object(30)),
+                                                      ConditionConjunctive::AND)),
+            constant_condition("TITLE", Comparator::EQUAL, Object("BOOK")),
+            ConditionConjunctive::AND));
+    expect_same_selection(condition);
+    EXPECT_EQ(2u, VectorizedSelection::create(condition)->get_column_predicates_count());
+
+    // nothing to vectorize
+    Condition::ptr_t title_condition = constant_condition("TITLE", Comparator::EQUAL, Object("PEN"));
+    title_condition->obey_schema(goods_schema, goods_schema);
+    EXPECT_FALSE(VectorizedSelection::create(title_condition));
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/operator/operator-mean.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+#include "currentia/core/operator/synopsis.h"
+#include "currentia/core/operator/window-aggregation.h"
+
+#include <algorithm>
+#include <deque>
+
+using namespace currentia;
+
+class TestWindowAggregation : public ::testing::Test {
+protected:
+    Schema::ptr_t goods_schema;
+
+    TestWindowAggregation():
+        goods_schema(new Schema) {
+        goods_schema->add_attribute("STOCK", Object::INT);
+        goods_schema->add_attribute("PRICE", Object::FLOAT);
+        goods_schema->freeze();
+    }
+
+    virtual ~TestWindowAggregation() {
+    }
+
+    Tuple::ptr_t create_goods_tuple(int stock, double price) {
+        return Tuple::create_easy(goods_schema, stock, price);
+    }
+};
+
+TEST_F (TestWindowAggregation, sliding_sum_follows_synopsis) {
+    Window window(5, 2);
+    Synopsis::ptr_t synopsis = create_synopsis_from_window(window);
+    SlidingSum stock_sum(goods_schema, "STOCK");
+    SlidingSum price_sum(goods_schema, "PRICE");
+    synopsis->set_on_insert([&](const Tuple::ptr_t& tuple) {
+            stock_sum.add(*tuple);
+            price_sum.add(*tuple);
+        });
+    synopsis->set_on_evict([&](const Tuple::ptr_t& tuple) {
+            stock_sum.remove(*tuple);
+            price_sum.remove(*tuple);
+        });
+
+    int accepted_count = 0;
+    synopsis->set_on_accept([&]() {
+            accepted_count++;
+            SlidingSum expected(goods_schema, "STOCK");
+            expected.recompute(synopsis->begin(), synopsis->end());
+            EXPECT_EQ(expected.get_sum(), stock_sum.get_sum());
+            EXPECT_EQ(5, stock_sum.get_count());
+            expected = SlidingSum(goods_schema, "PRICE");
+            expected.recompute(synopsis->begin(), synopsis->end());
+            EXPECT_DOUBLE_EQ(expected.get_sum(), price_sum.get_sum());
+        });
+
+    for (int i = 0; i < 20; ++i) {
+        synopsis->enqueue(create_goods_tuple(i, i * 0.5));
+        // as on redo
+        if (i == 11)
+            synopsis->reset();
+    }
+    EXPECT_EQ(6, accepted_count);
+}
+
+TEST_F (TestWindowAggregation, operator_mean) {
+    Stream::ptr_t input_stream = Stream::from_schema(goods_schema);
+    Operator::ptr_t adapter(new OperatorStreamAdapter(input_stream));
+    Operator::ptr_t mean(new OperatorMean(adapter, Window(4, 2), "PRICE"));
+
+    std::deque<double> prices;
+    std::vector<double> expected_means;
+    for (int i = 0; i < 12; ++i) {
+        double price = (i * 7 % 5) * 1.5;
+        input_stream->enqueue(create_goods_tuple(i, price));
+        prices.push_back(price);
+        if (prices.size() > 4)
+            prices.pop_front();
+        if (i == 3 || (i > 3 && (i - 3) % 2 == 0)) {
+            double sum = 0;
+            for (size_t j = 0; j < prices.size(); ++j)
+                sum += prices[j];
+            expected_means.push_back(sum / 4);
+        }
+    }
+
+    adapter->process_next(12);
+    for (int i = 0; i < 12; ++i)
+        mean->process_next();
+
+    Stream::ptr_t output_stream = mean->get_output_stream();
+    ASSERT_EQ(expected_means.size(), output_stream->get_tuples_count());
+    for (size_t i = 0; i < expected_means.size(); ++i)
+        EXPECT_DOUBLE_EQ(expected_means[i], output_stream->dequeue()->get_float_by_index(0));
+}
+
+struct Min {
+    int operator()(int older, int newer) const {
+        return std::min(older, newer);
+    }
+};
+
+TEST_F (TestWindowAggregation, two_stacks) {
+    TwoStacksAggregate<int, Min> minimum;
+    std::deque<int> values;
+
+    std::srand(1);
+    for (int i = 0; i < 1000; ++i) {
+        if (values.empty() || std::rand() % 3) {
+            int value = std::rand() % 100;
+            minimum.push(value);
+            values.push_back(value);
+        } else {
+            minimum.pop();
+            values.pop_front();
+        }
+        ASSERT_EQ(values.size(), minimum.size());
+        if (!values.empty()) {
+            ASSERT_EQ(*std::min_element(values.begin(), values.end()), minimum.get());
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include "currentia/core/cc/without-cc-scheduler.h"
+#include "currentia/core/operator/operator-projection.h"
+#include "currentia/core/operator/operator-selection.h"
+#include "currentia/core/operator/operator-stream-adapter.h"
+#include "currentia/core/scheduler/policy/scheduling-policy-round-robin.h"
+#include "currentia/core/scheduler/work-stealing-scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace currentia;
+
+class TestWorkStealingScheduler : public ::testing::Test {
+protected:
+    Schema::ptr_t man_schema;
+    Stream::ptr_t input_stream;
+    Operator::ptr_t adapter;
+    Operator::ptr_t root;
+
+    TestWorkStealingScheduler():
+        man_schema(create_man_schema()),
+        input_stream(Stream::from_schema(man_schema)),
+        adapter(new OperatorStreamAdapter(input_stream)) {
+        // adapter -> selection -> projection -> selection
+        Operator::ptr_t adults(new OperatorSelection(
+            adapter,
+            Condition::ptr_t(new ConditionConstantComparator("AGE", Comparator::GREATER_THAN_EQUAL,
+                                                             Object(20)))));
+        OperatorProjection::target_attribute_names_t names;
+        names.push_back("AGE");
+        Operator::ptr_t ages(new OperatorProjection(adults, names));
+        root = Operator::ptr_t(new OperatorSelection(
+            ages,
+            Condition::ptr_t(new ConditionConstantComparator("AGE", Comparator::LESS_THAN,
+                                                             Object(60)))));
+    }
+
+    virtual ~TestWorkStealingScheduler() {
+    }
+
+    Schema::ptr_t create_man_schema() {
+        Schema::ptr_t schema_ptr(new Schema);
+        schema_ptr->add_attribute("NAME", Object::STRING);
+        schema_ptr->add_attribute("AGE", Object::INT);
+        schema_ptr->freeze();
+
+        return schema_ptr;
+    }
+
+    // Waits until the stream has count tuples (or a few seconds)
+    static void wait_for_tuples(const Stream::ptr_t& stream, size_t count) {
+        for (int i = 0; i < 5000 && stream->get_tuples_count() < count; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+};
+
+TEST_F (TestWorkStealingScheduler, keeps_order_of_tuples) {
+    AbstractScheduler::ptr_t scheduler(
+        new WithoutCCScheduler(root, SchedulingPolicyFactory::ptr_t(new RoundRobinPolicyFactory())));
+    scheduler->set_batch_count(16);
+    WorkStealingScheduler work_stealing_scheduler(scheduler, 4);
+    work_stealing_scheduler.start();
+
+    for (int i = 0; i < 20000; ++i)
+        input_stream->enqueue(Tuple::create_easy(man_schema, "A", i % 100));
+
+    Stream::ptr_t output_stream = root->get_output_stream();
+    wait_for_tuples(output_stream, 20000 / 100 * 40);
+    work_stealing_scheduler.stop_and_wait();
+
+    ASSERT_EQ(20000u / 100 * 40, output_stream->get_tuples_count());
+    for (int i = 0; i < 20000; ++i) {
+        if (i % 100 < 20 || i % 100 >= 60)
+            continue;
+        Tuple::ptr_t tuple = output_stream->dequeue();
+        EXPECT_EQ(1u, tuple->get_schema()->size());
+        EXPECT_EQ(i % 100, tuple->get_int_by_index(0));
+    }
+    EXPECT_LE(20000 / 16, work_stealing_scheduler.get_executed_tasks_count());
+}
+
+// Marks an operator as a synchronization point, and records whether
+// it ever ran along with another operator
+class ExclusiveOperatorScheduler : public WithoutCCScheduler {
+    Operator* exclusive_operator_;
+    std::atomic<int> running_count_;
+    std::atomic<bool> exclusive_running_;
+
+public:
+    std::atomic<bool> overlapped;
+
+    ExclusiveOperatorScheduler(const Operator::ptr_t& root_operator, Operator* exclusive_operator):
+        WithoutCCScheduler(root_operator, SchedulingPolicyFactory::ptr_t(new RoundRobinPolicyFactory())),
+        exclusive_operator_(exclusive_operator),
+        running_count_(0),
+        exclusive_running_(false),
+        overlapped(false) {
+    }
+
+    bool is_synchronization_point(Operator* op) const {
+        return op == exclusive_operator_;
+    }
+
+    bool process_operator(Operator* next_operator) {
+        if (++running_count_ != 1 && next_operator == exclusive_operator_)
+            overlapped = true;
+        if (exclusive_running_)
+            overlapped = true;
+        if (next_operator == exclusive_operator_) {
+            exclusive_running_ = true;
+            std::this_thread::yield();
+        }
+        bool processed = WithoutCCScheduler::process_operator(next_operator);
+        if (next_operator == exclusive_operator_)
+            exclusive_running_ = false;
+        running_count_--;
+        return processed;
+    }
+};
+
+TEST_F (TestWorkStealingScheduler, runs_synchronization_points_exclusively) {
+    ExclusiveOperatorScheduler* exclusive_scheduler = new ExclusiveOperatorScheduler(root, root.get());
+    AbstractScheduler::ptr_t scheduler(exclusive_scheduler);
+    WorkStealingScheduler work_stealing_scheduler(scheduler, 4);
+    work_stealing_scheduler.start();
+
+    for (int i = 0; i < 5000; ++i)
+        input_stream->enqueue(Tuple::create_easy(man_schema, "A", 30));
+
+    Stream::ptr_t output_stream = root->get_output_stream();
+    wait_for_tuples(output_stream, 5000);
+    work_stealing_scheduler.stop_and_wait();
+
+    EXPECT_EQ(5000u, output_stream->get_tuples_count());
+    EXPECT_FALSE(exclusive_scheduler->overlapped);
+}
+
+TEST_F (TestWorkStealingScheduler, needs_a_worker) {
+    AbstractScheduler::ptr_t scheduler(
+        new WithoutCCScheduler(root, SchedulingPolicyFactory::ptr_t(new RoundRobinPolicyFactory())));
+    EXPECT_THROW(WorkStealingScheduler(scheduler, 0), std::string);
+}